@@ -2,7 +2,26 @@
 #define __DISPATCH_CPP_H__
 
 #include "Queue.h"
+#include "QueueBarrier.h"
+#include "QueueCancel.h"
+#include "QueueChannel.h"
+#include "QueueFair.h"
 #include "QueueFunction.h"
+#include "QueueGrain.h"
+#include "QueueGroup.h"
+#include "QueueIngest.h"
+#include "QueueLimiter.h"
+#include "QueueMemo.h"
+#include "QueueNumeric.h"
+#include "QueueParallel.h"
+#include "QueueProducer.h"
+#include "QueuePipeline.h"
 #include "QueueThread.h"
+#include "QueueReactor.h"
+#include "QueueSpill.h"
+#include "QueueStream.h"
+#include "QueueTaskGroup.h"
+#include "QueueTimer.h"
+#include "QueueWait.h"
 
 #endif // __DISPATCH_CPP_H__
\ No newline at end of file
@@ -1,18 +1,41 @@
 #ifndef __QUEUE_H__
 #define __QUEUE_H__
 
+// Queues use C++17 throughout (string_view, std::apply, fold expressions and inline variables, among others).
+#if __cplusplus < 201703L
+#error "DispatchCPP requires at least C++17 (compile with -std=c++17)."
+#endif
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
 
+#include <atomic>
+#include <chrono>
 #include <string>
 #include <vector>
 #include <deque>
 #include <functional>
+#include <iterator>
+#include <memory>
 #include <mutex>
+#include <tuple>
+#include <typeinfo>
+#include <unordered_map>
 
+#include "QueueBarrier.h"
+#include "QueueCancel.h"
+#include "QueueFair.h"
 #include "QueueFunction.h"
+#include "QueueGroup.h"
+#include "QueueIngest.h"
+#include "QueueLimiter.h"
+#include "QueueProducer.h"
+#include "QueueSpill.h"
+#include "QueueStream.h"
 #include "QueueThread.h"
+#include "QueueTimer.h"
+#include "QueueWait.h"
 
 // When we wait for threads to wrap up work, we do this in two steps:
 //   1. Wait for the deque of work to be empty (doesn't mean all threads have stopped yet, though).
@@ -24,11 +47,26 @@
 //    50us => ~5.0% CPU usage in blocking call to hasWorkLeft()
 #define QUEUE_THREAD_POLLING_TIME_US                    50
 
+// When keyed rebalancing is enabled, a key with no work in flight is moved off of its usual lane once that lane holds
+// more than SKEW times the work of the shortest lane, plus MIN_DEPTH.
+#define QUEUE_KEYED_REBALANCE_SKEW                      4
+#define QUEUE_KEYED_REBALANCE_MIN_DEPTH                 8
+
+// The number of shards coalesced work waiting to run is split into by its key's hash, each with its own lock.
+#define QUEUE_COALESCE_NUM_SHARDS                       16
+
 // This header file uses the standard namespace.
 using namespace std;
 
 // Declare the Queue within our DispatchCPP namespace.
 namespace DispatchCPP {
+    // Lets anything holding on to a Queue it doesn't own (like a QueueReactor's watches) check that the Queue still
+    // exists, and keeps it from being destroyed while they dispatch to it: hold the lock while doing either.
+    typedef struct __QUEUE_LIFETIME__ {
+        mutex lifetimeLock;
+        bool  isAlive;
+    } QueueLifetime;
+
     template <class RType, typename ...Args> class Queue {
         private:
             // The number of threads this queue will use to execution our QueueFunction object's invocations.
@@ -52,6 +90,293 @@ namespace DispatchCPP {
             // Our vector of threads.
             vector<QueueThread *> allThreads;
 
+            // Decides when our threads may start work, when we're rate limited or capped. Guarded by queueWorkLock.
+            QueueLimiter limiter;
+
+            // Tracks our barrier work, and holds other work back around it. Guarded by queueWorkLock.
+            QueueBarrier barrier;
+
+            // How our threads wait for work while there is none, and how they're woken for it.
+            QueueWaitState waitState;
+
+            // Shares our threads between the child Queues targeting us.
+            QueueFairScheduler fairScheduler;
+
+            // When we target a parent Queue, our place in its scheduler (otherwise nullptr).
+            QueueFairScheduler        * pTargetScheduler;
+            shared_ptr<QueueFairNode>   pTargetNode;
+
+            // The timer wheel servicing our delayed and periodic work.
+            QueueTimerWheel * pTimerWheel;
+
+            // Whether we still exist, shared with anyone who holds on to us without owning us.
+            shared_ptr<QueueLifetime> pLifetime;
+
+            // Where each key with keyed work in flight has been sent, and how much of its work is still in flight. Only
+            // tracked while rebalancing is enabled, and guarded by queueWorkLock.
+            typedef struct __QUEUE_KEYED_LANE__ {
+                unsigned int laneIndex;
+                unsigned int numPending;
+            } QueueKeyedLane;
+            unordered_map<size_t, QueueKeyedLane> keyedLanes;
+            bool                                  keyedRebalancing;
+
+            // A coalesced task still waiting to run: its key (along with the key's type, so keys whose hashes collide are
+            // never merged) and the arguments it'll run with.
+            typedef struct __QUEUE_COALESCED_ENTRY__ {
+                shared_ptr<void>  pKey;
+                const type_info * pKeyType;
+                tuple<Args...>    args;
+            } QueueCoalescedEntry;
+
+            // Coalesced tasks still waiting to run, by their key's hash, split into shards which each have their own
+            // lock. Also the number of dispatches which were merged into a waiting task rather than queued.
+            typedef struct __QUEUE_COALESCED_SHARD__ {
+                mutex                                                        shardLock;
+                unordered_multimap<size_t, shared_ptr<QueueCoalescedEntry>> allEntries;
+            } QueueCoalescedShard;
+            unique_ptr<QueueCoalescedShard[]> allCoalescedShards;
+            atomic<unsigned long long int>    numCoalesced;
+
+            // Where work goes once we're holding too much of it in memory: the spill itself, the number of records in it
+            // (guarded by queueWorkLock, so they count as queued work), how much work we hold before spilling (0 when
+            // spilling is off), and how arguments are turned into records and back. spillLock guards the spill, and is
+            // always taken before queueWorkLock.
+            unique_ptr<QueueSpill>                pSpill;
+            size_t                                numSpilled;
+            size_t                                spillThreshold;
+            function<string(Args...)>             spillSerialize;
+            function<tuple<Args...>(string_view)> spillDeserialize;
+            mutex                                 spillLock;
+
+            // Work which can't be written to disk (anything not from dispatchWork(), including barriers), dispatched while
+            // earlier work is spilled. It waits here, with a marker holding its place in the spill, so it can't overtake
+            // that work. Also the number of pieces of spilled work lost because they couldn't be read back, after which
+            // we stop spilling. Guarded by spillLock.
+            typedef struct __QUEUE_SPILL_HELD__ {
+                function<void()> work;
+                bool             isBarrier;
+            } QueueSpillHeld;
+            deque<QueueSpillHeld>                 allSpillHeld;
+            size_t                                numSpillLost;
+
+            // Our ID for producer buffers, every producer's buffer registered with us (guarded by producerLock), and when
+            // a buffer is handed over to us: once it holds flushSize pieces of work, or once its oldest has waited
+            // flushInterval.
+            unsigned long long int                  producerID;
+            vector<shared_ptr<QueueProducerBuffer>> allProducerBuffers;
+            mutex                                   producerLock;
+            atomic<size_t>                          producerFlushSize;
+            atomic<long long int>                   producerFlushUS;
+
+            // Returns the amount of work waiting to be picked up, both shared and in every thread's lane. The caller
+            // must hold queueWorkLock.
+            inline size_t numQueuedWork() {
+                size_t numQueued = (this->queueWork.size() + this->numSpilled);
+                if (this->pTargetNode != nullptr) {
+                    numQueued += this->pTargetNode->numPending.load(memory_order_acquire);
+                }
+                for (unsigned int threadIndex = 0; threadIndex < ((unsigned int) this->allThreads.size()); ++threadIndex) {
+                    numQueued += this->allThreads[threadIndex]->laneWork.size();
+                }
+                return(numQueued);
+            };
+
+            // Picks the lane a key's work goes to. The caller must hold queueWorkLock.
+            inline unsigned int pickKeyedLane(size_t keyHash) {
+                // Spread the key's hash out before picking its usual lane, since integer keys hash to themselves.
+                unsigned int numLanes  = (unsigned int) this->allThreads.size();
+                unsigned int laneIndex = (unsigned int) ((((unsigned long long int) keyHash) * 0x9E3779B97F4A7C15ULL) >> 32) % numLanes;
+                if (!this->keyedRebalancing) {
+                    return(laneIndex);
+                }
+
+                // Is the key's work still in flight? Then it has to stay put to stay in order.
+                auto existingLane = this->keyedLanes.find(keyHash);
+                if (existingLane != this->keyedLanes.end()) {
+                    existingLane->second.numPending++;
+                    return(existingLane->second.laneIndex);
+                }
+
+                // It's free to move, so move it if its usual lane is backed up compared to the shortest one.
+                unsigned int shortestIndex = 0;
+                for (unsigned int threadIndex = 1; threadIndex < numLanes; ++threadIndex) {
+                    if (this->allThreads[threadIndex]->laneWork.size() < this->allThreads[shortestIndex]->laneWork.size()) {
+                        shortestIndex = threadIndex;
+                    }
+                }
+                size_t shortestDepth = this->allThreads[shortestIndex]->laneWork.size();
+                if (this->allThreads[laneIndex]->laneWork.size() > ((shortestDepth * QUEUE_KEYED_REBALANCE_SKEW) + QUEUE_KEYED_REBALANCE_MIN_DEPTH)) {
+                    laneIndex = shortestIndex;
+                }
+                this->keyedLanes[keyHash] = { laneIndex, 1 };
+                return(laneIndex);
+            };
+
+            // Reads a trivially copyable argument back out of a spilled record.
+            template <typename T>
+            static inline T readSpilledArg(string_view record, size_t & offset) {
+                T value;
+                memcpy((void *) &value, record.data() + offset, sizeof(T));
+                offset += sizeof(T);
+                return(value);
+            };
+
+            // Spills the work to disk if we're already holding too much in memory, or if earlier work was spilled (so
+            // the work stays in order). Returns whether it was spilled; if the disk fails us, it's kept in memory.
+            inline bool spillWork(Args... args) {
+                lock_guard<mutex> spillGuard(this->spillLock);
+                this->queueWorkLock.lock();
+                bool shouldSpill = ((this->pSpill != nullptr) && (this->pTargetScheduler == nullptr) && ((this->numSpilled > 0) || (this->queueWork.size() >= this->spillThreshold)));
+                this->queueWorkLock.unlock();
+                if (!shouldSpill || !this->pSpill->push(this->spillSerialize(args...))) {
+                    return(false);
+                }
+
+                // Was this the first work spilled? Then queue up a refill, behind everything already in memory.
+                this->queueWorkLock.lock();
+                bool isFirstSpilled = ((this->numSpilled++) == 0);
+                if (isFirstSpilled) {
+                    this->queueWork.push_back([this](void) {
+                        this->refillFromSpill();
+                    });
+                    this->barrier.pushed(false);
+                }
+                bool isSingleWork = (!this->limiter.isEnabled() && !this->barrier.hasPending());
+                this->queueWorkLock.unlock();
+                if (isFirstSpilled) {
+                    this->notifyWorkers(isSingleWork);
+                }
+                return(true);
+            };
+
+            // Moves the next batch of spilled work back into memory, in order. While more is spilled, the next refill
+            // goes halfway through the batch, so our threads never run dry waiting on the disk.
+            inline void refillFromSpill() {
+                lock_guard<mutex> spillGuard(this->spillLock);
+                if (this->pSpill == nullptr) {
+                    return;
+                }
+
+                // Read the batch back, turning each record into work, and each marker back into the work it held a place
+                // for.
+                vector<QueueSpillHeld> allRefilled = vector<QueueSpillHeld>();
+                string                 record      = string();
+                bool                   isMarker    = false;
+                while ((allRefilled.size() < this->spillThreshold) && this->pSpill->pop(record, isMarker)) {
+                    if (isMarker) {
+                        if (this->allSpillHeld.size() == 0) {
+                            break;
+                        }
+                        allRefilled.push_back(move(this->allSpillHeld.front()));
+                        this->allSpillHeld.pop_front();
+                        continue;
+                    }
+                    tuple<Args...> args = this->spillDeserialize(record);
+                    allRefilled.push_back({ [this, args](void) {
+                        if (this->pQueueFunction != nullptr) {
+                            apply([this](auto &... allArgs) {
+                                this->pQueueFunction->runFunctions(allArgs...);
+                            }, args);
+                        }
+                    }, false });
+                }
+
+                // Came up short of what we spilled? Then the rest can't be read back: count it as lost, rather than
+                // trying again forever, and stop spilling. Work held in memory still runs, after everything before it.
+                this->queueWorkLock.lock();
+                this->numSpilled -= min(this->numSpilled, allRefilled.size());
+                if ((allRefilled.size() < this->spillThreshold) && (this->numSpilled > 0)) {
+                    this->numSpillLost += (this->numSpilled - min(this->numSpilled, this->allSpillHeld.size()));
+                    this->numSpilled    = 0;
+                    while (this->allSpillHeld.size() > 0) {
+                        allRefilled.push_back(move(this->allSpillHeld.front()));
+                        this->allSpillHeld.pop_front();
+                    }
+                    this->pSpill.reset();
+                }
+
+                // Move it into the queue all at once, so it never looks like there's no work left while we do.
+                bool needsRefill = (this->numSpilled > 0);
+                for (size_t workIndex = 0; workIndex <= allRefilled.size(); ++workIndex) {
+                    if (needsRefill && (workIndex == (allRefilled.size() / 2))) {
+                        this->queueWork.push_back([this](void) {
+                            this->refillFromSpill();
+                        });
+                        this->barrier.pushed(false);
+                    }
+                    if (workIndex < allRefilled.size()) {
+                        this->queueWork.push_back(move(allRefilled[workIndex].work));
+                        this->barrier.pushed(allRefilled[workIndex].isBarrier);
+                    }
+                }
+                this->queueWorkLock.unlock();
+                this->notifyWorkers(false);
+            };
+
+            // Holds work which can't be spilled in line behind whatever is, so it can't overtake it. Returns whether it
+            // was held; it isn't if nothing's spilled (anymore), or if the disk fails us, so the caller queues it.
+            inline bool holdBehindSpill(function<void()> & newFunction, bool isBarrier) {
+                lock_guard<mutex> spillGuard(this->spillLock);
+                lock_guard<mutex> tempLock(this->queueWorkLock);
+                if ((this->pSpill == nullptr) || (this->numSpilled == 0) || !this->pSpill->pushMarker()) {
+                    return(false);
+                }
+                this->allSpillHeld.push_back({ move(newFunction), isBarrier });
+                this->numSpilled++;
+                return(true);
+            };
+
+            // Appends work (or barrier work) to our shared deque, behind anything spilled, and wakes our threads for it.
+            inline void queueFunction(function<void()> newFunction, bool isBarrier) {
+                // Is earlier work spilled? Then this has to wait its turn behind it.
+                this->queueWorkLock.lock();
+                if (this->numSpilled > 0) {
+                    this->queueWorkLock.unlock();
+                    if (this->holdBehindSpill(newFunction, isBarrier)) {
+                        return;
+                    }
+                    this->queueWorkLock.lock();
+                }
+                this->queueWork.push_back(move(newFunction));
+                this->barrier.pushed(isBarrier);
+                bool isSingleWork = (!isBarrier && !this->limiter.isEnabled() && !this->barrier.hasPending());
+                this->queueWorkLock.unlock();
+                this->notifyWorkers(isSingleWork);
+            };
+
+            // Hands everything in a producer's buffer over to our threads, in one go.
+            inline void flushProducerBuffer(QueueProducerBuffer * pBuffer) {
+                lock_guard<mutex>        handoverLock(pBuffer->handoverLock);
+                vector<function<void()>> allTaken = pBuffer->take();
+                if (allTaken.size() == 0) {
+                    return;
+                }
+
+                // Do we target a parent Queue? Then it has to go through its scheduler, one piece at a time.
+                if (this->pTargetScheduler != nullptr) {
+                    for (function<void()> & newFunction : allTaken) {
+                        this->dispatchFunction(move(newFunction));
+                    }
+                    return;
+                }
+                this->queueWorkLock.lock();
+                for (function<void()> & newFunction : allTaken) {
+                    this->queueWork.push_back(move(newFunction));
+                    this->barrier.pushed(false);
+                }
+                bool isSingleWork = ((allTaken.size() == 1) && !this->limiter.isEnabled() && !this->barrier.hasPending());
+                this->queueWorkLock.unlock();
+                this->notifyWorkers(isSingleWork);
+            };
+
+            // Wakes our threads for work we've just queued. A single piece of shared work only needs a single thread,
+            // unless it's being held back by our limits or a barrier, since then the thread it wakes might not be the
+            // one able to start it.
+            inline void notifyWorkers(bool isSingleWork) {
+                this->waitState.notify(&(this->queueWorkVar), isSingleWork);
+            };
+
             // Initializes all the threads.
             inline void initializeThreads() {
                 // Create all of our queue thread objects, now.
@@ -60,7 +385,10 @@ namespace DispatchCPP {
                                                                this->pQueueFunction->closeFunc,
                                                                &(this->queueWorkLock),
                                                                &(this->queueWorkVar),
-                                                               &(this->queueWork)));
+                                                               &(this->queueWork),
+                                                               &(this->limiter),
+                                                               &(this->barrier),
+                                                               &(this->waitState)));
                 }
             };
 
@@ -92,14 +420,76 @@ namespace DispatchCPP {
                 this->deallocateQueueFunc = deallocateQueueFunction;
                 this->queueWork           = deque<function<void()>>();
                 this->allThreads          = vector<QueueThread *>();
+                this->keyedLanes          = unordered_map<size_t, QueueKeyedLane>();
+                this->keyedRebalancing    = false;
+                this->allCoalescedShards  = unique_ptr<QueueCoalescedShard[]>(new QueueCoalescedShard[QUEUE_COALESCE_NUM_SHARDS]);
+                this->numCoalesced        = 0;
+                this->pTargetScheduler    = nullptr;
+                this->pTargetNode         = nullptr;
+                this->pSpill              = nullptr;
+                this->producerID          = QueueProducerBuffer::nextOwnerID();
+                this->allProducerBuffers  = vector<shared_ptr<QueueProducerBuffer>>();
+                this->producerFlushSize   = QUEUE_PRODUCER_FLUSH_SIZE;
+                this->producerFlushUS     = QUEUE_PRODUCER_FLUSH_US;
+                this->numSpilled          = 0;
+                this->spillThreshold      = 0;
+                this->allSpillHeld        = deque<QueueSpillHeld>();
+                this->numSpillLost        = 0;
+                this->pLifetime           = make_shared<QueueLifetime>();
+                this->pLifetime->isAlive  = true;
+                this->fairScheduler.setDispatcher([this](function<void()> newFunction) {
+                    this->dispatchFunction(move(newFunction));
+                });
+
+                // Grab the shared timer wheel up front, so it's constructed before (and destroyed after) any Queue.
+                this->pTimerWheel         = &(QueueTimerWheel::shared());
 
                 // Initialize all our threads, now.
                 this->initializeThreads();
             };
             ~Queue() {
+                // Let anyone holding on to us know we're going away, waiting on anyone dispatching to us right now.
+                this->pLifetime->lifetimeLock.lock();
+                this->pLifetime->isAlive = false;
+                this->pLifetime->lifetimeLock.unlock();
+
+                // Make sure none of our timers fire once we're gone.
+                this->pTimerWheel->cancelOwner(this);
+
+                // Stop targeting our parent, waiting on any of our work it's running.
+                this->setTargetQueue((Queue *) nullptr);
+
+                // Throw away anything still sitting in our producers' buffers. Work we throw away is only destroyed once
+                // we've let go of our locks, since destroying it can run code of its own (like leaving a QueueGroup).
+                deque<function<void()>> allDiscarded = deque<function<void()>>();
+                this->producerLock.lock();
+                for (shared_ptr<QueueProducerBuffer> & pBuffer : this->allProducerBuffers) {
+                    vector<function<void()>> allTaken = pBuffer->take();
+                    move(allTaken.begin(), allTaken.end(), back_inserter(allDiscarded));
+                }
+                this->allProducerBuffers.clear();
+                this->producerLock.unlock();
+
+                // Throw away anything we've spilled, and anything held in line behind it.
+                deque<QueueSpillHeld> allSpillDiscarded = deque<QueueSpillHeld>();
+                this->spillLock.lock();
+                this->pSpill.reset();
+                allSpillDiscarded.swap(this->allSpillHeld);
+                this->spillLock.unlock();
+
                 this->queueWorkLock.lock();
+                move(this->queueWork.begin(), this->queueWork.end(), back_inserter(allDiscarded));
                 this->queueWork.clear();
+                this->numSpilled = 0;
+                this->barrier.cleared();
+                for (unsigned int threadIndex = 0; threadIndex < ((unsigned int) this->allThreads.size()); ++threadIndex) {
+                    deque<function<void()>> & laneWork = this->allThreads[threadIndex]->laneWork;
+                    move(laneWork.begin(), laneWork.end(), back_inserter(allDiscarded));
+                    laneWork.clear();
+                }
                 this->queueWorkLock.unlock();
+                allDiscarded.clear();
+                allSpillDiscarded.clear();
 
                 this->teardownThreads();
 
@@ -111,6 +501,11 @@ namespace DispatchCPP {
 
             // Add some work to the queue, to be executed by the Queue's QueueFunction object.
             void dispatchWork(Args... args) {
+                // Are we holding too much in memory? Then it goes to disk instead.
+                if ((this->spillThreshold > 0) && this->spillWork(args...)) {
+                    return;
+                }
+
                 // Declare our new piece of work we'll be adding to the queue's execution.
                 function<void()> newWork = [this, args...](void) {
                     if (this->pQueueFunction != nullptr) {
@@ -119,11 +514,492 @@ namespace DispatchCPP {
                 };
 
                 // Append this to our queue of work.
+                this->dispatchFunction(move(newWork));
+            };
+
+            // Add some work to the calling thread's own buffer for this queue, which is handed over to our threads in a
+            // batch once it's full or its oldest work has waited long enough (see setProducerBuffering()), or on flush().
+            // Threads dispatching at once never contend with each other, only with the handover. Buffered work is never
+            // spilled, and only runs in order with other work from the same thread.
+            void dispatchWorkBuffered(Args... args) {
+                // Declare our new piece of work, and grab our buffer (registering it, if it's new).
+                function<void()> newWork = [this, args...](void) {
+                    if (this->pQueueFunction != nullptr) {
+                        this->pQueueFunction->runFunctions(args...);
+                    }
+                };
+                shared_ptr<QueueProducerBuffer> pCreated = nullptr;
+                QueueProducerBuffer *           pBuffer  = QueueProducerBuffer::forThread(this->producerID, pCreated);
+                if (pCreated != nullptr) {
+                    lock_guard<mutex> tempLock(this->producerLock);
+                    this->allProducerBuffers.push_back(pCreated);
+                }
+
+                // Append it, and decide whether it's time to hand the buffer over (now, or later on our timer).
+                long long int flushUS = this->producerFlushUS.load(memory_order_relaxed);
+                pBuffer->bufferLock.lock();
+                pBuffer->allWork.push_back(move(newWork));
+                bool shouldFlush = (pBuffer->allWork.size() >= this->producerFlushSize.load(memory_order_relaxed));
+                bool shouldArm   = (!shouldFlush && !pBuffer->isTimerArmed && (flushUS > 0));
+                if (shouldArm) {
+                    pBuffer->isTimerArmed = true;
+                }
+                pBuffer->bufferLock.unlock();
+                if (shouldFlush) {
+                    this->flushProducerBuffer(pBuffer);
+                } else if (shouldArm) {
+                    this->pTimerWheel->addTimer(this, chrono::microseconds(flushUS), chrono::microseconds(0), [this, pBuffer](void) {
+                        pBuffer->bufferLock.lock();
+                        pBuffer->isTimerArmed = false;
+                        pBuffer->bufferLock.unlock();
+                        this->flushProducerBuffer(pBuffer);
+                    });
+                }
+            };
+
+            // Hands everything in every producer's buffer over to our threads, now.
+            void flush() {
+                this->producerLock.lock();
+                vector<shared_ptr<QueueProducerBuffer>> allBuffers = this->allProducerBuffers;
+                this->producerLock.unlock();
+                for (shared_ptr<QueueProducerBuffer> & pBuffer : allBuffers) {
+                    this->flushProducerBuffer(pBuffer.get());
+                }
+            };
+
+            // Sets when producers' buffers are handed over: once they hold flushSize pieces of work, or once their oldest
+            // has waited flushInterval (0 waits for flushSize, or flush()).
+            void setProducerBuffering(size_t flushSize, chrono::microseconds flushInterval = chrono::microseconds(QUEUE_PRODUCER_FLUSH_US)) {
+                this->producerFlushSize = ((flushSize > 0) ? flushSize : 1);
+                this->producerFlushUS   = (long long int) flushInterval.count();
+            };
+
+            // Runs one piece of work waiting in the queue on the calling thread, if there is one (and our limits let it
+            // start). Returns whether any work was run. This is what lets a thread waiting on other work help out, rather
+            // than block. Keyed work is never run this way, since it has to stay on its own thread.
+            bool runPendingWork() {
+                // Do we target a parent Queue? Then our work's waiting with its scheduler, so run it from there.
+                if ((this->pTargetScheduler != nullptr) && this->pTargetScheduler->runNode(this->pTargetNode)) {
+                    return(true);
+                }
+
+                function<void()> pendingWork = nullptr;
+                bool             wasAdmitted = false;
+                bool             wasBarrier  = false;
+
+                // Grab the next piece of work, if there is one and it's allowed to start.
+                this->queueWorkLock.lock();
+                if ((this->queueWork.size() > 0) && this->barrier.canStart(true)) {
+                    long long int waitNS = 0;
+                    if (this->limiter.isEnabled() && !(wasAdmitted = this->limiter.tryAcquire(waitNS))) {
+                        this->queueWorkLock.unlock();
+                        return(false);
+                    }
+                    pendingWork = move(this->queueWork.front());
+                    this->queueWork.pop_front();
+                    wasBarrier = this->barrier.started(true);
+                }
+                this->queueWorkLock.unlock();
+
+                // Run it, now.
+                if (pendingWork == nullptr) {
+                    return(false);
+                }
+                pendingWork();
+                if (wasAdmitted) {
+                    this->queueWorkLock.lock();
+                    this->limiter.release();
+                    this->queueWorkLock.unlock();
+                }
+                this->barrier.finished(wasBarrier, &(this->queueWorkLock), &(this->queueWorkVar), &(this->waitState));
+
+                // Work held back by our limits or the barrier may be free to start now, so wake anyone who could take it.
+                if (wasAdmitted || wasBarrier) {
+                    this->notifyWorkers(false);
+                }
+                return(true);
+            };
+
+            // Add some work to the queue, which is skipped if the token is cancelled before the work starts.
+            void dispatchWork(const QueueCancelToken & cancelToken, Args... args) {
+                // Declare our new piece of work, wrapped so it checks the token before running our QueueFunction.
+                function<void()> newWork = cancelToken.wrap([this, args...](void) {
+                    if (this->pQueueFunction != nullptr) {
+                        this->pQueueFunction->runFunctions(args...);
+                    }
+                });
+
+                // Append this to our queue of work.
+                this->dispatchFunction(move(newWork));
+            };
+
+            // Add some work to the queue whose result is published to the stream, which hands results back in the order
+            // they were dispatched. Blocks while the stream is full. Only for QueueFunctions which return a value.
+            template <typename Q = RType>
+            typename enable_if<!is_same<Q, void>::value, void>::type dispatchWorkOrdered(QueueResultStream<typename RValue<RType>::type> & stream, Args... args) {
+                // If the work is thrown away rather than run, its reservation publishes a tombstone as it's destroyed.
+                shared_ptr<QueueStreamReservation<typename RValue<RType>::type>> pReservation = make_shared<QueueStreamReservation<typename RValue<RType>::type>>(&stream);
+                this->dispatchFunction([this, pReservation, args...](void) {
+                    typename RValue<RType>::type result{};
+                    if (this->pQueueFunction != nullptr) {
+                        result = this->pQueueFunction->runFunctionsForResult(args...);
+                    }
+                    pReservation->publish(move(result));
+                });
+            };
+
+            // Add a piece of work for each chunk of the ingested file, which runs our QueueFunction with a view of the
+            // chunk's whole records. Each chunk is aligned to its records by the thread running it. The ingest has to
+            // outlive the work. Only for QueueFunctions taking a single string_view.
+            template <typename Q = tuple<Args...>>
+            typename enable_if<is_same<Q, tuple<string_view>>::value, void>::type dispatchIngest(const QueueIngest & ingest) {
+                const QueueIngest * pIngest = &ingest;
+                for (size_t chunkIndex = 0; chunkIndex < pIngest->getNumChunks(); ++chunkIndex) {
+                    this->dispatchFunction([this, pIngest, chunkIndex](void) {
+                        string_view chunk = pIngest->getChunk(chunkIndex);
+                        if ((chunk.size() > 0) && (this->pQueueFunction != nullptr)) {
+                            this->pQueueFunction->runFunctions(chunk);
+                        }
+                    });
+                }
+            };
+
+            // Add some work to the queue as part of a group, which won't drain until this work has finished.
+            void dispatchWork(const QueueGroup & group, Args... args) {
+                // Declare our new piece of work, wrapped so it leaves the group once it's finished.
+                function<void()> newWork = group.wrap([this, args...](void) {
+                    if (this->pQueueFunction != nullptr) {
+                        this->pQueueFunction->runFunctions(args...);
+                    }
+                });
+
+                // Append this to our queue of work.
+                this->dispatchFunction(move(newWork));
+            };
+
+            // Add an arbitrary function to the queue as part of a group.
+            void dispatchFunction(const QueueGroup & group, function<void()> newFunction) {
+                this->dispatchFunction(group.wrap(move(newFunction)));
+            };
+
+            // Add an arbitrary function to the queue, to be executed by one of the Queue's threads. This bypasses the
+            // Queue's QueueFunction entirely, which is what lets continuations and callbacks target any Queue.
+            void dispatchFunction(function<void()> newFunction) {
+                // Do we target a parent Queue? Then it runs our work, when its scheduler says it's our turn.
+                if (this->pTargetScheduler != nullptr) {
+                    this->pTargetScheduler->push(this->pTargetNode, move(newFunction));
+                    this->waitState.notifyHelpers();
+                    return;
+                }
+
+                // Append this to our queue of work.
+                this->queueFunction(move(newFunction), false);
+            };
+
+            // Add barrier work to the queue. It waits for all the work dispatched before it to finish, then runs on its
+            // own, and only once it's finished does the work dispatched after it start (in parallel, as usual). Useful for
+            // writes to a structure which the rest of the queue's work only reads.
+            void dispatchBarrier(Args... args) {
+                this->dispatchBarrierFunction([this, args...](void) {
+                    if (this->pQueueFunction != nullptr) {
+                        this->pQueueFunction->runFunctions(args...);
+                    }
+                });
+            };
+
+            // Add an arbitrary function to the queue as barrier work.
+            void dispatchBarrierFunction(function<void()> newFunction) {
+                // Do we target a parent Queue? Then its scheduler holds the rest of our work back around this.
+                if (this->pTargetScheduler != nullptr) {
+                    this->pTargetScheduler->push(this->pTargetNode, move(newFunction), true);
+                    this->waitState.notifyHelpers();
+                    return;
+                }
+                this->queueFunction(move(newFunction), true);
+            };
+
+            // Add some work to the queue which runs in order with all other work dispatched with the same key. Each key
+            // is hashed onto one of the Queue's threads, so work for different keys still runs in parallel, and a key's
+            // work keeps running on the same thread (and cache) as long as rebalancing is off.
+            template <typename KeyType>
+            void dispatchWorkKeyed(const KeyType & key, Args... args) {
+                this->dispatchFunctionKeyed(key, [this, args...](void) {
+                    if (this->pQueueFunction != nullptr) {
+                        this->pQueueFunction->runFunctions(args...);
+                    }
+                });
+            };
+
+            // Add an arbitrary function to the queue, which runs in order with all other work dispatched with the same key.
+            template <typename KeyType>
+            void dispatchFunctionKeyed(const KeyType & key, function<void()> newFunction) {
+                size_t keyHash = hash<KeyType>()(key);
+
+                // When rebalancing, we have to hear back once the key's work is done, so we know when it's free to move.
+                if (this->keyedRebalancing) {
+                    newFunction = [this, keyHash, newFunction](void) {
+                        newFunction();
+                        lock_guard<mutex> tempLock(this->queueWorkLock);
+                        auto existingLane = this->keyedLanes.find(keyHash);
+                        if ((existingLane != this->keyedLanes.end()) && (--(existingLane->second.numPending) == 0)) {
+                            this->keyedLanes.erase(existingLane);
+                        }
+                    };
+                }
+
+                // Append this to its thread's lane.
                 this->queueWorkLock.lock();
-                this->queueWork.push_back(newWork);
+                this->allThreads[this->pickKeyedLane(keyHash)]->laneWork.push_back(move(newFunction));
+                this->queueWorkLock.unlock();
+                this->notifyWorkers(false);
+            };
+
+            // Lets keys move between threads when their lanes get backed up. A key only ever moves while none of its work
+            // is in flight, so its work stays in order. Only change this while no keyed work is in flight.
+            void setKeyedRebalancing(bool enableRebalancing) {
+                lock_guard<mutex> tempLock(this->queueWorkLock);
+                this->keyedRebalancing = enableRebalancing;
+            };
+
+            // Add some work to the queue, unless work with the same key is still waiting to run, in which case that work
+            // runs with these arguments instead. Keys must be hashable and comparable with ==. Once work has started
+            // running, the next dispatch with its key queues new work.
+            template <typename KeyType>
+            void dispatchWorkCoalesced(const KeyType & key, Args... args) {
+                this->dispatchWorkCoalesced(key, nullptr, args...);
+            };
+
+            // Same as above, except the waiting work's arguments are combined with these using mergeFunc (which is handed
+            // the waiting arguments, then the new ones), rather than replaced. mergeFunc is called while holding a lock.
+            template <typename KeyType>
+            void dispatchWorkCoalesced(const KeyType & key, function<tuple<Args...>(const tuple<Args...> &, const tuple<Args...> &)> mergeFunc, Args... args) {
+                // Spread the key's hash out before picking its shard (as pickKeyedLane() does), since integer keys hash to
+                // themselves.
+                size_t                keyHash = hash<KeyType>()(key);
+                QueueCoalescedShard * pShard  = &(this->allCoalescedShards[((((unsigned long long int) keyHash) * 0x9E3779B97F4A7C15ULL) >> 32) % QUEUE_COALESCE_NUM_SHARDS]);
+
+                // Is there already work waiting for this key? If so, merge into it, and we're done.
+                pShard->shardLock.lock();
+                auto allMatches = pShard->allEntries.equal_range(keyHash);
+                for (auto existingEntry = allMatches.first; existingEntry != allMatches.second; ++existingEntry) {
+                    QueueCoalescedEntry * pEntry = existingEntry->second.get();
+                    if ((*(pEntry->pKeyType) == typeid(KeyType)) && (*((KeyType *) pEntry->pKey.get()) == key)) {
+                        pEntry->args = ((mergeFunc != nullptr) ? mergeFunc(pEntry->args, make_tuple(args...)) : make_tuple(args...));
+                        pShard->shardLock.unlock();
+                        this->numCoalesced.fetch_add(1, memory_order_relaxed);
+                        return;
+                    }
+                }
+                shared_ptr<QueueCoalescedEntry> pNewEntry = make_shared<QueueCoalescedEntry>();
+                pNewEntry->pKey     = make_shared<KeyType>(key);
+                pNewEntry->pKeyType = &typeid(KeyType);
+                pNewEntry->args     = make_tuple(args...);
+                pShard->allEntries.emplace(keyHash, pNewEntry);
+                pShard->shardLock.unlock();
+
+                // There isn't, so queue work which picks up whatever its arguments have become by the time it runs.
+                this->dispatchFunction([this, pShard, keyHash, pNewEntry](void) {
+                    pShard->shardLock.lock();
+                    auto allMatches = pShard->allEntries.equal_range(keyHash);
+                    for (auto existingEntry = allMatches.first; existingEntry != allMatches.second; ++existingEntry) {
+                        if (existingEntry->second == pNewEntry) {
+                            pShard->allEntries.erase(existingEntry);
+                            break;
+                        }
+                    }
+                    tuple<Args...> runArgs = move(pNewEntry->args);
+                    pShard->shardLock.unlock();
+
+                    if (this->pQueueFunction != nullptr) {
+                        apply([this](Args... args) {
+                            this->pQueueFunction->runFunctions(args...);
+                        }, runArgs);
+                    }
+                });
+            };
+
+            // Returns the number of coalesced dispatches which were merged into waiting work rather than queued.
+            unsigned long long int getNumCoalesced() {
+                return(this->numCoalesced.load(memory_order_relaxed));
+            };
+
+            // Add some work to the queue once the delay has passed. Returns an ID which can be used to cancel it.
+            QueueTimerID dispatchAfter(chrono::microseconds delay, Args... args) {
+                return(this->pTimerWheel->addTimer(this, delay, chrono::microseconds(0), [this, args...](void) {
+                    this->dispatchWork(args...);
+                }));
+            };
+
+            // Add some work to the queue every period, starting one period from now. Runs until it's cancelled.
+            QueueTimerID dispatchEvery(chrono::microseconds period, Args... args) {
+                return(this->pTimerWheel->addTimer(this, period, period, [this, args...](void) {
+                    this->dispatchWork(args...);
+                }));
+            };
+
+            // Cancels delayed or periodic work which hasn't been handed to the queue yet. Returns false if the timer
+            // has already fired for the last time, or was already cancelled.
+            bool cancelTimer(QueueTimerID timerID) {
+                return(this->pTimerWheel->cancelTimer(timerID));
+            };
+
+            // Limits this queue to starting at most tasksPerSecond pieces of work a second, allowing bursts of up to
+            // burstSize. Work which can't start yet stays queued, rather than holding one of our threads. 0 turns it off.
+            void setRateLimit(double tasksPerSecond, double burstSize = 1.0) {
+                this->queueWorkLock.lock();
+                this->limiter.setRateLimit(tasksPerSecond, burstSize);
                 this->queueWorkLock.unlock();
-                // this->queueWorkVar.notify_one();
                 this->queueWorkVar.notify_all();
+                if (this->pTargetScheduler != nullptr) {
+                    this->pTargetScheduler->updateNode(this->pTargetNode, [tasksPerSecond, burstSize](QueueFairNode * pNode) {
+                        pNode->limiter.setRateLimit(tasksPerSecond, burstSize);
+                    });
+                }
+            };
+
+            // Limits this queue to running at most maxInFlight pieces of work at once, no matter how many threads it has.
+            // Work which can't start yet stays queued. 0 turns it off.
+            void setMaxInFlight(unsigned int maxInFlight) {
+                this->queueWorkLock.lock();
+                this->limiter.setMaxInFlight(maxInFlight);
+                this->queueWorkLock.unlock();
+                this->queueWorkVar.notify_all();
+                if (this->pTargetScheduler != nullptr) {
+                    this->pTargetScheduler->updateNode(this->pTargetNode, [maxInFlight](QueueFairNode * pNode) {
+                        pNode->limiter.setMaxInFlight(maxInFlight);
+                    });
+                }
+            };
+
+            // Makes this Queue's work run on pTarget's threads rather than its own, sharing them fairly (by weight) with
+            // every other Queue targeting pTarget, using deficit round robin. maxInFlight caps how much of our work runs
+            // at once (0 for no cap). Targets can be nested, to build hierarchies of Queues. This applies to work
+            // dispatched with dispatchWork(), dispatchFunction() and dispatchBarrier() (and everything built on them),
+            // which our rate limit, in-flight cap and barriers still apply to; keyed work still runs on our own threads.
+            // Set this before dispatching work, and destroy children before their parent. Passing nullptr stops
+            // targeting, waiting on any of our work the old target is running.
+            template <class TargetType>
+            void setTargetQueue(TargetType * pTarget, unsigned int weight = 1, unsigned int maxInFlight = 0) {
+                // Leave our old target, if we had one.
+                if (this->pTargetScheduler != nullptr) {
+                    this->pTargetScheduler->removeNode(this->pTargetNode);
+                    this->pTargetScheduler->waitForNode(this->pTargetNode);
+                    this->pTargetScheduler = nullptr;
+                    this->pTargetNode      = nullptr;
+                }
+
+                // Join our new one, taking our limits along.
+                if (pTarget != nullptr) {
+                    this->queueWorkLock.lock();
+                    this->pTargetNode      = pTarget->getFairScheduler()->addNode(weight, maxInFlight, this->limiter, &(this->waitState));
+                    this->queueWorkLock.unlock();
+                    this->pTargetScheduler = pTarget->getFairScheduler();
+                }
+            };
+
+            // Changes our weight and cap within our target Queue.
+            void setTargetWeight(unsigned int weight, unsigned int maxInFlight = 0) {
+                if (this->pTargetScheduler != nullptr) {
+                    this->pTargetScheduler->setNodeWeight(this->pTargetNode, weight, maxInFlight);
+                }
+            };
+
+            // Returns the scheduler sharing our threads between the Queues targeting us.
+            QueueFairScheduler * getFairScheduler() {
+                return(&(this->fairScheduler));
+            };
+
+            // Returns whether we still exist, for anyone holding on to us without owning us.
+            shared_ptr<QueueLifetime> getLifetime() {
+                return(this->pLifetime);
+            };
+
+            // Returns the number of threads executing this queue's work.
+            unsigned int getNumThreads() {
+                return(this->numThreads);
+            };
+
+            // Returns the amount of work waiting to be picked up by one of our threads.
+            size_t getQueueDepth() {
+                lock_guard<mutex> tempLock(this->queueWorkLock);
+                return(this->numQueuedWork());
+            };
+
+            // Spills work to disk once more than maxInMemory pieces of it are waiting in memory, rather than letting the
+            // queue grow without limit. Spilled work is read back (in order) as the queue drains, maxInMemory at a time.
+            // Only work from dispatchWork() spills, and not while we target another Queue; anything else dispatched while
+            // work is spilled (barriers included) waits in memory, in line behind it. Call this before dispatching.
+            // This version is for Args which are all trivially copyable.
+            void setSpill(size_t maxInMemory, string spillDir = QUEUE_SPILL_DEFAULT_DIR) {
+                static_assert(conjunction<is_trivially_copyable<Args>...>::value, "Spilling without a serializer needs trivially copyable arguments");
+                this->setSpill(
+                    maxInMemory,
+                    [](Args... args) {
+                        string record = string();
+                        (record.append((const char *) &args, sizeof(Args)), ...);
+                        return(record);
+                    },
+                    [](string_view record) {
+                        size_t offset = 0;
+                        return(tuple<Args...>{ Queue::readSpilledArg<Args>(record, offset)... });
+                    },
+                    spillDir
+                );
+            };
+
+            // Spills work to disk, as above, turning each piece's arguments into a record and back with the functions given.
+            void setSpill(size_t maxInMemory, function<string(Args...)> serialize, function<tuple<Args...>(string_view)> deserialize, string spillDir = QUEUE_SPILL_DEFAULT_DIR) {
+                lock_guard<mutex> spillGuard(this->spillLock);
+                if (this->pSpill == nullptr) {
+                    this->pSpill = make_unique<QueueSpill>(spillDir);
+                }
+                this->spillSerialize   = serialize;
+                this->spillDeserialize = deserialize;
+                this->spillThreshold   = ((maxInMemory > 0) ? maxInMemory : 1);
+            };
+
+            // Returns the number of pieces of work waiting on disk, or in line behind it.
+            size_t getNumSpilled() {
+                lock_guard<mutex> tempLock(this->queueWorkLock);
+                return(this->numSpilled);
+            };
+
+            // Returns the number of pieces of spilled work which couldn't be read back, and were dropped. Once any are, we
+            // stop spilling, and keep everything in memory.
+            size_t getNumSpillLost() {
+                lock_guard<mutex> spillGuard(this->spillLock);
+                return(this->numSpillLost);
+            };
+
+            // Sets how our threads wait for work while there is none: parking straight away (the default), or spinning
+            // first, trading CPU while idle for picking work up sooner. All but the default also only wake a single
+            // thread for each piece of work, rather than every thread.
+            void setWaitStrategy(QueueWaitStrategy newStrategy) {
+                this->waitState.setStrategy(newStrategy);
+                this->queueWorkVar.notify_all();
+            };
+
+            // Returns the number of times our threads have been woken from parking, including the times someone else got
+            // to the work first.
+            unsigned long long int getNumWakeups() {
+                return(this->waitState.numWakeups.load(memory_order_relaxed));
+            };
+
+            // Returns how our threads wait for work, which threads helping out with our work (see runPendingWork())
+            // can wait on too.
+            QueueWaitState * getWaitState() {
+                return(&(this->waitState));
+            };
+
+            // Returns a snapshot of every thread's state. Each thread's entry is internally consistent, but the threads
+            // are read one after another rather than all at once.
+            vector<QueueThreadStatus> getThreadStatus() {
+                vector<QueueThreadStatus> allStatus = vector<QueueThreadStatus>();
+                allStatus.reserve(this->allThreads.size());
+                for (unsigned int threadIndex = 0; threadIndex < ((unsigned int) this->allThreads.size()); ++threadIndex) {
+                    allStatus.push_back(this->allThreads[threadIndex]->getStatus());
+                }
+                return(allStatus);
             };
 
             // This function returns whether there's still pending work (or not).
@@ -131,6 +1007,9 @@ namespace DispatchCPP {
                 // Declare our return value up front.
                 bool returnValue = false;
 
+                // Anything still sitting in a producer's buffer counts, so hand it all over first.
+                this->flush();
+
                 // Should we be blocking until all work is finished?
                 if (blockUntilDone) {
                     // Wait until there's no work left.
@@ -140,7 +1019,7 @@ namespace DispatchCPP {
 
                         // Is there no work left?
                         this->queueWorkLock.lock();
-                        hasWorkLeft = (this->queueWork.size() > 0);
+                        hasWorkLeft = (this->numQueuedWork() > 0);
                         this->queueWorkLock.unlock();
 
                         // Do we have any work left?
@@ -162,7 +1041,7 @@ namespace DispatchCPP {
                         // Iterate over all the threads to make sure they're all idle.
                         bool oneThreadNotIdle = false;
                         for (unsigned int threadIndex = 0; threadIndex < ((unsigned int) this->allThreads.size()); ++threadIndex) {
-                            if (!(this->allThreads[threadIndex]->isIdle)) {
+                            if (!(this->allThreads[threadIndex]->isIdle())) {
                                 oneThreadNotIdle = true;
                                 break;
                             }
@@ -191,7 +1070,7 @@ namespace DispatchCPP {
                 } else {
                     // Acquire the lock on the work queue.
                     this->queueWorkLock.lock();
-                    returnValue = (this->queueWork.size() > 0);
+                    returnValue = (this->numQueuedWork() > 0);
                     this->queueWorkLock.unlock();
 
                     // Is there no more work left in the queue?
@@ -199,7 +1078,7 @@ namespace DispatchCPP {
                         // We must now make sure all threads are idle, to actually say there is no more work being performed.
                         bool oneThreadNotIdle = false;
                         for (unsigned int threadIndex = 0; threadIndex < ((unsigned int) this->allThreads.size()); ++threadIndex) {
-                            if (!(this->allThreads[threadIndex]->isIdle)) {
+                            if (!(this->allThreads[threadIndex]->isIdle())) {
                                 oneThreadNotIdle = true;
                                 break;
                             }
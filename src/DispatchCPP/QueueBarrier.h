@@ -0,0 +1,149 @@
+#ifndef __QUEUE_BARRIER_H__
+#define __QUEUE_BARRIER_H__
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <algorithm>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+#include "QueueWait.h"
+
+// This header file uses the standard namespace.
+using namespace std;
+
+// Declare the QueueBarrier within our DispatchCPP namespace.
+namespace DispatchCPP {
+    // Tracks barrier work for a Queue. A barrier waits for all the work dispatched before it to finish, runs on its own,
+    // and only then lets the work dispatched after it start. It never needs a lock of its own: everything other than our
+    // running count is only touched while holding the Queue's work lock, which is already held whenever work is queued
+    // or picked up. Barriers are found by position, counting the work pushed onto and popped off the shared deque.
+    class QueueBarrier {
+        private:
+            // How much work has been pushed onto and popped off of the shared deque, and where each queued barrier sits.
+            unsigned long long int         numPushed;
+            unsigned long long int         numPopped;
+            deque<unsigned long long int>  allBarrierPositions;
+
+            // Whether a barrier is running right now.
+            bool                           isBarrierRunning;
+
+            // How much work is running right now (including barriers), and whether any barrier is queued or running.
+            // These are read by finishing work without the lock, so they're only ever accessed sequentially consistent.
+            atomic<unsigned int>           numRunning;
+            atomic<bool>                   isBarrierPending;
+
+            // Every piece of work the calling thread is in the middle of running, by its barrier tracker, innermost last.
+            // Only more than one when work waits on other work by running it (see Queue::runPendingWork()).
+            static inline thread_local vector<QueueBarrier *> allRunningHere;
+
+            // Returns how much of our running work is the calling thread's own, further up its stack. A barrier can't
+            // wait on that to finish, since it won't until the barrier's out of the way.
+            inline unsigned int numRunningHere() {
+                return((unsigned int) count(allRunningHere.begin(), allRunningHere.end(), this));
+            };
+
+        public:
+            // Constructor.
+            inline QueueBarrier() {
+                this->numPushed        = 0;
+                this->numPopped        = 0;
+                this->isBarrierRunning = false;
+                this->numRunning       = 0;
+                this->isBarrierPending = false;
+            };
+
+            // Returns whether the next work in the shared deque is a barrier.
+            inline bool isBarrierNext() {
+                return((this->allBarrierPositions.size() > 0) && (this->allBarrierPositions.front() == this->numPopped));
+            };
+
+            // Returns whether any barrier is queued or running.
+            inline bool hasPending() {
+                return(this->isBarrierPending);
+            };
+
+            // Records work pushed onto the shared deque.
+            inline void pushed(bool isBarrier) {
+                if (isBarrier) {
+                    this->allBarrierPositions.push_back(this->numPushed);
+                    this->isBarrierPending = true;
+                }
+                this->numPushed++;
+            };
+
+            // Forgets everything queued, once the shared deque's been cleared.
+            inline void cleared() {
+                this->numPushed = this->numPopped = 0;
+                this->allBarrierPositions.clear();
+                this->isBarrierPending = this->isBarrierRunning;
+            };
+
+            // Returns whether work may start on the calling thread, given where it would come from: none may while a
+            // barrier runs, and while a barrier is next in line, nothing else may start and it waits for everything
+            // running to finish (other than the work the calling thread itself is in the middle of).
+            inline bool canStart(bool fromSharedDeque) {
+                if (this->isBarrierRunning) {
+                    return(false);
+                }
+                if (this->isBarrierNext()) {
+                    return(fromSharedDeque && (this->numRunning == this->numRunningHere()));
+                }
+                return(true);
+            };
+
+            // Records work starting, on the thread which is about to run it. Returns whether it's a barrier.
+            inline bool started(bool fromSharedDeque) {
+                bool isBarrier = false;
+                if (fromSharedDeque) {
+                    isBarrier = this->isBarrierNext();
+                    if (isBarrier) {
+                        this->allBarrierPositions.pop_front();
+                        this->isBarrierRunning = true;
+                    }
+                    this->numPopped++;
+                }
+                this->numRunning++;
+                allRunningHere.push_back(this);
+                return(isBarrier);
+            };
+
+            // Records work finishing, waking whoever might be waiting on it: our threads, and any helpers sleeping on
+            // pWaitState (when there is one). Called without holding the work lock, on the thread which ran it.
+            inline void finished(bool wasBarrier, mutex * pWorkLock, condition_variable * pWorkVar, QueueWaitState * pWaitState = nullptr) {
+                allRunningHere.pop_back();
+
+                // Once a barrier finishes, everything behind it is free to start.
+                if (wasBarrier) {
+                    pWorkLock->lock();
+                    this->isBarrierRunning = false;
+                    this->isBarrierPending = (this->allBarrierPositions.size() > 0);
+                    this->numRunning--;
+                    pWorkLock->unlock();
+                    pWorkVar->notify_all();
+                    if (pWaitState != nullptr) {
+                        pWaitState->notifyHelpers();
+                    }
+                    return;
+                }
+
+                // Is a barrier waiting? Then it may be free to start now, even if other work's still running: a helper
+                // only waits on the work running on other threads. Nobody else wakes it, so we have to.
+                this->numRunning.fetch_sub(1);
+                if (this->isBarrierPending) {
+                    pWorkLock->lock();
+                    pWorkLock->unlock();
+                    pWorkVar->notify_all();
+                    if (pWaitState != nullptr) {
+                        pWaitState->notifyHelpers();
+                    }
+                }
+            };
+    };
+};
+
+#endif // __QUEUE_BARRIER_H__
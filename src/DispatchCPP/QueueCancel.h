@@ -0,0 +1,88 @@
+#ifndef __QUEUE_CANCEL_H__
+#define __QUEUE_CANCEL_H__
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <atomic>
+#include <functional>
+#include <memory>
+
+// This header file uses the standard namespace.
+using namespace std;
+
+// Declare the QueueCancelToken within our DispatchCPP namespace.
+namespace DispatchCPP {
+    // A token which can be attached to work at dispatch time. Cancelling the token bumps its epoch, which is O(1) no
+    // matter how much work is queued: each piece of work remembers the epoch it was dispatched under, and is skipped
+    // (without ever reaching its QueueFunction) if the epoch has moved on by the time a QueueThread picks it up. Work
+    // dispatched after a cancel runs as normal, so a single token can act as a reusable group. Copies of a token share
+    // the same state, and queued work keeps that state alive.
+    class QueueCancelToken {
+        private:
+            // The state shared by every copy of a token, and by all the work dispatched with it.
+            typedef struct __QUEUE_CANCEL_STATE__ {
+                atomic<unsigned long long int> epoch;
+                atomic<unsigned long long int> numSkipped;
+            } QueueCancelState;
+
+            // Our shared state.
+            shared_ptr<QueueCancelState> pState;
+
+            // The token (and epoch) of the work currently running on this thread, if any. Used for cooperative polling.
+            static inline thread_local QueueCancelState * pCurrentState = nullptr;
+            static inline thread_local unsigned long long int currentEpoch = 0;
+
+        public:
+            // Constructor.
+            inline QueueCancelToken() {
+                // Initialize our class members.
+                this->pState = make_shared<QueueCancelState>();
+                this->pState->epoch      = 0;
+                this->pState->numSkipped = 0;
+            };
+
+            // Cancels all work dispatched with this token which hasn't started yet. Work which is already running can
+            // notice by polling isCurrentCancelled().
+            inline void cancel() {
+                this->pState->epoch.fetch_add(1, memory_order_acq_rel);
+            };
+
+            // Returns the number of pieces of work which have been skipped because of this token.
+            inline unsigned long long int numSkipped() const {
+                return(this->pState->numSkipped.load(memory_order_relaxed));
+            };
+
+            // Wraps work so that it's skipped if this token is cancelled before it starts.
+            template <typename WorkFunc>
+            inline function<void()> wrap(WorkFunc newWork) const {
+                shared_ptr<QueueCancelState> pWorkState = this->pState;
+                unsigned long long int       workEpoch  = this->pState->epoch.load(memory_order_acquire);
+                return([pWorkState, workEpoch, newWork](void) {
+                    // Were we cancelled while we sat in the queue?
+                    if (pWorkState->epoch.load(memory_order_acquire) != workEpoch) {
+                        pWorkState->numSkipped.fetch_add(1, memory_order_relaxed);
+                        return;
+                    }
+
+                    // Run the work, letting it poll our token while it does.
+                    QueueCancelState     * pPreviousState = QueueCancelToken::pCurrentState;
+                    unsigned long long int previousEpoch  = QueueCancelToken::currentEpoch;
+                    QueueCancelToken::pCurrentState = pWorkState.get();
+                    QueueCancelToken::currentEpoch  = workEpoch;
+                    newWork();
+                    QueueCancelToken::pCurrentState = pPreviousState;
+                    QueueCancelToken::currentEpoch  = previousEpoch;
+                });
+            };
+
+            // Returns whether the token attached to the work running on this thread has been cancelled since the work
+            // was dispatched. Long-running work should poll this and return early. Always false for work dispatched
+            // without a token.
+            static inline bool isCurrentCancelled() {
+                return((QueueCancelToken::pCurrentState != nullptr) && (QueueCancelToken::pCurrentState->epoch.load(memory_order_relaxed) != QueueCancelToken::currentEpoch));
+            };
+    };
+};
+
+#endif // __QUEUE_CANCEL_H__
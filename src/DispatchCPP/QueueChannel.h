@@ -0,0 +1,199 @@
+#ifndef __QUEUE_CHANNEL_H__
+#define __QUEUE_CHANNEL_H__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+// The number of values a channel holds by default, before pushing blocks.
+#define QUEUE_CHANNEL_DEFAULT_CAPACITY  1024
+
+// The number of times a blocked push or pop yields, before it goes to sleep.
+#define QUEUE_CHANNEL_SPIN_COUNT        64
+
+// The size of a cache line, used to keep our push and pop positions apart.
+#define QUEUE_CHANNEL_CACHE_LINE_SIZE   64
+
+// This header file uses the standard namespace.
+using namespace std;
+
+// Declare the QueueChannel within our DispatchCPP namespace.
+namespace DispatchCPP {
+    // A bounded, lock-free channel of values, for any number of pushing and popping threads. Values are moved in and
+    // out, never copied. Each slot carries a sequence number saying whether it's ready to be pushed into or popped from,
+    // so pushes and pops only ever contend on claiming their position. Pushing blocks while the channel is full, and
+    // popping blocks while it's empty, until the channel is closed. Threads only ever sleep on a lock when they're
+    // actually blocked, and are only woken when someone is.
+    template <typename T> class QueueChannel {
+        private:
+            // A slot in our ring. It holds its position once it's free to push into, and its position + 1 once a value
+            // has been pushed into it.
+            typedef struct __QUEUE_CHANNEL_SLOT__ {
+                atomic<size_t> sequence;
+                T              value;
+            } QueueChannelSlot;
+
+            // Our ring, and its size (a power of two).
+            unique_ptr<QueueChannelSlot[]> allSlots;
+            size_t                         capacity;
+
+            // The next positions to be pushed into and popped from.
+            alignas(QUEUE_CHANNEL_CACHE_LINE_SIZE) atomic<size_t> pushPosition;
+            alignas(QUEUE_CHANNEL_CACHE_LINE_SIZE) atomic<size_t> popPosition;
+
+            // Whether no more values will be pushed, and the number of threads asleep waiting on the channel.
+            atomic<bool>         isClosed;
+            atomic<unsigned int> numWaiting;
+
+            // The lock and condition variable blocked threads sleep on.
+            mutex              waitLock;
+            condition_variable waitVar;
+
+            // Blocks until the condition holds: yielding at first, then sleeping.
+            template <typename Condition>
+            inline void waitUntil(Condition condition) {
+                for (unsigned int spinIndex = 0; spinIndex < QUEUE_CHANNEL_SPIN_COUNT; ++spinIndex) {
+                    if (condition()) {
+                        return;
+                    }
+                    this_thread::yield();
+                }
+                this->numWaiting.fetch_add(1);
+                unique_lock<mutex> tempLock(this->waitLock);
+                this->waitVar.wait(tempLock, condition);
+                tempLock.unlock();
+                this->numWaiting.fetch_sub(1);
+            };
+
+            // Wakes anyone asleep waiting on the channel.
+            inline void wakeWaiting() {
+                atomic_thread_fence(memory_order_seq_cst);
+                if (this->numWaiting.load() > 0) {
+                    this->waitLock.lock();
+                    this->waitLock.unlock();
+                    this->waitVar.notify_all();
+                }
+            };
+
+            // Pushes a value into the next free slot, unless the channel is full, without waking anyone.
+            inline bool pushInto(T & value) {
+                size_t position = this->pushPosition.load(memory_order_relaxed);
+                while (true) {
+                    QueueChannelSlot * pSlot      = &(this->allSlots[position & (this->capacity - 1)]);
+                    intptr_t           difference = ((intptr_t) pSlot->sequence.load(memory_order_acquire)) - ((intptr_t) position);
+                    if (difference == 0) {
+                        if (this->pushPosition.compare_exchange_weak(position, position + 1, memory_order_relaxed)) {
+                            pSlot->value = move(value);
+                            pSlot->sequence.store(position + 1, memory_order_release);
+                            return(true);
+                        }
+                    } else if (difference < 0) {
+                        return(false);
+                    } else {
+                        position = this->pushPosition.load(memory_order_relaxed);
+                    }
+                }
+            };
+
+            // Pops a value from the oldest full slot, unless the channel is empty, without waking anyone.
+            inline bool popFrom(T & value) {
+                size_t position = this->popPosition.load(memory_order_relaxed);
+                while (true) {
+                    QueueChannelSlot * pSlot      = &(this->allSlots[position & (this->capacity - 1)]);
+                    intptr_t           difference = ((intptr_t) pSlot->sequence.load(memory_order_acquire)) - ((intptr_t) (position + 1));
+                    if (difference == 0) {
+                        if (this->popPosition.compare_exchange_weak(position, position + 1, memory_order_relaxed)) {
+                            value = move(pSlot->value);
+                            pSlot->sequence.store(position + this->capacity, memory_order_release);
+                            return(true);
+                        }
+                    } else if (difference < 0) {
+                        return(false);
+                    } else {
+                        position = this->popPosition.load(memory_order_relaxed);
+                    }
+                }
+            };
+
+        public:
+            // Constructor. The capacity is rounded up to a power of two.
+            inline QueueChannel(size_t minCapacity = QUEUE_CHANNEL_DEFAULT_CAPACITY) {
+                this->capacity = 2;
+                while (this->capacity < minCapacity) {
+                    this->capacity <<= 1;
+                }
+                this->allSlots = unique_ptr<QueueChannelSlot[]>(new QueueChannelSlot[this->capacity]);
+                for (size_t slotIndex = 0; slotIndex < this->capacity; ++slotIndex) {
+                    this->allSlots[slotIndex].sequence.store(slotIndex, memory_order_relaxed);
+                }
+                this->pushPosition = 0;
+                this->popPosition  = 0;
+                this->isClosed     = false;
+                this->numWaiting   = 0;
+            };
+
+            // Pushes a value, unless the channel is full. Returns whether it was pushed.
+            inline bool tryPush(T && value) {
+                if (!this->pushInto(value)) {
+                    return(false);
+                }
+                this->wakeWaiting();
+                return(true);
+            };
+
+            // Pops a value, unless the channel is empty. Returns whether one was popped.
+            inline bool tryPop(T & value) {
+                if (!this->popFrom(value)) {
+                    return(false);
+                }
+                this->wakeWaiting();
+                return(true);
+            };
+
+            // Pushes a value, blocking while the channel is full.
+            inline void push(T && value) {
+                if (!this->pushInto(value)) {
+                    this->waitUntil([this, &value]() {
+                        return(this->pushInto(value));
+                    });
+                }
+                this->wakeWaiting();
+            };
+
+            // Pops a value, blocking while the channel is empty. Returns false once the channel's closed and empty.
+            inline bool pop(T & value) {
+                bool wasPopped = this->popFrom(value);
+                if (!wasPopped) {
+                    this->waitUntil([this, &value, &wasPopped]() {
+                        // Check whether we're closed first: if we are, every push has already finished.
+                        bool wasClosed = this->isClosed.load();
+                        wasPopped = this->popFrom(value);
+                        return(wasPopped || wasClosed);
+                    });
+                }
+                if (wasPopped) {
+                    this->wakeWaiting();
+                }
+                return(wasPopped);
+            };
+
+            // Marks the channel as closed, once every value has been pushed. Pops return false once it's drained.
+            inline void close() {
+                this->isClosed = true;
+                this->wakeWaiting();
+            };
+
+            // Returns the most values the channel holds at once.
+            inline size_t getCapacity() {
+                return(this->capacity);
+            };
+    };
+};
+
+#endif // __QUEUE_CHANNEL_H__
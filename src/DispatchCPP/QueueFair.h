@@ -0,0 +1,326 @@
+#ifndef __QUEUE_FAIR_H__
+#define __QUEUE_FAIR_H__
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "QueueBarrier.h"
+#include "QueueLimiter.h"
+#include "QueueTimer.h"
+#include "QueueWait.h"
+
+// This header file uses the standard namespace.
+using namespace std;
+
+// Declare the QueueFairScheduler within our DispatchCPP namespace.
+namespace DispatchCPP {
+    // A single child Queue's place in its parent's scheduler. Everything but numPending is guarded by the scheduler's
+    // lock.
+    typedef struct __QUEUE_FAIR_NODE__ {
+        deque<function<void()>> queuedWork;
+        unsigned int            weight;
+        unsigned int            maxInFlight;    // 0 when not capped.
+        unsigned int            numInFlight;
+        double                  deficit;
+        atomic<unsigned int>    numPending;     // Queued or running, read by the child without the scheduler's lock.
+        QueueLimiter            limiter;        // The child's own rate limit and cap.
+        QueueBarrier            barrier;        // The child's barrier work, amongst its queued work.
+        QueueWaitState *        pWaitState;     // The child's wait state, whose helpers its barriers may be holding back.
+        bool                    isTimerArmed;   // Whether a timer will dispatch a ticket once the limiter lets work start.
+        bool                    hasArmedTimer;  // Whether a timer was ever armed, so removing us needs to cancel it.
+    } QueueFairNode;
+
+    // Shares a parent Queue's threads fairly between the child Queues targeting it, using deficit round robin. Each piece
+    // of work a child dispatches is queued with its node here, and a ticket is dispatched onto the parent. Whichever of
+    // the parent's threads runs a ticket runs the next child work picked by deficit round robin, not necessarily the work
+    // the ticket was dispatched for, so a child flooding the parent with tickets still can't get ahead of its siblings.
+    // Children with a higher weight get proportionally more of the parent's work, and a child can be capped to a number
+    // of pieces of work running at once. Each child's own limits and barriers are applied here too, since its work
+    // never passes through its own threads.
+    class QueueFairScheduler {
+        private:
+            // The lock guarding everything below, our children, and what we wait on for a child's work to finish.
+            mutex                            schedulerLock;
+            vector<shared_ptr<QueueFairNode>> allNodes;
+            condition_variable               idleVar;
+
+            // The child whose turn it is, and the number of tickets which found only held back work, and went unused.
+            unsigned int                     currentIndex;
+            unsigned int                     numDeferredTickets;
+
+            // Children held back by their rate limit, which need a timer armed once we've let go of our lock, and when.
+            vector<pair<QueueFairNode *, long long int>> allTimersToArm;
+
+            // Dispatches a function onto our parent Queue.
+            function<void(function<void()>)> dispatcher;
+
+            // Returns whether a child's next work may start now, regardless of whose turn it is. If it may, and the
+            // child is limited, its limiter has already let the work through (wasAdmitted). The caller must hold
+            // schedulerLock.
+            inline bool isRunnable(QueueFairNode * pNode, bool & wasAdmitted) {
+                wasAdmitted = false;
+                if ((pNode->queuedWork.size() == 0) || ((pNode->maxInFlight > 0) && (pNode->numInFlight >= pNode->maxInFlight))) {
+                    return(false);
+                }
+                if (!pNode->barrier.canStart(true)) {
+                    return(false);
+                }
+                if (pNode->limiter.isEnabled()) {
+                    long long int waitNS = 0;
+                    if (!(wasAdmitted = pNode->limiter.tryAcquire(waitNS))) {
+                        // Held back by its rate: nothing else will let it go, so a timer has to.
+                        if ((waitNS > 0) && !pNode->isTimerArmed) {
+                            pNode->isTimerArmed  = true;
+                            pNode->hasArmedTimer = true;
+                            this->allTimersToArm.push_back(make_pair(pNode, waitNS));
+                        }
+                        return(false);
+                    }
+                }
+                return(true);
+            };
+
+            // Picks the next child work to run. The caller must hold schedulerLock.
+            inline QueueFairNode * pickNode(bool & wasAdmitted) {
+                unsigned int numNodes = (unsigned int) this->allNodes.size();
+                for (unsigned int attemptIndex = 0; (numNodes > 0) && (attemptIndex <= (2 * numNodes)); ++attemptIndex) {
+                    if (this->currentIndex >= numNodes) {
+                        this->currentIndex = 0;
+                    }
+
+                    // Does the current child still have deficit left, and work it's allowed to start?
+                    QueueFairNode * pNode = this->allNodes[this->currentIndex].get();
+                    if ((pNode->deficit >= 1.0) && this->isRunnable(pNode, wasAdmitted)) {
+                        return(pNode);
+                    }
+
+                    // It doesn't, so it's the next child's turn. Children without work don't save up deficit, and
+                    // children held back (by their cap, rate or a barrier) save up no more than a single turn's worth,
+                    // so they can't run their whole backlog back to back once they're let go.
+                    if (pNode->queuedWork.size() == 0) {
+                        pNode->deficit = 0.0;
+                    }
+                    this->currentIndex = ((this->currentIndex + 1) % numNodes);
+                    QueueFairNode * pNextNode = this->allNodes[this->currentIndex].get();
+                    if (pNextNode->queuedWork.size() > 0) {
+                        pNextNode->deficit = min(pNextNode->deficit + (double) pNextNode->weight, (double) pNextNode->weight);
+                    }
+                }
+                return(nullptr);
+            };
+
+            // Returns a ticket, which runs the next child work when our parent runs it.
+            inline function<void()> makeTicket() {
+                return([this](void) {
+                    this->runNext();
+                });
+            };
+
+            // Arms a timer for each child held back by its rate limit, which hands back one of the tickets deferred in
+            // the meantime once it's due. Called without holding schedulerLock.
+            inline void armTimers(vector<pair<QueueFairNode *, long long int>> & allToArm) {
+                for (pair<QueueFairNode *, long long int> & toArm : allToArm) {
+                    QueueFairNode * pNode = toArm.first;
+                    QueueTimerWheel::shared().addTimer(pNode, chrono::microseconds((toArm.second + 999) / 1000), chrono::microseconds(0), [this, pNode](void) {
+                        bool needsTicket = false;
+                        this->schedulerLock.lock();
+                        pNode->isTimerArmed = false;
+                        if (this->numDeferredTickets > 0) {
+                            this->numDeferredTickets--;
+                            needsTicket = true;
+                        }
+                        this->schedulerLock.unlock();
+                        if (needsTicket) {
+                            this->dispatcher(this->makeTicket());
+                        }
+                    });
+                }
+            };
+
+            // Runs a child's next work, which the caller has just found runnable, on the calling thread. The caller must
+            // hold schedulerLock, which this lets go of.
+            inline void runWork(QueueFairNode * pNode, bool wasAdmitted) {
+                function<void()> nextWork   = move(pNode->queuedWork.front());
+                pNode->queuedWork.pop_front();
+                bool             wasBarrier = pNode->barrier.started(true);
+                pNode->numInFlight++;
+                vector<pair<QueueFairNode *, long long int>> allToArm;
+                allToArm.swap(this->allTimersToArm);
+                this->schedulerLock.unlock();
+                this->armTimers(allToArm);
+
+                // Run it.
+                nextWork();
+                pNode->barrier.finished(wasBarrier, &(this->schedulerLock), &(this->idleVar), pNode->pWaitState);
+
+                // Tickets which found only held back work can go, now: all of them once a barrier's out of the way,
+                // otherwise the one for the room we just made.
+                unsigned int numTickets = 0;
+                this->schedulerLock.lock();
+                pNode->numInFlight--;
+                if (wasAdmitted) {
+                    pNode->limiter.release();
+                }
+                if ((this->numDeferredTickets > 0) && (pNode->queuedWork.size() > 0)) {
+                    numTickets = (wasBarrier ? min(this->numDeferredTickets, (unsigned int) pNode->queuedWork.size()) : 1);
+                    this->numDeferredTickets -= numTickets;
+                }
+                if (--(pNode->numPending) == 0) {
+                    this->idleVar.notify_all();
+                }
+                this->schedulerLock.unlock();
+                for (unsigned int ticketIndex = 0; ticketIndex < numTickets; ++ticketIndex) {
+                    this->dispatcher(this->makeTicket());
+                }
+            };
+
+        public:
+            // Constructor.
+            inline QueueFairScheduler() {
+                this->allNodes           = vector<shared_ptr<QueueFairNode>>();
+                this->currentIndex       = 0;
+                this->numDeferredTickets = 0;
+                this->dispatcher         = nullptr;
+            };
+
+            // Sets how tickets are dispatched onto our parent Queue.
+            inline void setDispatcher(function<void(function<void()>)> newDispatcher) {
+                this->dispatcher = newDispatcher;
+            };
+
+            // Adds a child, returning its node. The child's limits start out as a copy of limiter's.
+            inline shared_ptr<QueueFairNode> addNode(unsigned int weight, unsigned int maxInFlight, const QueueLimiter & limiter, QueueWaitState * pWaitState = nullptr) {
+                shared_ptr<QueueFairNode> pNode = make_shared<QueueFairNode>();
+                pNode->weight        = max(weight, 1u);
+                pNode->maxInFlight   = maxInFlight;
+                pNode->numInFlight   = 0;
+                pNode->deficit       = 0.0;
+                pNode->numPending    = 0;
+                pNode->isTimerArmed  = false;
+                pNode->hasArmedTimer = false;
+                pNode->pWaitState    = pWaitState;
+                pNode->limiter.copySettings(limiter);
+                lock_guard<mutex> tempLock(this->schedulerLock);
+                this->allNodes.push_back(pNode);
+                return(pNode);
+            };
+
+            // Changes a child's weight and cap.
+            inline void setNodeWeight(shared_ptr<QueueFairNode> pNode, unsigned int weight, unsigned int maxInFlight) {
+                this->updateNode(pNode, [weight, maxInFlight](QueueFairNode * pUpdating) {
+                    pUpdating->weight      = max(weight, 1u);
+                    pUpdating->maxInFlight = maxInFlight;
+                });
+            };
+
+            // Changes a child's node (its weight, cap, or limits) with updateFunc, which is called while holding our
+            // lock. Hands back a deferred ticket, in case the change lets held back work start.
+            inline void updateNode(shared_ptr<QueueFairNode> pNode, function<void(QueueFairNode *)> updateFunc) {
+                bool needsTicket = false;
+                this->schedulerLock.lock();
+                updateFunc(pNode.get());
+                if (this->numDeferredTickets > 0) {
+                    this->numDeferredTickets--;
+                    needsTicket = true;
+                }
+                this->schedulerLock.unlock();
+                if (needsTicket) {
+                    this->dispatcher(this->makeTicket());
+                }
+            };
+
+            // Removes a child, dropping any of its work which hasn't started yet. Work already running still finishes.
+            // Dropped work is only destroyed once we've let go of our lock, since destroying it can run code of its own.
+            inline void removeNode(shared_ptr<QueueFairNode> pNode) {
+                deque<function<void()>> allDiscarded = deque<function<void()>>();
+                this->schedulerLock.lock();
+                pNode->numPending -= (unsigned int) pNode->queuedWork.size();
+                allDiscarded.swap(pNode->queuedWork);
+                for (unsigned int nodeIndex = 0; nodeIndex < ((unsigned int) this->allNodes.size()); ++nodeIndex) {
+                    if (this->allNodes[nodeIndex] == pNode) {
+                        this->allNodes.erase(this->allNodes.begin() + nodeIndex);
+                        if (this->currentIndex > nodeIndex) {
+                            this->currentIndex--;
+                        }
+                        break;
+                    }
+                }
+                bool hasArmedTimer = pNode->hasArmedTimer;
+                this->schedulerLock.unlock();
+                allDiscarded.clear();
+                this->idleVar.notify_all();
+                if (hasArmedTimer) {
+                    QueueTimerWheel::shared().cancelOwner(pNode.get());
+                }
+            };
+
+            // Blocks until none of a child's work is queued or running.
+            inline void waitForNode(shared_ptr<QueueFairNode> pNode) {
+                unique_lock<mutex> tempLock(this->schedulerLock);
+                this->idleVar.wait(tempLock, [pNode] {
+                    return(pNode->numPending.load() == 0);
+                });
+            };
+
+            // Queues a child's work (barrier work, if isBarrier), and dispatches a ticket for it onto our parent.
+            inline void push(shared_ptr<QueueFairNode> pNode, function<void()> newWork, bool isBarrier = false) {
+                this->schedulerLock.lock();
+                pNode->queuedWork.push_back(move(newWork));
+                pNode->barrier.pushed(isBarrier);
+                pNode->numPending++;
+                this->schedulerLock.unlock();
+                this->dispatcher(this->makeTicket());
+            };
+
+            // Runs the next child work, picked by deficit round robin. Called by our tickets.
+            inline void runNext() {
+                // Pick the work. If all that's left is held back, save the ticket for when that changes.
+                bool wasAdmitted = false;
+                this->schedulerLock.lock();
+                QueueFairNode * pNode = this->pickNode(wasAdmitted);
+                if (pNode == nullptr) {
+                    for (unsigned int nodeIndex = 0; nodeIndex < ((unsigned int) this->allNodes.size()); ++nodeIndex) {
+                        if (this->allNodes[nodeIndex]->queuedWork.size() > 0) {
+                            this->numDeferredTickets++;
+                            break;
+                        }
+                    }
+                    vector<pair<QueueFairNode *, long long int>> allToArm;
+                    allToArm.swap(this->allTimersToArm);
+                    this->schedulerLock.unlock();
+                    this->armTimers(allToArm);
+                    return;
+                }
+                pNode->deficit -= 1.0;
+                this->runWork(pNode, wasAdmitted);
+            };
+
+            // Runs a child's own next work on the calling thread, if it may start now, whoever's turn it is. Returns
+            // whether any work was run. This is what lets a thread waiting on a child's work help with it, rather than
+            // wait on tickets which might be stuck behind it. The ticket dispatched for the work finds nothing, later.
+            inline bool runNode(shared_ptr<QueueFairNode> pNode) {
+                bool wasAdmitted = false;
+                this->schedulerLock.lock();
+                if (!this->isRunnable(pNode.get(), wasAdmitted)) {
+                    vector<pair<QueueFairNode *, long long int>> allToArm;
+                    allToArm.swap(this->allTimersToArm);
+                    this->schedulerLock.unlock();
+                    this->armTimers(allToArm);
+                    return(false);
+                }
+                this->runWork(pNode.get(), wasAdmitted);
+                return(true);
+            };
+    };
+};
+
+#endif // __QUEUE_FAIR_H__
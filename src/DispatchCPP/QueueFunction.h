@@ -6,8 +6,12 @@
 #include <unistd.h>
 
 #include <functional>
+#include <memory>
+#include <tuple>
 #include <type_traits>
 
+#include "QueueMemo.h"
+
 // Define which controls whether the postFunc is called when the mainFunc is not invoked.
 // #define QUEUE_FUNCTION_ENABLE_POST_FUNC_CALL_WHEN_MAIN_NOT_INVOKED
 
@@ -40,6 +44,12 @@ namespace DispatchCPP {
 
             function<void(void)>                            closeFunc;
 
+            // When our main function's results are memoized, these look results up in (and report on) our memo cache,
+            // which they hold, so copies of us share it (otherwise nullptr). They're only built by setMemoized(), so
+            // QueueFunctions which aren't memoized don't need hashable, comparable arguments.
+            function<typename RValue<RType>::type(function<typename RValue<RType>::type(void)>, Args...)> memoMainFunc;
+            function<QueueMemoStats(void)>                                                                memoStatsFunc;
+
             // =========================================================================================================
 
             QueueFunction(function<typename RValue<RType>::type(Args...)> newMainFunc,
@@ -62,6 +72,8 @@ namespace DispatchCPP {
                 this->pPostFuncNotVoid = nullptr;
                 this->pPostFuncVoid    = nullptr;
                 this->closeFunc        = nullptr;
+                this->memoMainFunc     = nullptr;
+                this->memoStatsFunc    = nullptr;
             };
 
             // =========================================================================================================
@@ -104,6 +116,30 @@ namespace DispatchCPP {
                 this->closeFunc = newCloseFunc;
             }
 
+            // --------------------
+
+            // Memoizes our main function's results, keeping up to maxEntries of them. Only for main functions which
+            // always give the same result for the same arguments (and whose arguments are hashable and comparable).
+            // Pre and post functions still run every time. Call this before dispatching.
+            template<typename Q = RType>
+            typename enable_if<!is_same<Q, void>::value, void>::type setMemoized(size_t maxEntries = QUEUE_MEMO_DEFAULT_MAX_ENTRIES) {
+                shared_ptr<QueueMemoCache<typename RValue<RType>::type, Args...>> pMemoCache = make_shared<QueueMemoCache<typename RValue<RType>::type, Args...>>(maxEntries);
+                this->memoMainFunc = [pMemoCache](function<typename RValue<RType>::type(void)> computeFunc, Args... args) {
+                    return(pMemoCache->getOrCompute(tuple<Args...>(args...), computeFunc));
+                };
+                this->memoStatsFunc = [pMemoCache]() {
+                    return(pMemoCache->getStats());
+                };
+            };
+
+            // Returns how our memo cache has been doing (all zeroes, if we aren't memoized).
+            QueueMemoStats getMemoStats() {
+                if (this->memoStatsFunc == nullptr) {
+                    return(QueueMemoStats{ 0, 0, 0, 0, 0 });
+                }
+                return(this->memoStatsFunc());
+            };
+
             // =========================================================================================================
 
             bool runPreFunc(Args... args) {
@@ -114,6 +150,11 @@ namespace DispatchCPP {
 
             template<typename Q = RType>
             typename enable_if<!is_same<Q, void>::value, typename RValue<RType>::type>::type runMainFunc(Args... args) {
+                if (this->memoMainFunc != nullptr) {
+                    return(this->memoMainFunc([this, &args...]() {
+                        return(this->mainFuncNotVoid(args...));
+                    }, args...));
+                }
                 return(this->mainFuncNotVoid(args...));
             };
 
@@ -150,6 +191,25 @@ namespace DispatchCPP {
                 }
             };
 
+            // Same as runFunctions(), except the main function's result is handed back as well (or a default constructed
+            // one, if the pre function says not to run it).
+            template<typename Q = RType>
+            typename enable_if<!is_same<Q, void>::value, typename RValue<RType>::type>::type runFunctionsForResult(Args... args) {
+                bool preFuncResult = true;
+                if ((this->preFunc != nullptr) && (this->mainFuncNotVoid != nullptr)) {
+                    preFuncResult = this->runPreFunc(args...);
+                }
+                typename RValue<RType>::type mainFuncNotVoidResult{};
+                if (preFuncResult && (this->mainFuncNotVoid != nullptr)) {
+                    mainFuncNotVoidResult = this->runMainFunc(args...);
+                    if (this->pPostFuncNotVoid != nullptr) {
+                        function<void(typename RValue<RType>::type)> func = *((function<void(typename RValue<RType>::type)> *) this->pPostFuncNotVoid);
+                        func(mainFuncNotVoidResult);
+                    }
+                }
+                return(mainFuncNotVoidResult);
+            };
+
             template<typename Q = RType>
             typename enable_if<is_same<Q, void>::value, void>::type runFunctions(Args... args) {
                 bool preFuncResult = true;
@@ -0,0 +1,126 @@
+#ifndef __QUEUE_GRAIN_H__
+#define __QUEUE_GRAIN_H__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <algorithm>
+#include <mutex>
+
+// How long each chunk of a range should take to run, by default. Long enough that dispatching it is cheap next to
+// running it, short enough that there are plenty of chunks to balance across threads.
+#define QUEUE_GRAIN_TARGET_US           100
+
+// How much weight each new measurement gets in our running per-item cost, so we follow the input as it changes without
+// jumping around on every noisy chunk.
+#define QUEUE_GRAIN_SMOOTHING           0.25
+
+// The most a single measurement may count for, as a multiple of our running per-item cost, so one chunk which hit cold
+// caches or page faults can't throw our chunk size off. Genuinely more expensive items still win out, over a few chunks.
+#define QUEUE_GRAIN_MAX_SAMPLE_RATIO    4.0
+
+// The smallest and largest chunks we'll ever choose, by default.
+#define QUEUE_GRAIN_MIN_CHUNK           1
+#define QUEUE_GRAIN_MAX_CHUNK           (1 << 20)
+
+// This header file uses the standard namespace.
+using namespace std;
+
+// Declare the QueueGrainTuner within our DispatchCPP namespace.
+namespace DispatchCPP {
+    // Chooses how many items to put in each chunk of a range, from how long chunks have actually taken to run. Every
+    // measurement updates a smoothed cost per item, and the chunk size is whatever that cost says fits in our target
+    // duration. Keep one around for each kind of work and reuse it between ranges, so later ranges start out tuned.
+    class QueueGrainTuner {
+        private:
+            // Guards everything below.
+            mutex                  tunerLock;
+
+            // Our smoothed cost per item, how long we'd like each chunk to take, and the number of measurements so far.
+            double                 costPerItemNS;
+            long long int          targetNS;
+            unsigned long long int numSamples;
+
+            // The smallest and largest chunks we'll choose.
+            size_t                 minChunk;
+            size_t                 maxChunk;
+
+        public:
+            // Constructor.
+            inline QueueGrainTuner(unsigned int targetUS = QUEUE_GRAIN_TARGET_US, size_t newMinChunk = QUEUE_GRAIN_MIN_CHUNK, size_t newMaxChunk = QUEUE_GRAIN_MAX_CHUNK) {
+                this->costPerItemNS = 0.0;
+                this->targetNS      = (((long long int) targetUS) * 1000);
+                this->numSamples    = 0;
+                this->minChunk      = max((size_t) 1, newMinChunk);
+                this->maxChunk      = max(this->minChunk, newMaxChunk);
+            };
+
+            // Returns the CPU time the calling thread has used, in nanoseconds. Time chunks with this rather than the clock
+            // on the wall, so a chunk whose thread was preempted partway through doesn't look more expensive than it was.
+            static inline long long int threadCPUNS() {
+                struct timespec cpuTime;
+                clock_gettime(CLOCK_THREAD_CPUTIME_ID, &cpuTime);
+                return((((long long int) cpuTime.tv_sec) * 1000000000LL) + ((long long int) cpuTime.tv_nsec));
+            };
+
+            // Records that a chunk of numItems took elapsedNS to run.
+            inline void record(size_t numItems, long long int elapsedNS) {
+                if ((numItems == 0) || (elapsedNS < 0)) {
+                    return;
+                }
+                double sampleNS = (((double) elapsedNS) / ((double) numItems));
+                lock_guard<mutex> tempLock(this->tunerLock);
+                if (this->numSamples == 0) {
+                    this->costPerItemNS = sampleNS;
+                } else {
+                    sampleNS = min(sampleNS, (this->costPerItemNS * QUEUE_GRAIN_MAX_SAMPLE_RATIO));
+                    this->costPerItemNS += (QUEUE_GRAIN_SMOOTHING * (sampleNS - this->costPerItemNS));
+                }
+                this->numSamples++;
+            };
+
+            // Returns how many items the next chunk should hold. Our smallest chunk until we've measured anything.
+            inline size_t getChunkSize() {
+                lock_guard<mutex> tempLock(this->tunerLock);
+                if (this->numSamples == 0) {
+                    return(this->minChunk);
+                }
+                double chunkSize = (((double) this->targetNS) / max(this->costPerItemNS, 1.0));
+                return(min(this->maxChunk, max(this->minChunk, (size_t) chunkSize)));
+            };
+
+            // Sets how long we'd like each chunk to take.
+            inline void setTarget(unsigned int targetUS) {
+                lock_guard<mutex> tempLock(this->tunerLock);
+                this->targetNS = (((long long int) targetUS) * 1000);
+            };
+
+            // Returns how long we'd like each chunk to take.
+            inline unsigned int getTargetUS() {
+                lock_guard<mutex> tempLock(this->tunerLock);
+                return((unsigned int) (this->targetNS / 1000));
+            };
+
+            // Returns our smoothed cost per item, in nanoseconds (0 until we've measured anything).
+            inline double getCostPerItemNS() {
+                lock_guard<mutex> tempLock(this->tunerLock);
+                return(this->costPerItemNS);
+            };
+
+            // Returns the number of chunks we've measured.
+            inline unsigned long long int getNumSamples() {
+                lock_guard<mutex> tempLock(this->tunerLock);
+                return(this->numSamples);
+            };
+
+            // Forgets everything we've measured.
+            inline void reset() {
+                lock_guard<mutex> tempLock(this->tunerLock);
+                this->costPerItemNS = 0.0;
+                this->numSamples    = 0;
+            };
+    };
+};
+
+#endif // __QUEUE_GRAIN_H__
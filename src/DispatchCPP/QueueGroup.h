@@ -0,0 +1,163 @@
+#ifndef __QUEUE_GROUP_H__
+#define __QUEUE_GROUP_H__
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// This header file uses the standard namespace.
+using namespace std;
+
+// Declare the QueueGroup within our DispatchCPP namespace.
+namespace DispatchCPP {
+    // Tracks a set of dispatched work, across any number of Queues. Work is added to the group when it's dispatched
+    // (or by calling enter() and leave() around anything else), and the group drains once all of it has finished.
+    // Callers can block on the group with wait() or waitFor(), or have notify() dispatch a callback onto a Queue once it
+    // drains, without blocking any thread at all. Copies of a group share the same state, and queued work keeps that
+    // state alive. A drained group can be reused.
+    class QueueGroup {
+        private:
+            // The state shared by every copy of a group, and by all the work dispatched with it.
+            typedef struct __QUEUE_GROUP_STATE__ {
+                atomic<unsigned int>             numPending;
+                mutex                            drainLock;
+                condition_variable               drainVar;
+                vector<function<void()>>         allNotifications;
+            } QueueGroupState;
+
+            // Our shared state.
+            shared_ptr<QueueGroupState> pState;
+
+            // Called once the group has drained: wakes all our waiters, and dispatches our notifications.
+            static inline void drained(QueueGroupState * pDrainedState) {
+                vector<function<void()>> allNotifications = vector<function<void()>>();
+                pDrainedState->drainLock.lock();
+                if (pDrainedState->numPending.load(memory_order_acquire) == 0) {
+                    allNotifications.swap(pDrainedState->allNotifications);
+                }
+                pDrainedState->drainVar.notify_all();
+                pDrainedState->drainLock.unlock();
+                for (unsigned int index = 0; index < ((unsigned int) allNotifications.size()); ++index) {
+                    allNotifications[index]();
+                }
+            };
+
+            // Takes a piece of work out of the group, draining it if that was the last.
+            static inline void leaveState(QueueGroupState * pLeavingState) {
+                if (pLeavingState->numPending.fetch_sub(1, memory_order_acq_rel) == 1) {
+                    QueueGroup::drained(pLeavingState);
+                }
+            };
+
+            // Leaves the group on behalf of a piece of wrapped work, exactly once: when the work finishes, or when it's
+            // destroyed without ever having run (thrown away by a Queue being destroyed, say), so the group still drains.
+            class QueueGroupLeaveGuard {
+                private:
+                    shared_ptr<QueueGroupState> pState;
+                    bool                        hasLeft;
+
+                public:
+                    // Constructor.
+                    inline QueueGroupLeaveGuard(shared_ptr<QueueGroupState> pNewState) {
+                        this->pState  = pNewState;
+                        this->hasLeft = false;
+                    };
+
+                    // Destructor.
+                    inline ~QueueGroupLeaveGuard() {
+                        this->leave();
+                    };
+
+                    // Guards can't be copied, since only one may leave.
+                    QueueGroupLeaveGuard(const QueueGroupLeaveGuard &) = delete;
+                    QueueGroupLeaveGuard & operator=(const QueueGroupLeaveGuard &) = delete;
+
+                    // Leaves the group, unless we already have.
+                    inline void leave() {
+                        if (!this->hasLeft) {
+                            this->hasLeft = true;
+                            QueueGroup::leaveState(this->pState.get());
+                        }
+                    };
+            };
+
+        public:
+            // Constructor.
+            inline QueueGroup() {
+                // Initialize our class members.
+                this->pState = make_shared<QueueGroupState>();
+                this->pState->numPending = 0;
+            };
+
+            // Adds a piece of work to the group, by hand. Must be balanced by a call to leave().
+            inline void enter() const {
+                this->pState->numPending.fetch_add(1, memory_order_relaxed);
+            };
+
+            // Marks a piece of work added with enter() as finished.
+            inline void leave() const {
+                QueueGroup::leaveState(this->pState.get());
+            };
+
+            // Adds work to the group, wrapping it so it leaves the group once it's finished, or once it's thrown away
+            // without running.
+            template <typename WorkFunc>
+            inline function<void()> wrap(WorkFunc newWork) const {
+                this->enter();
+                shared_ptr<QueueGroupLeaveGuard> pGuard = make_shared<QueueGroupLeaveGuard>(this->pState);
+                return([pGuard, newWork](void) {
+                    newWork();
+                    pGuard->leave();
+                });
+            };
+
+            // Blocks until the group drains.
+            inline void wait() const {
+                unique_lock<mutex> tempLock(this->pState->drainLock);
+                this->pState->drainVar.wait(tempLock, [this]() {
+                    return(this->pState->numPending.load(memory_order_acquire) == 0);
+                });
+            };
+
+            // Blocks until the group drains, or the timeout passes. Returns whether the group drained.
+            inline bool waitFor(chrono::microseconds timeout) const {
+                unique_lock<mutex> tempLock(this->pState->drainLock);
+                return(this->pState->drainVar.wait_for(tempLock, timeout, [this]() {
+                    return(this->pState->numPending.load(memory_order_acquire) == 0);
+                }));
+            };
+
+            // Dispatches the callback onto pQueue once the group drains (right away, if it already has). Each call
+            // fires once.
+            template <class QueueType>
+            inline void notify(QueueType * pQueue, function<void()> callback) const {
+                function<void()> notification = [pQueue, callback](void) {
+                    pQueue->dispatchFunction(callback);
+                };
+
+                // Has the group already drained? If not, we'll be dispatched once it does.
+                this->pState->drainLock.lock();
+                if (this->pState->numPending.load(memory_order_acquire) > 0) {
+                    this->pState->allNotifications.push_back(move(notification));
+                    this->pState->drainLock.unlock();
+                    return;
+                }
+                this->pState->drainLock.unlock();
+                notification();
+            };
+
+            // Returns the number of pieces of work in the group which haven't finished yet.
+            inline unsigned int numPending() const {
+                return(this->pState->numPending.load(memory_order_acquire));
+            };
+    };
+};
+
+#endif // __QUEUE_GROUP_H__
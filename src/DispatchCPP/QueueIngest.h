@@ -0,0 +1,130 @@
+#ifndef __QUEUE_INGEST_H__
+#define __QUEUE_INGEST_H__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <string>
+#include <string_view>
+
+// The size of each chunk dispatched by default. Big enough that dispatching is free next to reading, small enough
+// that every thread gets plenty of chunks.
+#define QUEUE_INGEST_DEFAULT_CHUNK_SIZE (4 * 1024 * 1024)
+
+// This header file uses the standard namespace.
+using namespace std;
+
+// Declare the QueueIngest within our DispatchCPP namespace.
+namespace DispatchCPP {
+    // A file mapped into memory, split into chunks of whole records, for Queues to work through in parallel. Chunks
+    // are views into the mapping, so records are never copied. Each chunk only knows its nominal byte range up front:
+    // it's aligned to the records it holds (by scanning for the delimiter at each end) when it's fetched, so the
+    // splitting happens on whichever threads run the chunks, not the one dispatching them. A record belongs to the
+    // chunk its first byte falls within.
+    class QueueIngest {
+        private:
+            // Our mapping, and its size.
+            const char * pData;
+            size_t       dataSize;
+
+            // The size of each chunk, and the delimiter between records.
+            size_t chunkSize;
+            char   delimiter;
+
+            // Returns where the first record starting at or after the position begins.
+            inline size_t findRecordStart(size_t position) const {
+                if (position == 0) {
+                    return(0);
+                }
+                if (position >= this->dataSize) {
+                    return(this->dataSize);
+                }
+                const char * pDelimiter = (const char *) memchr(this->pData + position - 1, this->delimiter, this->dataSize - position + 1);
+                return((pDelimiter != nullptr) ? ((size_t) (pDelimiter - this->pData) + 1) : this->dataSize);
+            };
+
+        public:
+            // Constructor. Maps the file in, hinting that it'll be read sequentially. Check isOpen() afterwards.
+            inline QueueIngest(string filePath, size_t newChunkSize = QUEUE_INGEST_DEFAULT_CHUNK_SIZE, char newDelimiter = '\n') {
+                // Initialize our class members.
+                this->pData     = nullptr;
+                this->dataSize  = 0;
+                this->chunkSize = ((newChunkSize > 0) ? newChunkSize : QUEUE_INGEST_DEFAULT_CHUNK_SIZE);
+                this->delimiter = newDelimiter;
+
+                // Map the file in. We don't need the descriptor once it's mapped.
+                int fileFD = open(filePath.c_str(), O_RDONLY);
+                if (fileFD < 0) {
+                    return;
+                }
+                struct stat fileStat;
+                if ((fstat(fileFD, &fileStat) == 0) && (fileStat.st_size > 0)) {
+                    void * pMap = mmap(NULL, (size_t) fileStat.st_size, PROT_READ, MAP_PRIVATE, fileFD, 0);
+                    if (pMap != MAP_FAILED) {
+                        madvise(pMap, (size_t) fileStat.st_size, MADV_SEQUENTIAL);
+                        this->pData    = (const char *) pMap;
+                        this->dataSize = (size_t) fileStat.st_size;
+                    }
+                }
+                close(fileFD);
+            };
+
+            // Destructor. Every chunk's view is invalid once we're gone.
+            inline ~QueueIngest() {
+                if (this->pData != nullptr) {
+                    munmap((void *) this->pData, this->dataSize);
+                }
+            };
+
+            // A mapping can't be shared by two owners.
+            QueueIngest(const QueueIngest &) = delete;
+            QueueIngest & operator=(const QueueIngest &) = delete;
+
+            // Returns whether the file was mapped. Empty files never are.
+            inline bool isOpen() const {
+                return(this->pData != nullptr);
+            };
+
+            // Returns the size of the file.
+            inline size_t getSize() const {
+                return(this->dataSize);
+            };
+
+            // Returns the number of chunks the file is split into.
+            inline size_t getNumChunks() const {
+                return((this->dataSize + this->chunkSize - 1) / this->chunkSize);
+            };
+
+            // Returns the whole records within a chunk, aligning it on the calling thread. Empty if a single record
+            // spans the whole chunk (that record belongs to an earlier chunk).
+            inline string_view getChunk(size_t chunkIndex) const {
+                size_t chunkStart = this->findRecordStart(chunkIndex * this->chunkSize);
+                size_t chunkEnd   = this->findRecordStart((chunkIndex + 1) * this->chunkSize);
+                if (chunkStart >= chunkEnd) {
+                    return(string_view());
+                }
+                return(string_view(this->pData + chunkStart, chunkEnd - chunkStart));
+            };
+
+            // Calls the function with each record in the chunk, without its delimiter.
+            template <typename RecordFunc>
+            static inline void forEachRecord(string_view chunk, RecordFunc recordFunc, char delimiter = '\n') {
+                while (chunk.size() > 0) {
+                    size_t delimiterIndex = chunk.find(delimiter);
+                    if (delimiterIndex == string_view::npos) {
+                        recordFunc(chunk);
+                        return;
+                    }
+                    recordFunc(chunk.substr(0, delimiterIndex));
+                    chunk.remove_prefix(delimiterIndex + 1);
+                }
+            };
+    };
+};
+
+#endif // __QUEUE_INGEST_H__
@@ -0,0 +1,129 @@
+#ifndef __QUEUE_LIMITER_H__
+#define __QUEUE_LIMITER_H__
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <chrono>
+
+// Threads held back by the rate limit always wake a little late. So that lateness doesn't eat into the rate, a bucket
+// which has been holding work back keeps up to this much extra time's worth of tokens when it refills.
+#define QUEUE_LIMITER_LATENESS_ALLOWANCE_US     2000
+
+// This header file uses the standard namespace.
+using namespace std;
+
+// Declare the QueueLimiter within our DispatchCPP namespace.
+namespace DispatchCPP {
+    // Decides when a Queue's threads may start their next piece of work: a token bucket caps the rate work starts at,
+    // and a counter caps how much runs at once. It isn't thread safe by itself; every call is made while holding the
+    // Queue's work lock, and the Queue's threads wait on the Queue's condition variable while they're held back.
+    class QueueLimiter {
+        private:
+            // Our token bucket: how fast it refills (tokens per second, 0 when not rate limiting), how many tokens it
+            // can hold, how many it holds right now, and when we last refilled it.
+            double        tokensPerSecond;
+            double        maxTokens;
+            double        numTokens;
+            long long int lastRefillNS;
+            bool          isHoldingBack;
+
+            // The most work allowed to run at once (0 when not capped), and how much is running right now.
+            unsigned int maxInFlight;
+            unsigned int numInFlight;
+
+            // Returns the current time, in steady_clock nanoseconds.
+            static inline long long int nowNS() {
+                return((long long int) chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count());
+            };
+
+        public:
+            // Constructor.
+            inline QueueLimiter() {
+                this->tokensPerSecond = 0.0;
+                this->maxTokens       = 0.0;
+                this->numTokens       = 0.0;
+                this->lastRefillNS    = 0;
+                this->isHoldingBack   = false;
+                this->maxInFlight     = 0;
+                this->numInFlight     = 0;
+            };
+
+            // Limits work to starting at most tokensPerSecond times a second, allowing bursts of up to burstSize. A rate
+            // of 0 turns rate limiting off. The bucket starts out full.
+            inline void setRateLimit(double newTokensPerSecond, double burstSize) {
+                this->tokensPerSecond = max(newTokensPerSecond, 0.0);
+                this->maxTokens       = max(burstSize, 1.0);
+                this->numTokens       = this->maxTokens;
+                this->lastRefillNS    = nowNS();
+                this->isHoldingBack   = false;
+            };
+
+            // Takes on another limiter's rate limit (with a full bucket) and cap, but not the work it's let through.
+            inline void copySettings(const QueueLimiter & other) {
+                this->tokensPerSecond = other.tokensPerSecond;
+                this->maxTokens       = other.maxTokens;
+                this->numTokens       = other.maxTokens;
+                this->lastRefillNS    = nowNS();
+                this->isHoldingBack   = false;
+                this->maxInFlight     = other.maxInFlight;
+            };
+
+            // Limits work to at most newMaxInFlight running at once. 0 turns the cap off.
+            inline void setMaxInFlight(unsigned int newMaxInFlight) {
+                this->maxInFlight = newMaxInFlight;
+            };
+
+            // Returns whether we're limiting anything at all.
+            inline bool isEnabled() {
+                return((this->tokensPerSecond > 0.0) || (this->maxInFlight > 0));
+            };
+
+            // Tries to let a piece of work start. If it can't start yet, returns false, setting waitNS to how long until
+            // it could (or to 0 if it has to wait for running work to finish instead).
+            inline bool tryAcquire(long long int & waitNS) {
+                waitNS = 0;
+
+                // Are we already running as much as we're allowed to?
+                if ((this->maxInFlight > 0) && (this->numInFlight >= this->maxInFlight)) {
+                    return(false);
+                }
+
+                // Refill our bucket, and see whether there's a token in it.
+                if (this->tokensPerSecond > 0.0) {
+                    long long int currentNS   = nowNS();
+                    double        bucketSize  = this->maxTokens;
+                    if (this->isHoldingBack) {
+                        bucketSize += ((((double) QUEUE_LIMITER_LATENESS_ALLOWANCE_US) / 1000000.0) * this->tokensPerSecond);
+                    }
+                    this->numTokens    = min(bucketSize, this->numTokens + ((((double) (currentNS - this->lastRefillNS)) / 1000000000.0) * this->tokensPerSecond));
+                    this->lastRefillNS = currentNS;
+                    if (this->numTokens < 1.0) {
+                        this->isHoldingBack = true;
+                        waitNS = max((long long int) (((1.0 - this->numTokens) / this->tokensPerSecond) * 1000000000.0), 1LL);
+                        return(false);
+                    }
+                    this->numTokens    -= 1.0;
+                    this->isHoldingBack = (this->numTokens < 1.0);
+                }
+
+                this->numInFlight++;
+                return(true);
+            };
+
+            // Marks a piece of work let through by tryAcquire() as finished.
+            inline void release() {
+                if (this->numInFlight > 0) {
+                    this->numInFlight--;
+                }
+            };
+
+            // Returns how much work let through by tryAcquire() is still running.
+            inline unsigned int getNumInFlight() {
+                return(this->numInFlight);
+            };
+    };
+};
+
+#endif // __QUEUE_LIMITER_H__
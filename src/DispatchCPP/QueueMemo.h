@@ -0,0 +1,237 @@
+#ifndef __QUEUE_MEMO_H__
+#define __QUEUE_MEMO_H__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+// The number of shards a memo cache is split into, each with its own lock.
+#define QUEUE_MEMO_NUM_SHARDS           16
+
+// The number of results a memo cache holds by default.
+#define QUEUE_MEMO_DEFAULT_MAX_ENTRIES  4096
+
+// This header file uses the standard namespace.
+using namespace std;
+
+// A snapshot of how a memo cache has been doing.
+typedef struct __QUEUE_MEMO_STATS__ {
+    unsigned long long int numHits;         // Results found in the cache.
+    unsigned long long int numAttached;     // Results another thread was already computing, which we waited on.
+    unsigned long long int numMisses;       // Results we had to compute.
+    unsigned long long int numEvictions;    // Results thrown out to make room.
+    unsigned long long int computeNS;       // The total CPU time spent computing results.
+} QueueMemoStats;
+
+// Declare the QueueMemoCache within our DispatchCPP namespace.
+namespace DispatchCPP {
+    // A bounded cache of results by their arguments, for functions which always give the same result for the same
+    // arguments. It's split into shards by the arguments' hash, each with its own lock, and each evicting with CLOCK
+    // (a result gets a second chance if it's been used since the hand last passed it). When several threads want the
+    // same missing result at once, only the first computes it, and the rest wait for (and share) its result.
+    template <typename R, typename ...Args> class QueueMemoCache {
+        private:
+            // A cached result, along with its arguments (to rule out hash collisions) and whether it's been used since
+            // the clock hand last passed it.
+            typedef struct __QUEUE_MEMO_ENTRY__ {
+                size_t         keyHash;
+                tuple<Args...> key;
+                R              result;
+                bool           isReferenced;
+            } QueueMemoEntry;
+
+            // A result being computed, which other threads can wait on. If computing it threw, pError holds what was thrown.
+            typedef struct __QUEUE_MEMO_FLIGHT__ {
+                tuple<Args...>     key;
+                optional<R>        result;
+                exception_ptr      pError;
+                bool               isDone;
+                condition_variable doneVar;
+            } QueueMemoFlight;
+
+            // A shard: its entries, where each entry lives by hash, where the clock hand is, and the results in flight.
+            typedef struct __QUEUE_MEMO_SHARD__ {
+                mutex                                       shardLock;
+                vector<QueueMemoEntry>                      allEntries;
+                unordered_map<size_t, size_t>               entryIndices;
+                size_t                                      clockHand;
+                unordered_map<size_t, shared_ptr<QueueMemoFlight>> allFlights;
+            } QueueMemoShard;
+
+            // Our shards, and the most entries each one holds.
+            unique_ptr<QueueMemoShard[]> allShards;
+            size_t                       maxShardEntries;
+
+            // Our stats.
+            atomic<unsigned long long int> numHits;
+            atomic<unsigned long long int> numAttached;
+            atomic<unsigned long long int> numMisses;
+            atomic<unsigned long long int> numEvictions;
+            atomic<unsigned long long int> computeNS;
+
+            // Returns the CPU time the calling thread has used, in nanoseconds.
+            static inline unsigned long long int threadCPUNS() {
+                struct timespec cpuTime;
+                clock_gettime(CLOCK_THREAD_CPUTIME_ID, &cpuTime);
+                return((((unsigned long long int) cpuTime.tv_sec) * 1000000000ULL) + ((unsigned long long int) cpuTime.tv_nsec));
+            };
+
+            // Hashes a set of arguments.
+            static inline size_t hashKey(const tuple<Args...> & key) {
+                size_t keyHash = 14695981039346656037ULL;
+                apply([&keyHash](const Args &... args) {
+                    ((keyHash = ((keyHash ^ hash<Args>()(args)) * 1099511628211ULL)), ...);
+                }, key);
+                return(keyHash ^ (keyHash >> 29));
+            };
+
+            // Stores a result in its shard, evicting with CLOCK once it's full. The caller must hold the shard's lock.
+            inline void store(QueueMemoShard & shard, size_t keyHash, const tuple<Args...> & key, const R & result) {
+                // Is there already an entry with this hash (a collision)? Then replace it.
+                auto existingIndex = shard.entryIndices.find(keyHash);
+                if (existingIndex != shard.entryIndices.end()) {
+                    QueueMemoEntry & existingEntry = shard.allEntries[existingIndex->second];
+                    existingEntry.key          = key;
+                    existingEntry.result       = result;
+                    existingEntry.isReferenced = true;
+                    return;
+                }
+
+                // Is there still room? Then it's simply added.
+                if (shard.allEntries.size() < this->maxShardEntries) {
+                    shard.entryIndices[keyHash] = shard.allEntries.size();
+                    shard.allEntries.push_back({ keyHash, key, result, false });
+                    return;
+                }
+
+                // Sweep the hand around, clearing references, until it finds an entry which hasn't been used.
+                while (shard.allEntries[shard.clockHand].isReferenced) {
+                    shard.allEntries[shard.clockHand].isReferenced = false;
+                    shard.clockHand = ((shard.clockHand + 1) % shard.allEntries.size());
+                }
+                QueueMemoEntry & victimEntry = shard.allEntries[shard.clockHand];
+                shard.entryIndices.erase(victimEntry.keyHash);
+                shard.entryIndices[keyHash] = shard.clockHand;
+                victimEntry.keyHash      = keyHash;
+                victimEntry.key          = key;
+                victimEntry.result       = result;
+                victimEntry.isReferenced = false;
+                shard.clockHand = ((shard.clockHand + 1) % shard.allEntries.size());
+                this->numEvictions.fetch_add(1, memory_order_relaxed);
+            };
+
+        public:
+            // Constructor.
+            inline QueueMemoCache(size_t maxEntries = QUEUE_MEMO_DEFAULT_MAX_ENTRIES) {
+                // Initialize our class members.
+                this->allShards       = unique_ptr<QueueMemoShard[]>(new QueueMemoShard[QUEUE_MEMO_NUM_SHARDS]);
+                this->maxShardEntries = max((size_t) 1, (maxEntries + QUEUE_MEMO_NUM_SHARDS - 1) / QUEUE_MEMO_NUM_SHARDS);
+                for (unsigned int shardIndex = 0; shardIndex < QUEUE_MEMO_NUM_SHARDS; ++shardIndex) {
+                    this->allShards[shardIndex].clockHand = 0;
+                    this->allShards[shardIndex].allEntries.reserve(this->maxShardEntries);
+                }
+                this->numHits      = 0;
+                this->numAttached  = 0;
+                this->numMisses    = 0;
+                this->numEvictions = 0;
+                this->computeNS    = 0;
+            };
+
+            // Returns the cached result for the arguments, computing it (once, no matter how many threads ask at the
+            // same time) if it isn't cached. If computing it throws, nothing is cached, and the exception is rethrown to
+            // the thread computing it and every thread waiting on it.
+            template <typename ComputeFunc>
+            inline R getOrCompute(const tuple<Args...> & key, ComputeFunc computeFunc) {
+                size_t           keyHash = QueueMemoCache::hashKey(key);
+                QueueMemoShard & shard   = this->allShards[(keyHash >> 7) % QUEUE_MEMO_NUM_SHARDS];
+                unique_lock<mutex> tempLock(shard.shardLock);
+
+                // Is it cached?
+                auto existingIndex = shard.entryIndices.find(keyHash);
+                if ((existingIndex != shard.entryIndices.end()) && (shard.allEntries[existingIndex->second].key == key)) {
+                    QueueMemoEntry & existingEntry = shard.allEntries[existingIndex->second];
+                    existingEntry.isReferenced = true;
+                    this->numHits.fetch_add(1, memory_order_relaxed);
+                    return(existingEntry.result);
+                }
+
+                // Is someone already computing it? Then wait for their result.
+                auto existingFlight = shard.allFlights.find(keyHash);
+                if ((existingFlight != shard.allFlights.end()) && (existingFlight->second->key == key)) {
+                    shared_ptr<QueueMemoFlight> pFlight = existingFlight->second;
+                    pFlight->doneVar.wait(tempLock, [pFlight]() {
+                        return(pFlight->isDone);
+                    });
+                    this->numAttached.fetch_add(1, memory_order_relaxed);
+                    if (pFlight->pError != nullptr) {
+                        rethrow_exception(pFlight->pError);
+                    }
+                    return(*pFlight->result);
+                }
+
+                // No, so we compute it, without holding the lock.
+                shared_ptr<QueueMemoFlight> pFlight = make_shared<QueueMemoFlight>();
+                pFlight->key    = key;
+                pFlight->isDone = false;
+                bool isFlightTracked = (existingFlight == shard.allFlights.end());
+                if (isFlightTracked) {
+                    shard.allFlights[keyHash] = pFlight;
+                }
+                tempLock.unlock();
+                unsigned long long int beforeCompute = QueueMemoCache::threadCPUNS();
+                optional<R>            result;
+                try {
+                    result.emplace(computeFunc());
+                } catch (...) {
+                    // Let anyone waiting on us know it failed, so they aren't left waiting forever.
+                    tempLock.lock();
+                    if (isFlightTracked) {
+                        pFlight->pError = current_exception();
+                        pFlight->isDone = true;
+                        shard.allFlights.erase(keyHash);
+                    }
+                    tempLock.unlock();
+                    pFlight->doneVar.notify_all();
+                    throw;
+                }
+                this->computeNS.fetch_add(QueueMemoCache::threadCPUNS() - beforeCompute, memory_order_relaxed);
+                this->numMisses.fetch_add(1, memory_order_relaxed);
+
+                // Cache it, and hand it to anyone waiting on us.
+                tempLock.lock();
+                this->store(shard, keyHash, key, *result);
+                if (isFlightTracked) {
+                    pFlight->result = result;
+                    pFlight->isDone = true;
+                    shard.allFlights.erase(keyHash);
+                }
+                tempLock.unlock();
+                pFlight->doneVar.notify_all();
+                return(*result);
+            };
+
+            // Returns a snapshot of our stats.
+            inline QueueMemoStats getStats() {
+                QueueMemoStats stats;
+                stats.numHits      = this->numHits.load(memory_order_relaxed);
+                stats.numAttached  = this->numAttached.load(memory_order_relaxed);
+                stats.numMisses    = this->numMisses.load(memory_order_relaxed);
+                stats.numEvictions = this->numEvictions.load(memory_order_relaxed);
+                stats.computeNS    = this->computeNS.load(memory_order_relaxed);
+                return(stats);
+            };
+    };
+};
+
+#endif // __QUEUE_MEMO_H__
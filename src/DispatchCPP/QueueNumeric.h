@@ -0,0 +1,548 @@
+#ifndef __QUEUE_NUMERIC_H__
+#define __QUEUE_NUMERIC_H__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <limits>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define QUEUE_NUMERIC_ENABLE_X86
+#endif // __x86_64__ || __i386__
+
+#include "Queue.h"
+#include "QueueParallel.h"
+
+// The number of doubles in each cache block the parallel kernels hand out. Workers claim whole blocks at a time, and
+// partial results are combined in block order, so results don't change with the number of threads. 32K doubles (256KB)
+// keeps each block within a typical L2 cache.
+#define NUMERIC_BLOCK_SIZE              32768
+
+// The number of tasks dispatched per thread. Tasks claim blocks dynamically, so this only needs to cover stragglers.
+#define NUMERIC_TASKS_PER_THREAD        2
+
+// This header file uses the standard namespace.
+using namespace std;
+
+// The instruction sets the numeric kernels can use.
+typedef enum {
+    NumericISAScalar = 0,
+    NumericISASSE2,
+    NumericISAAVX2,
+    NumericISACount
+} NumericISA;
+
+// Declare our numeric kernels within our DispatchCPP namespace. Each comes in three flavours (scalar, SSE2 and
+// AVX2/FMA); the best one the CPU supports is picked at runtime, and can be overridden with numericSetISA().
+namespace DispatchCPP {
+    // Returns the best instruction set this CPU supports.
+    inline NumericISA numericDetectISA() {
+#ifdef QUEUE_NUMERIC_ENABLE_X86
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+            return(NumericISAAVX2);
+        }
+        if (__builtin_cpu_supports("sse2")) {
+            return(NumericISASSE2);
+        }
+#endif // QUEUE_NUMERIC_ENABLE_X86
+        return(NumericISAScalar);
+    };
+
+    // The instruction set the kernels are currently using.
+    inline atomic<int> & numericCurrentISA() {
+        static atomic<int> currentISA((int) numericDetectISA());
+        return(currentISA);
+    };
+
+    // Returns the instruction set the kernels are currently using.
+    inline NumericISA numericGetISA() {
+        return((NumericISA) numericCurrentISA().load(memory_order_relaxed));
+    };
+
+    // Forces the kernels onto a given instruction set, as long as the CPU supports it. Returns the one now in use.
+    inline NumericISA numericSetISA(NumericISA newISA) {
+        NumericISA bestISA = numericDetectISA();
+        numericCurrentISA().store((int) ((newISA < bestISA) ? newISA : bestISA), memory_order_relaxed);
+        return(numericGetISA());
+    };
+
+    // Returns a printable name for an instruction set.
+    inline const char * numericISAName(NumericISA isa) {
+        switch (isa) {
+            case NumericISASSE2: return("SSE2");
+            case NumericISAAVX2: return("AVX2");
+            default:             return("Scalar");
+        }
+    };
+
+    // =================================================================================================================
+    // Scalar kernels. Four independent accumulators each, so even these aren't bound by a single dependency chain.
+
+    inline double numericSumScalar(const double * pData, size_t numEntries) {
+        double sum0 = 0.0, sum1 = 0.0, sum2 = 0.0, sum3 = 0.0;
+        size_t index = 0;
+        for (; (index + 4) <= numEntries; index += 4) {
+            sum0 += pData[index];
+            sum1 += pData[index + 1];
+            sum2 += pData[index + 2];
+            sum3 += pData[index + 3];
+        }
+        for (; index < numEntries; ++index) {
+            sum0 += pData[index];
+        }
+        return((sum0 + sum1) + (sum2 + sum3));
+    };
+
+    inline double numericDotScalar(const double * pDataA, const double * pDataB, size_t numEntries) {
+        double sum0 = 0.0, sum1 = 0.0, sum2 = 0.0, sum3 = 0.0;
+        size_t index = 0;
+        for (; (index + 4) <= numEntries; index += 4) {
+            sum0 += (pDataA[index]     * pDataB[index]);
+            sum1 += (pDataA[index + 1] * pDataB[index + 1]);
+            sum2 += (pDataA[index + 2] * pDataB[index + 2]);
+            sum3 += (pDataA[index + 3] * pDataB[index + 3]);
+        }
+        for (; index < numEntries; ++index) {
+            sum0 += (pDataA[index] * pDataB[index]);
+        }
+        return((sum0 + sum1) + (sum2 + sum3));
+    };
+
+    // NaNs are skipped. With nothing else to go on, the min is +infinity and the max is -infinity.
+    inline void numericMinMaxScalar(const double * pData, size_t numEntries, double * pMin, double * pMax) {
+        double minValue = numeric_limits<double>::infinity(), maxValue = -numeric_limits<double>::infinity();
+        for (size_t index = 0; index < numEntries; ++index) {
+            minValue = ((pData[index] < minValue) ? pData[index] : minValue);
+            maxValue = ((pData[index] > maxValue) ? pData[index] : maxValue);
+        }
+        *pMin = minValue;
+        *pMax = maxValue;
+    };
+
+    // Entries at even indices are subtracted, and entries at odd indices are added.
+    inline double numericAlternatingSumScalar(const double * pData, size_t numEntries) {
+        double sumEven0 = 0.0, sumOdd0 = 0.0, sumEven1 = 0.0, sumOdd1 = 0.0;
+        size_t index = 0;
+        for (; (index + 4) <= numEntries; index += 4) {
+            sumEven0 += pData[index];
+            sumOdd0  += pData[index + 1];
+            sumEven1 += pData[index + 2];
+            sumOdd1  += pData[index + 3];
+        }
+        for (; index < numEntries; ++index) {
+            if (index % 2) {
+                sumOdd0 += pData[index];
+            } else {
+                sumEven0 += pData[index];
+            }
+        }
+        return((sumOdd0 + sumOdd1) - (sumEven0 + sumEven1));
+    };
+
+    // Values outside of [minValue, maxValue] (and NaNs) are counted in the spare bin, pBins[numBins]. maxValue itself
+    // lands in the last real bin.
+    inline void numericHistogramScalar(const double * pData, size_t numEntries, double minValue, double maxValue, size_t numBins, size_t * pBins) {
+        double binScale = (((double) numBins) / (maxValue - minValue));
+        for (size_t index = 0; index < numEntries; ++index) {
+            double value = pData[index];
+            if ((value >= minValue) && (value <= maxValue)) {
+                size_t binIndex = ((size_t) ((value - minValue) * binScale));
+                pBins[(binIndex < numBins) ? binIndex : (numBins - 1)] += 1;
+            } else {
+                pBins[numBins] += 1;
+            }
+        }
+    };
+
+#ifdef QUEUE_NUMERIC_ENABLE_X86
+    // =================================================================================================================
+    // SSE2 kernels. SSE2 is part of x86-64 itself, so these need no special target.
+
+    inline double numericSumSSE2(const double * pData, size_t numEntries) {
+        __m128d sum0 = _mm_setzero_pd(), sum1 = _mm_setzero_pd(), sum2 = _mm_setzero_pd(), sum3 = _mm_setzero_pd();
+        size_t  index = 0;
+        for (; (index + 8) <= numEntries; index += 8) {
+            sum0 = _mm_add_pd(sum0, _mm_loadu_pd(pData + index));
+            sum1 = _mm_add_pd(sum1, _mm_loadu_pd(pData + index + 2));
+            sum2 = _mm_add_pd(sum2, _mm_loadu_pd(pData + index + 4));
+            sum3 = _mm_add_pd(sum3, _mm_loadu_pd(pData + index + 6));
+        }
+        double lanes[2];
+        _mm_storeu_pd(lanes, _mm_add_pd(_mm_add_pd(sum0, sum1), _mm_add_pd(sum2, sum3)));
+        return(lanes[0] + lanes[1] + numericSumScalar(pData + index, numEntries - index));
+    };
+
+    inline double numericDotSSE2(const double * pDataA, const double * pDataB, size_t numEntries) {
+        __m128d sum0 = _mm_setzero_pd(), sum1 = _mm_setzero_pd(), sum2 = _mm_setzero_pd(), sum3 = _mm_setzero_pd();
+        size_t  index = 0;
+        for (; (index + 8) <= numEntries; index += 8) {
+            sum0 = _mm_add_pd(sum0, _mm_mul_pd(_mm_loadu_pd(pDataA + index),     _mm_loadu_pd(pDataB + index)));
+            sum1 = _mm_add_pd(sum1, _mm_mul_pd(_mm_loadu_pd(pDataA + index + 2), _mm_loadu_pd(pDataB + index + 2)));
+            sum2 = _mm_add_pd(sum2, _mm_mul_pd(_mm_loadu_pd(pDataA + index + 4), _mm_loadu_pd(pDataB + index + 4)));
+            sum3 = _mm_add_pd(sum3, _mm_mul_pd(_mm_loadu_pd(pDataA + index + 6), _mm_loadu_pd(pDataB + index + 6)));
+        }
+        double lanes[2];
+        _mm_storeu_pd(lanes, _mm_add_pd(_mm_add_pd(sum0, sum1), _mm_add_pd(sum2, sum3)));
+        return(lanes[0] + lanes[1] + numericDotScalar(pDataA + index, pDataB + index, numEntries - index));
+    };
+
+    inline void numericMinMaxSSE2(const double * pData, size_t numEntries, double * pMin, double * pMax) {
+        __m128d minValues = _mm_set1_pd(numeric_limits<double>::infinity());
+        __m128d maxValues = _mm_set1_pd(-numeric_limits<double>::infinity());
+        size_t  index     = 0;
+        for (; (index + 2) <= numEntries; index += 2) {
+            // minpd/maxpd return their second operand when either is a NaN, so keeping our running values second
+            // skips NaNs, just like the scalar kernel.
+            __m128d values = _mm_loadu_pd(pData + index);
+            minValues = _mm_min_pd(values, minValues);
+            maxValues = _mm_max_pd(values, maxValues);
+        }
+        double minLanes[2], maxLanes[2], tailMin, tailMax;
+        _mm_storeu_pd(minLanes, minValues);
+        _mm_storeu_pd(maxLanes, maxValues);
+        numericMinMaxScalar(pData + index, numEntries - index, &tailMin, &tailMax);
+        *pMin = min(min(minLanes[0], minLanes[1]), tailMin);
+        *pMax = max(max(maxLanes[0], maxLanes[1]), tailMax);
+    };
+
+    inline double numericAlternatingSumSSE2(const double * pData, size_t numEntries) {
+        // Flip the sign of every even lane. Each step covers an even number of entries, so lane parity never changes.
+        const __m128d signFlip = _mm_castsi128_pd(_mm_set_epi64x(0, (long long int) 0x8000000000000000ULL));
+        __m128d sum0  = _mm_setzero_pd(), sum1 = _mm_setzero_pd(), sum2 = _mm_setzero_pd(), sum3 = _mm_setzero_pd();
+        size_t  index = 0;
+        for (; (index + 8) <= numEntries; index += 8) {
+            sum0 = _mm_add_pd(sum0, _mm_xor_pd(_mm_loadu_pd(pData + index),     signFlip));
+            sum1 = _mm_add_pd(sum1, _mm_xor_pd(_mm_loadu_pd(pData + index + 2), signFlip));
+            sum2 = _mm_add_pd(sum2, _mm_xor_pd(_mm_loadu_pd(pData + index + 4), signFlip));
+            sum3 = _mm_add_pd(sum3, _mm_xor_pd(_mm_loadu_pd(pData + index + 6), signFlip));
+        }
+        double lanes[2];
+        _mm_storeu_pd(lanes, _mm_add_pd(_mm_add_pd(sum0, sum1), _mm_add_pd(sum2, sum3)));
+        return(lanes[0] + lanes[1] + numericAlternatingSumScalar(pData + index, numEntries - index));
+    };
+
+    inline void numericHistogramSSE2(const double * pData, size_t numEntries, double minValue, double maxValue, size_t numBins, size_t * pBins) {
+        // Work out two bin indices at a time, and drop anything out of range by sending it to a spare bin at the end.
+        const __m128d mins     = _mm_set1_pd(minValue);
+        const __m128d maxs     = _mm_set1_pd(maxValue);
+        const __m128d scale    = _mm_set1_pd(((double) numBins) / (maxValue - minValue));
+        const __m128d lastBin  = _mm_set1_pd((double) (numBins - 1));
+        const __m128d spareBin = _mm_set1_pd((double) numBins);
+        size_t        index    = 0;
+        for (; (index + 2) <= numEntries; index += 2) {
+            __m128d values  = _mm_loadu_pd(pData + index);
+            __m128d inRange = _mm_and_pd(_mm_cmpge_pd(values, mins), _mm_cmple_pd(values, maxs));
+            __m128d bins    = _mm_min_pd(_mm_mul_pd(_mm_sub_pd(values, mins), scale), lastBin);
+            bins = _mm_or_pd(_mm_and_pd(inRange, bins), _mm_andnot_pd(inRange, spareBin));
+            int binIndices[4];
+            _mm_storeu_si128((__m128i *) binIndices, _mm_cvttpd_epi32(bins));
+            pBins[binIndices[0]] += 1;
+            pBins[binIndices[1]] += 1;
+        }
+        numericHistogramScalar(pData + index, numEntries - index, minValue, maxValue, numBins, pBins);
+    };
+
+    // =================================================================================================================
+    // AVX2 kernels. These are compiled for AVX2 and FMA regardless of the build's own flags, and only ever called once
+    // we've checked the CPU supports both.
+
+    __attribute__((target("avx2,fma")))
+    inline double numericSumAVX2(const double * pData, size_t numEntries) {
+        __m256d sum0 = _mm256_setzero_pd(), sum1 = _mm256_setzero_pd(), sum2 = _mm256_setzero_pd(), sum3 = _mm256_setzero_pd();
+        size_t  index = 0;
+        for (; (index + 16) <= numEntries; index += 16) {
+            sum0 = _mm256_add_pd(sum0, _mm256_loadu_pd(pData + index));
+            sum1 = _mm256_add_pd(sum1, _mm256_loadu_pd(pData + index + 4));
+            sum2 = _mm256_add_pd(sum2, _mm256_loadu_pd(pData + index + 8));
+            sum3 = _mm256_add_pd(sum3, _mm256_loadu_pd(pData + index + 12));
+        }
+        double lanes[4];
+        _mm256_storeu_pd(lanes, _mm256_add_pd(_mm256_add_pd(sum0, sum1), _mm256_add_pd(sum2, sum3)));
+        return((lanes[0] + lanes[1]) + (lanes[2] + lanes[3]) + numericSumScalar(pData + index, numEntries - index));
+    };
+
+    __attribute__((target("avx2,fma")))
+    inline double numericDotAVX2(const double * pDataA, const double * pDataB, size_t numEntries) {
+        __m256d sum0 = _mm256_setzero_pd(), sum1 = _mm256_setzero_pd(), sum2 = _mm256_setzero_pd(), sum3 = _mm256_setzero_pd();
+        size_t  index = 0;
+        for (; (index + 16) <= numEntries; index += 16) {
+            sum0 = _mm256_fmadd_pd(_mm256_loadu_pd(pDataA + index),      _mm256_loadu_pd(pDataB + index),      sum0);
+            sum1 = _mm256_fmadd_pd(_mm256_loadu_pd(pDataA + index + 4),  _mm256_loadu_pd(pDataB + index + 4),  sum1);
+            sum2 = _mm256_fmadd_pd(_mm256_loadu_pd(pDataA + index + 8),  _mm256_loadu_pd(pDataB + index + 8),  sum2);
+            sum3 = _mm256_fmadd_pd(_mm256_loadu_pd(pDataA + index + 12), _mm256_loadu_pd(pDataB + index + 12), sum3);
+        }
+        double lanes[4];
+        _mm256_storeu_pd(lanes, _mm256_add_pd(_mm256_add_pd(sum0, sum1), _mm256_add_pd(sum2, sum3)));
+        return((lanes[0] + lanes[1]) + (lanes[2] + lanes[3]) + numericDotScalar(pDataA + index, pDataB + index, numEntries - index));
+    };
+
+    __attribute__((target("avx2,fma")))
+    inline void numericMinMaxAVX2(const double * pData, size_t numEntries, double * pMin, double * pMax) {
+        __m256d minValues0 = _mm256_set1_pd(numeric_limits<double>::infinity()), minValues1 = minValues0;
+        __m256d maxValues0 = _mm256_set1_pd(-numeric_limits<double>::infinity()), maxValues1 = maxValues0;
+        size_t  index      = 0;
+        for (; (index + 8) <= numEntries; index += 8) {
+            __m256d values0 = _mm256_loadu_pd(pData + index);
+            __m256d values1 = _mm256_loadu_pd(pData + index + 4);
+            minValues0 = _mm256_min_pd(values0, minValues0);
+            maxValues0 = _mm256_max_pd(values0, maxValues0);
+            minValues1 = _mm256_min_pd(values1, minValues1);
+            maxValues1 = _mm256_max_pd(values1, maxValues1);
+        }
+        double minLanes[4], maxLanes[4], tailMin, tailMax;
+        _mm256_storeu_pd(minLanes, _mm256_min_pd(minValues0, minValues1));
+        _mm256_storeu_pd(maxLanes, _mm256_max_pd(maxValues0, maxValues1));
+        numericMinMaxScalar(pData + index, numEntries - index, &tailMin, &tailMax);
+        *pMin = min(min(min(minLanes[0], minLanes[1]), min(minLanes[2], minLanes[3])), tailMin);
+        *pMax = max(max(max(maxLanes[0], maxLanes[1]), max(maxLanes[2], maxLanes[3])), tailMax);
+    };
+
+    __attribute__((target("avx2,fma")))
+    inline double numericAlternatingSumAVX2(const double * pData, size_t numEntries) {
+        // Flip the sign of every even lane. Each step covers an even number of entries, so lane parity never changes.
+        const __m256d signFlip = _mm256_castsi256_pd(_mm256_set_epi64x(0, (long long int) 0x8000000000000000ULL, 0, (long long int) 0x8000000000000000ULL));
+        __m256d sum0  = _mm256_setzero_pd(), sum1 = _mm256_setzero_pd(), sum2 = _mm256_setzero_pd(), sum3 = _mm256_setzero_pd();
+        size_t  index = 0;
+        for (; (index + 16) <= numEntries; index += 16) {
+            sum0 = _mm256_add_pd(sum0, _mm256_xor_pd(_mm256_loadu_pd(pData + index),      signFlip));
+            sum1 = _mm256_add_pd(sum1, _mm256_xor_pd(_mm256_loadu_pd(pData + index + 4),  signFlip));
+            sum2 = _mm256_add_pd(sum2, _mm256_xor_pd(_mm256_loadu_pd(pData + index + 8),  signFlip));
+            sum3 = _mm256_add_pd(sum3, _mm256_xor_pd(_mm256_loadu_pd(pData + index + 12), signFlip));
+        }
+        double lanes[4];
+        _mm256_storeu_pd(lanes, _mm256_add_pd(_mm256_add_pd(sum0, sum1), _mm256_add_pd(sum2, sum3)));
+        return((lanes[0] + lanes[1]) + (lanes[2] + lanes[3]) + numericAlternatingSumScalar(pData + index, numEntries - index));
+    };
+
+    __attribute__((target("avx2,fma")))
+    inline void numericHistogramAVX2(const double * pData, size_t numEntries, double minValue, double maxValue, size_t numBins, size_t * pBins) {
+        // Work out four bin indices at a time, and drop anything out of range by sending it to a spare bin at the end.
+        const __m256d mins     = _mm256_set1_pd(minValue);
+        const __m256d maxs     = _mm256_set1_pd(maxValue);
+        const __m256d scale    = _mm256_set1_pd(((double) numBins) / (maxValue - minValue));
+        const __m256d lastBin  = _mm256_set1_pd((double) (numBins - 1));
+        const __m256d spareBin = _mm256_set1_pd((double) numBins);
+        size_t        index    = 0;
+        for (; (index + 4) <= numEntries; index += 4) {
+            __m256d values  = _mm256_loadu_pd(pData + index);
+            __m256d inRange = _mm256_and_pd(_mm256_cmp_pd(values, mins, _CMP_GE_OQ), _mm256_cmp_pd(values, maxs, _CMP_LE_OQ));
+            __m256d bins    = _mm256_min_pd(_mm256_mul_pd(_mm256_sub_pd(values, mins), scale), lastBin);
+            bins = _mm256_blendv_pd(spareBin, bins, inRange);
+            int binIndices[4];
+            _mm_storeu_si128((__m128i *) binIndices, _mm256_cvttpd_epi32(bins));
+            pBins[binIndices[0]] += 1;
+            pBins[binIndices[1]] += 1;
+            pBins[binIndices[2]] += 1;
+            pBins[binIndices[3]] += 1;
+        }
+        numericHistogramScalar(pData + index, numEntries - index, minValue, maxValue, numBins, pBins);
+    };
+#endif // QUEUE_NUMERIC_ENABLE_X86
+
+    // =================================================================================================================
+    // Serial kernels, dispatching to the current instruction set.
+
+    inline double numericSum(const double * pData, size_t numEntries) {
+#ifdef QUEUE_NUMERIC_ENABLE_X86
+        switch (numericGetISA()) {
+            case NumericISAAVX2: return(numericSumAVX2(pData, numEntries));
+            case NumericISASSE2: return(numericSumSSE2(pData, numEntries));
+            default:             break;
+        }
+#endif // QUEUE_NUMERIC_ENABLE_X86
+        return(numericSumScalar(pData, numEntries));
+    };
+
+    inline double numericDot(const double * pDataA, const double * pDataB, size_t numEntries) {
+#ifdef QUEUE_NUMERIC_ENABLE_X86
+        switch (numericGetISA()) {
+            case NumericISAAVX2: return(numericDotAVX2(pDataA, pDataB, numEntries));
+            case NumericISASSE2: return(numericDotSSE2(pDataA, pDataB, numEntries));
+            default:             break;
+        }
+#endif // QUEUE_NUMERIC_ENABLE_X86
+        return(numericDotScalar(pDataA, pDataB, numEntries));
+    };
+
+    // NaNs are skipped. With nothing else to go on, the min is +infinity and the max is -infinity.
+    inline void numericMinMax(const double * pData, size_t numEntries, double * pMin, double * pMax) {
+#ifdef QUEUE_NUMERIC_ENABLE_X86
+        switch (numericGetISA()) {
+            case NumericISAAVX2: numericMinMaxAVX2(pData, numEntries, pMin, pMax); return;
+            case NumericISASSE2: numericMinMaxSSE2(pData, numEntries, pMin, pMax); return;
+            default:             break;
+        }
+#endif // QUEUE_NUMERIC_ENABLE_X86
+        numericMinMaxScalar(pData, numEntries, pMin, pMax);
+    };
+
+    inline double numericAlternatingSum(const double * pData, size_t numEntries) {
+#ifdef QUEUE_NUMERIC_ENABLE_X86
+        switch (numericGetISA()) {
+            case NumericISAAVX2: return(numericAlternatingSumAVX2(pData, numEntries));
+            case NumericISASSE2: return(numericAlternatingSumSSE2(pData, numEntries));
+            default:             break;
+        }
+#endif // QUEUE_NUMERIC_ENABLE_X86
+        return(numericAlternatingSumScalar(pData, numEntries));
+    };
+
+    // pBins must have room for numBins + 1 counts; the last is a spare which out-of-range values (and NaNs) are counted
+    // into. If the range is empty (maxValue isn't above minValue), everything is out of range.
+    inline void numericHistogram(const double * pData, size_t numEntries, double minValue, double maxValue, size_t numBins, size_t * pBins) {
+        if ((numBins == 0) || !(maxValue > minValue)) {
+            pBins[numBins] += numEntries;
+            return;
+        }
+#ifdef QUEUE_NUMERIC_ENABLE_X86
+        switch (numericGetISA()) {
+            case NumericISAAVX2: numericHistogramAVX2(pData, numEntries, minValue, maxValue, numBins, pBins); return;
+            case NumericISASSE2: numericHistogramSSE2(pData, numEntries, minValue, maxValue, numBins, pBins); return;
+            default:             break;
+        }
+#endif // QUEUE_NUMERIC_ENABLE_X86
+        numericHistogramScalar(pData, numEntries, minValue, maxValue, numBins, pBins);
+    };
+
+    // =================================================================================================================
+    // Parallel kernels, splitting the range into cache blocks across a Queue's threads.
+
+    // Returns the number of tasks the block kernels split a range across.
+    template <class RType, typename ...Args>
+    inline unsigned int numericNumTasks(Queue<RType, Args...> * pQueue, size_t numEntries) {
+        size_t       numBlocks  = ((numEntries + NUMERIC_BLOCK_SIZE - 1) / NUMERIC_BLOCK_SIZE);
+        unsigned int numThreads = ((pQueue != nullptr) ? pQueue->getNumThreads() : 1);
+        return((unsigned int) min((size_t) ((numThreads > 1) ? (numThreads * NUMERIC_TASKS_PER_THREAD) : 1), numBlocks));
+    };
+
+    // Runs blockFunc(taskIndex, blockIndex, blockStart, blockSize) for every block of a range, with numericNumTasks()
+    // tasks on the Queue's threads claiming blocks as they go.
+    template <class RType, typename ...Args>
+    inline void parallelForBlocksByTask(Queue<RType, Args...> * pQueue, size_t numEntries, function<void(unsigned int, size_t, size_t, size_t)> blockFunc) {
+        size_t       numBlocks = ((numEntries + NUMERIC_BLOCK_SIZE - 1) / NUMERIC_BLOCK_SIZE);
+        unsigned int numTasks  = numericNumTasks(pQueue, numEntries);
+        atomic<size_t> nextBlock(0);
+        parallelRun(pQueue, numTasks, [&nextBlock, &blockFunc, numBlocks, numEntries](unsigned int taskIndex) {
+            for (size_t blockIndex = nextBlock++; blockIndex < numBlocks; blockIndex = nextBlock++) {
+                size_t blockStart = (blockIndex * NUMERIC_BLOCK_SIZE);
+                blockFunc(taskIndex, blockIndex, blockStart, min((size_t) NUMERIC_BLOCK_SIZE, numEntries - blockStart));
+            }
+        });
+    };
+
+    // Runs blockFunc(blockIndex, blockStart, blockSize) for every block of a range, with the Queue's threads claiming
+    // blocks as they go.
+    template <class RType, typename ...Args>
+    inline void parallelForBlocks(Queue<RType, Args...> * pQueue, size_t numEntries, function<void(size_t, size_t, size_t)> blockFunc) {
+        parallelForBlocksByTask(pQueue, numEntries, [&blockFunc](unsigned int taskIndex, size_t blockIndex, size_t blockStart, size_t blockSize) {
+            blockFunc(blockIndex, blockStart, blockSize);
+        });
+    };
+
+    template <class RType, typename ...Args>
+    inline double parallelSum(Queue<RType, Args...> * pQueue, const double * pData, size_t numEntries) {
+        vector<double> allPartials = vector<double>((numEntries + NUMERIC_BLOCK_SIZE - 1) / NUMERIC_BLOCK_SIZE, 0.0);
+        parallelForBlocks(pQueue, numEntries, [pData, &allPartials](size_t blockIndex, size_t blockStart, size_t blockSize) {
+            allPartials[blockIndex] = numericSum(pData + blockStart, blockSize);
+        });
+        return(numericSumScalar(allPartials.data(), allPartials.size()));
+    };
+
+    template <class RType, typename ...Args>
+    inline double parallelDot(Queue<RType, Args...> * pQueue, const double * pDataA, const double * pDataB, size_t numEntries) {
+        vector<double> allPartials = vector<double>((numEntries + NUMERIC_BLOCK_SIZE - 1) / NUMERIC_BLOCK_SIZE, 0.0);
+        parallelForBlocks(pQueue, numEntries, [pDataA, pDataB, &allPartials](size_t blockIndex, size_t blockStart, size_t blockSize) {
+            allPartials[blockIndex] = numericDot(pDataA + blockStart, pDataB + blockStart, blockSize);
+        });
+        return(numericSumScalar(allPartials.data(), allPartials.size()));
+    };
+
+    template <class RType, typename ...Args>
+    inline void parallelMinMax(Queue<RType, Args...> * pQueue, const double * pData, size_t numEntries, double * pMin, double * pMax) {
+        size_t         numBlocks  = ((numEntries + NUMERIC_BLOCK_SIZE - 1) / NUMERIC_BLOCK_SIZE);
+        vector<double> allMins    = vector<double>(numBlocks, 0.0);
+        vector<double> allMaxes   = vector<double>(numBlocks, 0.0);
+        parallelForBlocks(pQueue, numEntries, [pData, &allMins, &allMaxes](size_t blockIndex, size_t blockStart, size_t blockSize) {
+            numericMinMax(pData + blockStart, blockSize, &(allMins[blockIndex]), &(allMaxes[blockIndex]));
+        });
+        *pMin = numeric_limits<double>::infinity();
+        *pMax = -numeric_limits<double>::infinity();
+        for (size_t blockIndex = 0; blockIndex < numBlocks; ++blockIndex) {
+            *pMin = min(*pMin, allMins[blockIndex]);
+            *pMax = max(*pMax, allMaxes[blockIndex]);
+        }
+    };
+
+    // Entries at even indices are subtracted, and entries at odd indices are added. Blocks are an even size, so each
+    // starts on an even index.
+    template <class RType, typename ...Args>
+    inline double parallelAlternatingSum(Queue<RType, Args...> * pQueue, const double * pData, size_t numEntries) {
+        vector<double> allPartials = vector<double>((numEntries + NUMERIC_BLOCK_SIZE - 1) / NUMERIC_BLOCK_SIZE, 0.0);
+        parallelForBlocks(pQueue, numEntries, [pData, &allPartials](size_t blockIndex, size_t blockStart, size_t blockSize) {
+            allPartials[blockIndex] = numericAlternatingSum(pData + blockStart, blockSize);
+        });
+        return(numericSumScalar(allPartials.data(), allPartials.size()));
+    };
+
+    // Reduces transformFunc(entry) over a range with reduceFunc. The transform is arbitrary, so rather than explicit
+    // SIMD this keeps four independent accumulators per block, which leaves the compiler free to vectorize simple
+    // transforms. reduceFunc must be associative and commutative, and init must be its identity.
+    template <class RType, typename ...Args, typename InType, typename OutType, typename ReduceFunc, typename TransformFunc>
+    inline OutType parallelTransformReduce(Queue<RType, Args...> * pQueue, const InType * pData, size_t numEntries, OutType init, ReduceFunc reduceFunc, TransformFunc transformFunc) {
+        vector<OutType> allPartials = vector<OutType>((numEntries + NUMERIC_BLOCK_SIZE - 1) / NUMERIC_BLOCK_SIZE, init);
+        parallelForBlocks(pQueue, numEntries, [pData, init, &reduceFunc, &transformFunc, &allPartials](size_t blockIndex, size_t blockStart, size_t blockSize) {
+            const InType * pBlock = (pData + blockStart);
+            OutType        sum0   = init, sum1 = init, sum2 = init, sum3 = init;
+            size_t         index  = 0;
+            for (; (index + 4) <= blockSize; index += 4) {
+                sum0 = reduceFunc(sum0, transformFunc(pBlock[index]));
+                sum1 = reduceFunc(sum1, transformFunc(pBlock[index + 1]));
+                sum2 = reduceFunc(sum2, transformFunc(pBlock[index + 2]));
+                sum3 = reduceFunc(sum3, transformFunc(pBlock[index + 3]));
+            }
+            for (; index < blockSize; ++index) {
+                sum0 = reduceFunc(sum0, transformFunc(pBlock[index]));
+            }
+            allPartials[blockIndex] = reduceFunc(reduceFunc(sum0, sum1), reduceFunc(sum2, sum3));
+        });
+        OutType returnValue = init;
+        for (size_t blockIndex = 0; blockIndex < allPartials.size(); ++blockIndex) {
+            returnValue = reduceFunc(returnValue, allPartials[blockIndex]);
+        }
+        return(returnValue);
+    };
+
+    // Counts the entries falling into each of numBins equal-width bins over [minValue, maxValue]. Values outside of
+    // that range (and NaNs) are ignored, and maxValue itself lands in the last bin.
+    template <class RType, typename ...Args>
+    inline vector<size_t> parallelHistogram(Queue<RType, Args...> * pQueue, const double * pData, size_t numEntries, double minValue, double maxValue, size_t numBins) {
+        vector<size_t> allBins = vector<size_t>(numBins, 0);
+        if ((numBins == 0) || !(maxValue > minValue)) {
+            return(allBins);
+        }
+
+        // Every task keeps its own bins (plus a spare), each in its own allocation, so tasks never write to the same
+        // counts (or cache lines). They're only merged once every task is done, so merging needs no lock.
+        unsigned int           numTasks    = numericNumTasks(pQueue, numEntries);
+        vector<vector<size_t>> allTaskBins = vector<vector<size_t>>(numTasks, vector<size_t>(numBins + 1, 0));
+        parallelForBlocksByTask(pQueue, numEntries, [pData, minValue, maxValue, numBins, &allTaskBins](unsigned int taskIndex, size_t blockIndex, size_t blockStart, size_t blockSize) {
+            numericHistogram(pData + blockStart, blockSize, minValue, maxValue, numBins, allTaskBins[taskIndex].data());
+        });
+        for (unsigned int taskIndex = 0; taskIndex < numTasks; ++taskIndex) {
+            for (size_t binIndex = 0; binIndex < numBins; ++binIndex) {
+                allBins[binIndex] += allTaskBins[taskIndex][binIndex];
+            }
+        }
+        return(allBins);
+    };
+};
+
+#endif // __QUEUE_NUMERIC_H__
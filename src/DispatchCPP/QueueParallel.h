@@ -0,0 +1,600 @@
+#ifndef __QUEUE_PARALLEL_H__
+#define __QUEUE_PARALLEL_H__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <type_traits>
+#include <vector>
+
+#include "Queue.h"
+#include "QueueGrain.h"
+#include "QueueThread.h"
+
+// Ranges smaller than this are simply handed to std::sort, as splitting them up costs more than it saves.
+#define PARALLEL_SORT_SERIAL_CUTOFF         65536
+
+// The number of buckets sample sort splits a range into per thread. More buckets balance better when keys are skewed.
+#define PARALLEL_SORT_BUCKETS_PER_THREAD    4
+
+// The number of samples taken per bucket when choosing splitters.
+#define PARALLEL_SORT_OVERSAMPLING          64
+
+// A bucket holding more than this many times its share of the range is too big to sort on one thread (the keys are
+// skewed, or full of duplicates). It's split up again instead, up to MAX_DEPTH times.
+#define PARALLEL_SORT_SKEW_FACTOR           4
+#define PARALLEL_SORT_MAX_DEPTH             4
+
+// Ranges smaller than this are scanned, partitioned or compacted serially.
+#define PARALLEL_SCAN_SERIAL_CUTOFF         32768
+
+// The size of a cache line. Per-thread totals are padded out to this, so threads never write to the same line.
+#define PARALLEL_CACHE_LINE_SIZE            64
+
+// The number of bits radix sort consumes per pass.
+#define PARALLEL_RADIX_BITS                 8
+#define PARALLEL_RADIX_NUM_DIGITS           (1 << PARALLEL_RADIX_BITS)
+
+// The fewest chunks per thread an adaptive range is split into, however cheap its items, so threads stay balanced.
+#define PARALLEL_GRAIN_CHUNKS_PER_THREAD    4
+
+// This header file uses the standard namespace.
+using namespace std;
+
+// Declare our parallel algorithms within our DispatchCPP namespace. Each of them runs on the threads of whichever Queue
+// it's given (through dispatchFunction, so the Queue's own QueueFunction is never involved), with the calling thread
+// taking a share of the work itself. They block until finished, so they must not be called from one of the given
+// Queue's own threads.
+namespace DispatchCPP {
+    // Runs taskFunc(0) through taskFunc(numTasks - 1) across the Queue's threads, and blocks until all have returned.
+    // The calling thread runs task 0 itself.
+    template <class RType, typename ...Args>
+    inline void parallelRun(Queue<RType, Args...> * pQueue, unsigned int numTasks, function<void(unsigned int)> taskFunc) {
+        // Anything to do?
+        if (numTasks == 0) {
+            return;
+        }
+
+        // Without a Queue, just run everything on the calling thread.
+        if (pQueue == nullptr) {
+            for (unsigned int taskIndex = 0; taskIndex < numTasks; ++taskIndex) {
+                taskFunc(taskIndex);
+            }
+            return;
+        }
+
+        // Dispatch every task but the first, each of which counts itself off once it's done.
+        mutex              doneLock;
+        condition_variable doneVar;
+        unsigned int       numTasksLeft = (numTasks - 1);
+        for (unsigned int taskIndex = 1; taskIndex < numTasks; ++taskIndex) {
+            pQueue->dispatchFunction([&taskFunc, &doneLock, &doneVar, &numTasksLeft, taskIndex](void) {
+                taskFunc(taskIndex);
+                lock_guard<mutex> tempLock(doneLock);
+                numTasksLeft -= 1;
+                if (numTasksLeft == 0) {
+                    doneVar.notify_all();
+                }
+            });
+        }
+
+        // Run the first task ourselves, then wait on the rest.
+        taskFunc(0);
+        unique_lock<mutex> tempLock(doneLock);
+        doneVar.wait(tempLock, [&numTasksLeft] {
+            return(numTasksLeft == 0);
+        });
+    };
+
+    // Runs rangeFunc over [0, numItems) across the Queue's threads in chunks, each dispatched on its own, and blocks
+    // until all have returned. The tuner picks each chunk's size from how long earlier chunks took (as timed by the
+    // QueueThread running them), so it keeps adjusting as chunks finish. If the tuner hasn't measured anything yet, the
+    // calling thread runs a first chunk itself to get started. The calling thread always runs the last chunk.
+    template <class RType, typename ...Args>
+    inline void parallelForAdaptive(Queue<RType, Args...> * pQueue, QueueGrainTuner * pTuner, size_t numItems, function<void(size_t, size_t)> rangeFunc) {
+        // Anything to do?
+        if (numItems == 0) {
+            return;
+        }
+
+        // Without a Queue, just run everything on the calling thread.
+        if (pQueue == nullptr) {
+            rangeFunc(0, numItems);
+            return;
+        }
+
+        // Runs a chunk on the calling thread, timing just the chunk itself by the CPU time it used. Chunks may run on a
+        // QueueThread or on a thread helping out from inside some other work (see runPendingWork()), so they always
+        // take their own timestamps rather than relying on when the surrounding work started.
+        size_t position = 0;
+        auto runChunkHere = [pTuner, &rangeFunc](size_t first, size_t last) {
+            long long int startNS = QueueGrainTuner::threadCPUNS();
+            rangeFunc(first, last);
+            pTuner->record(last - first, QueueGrainTuner::threadCPUNS() - startNS);
+        };
+
+        // Measure a first chunk, if we've nothing to go on.
+        if (pTuner->getNumSamples() == 0) {
+            size_t chunkSize = min(pTuner->getChunkSize(), numItems);
+            runChunkHere(0, chunkSize);
+            position = chunkSize;
+        }
+
+        // However cheap the items, never hand out fewer than a few chunks per thread.
+        size_t maxBalancedChunk = max((size_t) 1, (numItems / (((size_t) pQueue->getNumThreads()) * PARALLEL_GRAIN_CHUNKS_PER_THREAD)));
+
+        // Dispatch chunks until only the last is left, each timing itself and counting itself off.
+        mutex              doneLock;
+        condition_variable doneVar;
+        size_t             numChunksLeft = 0;
+        while (position < numItems) {
+            size_t chunkSize = min(min(pTuner->getChunkSize(), maxBalancedChunk), (numItems - position));
+            size_t first     = position;
+            size_t last      = (position + chunkSize);
+            position         = last;
+            if (last == numItems) {
+                runChunkHere(first, last);
+                break;
+            }
+            doneLock.lock();
+            numChunksLeft += 1;
+            doneLock.unlock();
+            pQueue->dispatchFunction([&runChunkHere, &doneLock, &doneVar, &numChunksLeft, first, last](void) {
+                runChunkHere(first, last);
+                lock_guard<mutex> tempLock(doneLock);
+                numChunksLeft -= 1;
+                if (numChunksLeft == 0) {
+                    doneVar.notify_all();
+                }
+            });
+        }
+
+        // Wait on the rest.
+        unique_lock<mutex> tempLock(doneLock);
+        doneVar.wait(tempLock, [&numChunksLeft] {
+            return(numChunksLeft == 0);
+        });
+    };
+
+    // A value padded out to its own cache line.
+    template <typename T> struct alignas(PARALLEL_CACHE_LINE_SIZE) ParallelPaddedValue {
+        T value;
+    };
+
+    // Sorts [first, last) using parallel sample sort. Splitters are chosen from an oversampled, sorted set of keys; each
+    // thread then counts and scatters its own slice of the range into per-bucket regions of a scratch buffer, and
+    // finally every bucket is sorted with std::sort and moved back. Small ranges (or single-threaded Queues) fall
+    // straight back to std::sort. Buckets which end up far bigger than their share (skewed or duplicate-heavy keys)
+    // have the keys equal to their lower splitter set aside, since those are already in order, and the rest is sample
+    // sorted again. Like std::sort, this is not stable.
+    template <class RType, typename ...Args, class RandomIt, class Compare>
+    inline void parallelSort(Queue<RType, Args...> * pQueue, RandomIt first, RandomIt last, Compare comp, unsigned int depth = 0) {
+        typedef typename iterator_traits<RandomIt>::value_type ValueType;
+
+        // Is it worth splitting this range up at all?
+        size_t       numElements = ((size_t) (last - first));
+        unsigned int numThreads  = ((pQueue != nullptr) ? pQueue->getNumThreads() : 1);
+        if ((numThreads <= 1) || (numElements < PARALLEL_SORT_SERIAL_CUTOFF)) {
+            sort(first, last, comp);
+            return;
+        }
+        unsigned int numChunks  = numThreads;
+        unsigned int numBuckets = (numThreads * PARALLEL_SORT_BUCKETS_PER_THREAD);
+
+        // Take an evenly strided, jittered sample of the range, and pull our splitters out of it.
+        size_t            numSamples  = (((size_t) numBuckets) * PARALLEL_SORT_OVERSAMPLING);
+        size_t            sampleStep  = (numElements / numSamples);
+        if (sampleStep == 0) {
+            sort(first, last, comp);
+            return;
+        }
+        uint64_t          sampleSeed  = 0x9E3779B97F4A7C15ULL;
+        vector<ValueType> allSamples  = vector<ValueType>();
+        allSamples.reserve(numSamples);
+        for (size_t sampleIndex = 0; sampleIndex < numSamples; ++sampleIndex) {
+            sampleSeed = ((sampleSeed * 6364136223846793005ULL) + 1442695040888963407ULL);
+            allSamples.push_back(*(first + ((sampleIndex * sampleStep) + ((size_t) ((sampleSeed >> 33) % sampleStep)))));
+        }
+        sort(allSamples.begin(), allSamples.end(), comp);
+        vector<ValueType> allSplitters = vector<ValueType>();
+        allSplitters.reserve(numBuckets - 1);
+        for (unsigned int bucketIndex = 1; bucketIndex < numBuckets; ++bucketIndex) {
+            allSplitters.push_back(allSamples[bucketIndex * PARALLEL_SORT_OVERSAMPLING]);
+        }
+        auto bucketOf = [&allSplitters, &comp](const ValueType & value) {
+            return((unsigned int) (upper_bound(allSplitters.begin(), allSplitters.end(), value, comp) - allSplitters.begin()));
+        };
+
+        // Each chunk counts how many of its elements land in each bucket.
+        vector<size_t> allCounts = vector<size_t>(((size_t) numChunks) * numBuckets, 0);
+        parallelRun(pQueue, numChunks, [first, numElements, numChunks, numBuckets, &allCounts, &bucketOf](unsigned int chunkIndex) {
+            vector<size_t> chunkCounts = vector<size_t>(numBuckets, 0);
+            size_t         chunkEnd    = ((numElements * (chunkIndex + 1)) / numChunks);
+            for (size_t index = ((numElements * chunkIndex) / numChunks); index < chunkEnd; ++index) {
+                chunkCounts[bucketOf(*(first + index))] += 1;
+            }
+            copy(chunkCounts.begin(), chunkCounts.end(), allCounts.begin() + (((size_t) chunkIndex) * numBuckets));
+        });
+
+        // Turn the counts into where each chunk starts writing within each bucket.
+        vector<size_t> allOffsets      = vector<size_t>(((size_t) numChunks) * numBuckets, 0);
+        vector<size_t> allBucketStarts = vector<size_t>(numBuckets + 1, 0);
+        size_t         runningOffset   = 0;
+        for (unsigned int bucketIndex = 0; bucketIndex < numBuckets; ++bucketIndex) {
+            allBucketStarts[bucketIndex] = runningOffset;
+            for (unsigned int chunkIndex = 0; chunkIndex < numChunks; ++chunkIndex) {
+                allOffsets[(((size_t) chunkIndex) * numBuckets) + bucketIndex] = runningOffset;
+                runningOffset += allCounts[(((size_t) chunkIndex) * numBuckets) + bucketIndex];
+            }
+        }
+        allBucketStarts[numBuckets] = runningOffset;
+
+        // Scatter every chunk into its buckets within our scratch buffer.
+        unique_ptr<ValueType[]> pScratch = unique_ptr<ValueType[]>(new ValueType[numElements]);
+        ValueType *             pBuffer  = pScratch.get();
+        parallelRun(pQueue, numChunks, [first, numElements, numChunks, numBuckets, pBuffer, &allOffsets, &bucketOf](unsigned int chunkIndex) {
+            size_t * pChunkOffsets = &(allOffsets[((size_t) chunkIndex) * numBuckets]);
+            size_t   chunkEnd      = ((numElements * (chunkIndex + 1)) / numChunks);
+            for (size_t index = ((numElements * chunkIndex) / numChunks); index < chunkEnd; ++index) {
+                pBuffer[pChunkOffsets[bucketOf(*(first + index))]++] = move(*(first + index));
+            }
+        });
+
+        // Which buckets are too big to sort on a single thread?
+        size_t       maxBucketSize = max(((numElements / numBuckets) * PARALLEL_SORT_SKEW_FACTOR), (size_t) PARALLEL_SORT_SERIAL_CUTOFF);
+        vector<bool> allOversized  = vector<bool>(numBuckets, false);
+        for (unsigned int bucketIndex = 0; bucketIndex < numBuckets; ++bucketIndex) {
+            allOversized[bucketIndex] = ((depth < PARALLEL_SORT_MAX_DEPTH) && ((allBucketStarts[bucketIndex + 1] - allBucketStarts[bucketIndex]) > maxBucketSize));
+        }
+
+        // Sort every other bucket, and move it back into place.
+        parallelRun(pQueue, numBuckets, [first, pBuffer, &allBucketStarts, &allOversized, &comp](unsigned int bucketIndex) {
+            if (allOversized[bucketIndex]) {
+                return;
+            }
+            ValueType * pBucketStart = (pBuffer + allBucketStarts[bucketIndex]);
+            ValueType * pBucketEnd   = (pBuffer + allBucketStarts[bucketIndex + 1]);
+            sort(pBucketStart, pBucketEnd, comp);
+            move(pBucketStart, pBucketEnd, first + allBucketStarts[bucketIndex]);
+        });
+
+        // Split the oversized buckets up again. Every key in a bucket is at least its lower splitter, so the ones equal
+        // to it go first as they are, and only the rest needs sorting (which is what keeps all-equal keys from landing
+        // in the same bucket over and over).
+        for (unsigned int bucketIndex = 0; bucketIndex < numBuckets; ++bucketIndex) {
+            if (!allOversized[bucketIndex]) {
+                continue;
+            }
+            ValueType * pBucketStart = (pBuffer + allBucketStarts[bucketIndex]);
+            ValueType * pBucketEnd   = (pBuffer + allBucketStarts[bucketIndex + 1]);
+            ValueType * pUnsorted    = pBucketStart;
+            if (bucketIndex > 0) {
+                const ValueType & lowerSplitter = allSplitters[bucketIndex - 1];
+                pUnsorted = partition(pBucketStart, pBucketEnd, [&lowerSplitter, &comp](const ValueType & value) {
+                    return(!comp(lowerSplitter, value));
+                });
+            }
+            parallelSort(pQueue, pUnsorted, pBucketEnd, comp, depth + 1);
+            move(pBucketStart, pBucketEnd, first + allBucketStarts[bucketIndex]);
+        }
+    };
+
+    // Sorts [first, last) in ascending order using parallel sample sort.
+    template <class RType, typename ...Args, class RandomIt>
+    inline void parallelSort(Queue<RType, Args...> * pQueue, RandomIt first, RandomIt last) {
+        parallelSort(pQueue, first, last, less<typename iterator_traits<RandomIt>::value_type>());
+    };
+
+    // Sorts integer keys in [first, last) in ascending order using a parallel LSD radix sort. Each pass has every
+    // thread histogram its own slice, then scatter it (stably) into a scratch buffer. Passes where every key shares the
+    // same digit are skipped entirely, so narrow key ranges only pay for the digits which actually vary. The range must
+    // be contiguous in memory (a vector or an array).
+    template <class RType, typename ...Args, class RandomIt>
+    inline typename enable_if<is_integral<typename iterator_traits<RandomIt>::value_type>::value && !is_same<typename iterator_traits<RandomIt>::value_type, bool>::value, void>::type parallelRadixSort(Queue<RType, Args...> * pQueue, RandomIt first, RandomIt last) {
+        typedef typename iterator_traits<RandomIt>::value_type ValueType;
+        typedef typename make_unsigned<ValueType>::type        KeyType;
+
+        // Is it worth radix sorting this range at all?
+        size_t numElements = ((size_t) (last - first));
+        if (numElements < PARALLEL_SORT_SERIAL_CUTOFF) {
+            sort(first, last);
+            return;
+        }
+        unsigned int numChunks = ((pQueue != nullptr) ? pQueue->getNumThreads() : 1);
+
+        // Signed keys have their sign bit flipped, so negative values sort before positive ones.
+        const KeyType signFlip = (is_signed<ValueType>::value ? (((KeyType) 1) << ((sizeof(KeyType) * 8) - 1)) : 0);
+
+        // We ping-pong between the range itself and a scratch buffer.
+        unique_ptr<ValueType[]> pScratch    = unique_ptr<ValueType[]>(new ValueType[numElements]);
+        ValueType *             pSource     = &(*first);
+        ValueType *             pDest       = pScratch.get();
+        vector<size_t>          allCounts   = vector<size_t>(((size_t) numChunks) * PARALLEL_RADIX_NUM_DIGITS, 0);
+
+        for (unsigned int shift = 0; shift < (sizeof(KeyType) * 8); shift += PARALLEL_RADIX_BITS) {
+            // Each chunk histograms this pass's digit.
+            parallelRun(pQueue, numChunks, [pSource, numElements, numChunks, shift, signFlip, &allCounts](unsigned int chunkIndex) {
+                size_t chunkCounts[PARALLEL_RADIX_NUM_DIGITS];
+                memset(chunkCounts, 0, sizeof(chunkCounts));
+                size_t chunkEnd = ((numElements * (chunkIndex + 1)) / numChunks);
+                for (size_t index = ((numElements * chunkIndex) / numChunks); index < chunkEnd; ++index) {
+                    chunkCounts[(((KeyType) pSource[index]) ^ signFlip) >> shift & (PARALLEL_RADIX_NUM_DIGITS - 1)] += 1;
+                }
+                copy(chunkCounts, chunkCounts + PARALLEL_RADIX_NUM_DIGITS, allCounts.begin() + (((size_t) chunkIndex) * PARALLEL_RADIX_NUM_DIGITS));
+            });
+
+            // Turn the counts into where each chunk starts writing each digit. If one digit holds every key, this pass
+            // wouldn't move anything, so skip it.
+            bool   isSkippable   = false;
+            size_t runningOffset = 0;
+            for (unsigned int digit = 0; digit < PARALLEL_RADIX_NUM_DIGITS; ++digit) {
+                size_t digitStart = runningOffset;
+                for (unsigned int chunkIndex = 0; chunkIndex < numChunks; ++chunkIndex) {
+                    size_t chunkCount = allCounts[(((size_t) chunkIndex) * PARALLEL_RADIX_NUM_DIGITS) + digit];
+                    allCounts[(((size_t) chunkIndex) * PARALLEL_RADIX_NUM_DIGITS) + digit] = runningOffset;
+                    runningOffset += chunkCount;
+                }
+                if ((runningOffset - digitStart) == numElements) {
+                    isSkippable = true;
+                }
+            }
+            if (isSkippable) {
+                continue;
+            }
+
+            // Scatter every chunk, in order, so each pass is stable.
+            parallelRun(pQueue, numChunks, [pSource, pDest, numElements, numChunks, shift, signFlip, &allCounts](unsigned int chunkIndex) {
+                size_t * pChunkOffsets = &(allCounts[((size_t) chunkIndex) * PARALLEL_RADIX_NUM_DIGITS]);
+                size_t   chunkEnd      = ((numElements * (chunkIndex + 1)) / numChunks);
+                for (size_t index = ((numElements * chunkIndex) / numChunks); index < chunkEnd; ++index) {
+                    pDest[pChunkOffsets[(((KeyType) pSource[index]) ^ signFlip) >> shift & (PARALLEL_RADIX_NUM_DIGITS - 1)]++] = pSource[index];
+                }
+            });
+            swap(pSource, pDest);
+        }
+
+        // Make sure the sorted keys end up back in the range itself.
+        if (pSource != &(*first)) {
+            ValueType * pTarget = &(*first);
+            parallelRun(pQueue, numChunks, [pSource, pTarget, numElements, numChunks](unsigned int chunkIndex) {
+                size_t chunkStart = ((numElements * chunkIndex) / numChunks);
+                size_t chunkEnd   = ((numElements * (chunkIndex + 1)) / numChunks);
+                memcpy(pTarget + chunkStart, pSource + chunkStart, (chunkEnd - chunkStart) * sizeof(ValueType));
+            });
+        }
+    };
+
+    // Sorts booleans in [first, last): there's only the one bit, so this just counts the falses and writes them out,
+    // followed by the trues. It's done on the calling thread, as it's never worth splitting up.
+    template <class RType, typename ...Args, class RandomIt>
+    inline typename enable_if<is_same<typename iterator_traits<RandomIt>::value_type, bool>::value, void>::type parallelRadixSort(Queue<RType, Args...> * pQueue, RandomIt first, RandomIt last) {
+        size_t numFalse = (size_t) count(first, last, false);
+        fill(first, first + numFalse, false);
+        fill(first + numFalse, last, true);
+    };
+
+    // Writes the inclusive scan (running total) of [first, last) under binaryOp to dFirst, returning the end of the
+    // output. The output may be the input itself. This is a blocked scan: every thread reduces its own contiguous
+    // chunk (up-sweep), the chunk totals are scanned serially, and every thread then scans its chunk again starting
+    // from its chunk's offset (down-sweep). binaryOp must be associative.
+    template <class RType, typename ...Args, class InputIt, class OutputIt, class BinaryOp>
+    inline OutputIt parallelInclusiveScan(Queue<RType, Args...> * pQueue, InputIt first, InputIt last, OutputIt dFirst, BinaryOp binaryOp) {
+        typedef typename iterator_traits<InputIt>::value_type ValueType;
+
+        // Is it worth splitting this range up at all?
+        size_t       numElements = ((size_t) (last - first));
+        unsigned int numChunks   = ((pQueue != nullptr) ? pQueue->getNumThreads() : 1);
+        if ((numChunks <= 1) || (numElements < PARALLEL_SCAN_SERIAL_CUTOFF)) {
+            return(inclusive_scan(first, last, dFirst, binaryOp));
+        }
+
+        // Up-sweep: each chunk reduces itself. Every chunk but the last needs its total.
+        vector<ParallelPaddedValue<ValueType>> allTotals = vector<ParallelPaddedValue<ValueType>>(numChunks);
+        parallelRun(pQueue, numChunks - 1, [first, numElements, numChunks, &binaryOp, &allTotals](unsigned int chunkIndex) {
+            size_t    chunkStart = ((numElements * chunkIndex) / numChunks);
+            size_t    chunkEnd   = ((numElements * (chunkIndex + 1)) / numChunks);
+            ValueType chunkTotal = *(first + chunkStart);
+            for (size_t index = (chunkStart + 1); index < chunkEnd; ++index) {
+                chunkTotal = binaryOp(chunkTotal, *(first + index));
+            }
+            allTotals[chunkIndex].value = chunkTotal;
+        });
+
+        // Scan the chunk totals, so each holds the total of every chunk before the next one.
+        for (unsigned int chunkIndex = 1; chunkIndex < (numChunks - 1); ++chunkIndex) {
+            allTotals[chunkIndex].value = binaryOp(allTotals[chunkIndex - 1].value, allTotals[chunkIndex].value);
+        }
+
+        // Down-sweep: each chunk scans itself, starting from the total of every chunk before it.
+        parallelRun(pQueue, numChunks, [first, dFirst, numElements, numChunks, &binaryOp, &allTotals](unsigned int chunkIndex) {
+            size_t    chunkStart   = ((numElements * chunkIndex) / numChunks);
+            size_t    chunkEnd     = ((numElements * (chunkIndex + 1)) / numChunks);
+            ValueType runningTotal = ((chunkIndex > 0) ? binaryOp(allTotals[chunkIndex - 1].value, *(first + chunkStart)) : *(first + chunkStart));
+            *(dFirst + chunkStart) = runningTotal;
+            for (size_t index = (chunkStart + 1); index < chunkEnd; ++index) {
+                runningTotal = binaryOp(runningTotal, *(first + index));
+                *(dFirst + index) = runningTotal;
+            }
+        });
+        return(dFirst + numElements);
+    };
+
+    template <class RType, typename ...Args, class InputIt, class OutputIt>
+    inline OutputIt parallelInclusiveScan(Queue<RType, Args...> * pQueue, InputIt first, InputIt last, OutputIt dFirst) {
+        return(parallelInclusiveScan(pQueue, first, last, dFirst, plus<typename iterator_traits<InputIt>::value_type>()));
+    };
+
+    // Writes the exclusive scan of [first, last) under binaryOp to dFirst, starting from init, and returns the end of
+    // the output. Each output is the total of everything strictly before it, which makes this the scan for turning
+    // counts into offsets. The output may be the input itself.
+    template <class RType, typename ...Args, class InputIt, class OutputIt, class T, class BinaryOp>
+    inline OutputIt parallelExclusiveScan(Queue<RType, Args...> * pQueue, InputIt first, InputIt last, OutputIt dFirst, T init, BinaryOp binaryOp) {
+        // Is it worth splitting this range up at all?
+        size_t       numElements = ((size_t) (last - first));
+        unsigned int numChunks   = ((pQueue != nullptr) ? pQueue->getNumThreads() : 1);
+        if ((numChunks <= 1) || (numElements < PARALLEL_SCAN_SERIAL_CUTOFF)) {
+            return(exclusive_scan(first, last, dFirst, init, binaryOp));
+        }
+
+        // Up-sweep: each chunk reduces itself. Every chunk but the last needs its total.
+        vector<ParallelPaddedValue<T>> allTotals = vector<ParallelPaddedValue<T>>(numChunks);
+        parallelRun(pQueue, numChunks - 1, [first, numElements, numChunks, &binaryOp, &allTotals](unsigned int chunkIndex) {
+            size_t chunkStart = ((numElements * chunkIndex) / numChunks);
+            size_t chunkEnd   = ((numElements * (chunkIndex + 1)) / numChunks);
+            T      chunkTotal = *(first + chunkStart);
+            for (size_t index = (chunkStart + 1); index < chunkEnd; ++index) {
+                chunkTotal = binaryOp(chunkTotal, *(first + index));
+            }
+            allTotals[chunkIndex].value = chunkTotal;
+        });
+
+        // Scan the chunk totals, so each holds init plus every chunk up to and including itself.
+        T runningTotal = init;
+        for (unsigned int chunkIndex = 0; chunkIndex < (numChunks - 1); ++chunkIndex) {
+            runningTotal = binaryOp(runningTotal, allTotals[chunkIndex].value);
+            allTotals[chunkIndex].value = runningTotal;
+        }
+
+        // Down-sweep: each chunk scans itself, starting from everything before it. Each input is read before the
+        // output in the same spot is written, so this works in place.
+        parallelRun(pQueue, numChunks, [first, dFirst, numElements, numChunks, init, &binaryOp, &allTotals](unsigned int chunkIndex) {
+            size_t chunkStart   = ((numElements * chunkIndex) / numChunks);
+            size_t chunkEnd     = ((numElements * (chunkIndex + 1)) / numChunks);
+            T      chunkTotal   = ((chunkIndex > 0) ? allTotals[chunkIndex - 1].value : init);
+            for (size_t index = chunkStart; index < chunkEnd; ++index) {
+                T currentValue = *(first + index);
+                *(dFirst + index) = chunkTotal;
+                chunkTotal = binaryOp(chunkTotal, currentValue);
+            }
+        });
+        return(dFirst + numElements);
+    };
+
+    template <class RType, typename ...Args, class InputIt, class OutputIt, class T>
+    inline OutputIt parallelExclusiveScan(Queue<RType, Args...> * pQueue, InputIt first, InputIt last, OutputIt dFirst, T init) {
+        return(parallelExclusiveScan(pQueue, first, last, dFirst, init, plus<T>()));
+    };
+
+    // Copies every element of [first, last) satisfying pred to dFirst, preserving their order, and returns the end of
+    // the output. Each thread counts its chunk's matches, the counts are scanned into offsets, and each thread then
+    // copies its matches to its offset. pred is called twice per element, so it should be cheap and pure. The output
+    // must not overlap the input.
+    template <class RType, typename ...Args, class InputIt, class OutputIt, class UnaryPred>
+    inline OutputIt parallelCopyIf(Queue<RType, Args...> * pQueue, InputIt first, InputIt last, OutputIt dFirst, UnaryPred pred) {
+        // Is it worth splitting this range up at all?
+        size_t       numElements = ((size_t) (last - first));
+        unsigned int numChunks   = ((pQueue != nullptr) ? pQueue->getNumThreads() : 1);
+        if ((numChunks <= 1) || (numElements < PARALLEL_SCAN_SERIAL_CUTOFF)) {
+            return(copy_if(first, last, dFirst, pred));
+        }
+
+        // Each chunk counts its matches.
+        vector<ParallelPaddedValue<size_t>> allOffsets = vector<ParallelPaddedValue<size_t>>(numChunks);
+        parallelRun(pQueue, numChunks, [first, numElements, numChunks, &pred, &allOffsets](unsigned int chunkIndex) {
+            size_t chunkEnd   = ((numElements * (chunkIndex + 1)) / numChunks);
+            size_t numMatches = 0;
+            for (size_t index = ((numElements * chunkIndex) / numChunks); index < chunkEnd; ++index) {
+                numMatches += (pred(*(first + index)) ? 1 : 0);
+            }
+            allOffsets[chunkIndex].value = numMatches;
+        });
+
+        // Turn the counts into where each chunk starts writing.
+        size_t numMatches = 0;
+        for (unsigned int chunkIndex = 0; chunkIndex < numChunks; ++chunkIndex) {
+            size_t chunkMatches = allOffsets[chunkIndex].value;
+            allOffsets[chunkIndex].value = numMatches;
+            numMatches += chunkMatches;
+        }
+
+        // Each chunk copies its matches, now.
+        parallelRun(pQueue, numChunks, [first, dFirst, numElements, numChunks, &pred, &allOffsets](unsigned int chunkIndex) {
+            size_t   chunkEnd = ((numElements * (chunkIndex + 1)) / numChunks);
+            OutputIt dCurrent = (dFirst + allOffsets[chunkIndex].value);
+            for (size_t index = ((numElements * chunkIndex) / numChunks); index < chunkEnd; ++index) {
+                if (pred(*(first + index))) {
+                    *dCurrent = *(first + index);
+                    ++dCurrent;
+                }
+            }
+        });
+        return(dFirst + numMatches);
+    };
+
+    // Reorders [first, last) so every element satisfying pred comes before every element which doesn't, and returns
+    // the first element of the second group. The relative order within each group is preserved (as with
+    // std::stable_partition). Elements are scattered through a scratch buffer the size of the range, and pred is
+    // called twice per element, so it should be cheap and pure.
+    template <class RType, typename ...Args, class RandomIt, class UnaryPred>
+    inline RandomIt parallelPartition(Queue<RType, Args...> * pQueue, RandomIt first, RandomIt last, UnaryPred pred) {
+        typedef typename iterator_traits<RandomIt>::value_type ValueType;
+
+        // Is it worth splitting this range up at all?
+        size_t       numElements = ((size_t) (last - first));
+        unsigned int numChunks   = ((pQueue != nullptr) ? pQueue->getNumThreads() : 1);
+        if ((numChunks <= 1) || (numElements < PARALLEL_SCAN_SERIAL_CUTOFF)) {
+            return(stable_partition(first, last, pred));
+        }
+
+        // Each chunk counts its matches.
+        vector<ParallelPaddedValue<size_t>> allTrueOffsets  = vector<ParallelPaddedValue<size_t>>(numChunks);
+        vector<ParallelPaddedValue<size_t>> allFalseOffsets = vector<ParallelPaddedValue<size_t>>(numChunks);
+        parallelRun(pQueue, numChunks, [first, numElements, numChunks, &pred, &allTrueOffsets](unsigned int chunkIndex) {
+            size_t chunkEnd   = ((numElements * (chunkIndex + 1)) / numChunks);
+            size_t numMatches = 0;
+            for (size_t index = ((numElements * chunkIndex) / numChunks); index < chunkEnd; ++index) {
+                numMatches += (pred(*(first + index)) ? 1 : 0);
+            }
+            allTrueOffsets[chunkIndex].value = numMatches;
+        });
+
+        // Matches are written from the front, and everything else follows every match.
+        size_t numMatches = 0;
+        for (unsigned int chunkIndex = 0; chunkIndex < numChunks; ++chunkIndex) {
+            numMatches += allTrueOffsets[chunkIndex].value;
+        }
+        size_t trueOffset  = 0;
+        size_t falseOffset = numMatches;
+        for (unsigned int chunkIndex = 0; chunkIndex < numChunks; ++chunkIndex) {
+            size_t chunkSize    = (((numElements * (chunkIndex + 1)) / numChunks) - ((numElements * chunkIndex) / numChunks));
+            size_t chunkMatches = allTrueOffsets[chunkIndex].value;
+            allTrueOffsets[chunkIndex].value  = trueOffset;
+            allFalseOffsets[chunkIndex].value = falseOffset;
+            trueOffset  += chunkMatches;
+            falseOffset += (chunkSize - chunkMatches);
+        }
+
+        // Each chunk scatters into our scratch buffer, and then each chunk of the buffer is moved back.
+        unique_ptr<ValueType[]> pScratch = unique_ptr<ValueType[]>(new ValueType[numElements]);
+        ValueType *             pBuffer  = pScratch.get();
+        parallelRun(pQueue, numChunks, [first, pBuffer, numElements, numChunks, &pred, &allTrueOffsets, &allFalseOffsets](unsigned int chunkIndex) {
+            size_t chunkEnd    = ((numElements * (chunkIndex + 1)) / numChunks);
+            size_t trueIndex   = allTrueOffsets[chunkIndex].value;
+            size_t falseIndex  = allFalseOffsets[chunkIndex].value;
+            for (size_t index = ((numElements * chunkIndex) / numChunks); index < chunkEnd; ++index) {
+                if (pred(*(first + index))) {
+                    pBuffer[trueIndex++] = move(*(first + index));
+                } else {
+                    pBuffer[falseIndex++] = move(*(first + index));
+                }
+            }
+        });
+        parallelRun(pQueue, numChunks, [first, pBuffer, numElements, numChunks](unsigned int chunkIndex) {
+            size_t chunkStart = ((numElements * chunkIndex) / numChunks);
+            size_t chunkEnd   = ((numElements * (chunkIndex + 1)) / numChunks);
+            move(pBuffer + chunkStart, pBuffer + chunkEnd, first + chunkStart);
+        });
+        return(first + numMatches);
+    };
+};
+
+#endif // __QUEUE_PARALLEL_H__
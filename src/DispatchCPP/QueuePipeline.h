@@ -0,0 +1,280 @@
+#ifndef __QUEUE_PIPELINE_H__
+#define __QUEUE_PIPELINE_H__
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "Queue.h"
+#include "QueueChannel.h"
+
+// The number of values each stage's input channel holds by default, before the stage before it blocks.
+#define QUEUE_PIPELINE_DEFAULT_CAPACITY 1024
+
+// This header file uses the standard namespace.
+using namespace std;
+
+// Declare the QueuePipeline within our DispatchCPP namespace.
+namespace DispatchCPP {
+    // Where a stage sends its output: into the next stage's channel, or straight into the next stage's function when
+    // the two have been fused.
+    template <typename T> class QueuePipelineOutlet {
+        public:
+            function<void(T &&)> emit;
+            function<void()>     close;
+    };
+
+    // The parts of a stage the pipeline needs, no matter what it takes or makes.
+    class QueuePipelineStageBase {
+        public:
+            virtual ~QueuePipelineStageBase() {};
+            virtual void start() = 0;
+            virtual void join()  = 0;
+    };
+
+    // A stage with its own input channel, whose consumers run on a Queue's threads, taking In and passing Out on (or
+    // consuming it, if Out is void). The Queue is our own, with a thread per consumer, unless one's handed to us.
+    template <typename In, typename Out> class QueuePipelineStage : public QueuePipelineStageBase {
+        private:
+            // Our own Queue (if we weren't handed one), and what dispatches our consumers onto the Queue they run on.
+            unique_ptr<Queue<void>>          pOwnQueue;
+            function<void(function<void()>)> dispatcher;
+
+            // Our consumers, the number of them which haven't finished yet, and what join() waits on for them.
+            unsigned int                     numConsumers;
+            atomic<unsigned int>             numRunning;
+            mutex                            finishLock;
+            condition_variable               finishVar;
+
+            // What each of our consumers runs: pops values until our channel's closed and drained. The last consumer
+            // out closes the stage after us.
+            inline void consume() {
+                In value;
+                while (this->input.pop(value)) {
+                    if constexpr (is_void<Out>::value) {
+                        this->stageFunc(move(value));
+                    } else {
+                        this->pOutlet->emit(this->stageFunc(move(value)));
+                    }
+                }
+                lock_guard<mutex> tempLock(this->finishLock);
+                if (this->numRunning.fetch_sub(1) == 1) {
+                    if constexpr (!is_void<Out>::value) {
+                        this->pOutlet->close();
+                    }
+                    this->finishVar.notify_all();
+                }
+            };
+
+        public:
+            // Our input, what we do with it, and where our output goes.
+            QueueChannel<In>                 input;
+            function<Out(In &&)>             stageFunc;
+            shared_ptr<QueuePipelineOutlet<
+                typename conditional<is_void<Out>::value, char, Out>::type>> pOutlet;
+
+            // Constructor. Our consumers run on whatever newDispatcher dispatches onto, or on a Queue of our own if
+            // it's nullptr.
+            template <typename StageFunc>
+            inline QueuePipelineStage(unsigned int newNumConsumers, size_t capacity, StageFunc newStageFunc, function<void(function<void()>)> newDispatcher = nullptr) : input(capacity) {
+                this->numConsumers = ((newNumConsumers > 0) ? newNumConsumers : 1);
+                this->numRunning   = 0;
+                this->stageFunc    = newStageFunc;
+                this->dispatcher   = newDispatcher;
+                if (this->dispatcher == nullptr) {
+                    Queue<void> * pNewQueue = new Queue<void>(new QueueFunction<void>([]() {}), this->numConsumers, true);
+                    this->pOwnQueue  = unique_ptr<Queue<void>>(pNewQueue);
+                    this->dispatcher = [pNewQueue](function<void()> newFunction) {
+                        pNewQueue->dispatchFunction(move(newFunction));
+                    };
+                }
+            };
+
+            // Dispatches our consumers.
+            inline void start() {
+                this->numRunning = this->numConsumers;
+                for (unsigned int consumerIndex = 0; consumerIndex < this->numConsumers; ++consumerIndex) {
+                    this->dispatcher([this]() {
+                        this->consume();
+                    });
+                }
+            };
+
+            // Waits for our consumers to drain our channel and finish.
+            inline void join() {
+                unique_lock<mutex> tempLock(this->finishLock);
+                this->finishVar.wait(tempLock, [this]() {
+                    return(this->numRunning.load() == 0);
+                });
+            };
+    };
+
+    // The state shared by a pipeline and every builder made from it.
+    template <typename In> class QueuePipelineCore {
+        public:
+            // Where pushed values go, how big each stage's channel is, and every stage with consumers of its own.
+            shared_ptr<QueuePipelineOutlet<In>>       pHead;
+            size_t                                    capacity;
+            vector<shared_ptr<QueuePipelineStageBase>> allStages;
+            bool                                      isStarted;
+
+            // Destructor. Lets anything still in flight drain, if the pipeline was never finished.
+            inline ~QueuePipelineCore() {
+                if (this->isStarted) {
+                    this->pHead->close();
+                    for (shared_ptr<QueuePipelineStageBase> & pStage : this->allStages) {
+                        pStage->join();
+                    }
+                }
+            };
+    };
+
+    // A chain of typed stages connected by bounded channels, each stage's consumers running on a Queue: one of its own
+    // with a thread per consumer, or one handed to then() or sink(). Values pushed into the pipeline are moved from
+    // stage to stage without being copied, and a full channel blocks the stage before it, all the way back to whoever's
+    // pushing, so a slow stage holds everything upstream back instead of letting it queue up without limit. Adjacent
+    // serial (single consumer) stages without a Queue of their own are fused, running one after the other on the
+    // same thread with no channel between them. Build the pipeline with then() and finish it with sink(), which
+    // dispatches every stage's consumers; then push() values and call finish() to wait for them all to come out the
+    // other end.
+    template <typename In, typename Out = In> class QueuePipeline {
+        template <typename, typename> friend class QueuePipeline;
+
+        private:
+            // Our shared state, where our last stage sends its output, and whether that stage is serial.
+            shared_ptr<QueuePipelineCore<In>>    pCore;
+            shared_ptr<QueuePipelineOutlet<Out>> pTail;
+            bool                                 isTailSerial;
+
+            // Constructor, for the builders made by then().
+            inline QueuePipeline(shared_ptr<QueuePipelineCore<In>> pNewCore, shared_ptr<QueuePipelineOutlet<Out>> pNewTail, bool isNewTailSerial) {
+                this->pCore        = pNewCore;
+                this->pTail        = pNewTail;
+                this->isTailSerial = isNewTailSerial;
+            };
+
+            // Adds a stage taking Out, whose consumers run on whatever dispatcher dispatches onto (or a Queue of the
+            // stage's own, if it's nullptr), fusing it into our last stage if both are serial and it has no Queue handed
+            // to it. Returns the new stage's outlet (if it has output).
+            template <typename Next, typename StageFunc>
+            inline shared_ptr<QueuePipelineOutlet<typename conditional<is_void<Next>::value, char, Next>::type>> addStage(unsigned int numThreads, StageFunc stageFunc, function<void(function<void()>)> dispatcher = nullptr) {
+                typedef typename conditional<is_void<Next>::value, char, Next>::type NextOutlet;
+                shared_ptr<QueuePipelineOutlet<NextOutlet>> pNextTail = make_shared<QueuePipelineOutlet<NextOutlet>>();
+
+                // Can we run on the same thread as the stage before us?
+                if ((this->isTailSerial) && (numThreads <= 1) && (dispatcher == nullptr)) {
+                    if constexpr (is_void<Next>::value) {
+                        this->pTail->emit  = stageFunc;
+                        this->pTail->close = []() {};
+                    } else {
+                        this->pTail->emit = [stageFunc, pNextTail](Out && value) {
+                            pNextTail->emit(stageFunc(move(value)));
+                        };
+                        this->pTail->close = [pNextTail]() {
+                            pNextTail->close();
+                        };
+                    }
+                    return(pNextTail);
+                }
+
+                // No, so we get a channel and consumers of our own.
+                shared_ptr<QueuePipelineStage<Out, Next>> pStage = make_shared<QueuePipelineStage<Out, Next>>(numThreads, this->pCore->capacity, stageFunc, dispatcher);
+                pStage->pOutlet = pNextTail;
+                QueuePipelineStage<Out, Next> * pRawStage = pStage.get();
+                this->pTail->emit = [pRawStage](Out && value) {
+                    pRawStage->input.push(move(value));
+                };
+                this->pTail->close = [pRawStage]() {
+                    pRawStage->input.close();
+                };
+                this->pCore->allStages.push_back(pStage);
+                return(pNextTail);
+            };
+
+            // Returns what dispatches a stage's consumers onto pQueue.
+            template <class QueueType>
+            static inline function<void(function<void()>)> dispatcherFor(QueueType * pQueue) {
+                return([pQueue](function<void()> newFunction) {
+                    pQueue->dispatchFunction(move(newFunction));
+                });
+            };
+
+            // Dispatches every stage's consumers.
+            inline void start() {
+                for (shared_ptr<QueuePipelineStageBase> & pStage : this->pCore->allStages) {
+                    pStage->start();
+                }
+                this->pCore->isStarted = true;
+            };
+
+        public:
+            // Constructor. The capacity is the number of values each stage's channel holds.
+            inline QueuePipeline(size_t capacity = QUEUE_PIPELINE_DEFAULT_CAPACITY) {
+                static_assert(is_same<In, Out>::value, "A new pipeline must start with its input type");
+                this->pCore            = make_shared<QueuePipelineCore<In>>();
+                this->pCore->pHead     = make_shared<QueuePipelineOutlet<In>>();
+                this->pCore->capacity  = capacity;
+                this->pCore->isStarted = false;
+                this->pTail            = this->pCore->pHead;
+                this->isTailSerial     = false;
+            };
+
+            // Adds a stage, run by the given number of threads, which turns each Out into a Next.
+            template <typename Next, typename StageFunc>
+            inline QueuePipeline<In, Next> then(unsigned int numThreads, StageFunc stageFunc) {
+                return(QueuePipeline<In, Next>(this->pCore, this->addStage<Next>(numThreads, stageFunc), (numThreads <= 1)));
+            };
+
+            // Same as above, except the stage's consumers run on pQueue's threads. Each consumer holds one of them for
+            // as long as the pipeline runs, so pQueue needs at least numConsumers threads to spare.
+            template <typename Next, typename StageFunc, class QueueType>
+            inline QueuePipeline<In, Next> then(QueueType * pQueue, unsigned int numConsumers, StageFunc stageFunc) {
+                return(QueuePipeline<In, Next>(this->pCore, this->addStage<Next>(numConsumers, stageFunc, QueuePipeline::dispatcherFor(pQueue)), (numConsumers <= 1)));
+            };
+
+            // Adds the last stage, run by the given number of threads, which consumes each Out. Starts the pipeline.
+            template <typename StageFunc>
+            inline void sink(unsigned int numThreads, StageFunc stageFunc) {
+                this->addStage<void>(numThreads, stageFunc);
+                this->start();
+            };
+
+            // Same as above, except the stage's consumers run on pQueue's threads (see then()).
+            template <typename StageFunc, class QueueType>
+            inline void sink(QueueType * pQueue, unsigned int numConsumers, StageFunc stageFunc) {
+                this->addStage<void>(numConsumers, stageFunc, QueuePipeline::dispatcherFor(pQueue));
+                this->start();
+            };
+
+            // Pushes a value into the first stage, blocking while it's full. Only valid once sink() has been called,
+            // and safe to call from any number of threads.
+            inline void push(In && value) {
+                this->pCore->pHead->emit(move(value));
+            };
+
+            // Waits for every pushed value to make its way through every stage. No more values can be pushed after.
+            inline void finish() {
+                if (!this->pCore->isStarted) {
+                    return;
+                }
+                this->pCore->pHead->close();
+                for (shared_ptr<QueuePipelineStageBase> & pStage : this->pCore->allStages) {
+                    pStage->join();
+                }
+                this->pCore->isStarted = false;
+            };
+
+            // Returns the number of stages with consumers of their own, after fusing.
+            inline size_t getNumStages() {
+                return(this->pCore->allStages.size());
+            };
+    };
+};
+
+#endif // __QUEUE_PIPELINE_H__
@@ -0,0 +1,98 @@
+#ifndef __QUEUE_PRODUCER_H__
+#define __QUEUE_PRODUCER_H__
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+// The number of pieces of work a producer buffers before handing them to its Queue, by default.
+#define QUEUE_PRODUCER_FLUSH_SIZE       64
+
+// The longest a piece of work sits in a producer's buffer before it's handed over anyway, by default.
+#define QUEUE_PRODUCER_FLUSH_US         1000
+
+// This header file uses the standard namespace.
+using namespace std;
+
+// Declare the QueueProducerBuffer within our DispatchCPP namespace.
+namespace DispatchCPP {
+    // Work dispatched by a single thread to a single Queue, waiting to be handed over to it in a batch. Only its own
+    // thread appends to it, so its lock is only ever contended when the Queue harvests it. Its Queue owns it; the
+    // thread only keeps a weak reference, so it goes away with the Queue.
+    class QueueProducerBuffer {
+        public:
+            // The work waiting to be handed over, and whether a timer is waiting to hand it over.
+            vector<function<void()>> allWork;
+            bool                     isTimerArmed;
+            mutex                    bufferLock;
+
+            // Held from taking the work out of the buffer until it's been handed to the Queue, so two handovers (say, one
+            // on a timer and one because the buffer filled up) can't pass each other and reorder the thread's work. Always
+            // taken before bufferLock.
+            mutex                    handoverLock;
+
+            // Constructor.
+            inline QueueProducerBuffer() {
+                this->allWork      = vector<function<void()>>();
+                this->isTimerArmed = false;
+            };
+
+            // Takes everything waiting out of the buffer. Hold handoverLock while handing it over.
+            inline vector<function<void()>> take() {
+                vector<function<void()>> allTaken = vector<function<void()>>();
+                lock_guard<mutex> tempLock(this->bufferLock);
+                allTaken.swap(this->allWork);
+                return(allTaken);
+            };
+
+            // Returns a new ID for a Queue's buffers, never reused (unlike the Queue's address).
+            static inline unsigned long long int nextOwnerID() {
+                static atomic<unsigned long long int> lastOwnerID(0);
+                return(lastOwnerID.fetch_add(1) + 1);
+            };
+
+            // Returns the calling thread's buffer for an owner, and whether it was just created (and so needs
+            // registering with its owner, which keeps it alive from then on).
+            static inline QueueProducerBuffer * forThread(unsigned long long int ownerID, shared_ptr<QueueProducerBuffer> & pCreated) {
+                static thread_local unsigned long long int                                           lastOwnerID = 0;
+                static thread_local QueueProducerBuffer                                            * pLastBuffer = nullptr;
+                static thread_local unordered_map<unsigned long long int, weak_ptr<QueueProducerBuffer>> allBuffers;
+                static thread_local size_t                                                            pruneSize   = 8;
+
+                // Most threads only ever produce for one Queue at a time, so remember the last buffer we handed out.
+                if (ownerID == lastOwnerID) {
+                    return(pLastBuffer);
+                }
+                auto existingBuffer = allBuffers.find(ownerID);
+                if (existingBuffer != allBuffers.end()) {
+                    lastOwnerID = ownerID;
+                    pLastBuffer = existingBuffer->second.lock().get();
+                    return(pLastBuffer);
+                }
+
+                // It's new. Every so often, forget the buffers of Queues which have since been destroyed (IDs are never
+                // reused, so they'd never be asked for again).
+                if (allBuffers.size() >= pruneSize) {
+                    for (auto bufferIter = allBuffers.begin(); bufferIter != allBuffers.end();) {
+                        bufferIter = (bufferIter->second.expired() ? allBuffers.erase(bufferIter) : next(bufferIter));
+                    }
+                    pruneSize = max((size_t) 8, (allBuffers.size() * 2));
+                }
+                pCreated = make_shared<QueueProducerBuffer>();
+                allBuffers.emplace(ownerID, pCreated);
+                lastOwnerID = ownerID;
+                pLastBuffer = pCreated.get();
+                return(pLastBuffer);
+            };
+    };
+};
+
+#endif // __QUEUE_PRODUCER_H__
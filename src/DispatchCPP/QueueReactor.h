@@ -0,0 +1,276 @@
+#ifndef __QUEUE_REACTOR_H__
+#define __QUEUE_REACTOR_H__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+
+#include <atomic>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <thread>
+
+#include "Queue.h"
+
+// The maximum number of ready file descriptors the reactor handles per call to epoll_wait.
+#define QUEUE_REACTOR_MAX_EVENTS    256
+
+// The longest the epoll thread sleeps before checking whether it's been told to stop, in case the wakeup we send it
+// on teardown never arrives.
+#define QUEUE_REACTOR_MAX_WAIT_MS   100
+
+// The number of times we try to wake the epoll thread on teardown, before leaving it to notice on its own.
+#define QUEUE_REACTOR_WAKE_RETRIES  8
+
+// This header file uses the standard namespace.
+using namespace std;
+
+// Declare the QueueReactor within our DispatchCPP namespace.
+namespace DispatchCPP {
+    // This class owns a single epoll thread. Work running on a Queue registers a file descriptor along with a
+    // continuation, and gives up its QueueThread. Once the file descriptor becomes ready, the continuation is dispatched
+    // back onto the Queue it was registered for. Queue threads are only ever held for the CPU-bound parts of I/O work.
+    class QueueReactor {
+        private:
+            // Everything we track for a single watched file descriptor.
+            typedef struct __QUEUE_REACTOR_WATCH__ {
+                uint32_t                             events;
+                uint32_t                             generation;
+                bool                                 isOneShot;
+                function<void(int, uint32_t)>        continuation;
+                function<bool(function<void()>)>     dispatcher;
+            } QueueReactorWatch;
+
+            // Our epoll thread.
+            thread * pThread;
+
+            // Our epoll instance, and the eventfd we use to wake the epoll thread.
+            int epollFD;
+            int wakeFD;
+
+            // Increments with each new watch, so a late event for a closed and reused descriptor is never misdelivered.
+            uint32_t nextGeneration;
+
+            // The lock protecting our map of watches, and the map itself.
+            mutex                       watchLock;
+            map<int, QueueReactorWatch> allWatches;
+
+            // Adds or re-arms a watch, given a function which dispatches onto the watch's Queue (returning false once the
+            // Queue's gone).
+            inline bool addWatch(int fd, uint32_t events, function<bool(function<void()>)> dispatcher, function<void(int, uint32_t)> continuation, bool isOneShot) {
+                // Make sure we have somewhere to register it.
+                if (this->epollFD < 0) {
+                    return(false);
+                }
+
+                lock_guard<mutex> tempLock(this->watchLock);
+
+                // Are we re-arming a descriptor we already know about, or adding a new one?
+                auto existingWatch = this->allWatches.find(fd);
+                bool isExisting    = (existingWatch != this->allWatches.end());
+
+                // Fill out the watch, now.
+                QueueReactorWatch newWatch;
+                newWatch.events       = events;
+                newWatch.generation   = (isExisting ? existingWatch->second.generation : this->nextGeneration++);
+                newWatch.isOneShot    = isOneShot;
+                newWatch.continuation = continuation;
+                newWatch.dispatcher   = dispatcher;
+
+                // Register it with epoll. The generation rides along in the upper half of the event's data. Watches which
+                // aren't one-shot are edge-triggered, so a descriptor which isn't drained doesn't flood its Queue.
+                struct epoll_event newEvent;
+                newEvent.events   = (events | (isOneShot ? ((uint32_t) EPOLLONESHOT) : ((uint32_t) EPOLLET)));
+                newEvent.data.u64 = ((((uint64_t) newWatch.generation) << 32) | ((uint64_t) (uint32_t) fd));
+                if (epoll_ctl(this->epollFD, (isExisting ? EPOLL_CTL_MOD : EPOLL_CTL_ADD), fd, &newEvent) != 0) {
+                    return(false);
+                }
+                this->allWatches[fd] = newWatch;
+                return(true);
+            };
+
+            // Starts the epoll thread.
+            inline void initializeReactor() {
+                this->epollFD = epoll_create1(EPOLL_CLOEXEC);
+                this->wakeFD  = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+                if ((this->epollFD < 0) || (this->wakeFD < 0)) {
+                    this->teardownReactor();
+                    return;
+                }
+
+                // Register our wake eventfd, which never carries a continuation.
+                struct epoll_event wakeEvent;
+                wakeEvent.events   = EPOLLIN;
+                wakeEvent.data.u64 = ((uint64_t) (uint32_t) this->wakeFD);
+                epoll_ctl(this->epollFD, EPOLL_CTL_ADD, this->wakeFD, &wakeEvent);
+
+                // Start the thread.
+                this->keepGoing = true;
+                this->pThread   = new thread(this->reactorThreadFunc, this);
+            };
+
+            // Forgets a watch whose Queue has gone away, as long as it hasn't been replaced since.
+            inline void dropWatch(int fd, uint32_t generation) {
+                lock_guard<mutex> tempLock(this->watchLock);
+                auto droppedWatch = this->allWatches.find(fd);
+                if ((droppedWatch != this->allWatches.end()) && (droppedWatch->second.generation == generation)) {
+                    this->allWatches.erase(droppedWatch);
+                    epoll_ctl(this->epollFD, EPOLL_CTL_DEL, fd, NULL);
+                }
+            };
+
+            // Stops the epoll thread, blocking until it joins back, and closes our descriptors.
+            inline void teardownReactor() {
+                // Tell the thread to stop, and wake it so it notices. Should the wakeup never land, the thread still
+                // notices within QUEUE_REACTOR_MAX_WAIT_MS.
+                this->keepGoing = false;
+                if (this->pThread) {
+                    uint64_t wakeValue = 1;
+                    for (unsigned int attempt = 0; attempt < QUEUE_REACTOR_WAKE_RETRIES; ++attempt) {
+                        if (write(this->wakeFD, &wakeValue, sizeof(wakeValue)) == sizeof(wakeValue)) {
+                            break;
+                        }
+                        if ((errno != EINTR) && (errno != EAGAIN)) {
+                            break;
+                        }
+                    }
+                    this->pThread->join();
+                    delete(this->pThread);
+                    this->pThread = nullptr;
+                }
+
+                // Close our descriptors. Watched descriptors belong to whoever registered them.
+                if (this->wakeFD >= 0) {
+                    close(this->wakeFD);
+                    this->wakeFD = -1;
+                }
+                if (this->epollFD >= 0) {
+                    close(this->epollFD);
+                    this->epollFD = -1;
+                }
+            };
+
+        public:
+            // Flags we use for interacting with the thread's execution.
+            atomic<bool> keepGoing;
+            atomic<bool> isRunning;
+
+            // Constructor.
+            inline QueueReactor() {
+                // Initialize our class members.
+                this->pThread        = nullptr;
+                this->epollFD        = -1;
+                this->wakeFD         = -1;
+                this->nextGeneration = 1;
+                this->keepGoing      = false;
+                this->isRunning      = false;
+
+                // Start our epoll thread, now.
+                this->initializeReactor();
+            };
+
+            // Destructor.
+            inline ~QueueReactor() {
+                this->teardownReactor();
+            };
+
+            // Watches a file descriptor for the given epoll events (EPOLLIN, EPOLLOUT, ...). Once any are ready, the
+            // continuation is dispatched onto pQueue, and is handed the descriptor and the events which were ready.
+            // One-shot watches (the default) fire once, and are re-armed by calling this again, typically from within
+            // the continuation itself. Other watches are edge-triggered: they fire each time the descriptor becomes
+            // ready, so the continuation has to drain it (read until EAGAIN) or it won't fire again. Calling this for a
+            // descriptor already being watched replaces its watch. If pQueue is destroyed, its watches are dropped the
+            // next time they're ready, and never dispatched.
+            template <class RType, typename ...Args>
+            inline bool watchFD(int fd, uint32_t events, Queue<RType, Args...> * pQueue, function<void(int, uint32_t)> continuation, bool isOneShot = true) {
+                if ((pQueue == nullptr) || (continuation == nullptr)) {
+                    return(false);
+                }
+                shared_ptr<QueueLifetime> pLifetime = pQueue->getLifetime();
+                return(this->addWatch(fd, events, [pQueue, pLifetime](function<void()> newFunction) {
+                    lock_guard<mutex> tempLock(pLifetime->lifetimeLock);
+                    if (!pLifetime->isAlive) {
+                        return(false);
+                    }
+                    pQueue->dispatchFunction(move(newFunction));
+                    return(true);
+                }, continuation, isOneShot));
+            };
+
+            // Stops watching a file descriptor. This must happen before the descriptor is closed. Any continuation
+            // which has already been dispatched will still run.
+            inline bool unwatchFD(int fd) {
+                lock_guard<mutex> tempLock(this->watchLock);
+                if (this->allWatches.erase(fd) == 0) {
+                    return(false);
+                }
+                return(epoll_ctl(this->epollFD, EPOLL_CTL_DEL, fd, NULL) == 0);
+            };
+
+            // Returns the number of file descriptors currently being watched.
+            inline unsigned int numWatches() {
+                lock_guard<mutex> tempLock(this->watchLock);
+                return((unsigned int) this->allWatches.size());
+            };
+
+        private:
+            function<void(DispatchCPP::QueueReactor *)> reactorThreadFunc = [](DispatchCPP::QueueReactor * pThis) {
+                struct epoll_event allEvents[QUEUE_REACTOR_MAX_EVENTS];
+
+                // Indicate that we're running, now.
+                pThis->isRunning = true;
+
+                // Keep going until we're told to stop.
+                while (pThis->keepGoing) {
+                    int numEvents = epoll_wait(pThis->epollFD, allEvents, QUEUE_REACTOR_MAX_EVENTS, QUEUE_REACTOR_MAX_WAIT_MS);
+                    if ((numEvents < 0) && (errno != EINTR)) {
+                        break;
+                    }
+
+                    for (int eventIndex = 0; eventIndex < numEvents; ++eventIndex) {
+                        int      readyFD         = ((int) (uint32_t) (allEvents[eventIndex].data.u64 & 0xFFFFFFFF));
+                        uint32_t readyGeneration = ((uint32_t) (allEvents[eventIndex].data.u64 >> 32));
+                        uint32_t readyEvents     = allEvents[eventIndex].events;
+
+                        // Were we simply woken up? If so, drain the eventfd.
+                        if (readyFD == pThis->wakeFD) {
+                            uint64_t wakeValue = 0;
+                            while (read(pThis->wakeFD, &wakeValue, sizeof(wakeValue)) > 0) {}
+                            continue;
+                        }
+
+                        // Grab the watch's continuation and dispatcher, as long as it's still the same watch.
+                        function<void(int, uint32_t)>    continuation = nullptr;
+                        function<bool(function<void()>)> dispatcher   = nullptr;
+                        pThis->watchLock.lock();
+                        auto readyWatch = pThis->allWatches.find(readyFD);
+                        if ((readyWatch != pThis->allWatches.end()) && (readyWatch->second.generation == readyGeneration)) {
+                            continuation = readyWatch->second.continuation;
+                            dispatcher   = readyWatch->second.dispatcher;
+                        }
+                        pThis->watchLock.unlock();
+
+                        // Hand the continuation back to its Queue, unless it's gone, in which case so is the watch.
+                        if ((continuation != nullptr) && (dispatcher != nullptr)) {
+                            bool wasDispatched = dispatcher([continuation, readyFD, readyEvents]() {
+                                continuation(readyFD, readyEvents);
+                            });
+                            if (!wasDispatched) {
+                                pThis->dropWatch(readyFD, readyGeneration);
+                            }
+                        }
+                    }
+                }
+
+                // Indicate that we're no longer running.
+                pThis->isRunning = false;
+            };
+    };
+};
+
+#endif // __QUEUE_REACTOR_H__
@@ -0,0 +1,204 @@
+#ifndef __QUEUE_SPILL_H__
+#define __QUEUE_SPILL_H__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#include <deque>
+#include <string>
+#include <string_view>
+
+// The size of each segment file records are spilled into, by default.
+#define QUEUE_SPILL_DEFAULT_SEGMENT_SIZE    (64 * 1024 * 1024)
+
+// The directory segment files are created within, by default. Not /tmp, which is often a tmpfs (kept in memory, or in
+// swap), where spilling would save no memory at all. Pass a directory on a real disk to Queue::setSpill() if this isn't.
+#define QUEUE_SPILL_DEFAULT_DIR             "/var/tmp"
+
+// The length written in place of a record's, for a marker: a placeholder with no record of its own.
+#define QUEUE_SPILL_MARKER_LENGTH           0xFFFFFFFFU
+
+// How much of a segment is written (or read) before we drop those pages from our mapping, keeping our resident memory
+// bounded no matter how far behind the readers get. The data itself stays in the file.
+#define QUEUE_SPILL_RELEASE_SIZE            (1024 * 1024)
+
+// This header file uses the standard namespace.
+using namespace std;
+
+// Declare the QueueSpill within our DispatchCPP namespace.
+namespace DispatchCPP {
+    // A FIFO of records kept on disk, in a chain of memory-mapped segment files. Records are appended to the newest
+    // segment and popped from the oldest, which is unmapped and closed once it's drained. Segment files are unlinked as
+    // soon as they're created, so their space goes back to the filesystem once they're closed (or we crash). Pages are
+    // dropped from our mapping once we're done with them, so only a couple of pages per segment are ever resident.
+    // Markers hold a record's place in line without any record, for whatever the owner keeps elsewhere. Not
+    // thread-safe: the owner locks around it.
+    class QueueSpill {
+        private:
+            // A segment file, mapped in, and how far it's been written and read.
+            typedef struct __QUEUE_SPILL_SEGMENT__ {
+                int    fileFD;
+                char * pData;
+                size_t dataSize;
+                size_t writePosition;
+                size_t readPosition;
+                size_t writeReleased;
+                size_t readReleased;
+            } QueueSpillSegment;
+
+            // Where new segments go, and how big they are.
+            string spillDir;
+            size_t segmentSize;
+
+            // Our segments, oldest first, and the number of records within them.
+            deque<QueueSpillSegment> allSegments;
+            size_t                   numRecords;
+
+            // Drops the pages from our mapping which fall entirely between the two positions.
+            static inline void releasePages(char * pData, size_t & released, size_t position) {
+                size_t pageSize = (size_t) sysconf(_SC_PAGESIZE);
+                size_t endPage  = ((position / pageSize) * pageSize);
+                if (endPage > released) {
+                    madvise(pData + released, endPage - released, MADV_DONTNEED);
+                    released = endPage;
+                }
+            };
+
+            // Creates, maps and appends a segment big enough for the record. Returns whether it could.
+            inline bool addSegment(size_t minSize) {
+                QueueSpillSegment newSegment;
+                newSegment.dataSize      = ((minSize > this->segmentSize) ? minSize : this->segmentSize);
+                newSegment.writePosition = 0;
+                newSegment.readPosition  = 0;
+                newSegment.writeReleased = 0;
+                newSegment.readReleased  = 0;
+
+                // Create the file, and unlink it straight away: it only lives as long as we keep it open.
+                string filePath = (this->spillDir + "/dispatchcpp-spill-XXXXXX");
+                newSegment.fileFD = mkstemp(&(filePath[0]));
+                if (newSegment.fileFD < 0) {
+                    return(false);
+                }
+                unlink(filePath.c_str());
+                if (ftruncate(newSegment.fileFD, (off_t) newSegment.dataSize) != 0) {
+                    close(newSegment.fileFD);
+                    return(false);
+                }
+                void * pMap = mmap(NULL, newSegment.dataSize, PROT_READ | PROT_WRITE, MAP_SHARED, newSegment.fileFD, 0);
+                if (pMap == MAP_FAILED) {
+                    close(newSegment.fileFD);
+                    return(false);
+                }
+                madvise(pMap, newSegment.dataSize, MADV_SEQUENTIAL);
+                newSegment.pData = (char *) pMap;
+                this->allSegments.push_back(newSegment);
+                return(true);
+            };
+
+            // Unmaps and closes the oldest segment.
+            inline void popSegment() {
+                QueueSpillSegment & oldSegment = this->allSegments.front();
+                munmap(oldSegment.pData, oldSegment.dataSize);
+                close(oldSegment.fileFD);
+                this->allSegments.pop_front();
+            };
+
+            // Appends a record's length (or our marker length), then the record itself.
+            inline bool append(string_view record, uint32_t recordLength) {
+                size_t recordSize = (sizeof(uint32_t) + record.size());
+                if ((this->allSegments.size() == 0) || ((this->allSegments.back().writePosition + recordSize) > this->allSegments.back().dataSize)) {
+                    if (!this->addSegment(recordSize)) {
+                        return(false);
+                    }
+                }
+
+                // Write its length, then the record itself.
+                QueueSpillSegment & writeSegment = this->allSegments.back();
+                memcpy(writeSegment.pData + writeSegment.writePosition, &recordLength, sizeof(uint32_t));
+                if (record.size() > 0) {
+                    memcpy(writeSegment.pData + writeSegment.writePosition + sizeof(uint32_t), record.data(), record.size());
+                }
+                writeSegment.writePosition += recordSize;
+                if ((writeSegment.writePosition - writeSegment.writeReleased) >= QUEUE_SPILL_RELEASE_SIZE) {
+                    QueueSpill::releasePages(writeSegment.pData, writeSegment.writeReleased, writeSegment.writePosition);
+                }
+                this->numRecords++;
+                return(true);
+            };
+
+        public:
+            // Constructor.
+            inline QueueSpill(string newSpillDir = QUEUE_SPILL_DEFAULT_DIR, size_t newSegmentSize = QUEUE_SPILL_DEFAULT_SEGMENT_SIZE) {
+                // Initialize our class members.
+                this->spillDir    = newSpillDir;
+                this->segmentSize = newSegmentSize;
+                this->allSegments = deque<QueueSpillSegment>();
+                this->numRecords  = 0;
+            };
+
+            // Destructor. Anything still spilled is thrown away.
+            inline ~QueueSpill() {
+                while (this->allSegments.size() > 0) {
+                    this->popSegment();
+                }
+            };
+
+            // Segments can't be shared by two owners.
+            QueueSpill(const QueueSpill &) = delete;
+            QueueSpill & operator=(const QueueSpill &) = delete;
+
+            // Appends a record. Returns false if no segment could be created for it.
+            inline bool push(string_view record) {
+                return(this->append(record, (uint32_t) record.size()));
+            };
+
+            // Appends a marker. Returns false if no segment could be created for it.
+            inline bool pushMarker() {
+                return(this->append(string_view(), QUEUE_SPILL_MARKER_LENGTH));
+            };
+
+            // Pops the oldest record into the string (reusing its space), or tells us it's a marker. Returns false if
+            // there are none, or if the next one runs past what was written (in which case nothing more can be popped).
+            inline bool pop(string & record, bool & isMarker) {
+                // Move past any segments we've drained.
+                while ((this->allSegments.size() > 1) && (this->allSegments.front().readPosition >= this->allSegments.front().writePosition)) {
+                    this->popSegment();
+                }
+                if (this->numRecords == 0) {
+                    return(false);
+                }
+
+                // Read its length, then the record itself.
+                QueueSpillSegment & readSegment  = this->allSegments.front();
+                uint32_t            recordLength = 0;
+                if ((readSegment.readPosition + sizeof(uint32_t)) > readSegment.writePosition) {
+                    return(false);
+                }
+                memcpy(&recordLength, readSegment.pData + readSegment.readPosition, sizeof(uint32_t));
+                isMarker = (recordLength == QUEUE_SPILL_MARKER_LENGTH);
+                size_t dataLength = (isMarker ? 0 : (size_t) recordLength);
+                if ((readSegment.readPosition + sizeof(uint32_t) + dataLength) > readSegment.writePosition) {
+                    return(false);
+                }
+                record.assign(readSegment.pData + readSegment.readPosition + sizeof(uint32_t), dataLength);
+                readSegment.readPosition += (sizeof(uint32_t) + dataLength);
+                if ((readSegment.readPosition - readSegment.readReleased) >= QUEUE_SPILL_RELEASE_SIZE) {
+                    QueueSpill::releasePages(readSegment.pData, readSegment.readReleased, readSegment.readPosition);
+                }
+                this->numRecords--;
+                return(true);
+            };
+
+            // Returns the number of records (and markers) spilled.
+            inline size_t size() const {
+                return(this->numRecords);
+            };
+    };
+};
+
+#endif // __QUEUE_SPILL_H__
@@ -0,0 +1,240 @@
+#ifndef __QUEUE_STREAM_H__
+#define __QUEUE_STREAM_H__
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+// The number of results a stream holds by default, before dispatching blocks.
+#define QUEUE_STREAM_DEFAULT_CAPACITY   1024
+
+// The number of times a stream's consumer (or a blocked dispatcher) yields, before it goes to sleep.
+#define QUEUE_STREAM_SPIN_COUNT         64
+
+// The size of a cache line, used to keep our producer and consumer positions apart.
+#define QUEUE_STREAM_CACHE_LINE_SIZE    64
+
+// This header file uses the standard namespace.
+using namespace std;
+
+// Declare the QueueResultStream within our DispatchCPP namespace.
+namespace DispatchCPP {
+    // Hands back the results of work dispatched with Queue::dispatchWorkOrdered() in the order it was dispatched, no
+    // matter what order it finishes in. Each dispatch reserves the next sequence number, and its result is published
+    // into that slot of a fixed-size ring without any locking. A single consumer reads the ring in order with next().
+    // When the ring is full, dispatching blocks until the consumer catches up, so memory stays bounded. Threads only
+    // ever sleep on a lock when they're actually blocked, and are only woken when someone is.
+    template <typename T> class QueueResultStream {
+        private:
+            // A slot in our ring. It holds sequence + 1 once the result for sequence has been published into it (or a
+            // tombstone, if the work was thrown away before it could publish anything).
+            typedef struct __QUEUE_STREAM_SLOT__ {
+                atomic<unsigned long long int> readySequence;
+                bool                           isAbandoned;
+                T                              value;
+            } QueueStreamSlot;
+
+            // Our ring, its size (a power of two), and how far the consumer gets between waking blocked dispatchers.
+            unique_ptr<QueueStreamSlot[]> allSlots;
+            unsigned long long int        capacity;
+            unsigned long long int        wakeInterval;
+
+            // The next sequence number to be handed out, and the next one to be consumed.
+            alignas(QUEUE_STREAM_CACHE_LINE_SIZE) atomic<unsigned long long int> nextSequence;
+            alignas(QUEUE_STREAM_CACHE_LINE_SIZE) atomic<unsigned long long int> readSequence;
+
+            // Whether all the work has been dispatched, the number of tombstones skipped, and the number of threads
+            // asleep waiting on the stream: the consumer, and dispatchers blocked on a full ring.
+            atomic<bool>                   isClosed;
+            atomic<unsigned long long int> numAbandoned;
+            atomic<unsigned int>           numConsumerWaiting;
+            atomic<unsigned int>           numReserveWaiting;
+
+            // The lock blocked threads sleep on, and what the consumer and blocked dispatchers each sleep on.
+            mutex              waitLock;
+            condition_variable consumerVar;
+            condition_variable reserveVar;
+
+            // Blocks until the condition holds: yielding at first, then sleeping on waitVar.
+            template <typename Condition>
+            inline void waitUntil(atomic<unsigned int> & numWaiting, condition_variable & waitVar, Condition condition) {
+                for (unsigned int spinIndex = 0; spinIndex < QUEUE_STREAM_SPIN_COUNT; ++spinIndex) {
+                    if (condition()) {
+                        return;
+                    }
+                    this_thread::yield();
+                }
+                numWaiting.fetch_add(1);
+                unique_lock<mutex> tempLock(this->waitLock);
+                waitVar.wait(tempLock, condition);
+                tempLock.unlock();
+                numWaiting.fetch_sub(1);
+            };
+
+            // Wakes anyone asleep on waitVar.
+            inline void wake(atomic<unsigned int> & numWaiting, condition_variable & waitVar) {
+                if (numWaiting.load() > 0) {
+                    this->waitLock.lock();
+                    this->waitLock.unlock();
+                    waitVar.notify_all();
+                }
+            };
+
+            // Fills in a reserved sequence number's slot, waking the consumer if it's the one it's waiting on.
+            inline void fill(unsigned long long int sequence, bool isAbandoned, T && value) {
+                QueueStreamSlot * pSlot = &(this->allSlots[sequence & (this->capacity - 1)]);
+                if (!isAbandoned) {
+                    pSlot->value = move(value);
+                }
+                pSlot->isAbandoned = isAbandoned;
+                pSlot->readySequence.store(sequence + 1);
+                if (sequence == this->readSequence.load()) {
+                    this->wake(this->numConsumerWaiting, this->consumerVar);
+                }
+            };
+
+        public:
+            // Constructor. The capacity is rounded up to a power of two.
+            inline QueueResultStream(unsigned long long int minCapacity = QUEUE_STREAM_DEFAULT_CAPACITY) {
+                this->capacity = 1;
+                while (this->capacity < minCapacity) {
+                    this->capacity <<= 1;
+                }
+                this->wakeInterval = max(this->capacity / 2, 1ULL);
+                this->allSlots     = unique_ptr<QueueStreamSlot[]>(new QueueStreamSlot[this->capacity]);
+                for (unsigned long long int slotIndex = 0; slotIndex < this->capacity; ++slotIndex) {
+                    this->allSlots[slotIndex].readySequence = 0;
+                    this->allSlots[slotIndex].isAbandoned   = false;
+                }
+                this->nextSequence       = 0;
+                this->readSequence       = 0;
+                this->isClosed           = false;
+                this->numAbandoned       = 0;
+                this->numConsumerWaiting = 0;
+                this->numReserveWaiting  = 0;
+            };
+
+            // Reserves the next sequence number, blocking while the ring is full. Blocked dispatchers are woken every
+            // half a ring the consumer gets through, rather than for every slot it frees.
+            inline unsigned long long int reserve() {
+                unsigned long long int sequence = this->nextSequence.fetch_add(1);
+                if (sequence >= (this->readSequence.load() + this->capacity)) {
+                    unsigned long long int slack = (this->capacity / 2);
+                    this->waitUntil(this->numReserveWaiting, this->reserveVar, [this, sequence, slack]() {
+                        return((sequence + slack) < (this->readSequence.load() + this->capacity));
+                    });
+                }
+                return(sequence);
+            };
+
+            // Publishes the result for a reserved sequence number.
+            inline void publish(unsigned long long int sequence, T && value) {
+                this->fill(sequence, false, move(value));
+            };
+
+            // Publishes a tombstone for a reserved sequence number whose result will never come, which next() skips.
+            inline void abandon(unsigned long long int sequence) {
+                this->fill(sequence, true, T{});
+            };
+
+            // Marks the stream as finished: once everything dispatched so far has been consumed, next() returns false.
+            // Call this after the last dispatch.
+            inline void close() {
+                this->isClosed = true;
+                this->wake(this->numConsumerWaiting, this->consumerVar);
+            };
+
+            // Hands back the next result in dispatch order, blocking until it's ready, and skipping tombstones. Returns
+            // false once the stream has been closed and every result consumed. Only a single thread may consume a stream.
+            inline bool next(T & value) {
+                while (true) {
+                    unsigned long long int sequence = this->readSequence.load(memory_order_relaxed);
+                    QueueStreamSlot      * pSlot    = &(this->allSlots[sequence & (this->capacity - 1)]);
+
+                    // About to wait? Then let blocked dispatchers have whatever room there is first, since we might be
+                    // waiting on one of them.
+                    if ((pSlot->readySequence.load() != (sequence + 1)) && (this->numReserveWaiting.load() > 0)) {
+                        this->wake(this->numReserveWaiting, this->reserveVar);
+                    }
+                    this->waitUntil(this->numConsumerWaiting, this->consumerVar, [this, pSlot, sequence]() {
+                        return((pSlot->readySequence.load() == (sequence + 1)) || (this->isClosed.load() && (sequence >= this->nextSequence.load())));
+                    });
+                    if (pSlot->readySequence.load() != (sequence + 1)) {
+                        return(false);
+                    }
+
+                    // Take the result, and free up its slot.
+                    bool isAbandoned = pSlot->isAbandoned;
+                    if (!isAbandoned) {
+                        value = move(pSlot->value);
+                    }
+                    this->readSequence.store(sequence + 1);
+                    if (((sequence + 1) % this->wakeInterval) == 0) {
+                        this->wake(this->numReserveWaiting, this->reserveVar);
+                    }
+                    if (!isAbandoned) {
+                        return(true);
+                    }
+                    this->numAbandoned.fetch_add(1);
+                }
+            };
+
+            // Returns the number of results dispatched but not yet consumed.
+            inline unsigned long long int numPending() {
+                return(this->nextSequence.load() - this->readSequence.load());
+            };
+
+            // Returns the number of tombstones next() has skipped: results whose work was thrown away before it ran.
+            inline unsigned long long int getNumAbandoned() {
+                return(this->numAbandoned.load());
+            };
+
+            // Returns the most results the stream holds at once.
+            inline unsigned long long int getCapacity() {
+                return(this->capacity);
+            };
+    };
+
+    // A sequence number reserved from a stream, which publishes a tombstone in its place if it's destroyed before its
+    // result is published (say, because its work was thrown away along with its Queue), so the consumer never waits on
+    // a result which will never come.
+    template <typename T> class QueueStreamReservation {
+        private:
+            QueueResultStream<T> * pStream;
+            unsigned long long int sequence;
+            bool                   isPublished;
+
+        public:
+            // Constructor. Reserves the next sequence number, blocking while the stream is full.
+            inline QueueStreamReservation(QueueResultStream<T> * pNewStream) {
+                this->pStream     = pNewStream;
+                this->sequence    = pNewStream->reserve();
+                this->isPublished = false;
+            };
+
+            // Destructor.
+            inline ~QueueStreamReservation() {
+                if (!this->isPublished) {
+                    this->pStream->abandon(this->sequence);
+                }
+            };
+
+            // Reservations can't be copied, since only one may publish.
+            QueueStreamReservation(const QueueStreamReservation &) = delete;
+            QueueStreamReservation & operator=(const QueueStreamReservation &) = delete;
+
+            // Publishes our result.
+            inline void publish(T && value) {
+                this->pStream->publish(this->sequence, move(value));
+                this->isPublished = true;
+            };
+    };
+};
+
+#endif // __QUEUE_STREAM_H__
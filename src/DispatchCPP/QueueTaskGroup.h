@@ -0,0 +1,127 @@
+#ifndef __QUEUE_TASK_GROUP_H__
+#define __QUEUE_TASK_GROUP_H__
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <atomic>
+#include <functional>
+#include <memory>
+
+#include "Queue.h"
+#include "QueueWait.h"
+
+// This header file uses the standard namespace.
+using namespace std;
+
+// Declare the QueueTaskGroup within our DispatchCPP namespace.
+namespace DispatchCPP {
+    // Fork-join on top of a Queue. Tasks are spawned onto the Queue, and wait() blocks until all of them have finished.
+    // While waiting, the waiting thread runs whatever work is pending on the Queue, rather than sleeping. So a task
+    // running on one of the Queue's threads can spawn subtasks onto its own Queue and wait on them (recursively, as
+    // deep as it likes) without every thread ending up asleep waiting on work no one is left to run.
+    class QueueTaskGroup {
+        private:
+            // Everything our spawned tasks share with us. It's kept alive by each task, so a task finishing never
+            // touches a group which has already been destroyed. Waiters sleep on the Queue's wait state, so they're woken
+            // by new work on the Queue as well as by our last task finishing.
+            typedef struct __QUEUE_TASK_GROUP_STATE__ {
+                atomic<unsigned int> numPending;
+                QueueWaitState *     pWaitState;
+            } QueueTaskGroupState;
+            shared_ptr<QueueTaskGroupState> pState;
+
+            // Finishes a spawned task on behalf of the group, exactly once: when the task has run, or when it's destroyed
+            // without ever having run (thrown away by a Queue being destroyed, say), so wait() still returns.
+            class QueueTaskGroupFinishGuard {
+                private:
+                    shared_ptr<QueueTaskGroupState> pState;
+                    bool                            hasFinished;
+
+                public:
+                    // Constructor.
+                    inline QueueTaskGroupFinishGuard(shared_ptr<QueueTaskGroupState> pNewState) {
+                        this->pState      = pNewState;
+                        this->hasFinished = false;
+                    };
+
+                    // Destructor.
+                    inline ~QueueTaskGroupFinishGuard() {
+                        this->finish();
+                    };
+
+                    // Guards can't be copied, since only one may finish.
+                    QueueTaskGroupFinishGuard(const QueueTaskGroupFinishGuard &) = delete;
+                    QueueTaskGroupFinishGuard & operator=(const QueueTaskGroupFinishGuard &) = delete;
+
+                    // Finishes the task, unless we already have. Were we the last task? If so, wake whoever's waiting.
+                    inline void finish() {
+                        if (!this->hasFinished) {
+                            this->hasFinished = true;
+                            if (this->pState->numPending.fetch_sub(1) == 1) {
+                                this->pState->pWaitState->wakeHelpers();
+                            }
+                        }
+                    };
+            };
+
+            // Dispatches a function onto our Queue, and runs one piece of our Queue's pending work.
+            function<void(function<void()>)> dispatcher;
+            function<bool(void)>             helper;
+
+        public:
+            // Constructor. Tasks spawned by this group run on pQueue's threads (its QueueFunction is never called).
+            template <class RType, typename ...Args>
+            inline QueueTaskGroup(Queue<RType, Args...> * pQueue) {
+                this->pState             = make_shared<QueueTaskGroupState>();
+                this->pState->numPending = 0;
+                this->pState->pWaitState = pQueue->getWaitState();
+                this->dispatcher         = [pQueue](function<void()> newFunction) {
+                    pQueue->dispatchFunction(move(newFunction));
+                };
+                this->helper             = [pQueue]() {
+                    return(pQueue->runPendingWork());
+                };
+            };
+
+            // Destructor. Waits on anything still running, since tasks commonly refer to the caller's stack.
+            inline ~QueueTaskGroup() {
+                this->wait();
+            };
+
+            // Spawns a task onto our Queue. It counts as finished once it's run, or once it's thrown away without running.
+            inline void spawn(function<void()> newTask) {
+                this->pState->numPending.fetch_add(1, memory_order_relaxed);
+                shared_ptr<QueueTaskGroupFinishGuard> pGuard = make_shared<QueueTaskGroupFinishGuard>(this->pState);
+                this->dispatcher([pGuard, newTask]() {
+                    newTask();
+                    pGuard->finish();
+                });
+            };
+
+            // Blocks until every task spawned so far has finished, running the Queue's pending work in the meantime.
+            inline void wait() {
+                QueueTaskGroupState * pWaitingState = this->pState.get();
+                while (pWaitingState->numPending.load() > 0) {
+                    // Help out, if there's anything to help with.
+                    unsigned long long int seenSequence = pWaitingState->pWaitState->signalSequence.load();
+                    if (this->helper()) {
+                        continue;
+                    }
+
+                    // There isn't, so our tasks are running on other threads. Sleep until they finish, or until something
+                    // new is queued which we could help with.
+                    pWaitingState->pWaitState->waitToHelp(seenSequence, [pWaitingState] {
+                        return(pWaitingState->numPending.load() == 0);
+                    });
+                }
+            };
+
+            // Returns the number of spawned tasks which haven't finished yet.
+            inline unsigned int numPending() {
+                return(this->pState->numPending.load(memory_order_acquire));
+            };
+    };
+};
+
+#endif // __QUEUE_TASK_GROUP_H__
@@ -7,11 +7,18 @@
 #include <semaphore.h>
 #include <unistd.h>
 
+#include <atomic>
+#include <chrono>
+#include <deque>
 #include <functional>
 #include <thread>
 #include <condition_variable>
 #include <mutex>
 
+#include "QueueBarrier.h"
+#include "QueueLimiter.h"
+#include "QueueWait.h"
+
 // Defines
 #define THREAD_INIT_LOOP_WAIT_TIME_US         1
 #define THREAD_INIT_LOOP_MAX_WAIT_TIME_US     500
@@ -19,12 +26,32 @@
 #define THREAD_TEARDOWN_LOOP_MAX_WAIT_TIME_US 5000
 #define THREAD_TEARDOWN_LOOP_ENABLE_NOTIFY
 
+// The size of a cache line. Each QueueThread's state lives on its own, so workers updating their state never
+// invalidate the lines other workers (or whoever is polling them) are reading.
+#define QUEUE_THREAD_CACHE_LINE_SIZE          64
+
 // This header file uses the standard namespace.
 using namespace std;
 
 // Typedef pthread_t to QueueThreadID
 typedef pthread_t QueueTID;
 
+// The states a QueueThread moves through.
+typedef enum {
+    QueueThreadStateStarting = 0,   // Not yet waiting on work.
+    QueueThreadStateParked,         // Asleep, waiting on work to be dispatched.
+    QueueThreadStateIdle,           // Awake, but not running any work.
+    QueueThreadStateRunning,        // Running a piece of work.
+    QueueThreadStateStopped         // Finished, and no longer running.
+} QueueThreadState;
+
+// A consistent snapshot of a single QueueThread's state.
+typedef struct __QUEUE_THREAD_STATUS__ {
+    QueueThreadState       state;
+    long long int          taskStartNS;     // When the current work started (steady_clock), or 0 when not running any.
+    unsigned long long int numTasksDone;
+} QueueThreadStatus;
+
 // Forward declaration of our class within the DispatchCPP namespace.
 namespace DispatchCPP { class QueueThread; };
 
@@ -32,9 +59,33 @@ namespace DispatchCPP { class QueueThread; };
 namespace DispatchCPP {
     class QueueThread {
         private:
+            // Our state, which only our own thread ever writes. It's kept on its own cache line, and guarded by a
+            // sequence number (odd while being updated) so that readers can take a consistent snapshot of it without
+            // any locking.
+            typedef struct alignas(QUEUE_THREAD_CACHE_LINE_SIZE) __QUEUE_THREAD_STATE_BLOCK__ {
+                atomic<unsigned int>           sequence;
+                atomic<int>                    state;
+                atomic<long long int>          taskStartNS;
+                atomic<unsigned long long int> numTasksDone;
+            } QueueThreadStateBlock;
+            QueueThreadStateBlock stateBlock;
+
             // Our thread object, itself.
             thread * pThread;
 
+            // Updates our state. Only ever called from our own thread.
+            inline void setState(QueueThreadState newState, long long int newTaskStartNS, unsigned int numNewTasksDone) {
+                unsigned int sequence = this->stateBlock.sequence.load(memory_order_relaxed);
+                this->stateBlock.sequence.store(sequence + 1, memory_order_relaxed);
+                atomic_thread_fence(memory_order_release);
+                this->stateBlock.taskStartNS.store(newTaskStartNS, memory_order_relaxed);
+                if (numNewTasksDone > 0) {
+                    this->stateBlock.numTasksDone.store(this->stateBlock.numTasksDone.load(memory_order_relaxed) + numNewTasksDone, memory_order_relaxed);
+                }
+                this->stateBlock.state.store((int) newState, memory_order_relaxed);
+                this->stateBlock.sequence.store(sequence + 2, memory_order_release);
+            };
+
             // Initializes the thread.
             inline void initializeThread() {
                 // Make sure we're not already running.
@@ -129,10 +180,10 @@ namespace DispatchCPP {
             // Our close function.
             function<void(void)> closeFunc;
 
-            // Flags we use for interacting with the thread's execution.
-            volatile bool keepGoing;
-            volatile bool isRunning;
-            volatile bool isIdle;
+            // Flags we use for interacting with the thread's execution. These are written rarely (on start and stop),
+            // so they stay off of the cache line our state's constantly being written to.
+            atomic<bool> keepGoing;
+            atomic<bool> isRunning;
 
             // A pointer to our mutex protecting the deque of work.
             mutex * pWorkLock;
@@ -143,21 +194,44 @@ namespace DispatchCPP {
             // A pointer to our deque of work.
             deque<function<void()>> * pWorkQueue;
 
+            // A pointer to the limiter deciding when we may start work (or nullptr), guarded by pWorkLock.
+            QueueLimiter * pLimiter;
+
+            // A pointer to the barrier tracking which also decides when we may start work (or nullptr), guarded by pWorkLock.
+            QueueBarrier * pBarrier;
+
+            // A pointer to the wait strategy we follow while there's no work (or nullptr, to just park).
+            QueueWaitState * pWaitState;
+
+            // Work which only this thread may run (keyed work, which must stay in order), also guarded by pWorkLock.
+            // It's run before anything in the shared deque.
+            deque<function<void()>> laneWork;
+
             // Constructor.
             inline QueueThread(function<void(void)>      newInitFunc,
                                function<void(void)>      newCloseFunc,
                                mutex                   * pNewWorkLock,
                                condition_variable      * pNewWorkVar,
-                               deque<function<void()>> * pNewWorkQueue) {
+                               deque<function<void()>> * pNewWorkQueue,
+                               QueueLimiter            * pNewLimiter = nullptr,
+                               QueueBarrier            * pNewBarrier = nullptr,
+                               QueueWaitState          * pNewWaitState = nullptr) {
                 // Initialize our class members.
                 this->initFunc   = newInitFunc;
                 this->closeFunc  = newCloseFunc;
                 this->keepGoing  = true;
                 this->isRunning  = false;
-                this->isIdle     = false;
+                this->stateBlock.sequence     = 0;
+                this->stateBlock.state        = (int) QueueThreadStateStarting;
+                this->stateBlock.taskStartNS  = 0;
+                this->stateBlock.numTasksDone = 0;
                 this->pWorkLock  = pNewWorkLock;
                 this->pWorkVar   = pNewWorkVar;
                 this->pWorkQueue = pNewWorkQueue;
+                this->pLimiter   = pNewLimiter;
+                this->pBarrier   = pNewBarrier;
+                this->pWaitState = pNewWaitState;
+                this->laneWork   = deque<function<void()>>();
 
                 // Initialize our thread, now.
                 this->initializeThread();
@@ -169,11 +243,51 @@ namespace DispatchCPP {
                 this->teardownThread();
             };
 
+            // Returns whether we're not currently running any work. A single acquire load of our state.
+            inline bool isIdle() {
+                int currentState = this->stateBlock.state.load(memory_order_acquire);
+                return((currentState != QueueThreadStateRunning) && (currentState != QueueThreadStateStarting));
+            };
+
+            // Returns a consistent snapshot of our state, retrying if our thread was mid-update.
+            inline QueueThreadStatus getStatus() {
+                QueueThreadStatus status;
+                while (true) {
+                    unsigned int sequenceBefore = this->stateBlock.sequence.load(memory_order_acquire);
+                    status.state        = (QueueThreadState) this->stateBlock.state.load(memory_order_relaxed);
+                    status.taskStartNS  = this->stateBlock.taskStartNS.load(memory_order_relaxed);
+                    status.numTasksDone = this->stateBlock.numTasksDone.load(memory_order_relaxed);
+                    atomic_thread_fence(memory_order_acquire);
+                    unsigned int sequenceAfter = this->stateBlock.sequence.load(memory_order_relaxed);
+                    if (((sequenceBefore & 1) == 0) && (sequenceBefore == sequenceAfter)) {
+                        break;
+                    }
+                    this_thread::yield();
+                }
+                return(status);
+            };
+
+            // Returns whether there's work we could pick up. Must be called while holding pWorkLock.
+            inline bool hasWork() {
+                return((this->laneWork.size() > 0) || (this->pWorkQueue->size() > 0));
+            };
+
+            // Returns whether our next work comes from the shared deque rather than our lane: it does once our lane is
+            // empty, or whenever a barrier is next in line. Must be called while holding pWorkLock.
+            inline bool takesShared() {
+                return((this->laneWork.size() == 0) || ((this->pBarrier != nullptr) && this->pBarrier->isBarrierNext()));
+            };
+
             // Return the current thread's ID.
             static inline QueueTID TID() {
                 return(pthread_self());
             };
 
+            // Returns the current steady_clock time, in nanoseconds. The clock every QueueThread timestamps its work with.
+            static inline long long int nowNS() {
+                return((long long int) chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count());
+            };
+
         private:
             function<void(DispatchCPP::QueueThread *)> queueThreadFunc = [](DispatchCPP::QueueThread * pThis) {
                 // Check if we have a valid init function.
@@ -185,20 +299,54 @@ namespace DispatchCPP {
                 pThis->isRunning = true;
 
                 // Keep going until we're told to stop.
+                pThis->setState(QueueThreadStateIdle, 0, 0);
                 while (pThis->keepGoing) {
-                    // Indicate that we're currently idle.
-                    pThis->isIdle = true;
-
-                    // Wait until there's work to do.
+                    // Wait until there's work to do, spinning first if our strategy says to. We only mark ourselves parked
+                    // if we're actually going to sleep.
                     unique_lock<mutex> tempLock(*(pThis->pWorkLock));
-                    pThis->pWorkVar->wait(tempLock, [pThis] {
-                        bool hasNoWork         = (pThis->pWorkQueue->size() == 0);
-                        bool shouldKeepWaiting = (pThis->keepGoing && hasNoWork);
-                        return(!shouldKeepWaiting);
-                    });
+                    if (pThis->keepGoing && !pThis->hasWork() && (pThis->pWaitState != nullptr) && pThis->pWaitState->isSpinning()) {
+                        unsigned long long int seenSequence = pThis->pWaitState->signalSequence.load();
+                        tempLock.unlock();
+                        pThis->pWaitState->spin(seenSequence, pThis->keepGoing);
+                        tempLock.lock();
+                    }
+                    if (pThis->keepGoing && !pThis->hasWork()) {
+                        pThis->setState(QueueThreadStateParked, 0, 0);
+                        if (pThis->pWaitState != nullptr) {
+                            pThis->pWaitState->numParked.fetch_add(1);
+                        }
+                        // Count every time we're woken, including when someone else got to the work first.
+                        while (pThis->keepGoing && !pThis->hasWork()) {
+                            pThis->pWorkVar->wait(tempLock);
+                            if (pThis->pWaitState != nullptr) {
+                                pThis->pWaitState->numWakeups.fetch_add(1, memory_order_relaxed);
+                            }
+                        }
+                        if (pThis->pWaitState != nullptr) {
+                            pThis->pWaitState->numParked.fetch_sub(1);
+                        }
+                    }
 
-                    // Indicate that we're no longer idle.
-                    pThis->isIdle = false;
+                    // Work stays queued (and we stay parked) while a barrier holds it back, or until the limiter lets it
+                    // start.
+                    bool wasAdmitted = false;
+                    while (pThis->keepGoing && pThis->hasWork()) {
+                        long long int waitNS = 0;
+                        if ((pThis->pBarrier == nullptr) || pThis->pBarrier->canStart(pThis->takesShared())) {
+                            if ((pThis->pLimiter == nullptr) || !pThis->pLimiter->isEnabled()) {
+                                break;
+                            }
+                            if ((wasAdmitted = pThis->pLimiter->tryAcquire(waitNS))) {
+                                break;
+                            }
+                        }
+                        pThis->setState(QueueThreadStateParked, 0, 0);
+                        if (waitNS > 0) {
+                            pThis->pWorkVar->wait_for(tempLock, chrono::nanoseconds(waitNS));
+                        } else {
+                            pThis->pWorkVar->wait(tempLock);
+                        }
+                    }
 
                     // Are we being told to stop working? (after being woken up)
                     if (!pThis->keepGoing) {
@@ -208,12 +356,24 @@ namespace DispatchCPP {
                     }
 
                     // There's work to do! Grab the lock on the array of work, now.
-                    function<void()> newWork = nullptr;
-
-                    // Do we have any work?
-                    if (pThis->pWorkQueue->size() > 0) {
-                        newWork = pThis->pWorkQueue->front();
-                        pThis->pWorkQueue->pop_front();
+                    function<void()> newWork    = nullptr;
+                    bool             wasBarrier = false;
+
+                    // Do we have any work? Our own lane comes first, unless a barrier's next. Mark ourselves running while
+                    // we still hold the lock, so anyone who sees an empty queue also sees that we're busy with what was in it.
+                    if (pThis->hasWork()) {
+                        bool fromSharedDeque = pThis->takesShared();
+                        if (fromSharedDeque) {
+                            newWork = move(pThis->pWorkQueue->front());
+                            pThis->pWorkQueue->pop_front();
+                        } else {
+                            newWork = move(pThis->laneWork.front());
+                            pThis->laneWork.pop_front();
+                        }
+                        if (pThis->pBarrier != nullptr) {
+                            wasBarrier = pThis->pBarrier->started(fromSharedDeque);
+                        }
+                        pThis->setState(QueueThreadStateRunning, nowNS(), 0);
                     }
 
                     // Release the lock we have on the work queue.
@@ -222,10 +382,23 @@ namespace DispatchCPP {
                     // Did we get some work to do?
                     if (newWork != nullptr) {
                         newWork();
-                    }
 
-                    // Indicate that we're idle, now.
-                    pThis->isIdle = true;
+                        // Let the limiter know we're done, so whoever's waiting on us can start.
+                        if (wasAdmitted) {
+                            pThis->pWorkLock->lock();
+                            pThis->pLimiter->release();
+                            pThis->pWorkLock->unlock();
+                            pThis->pWorkVar->notify_all();
+                        }
+
+                        // Let any barrier waiting on us know we're done.
+                        if (pThis->pBarrier != nullptr) {
+                            pThis->pBarrier->finished(wasBarrier, pThis->pWorkLock, pThis->pWorkVar, pThis->pWaitState);
+                        }
+
+                        // Indicate that we're idle, now.
+                        pThis->setState(QueueThreadStateIdle, 0, 1);
+                    }
                 }
 
                 // Check if we have a valid close function.
@@ -234,8 +407,8 @@ namespace DispatchCPP {
                 }
 
                 // Indicate that we're no longer running, and that we're idle.
+                pThis->setState(QueueThreadStateStopped, 0, 0);
                 pThis->isRunning = false;
-                pThis->isIdle    = true;
             };
     };
 };
@@ -0,0 +1,392 @@
+#ifndef __QUEUE_TIMER_H__
+#define __QUEUE_TIMER_H__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// The resolution of the timer wheel. Timers never fire early, and fire at most one tick late (plus dispatch latency).
+#define QUEUE_TIMER_TICK_US             1000
+
+// The shape of the hierarchical timer wheel: each level has 2^bits slots, and each slot of a level spans a whole
+// rotation of the level below it. 5 levels of 64 slots at 1ms ticks cover ~12 days before timers need re-cascading.
+#define QUEUE_TIMER_WHEEL_BITS          6
+#define QUEUE_TIMER_WHEEL_SLOTS         (1 << QUEUE_TIMER_WHEEL_BITS)
+#define QUEUE_TIMER_WHEEL_LEVELS        5
+
+// Marks the end of a slot's list of timers, as well as an unused timer.
+#define QUEUE_TIMER_NIL                 0xFFFFFFFF
+
+// This header file uses the standard namespace.
+using namespace std;
+
+// Typedef the handle returned for each timer. Zero is never a valid timer.
+typedef unsigned long long int QueueTimerID;
+
+// Declare the QueueTimerWheel within our DispatchCPP namespace.
+namespace DispatchCPP {
+    // A hierarchical timing wheel, serviced by a single timer thread shared by every Queue. Adding and cancelling a
+    // timer are both O(1): timers live in a pool, are linked into their slot by index, and are unlinked by index.
+    class QueueTimerWheel {
+        private:
+            // Everything we track for a single timer. Timers are linked into their slot's list by pool index.
+            typedef struct __QUEUE_TIMER_NODE__ {
+                uint32_t         prevIndex;
+                uint32_t         nextIndex;
+                uint32_t         slotIndex;
+                uint32_t         generation;
+                uint64_t         expiryTick;
+                uint64_t         periodTicks;
+                const void     * pOwner;
+                function<void()> fireFunc;
+            } QueueTimerNode;
+
+            // A timer which has come due, waiting for the timer thread to call it (without holding our lock).
+            typedef struct __QUEUE_TIMER_FIRING__ {
+                QueueTimerID     timerID;
+                const void     * pOwner;
+                function<void()> fireFunc;
+                bool             isCancelled;
+            } QueueTimerFiring;
+
+            // Our pool of timers, and the head of its list of free timers.
+            vector<QueueTimerNode> allNodes;
+            uint32_t               freeIndex;
+
+            // The head of each slot's list of timers, for every level of the wheel.
+            uint32_t allSlots[QUEUE_TIMER_WHEEL_LEVELS * QUEUE_TIMER_WHEEL_SLOTS];
+
+            // The next tick to be processed, and the number of timers waiting on it.
+            uint64_t currentTick;
+            size_t   numPending;
+
+            // The time tick zero began.
+            chrono::steady_clock::time_point startTime;
+
+            // The timers which have come due and are being called, and the owner of the one being called right now (or
+            // nullptr), along with the conditional variable signalled each time one has been called.
+            vector<QueueTimerFiring> allFiring;
+            const void             * pFiringOwner;
+            condition_variable       firedVar;
+
+            // The lock protecting everything above, and the conditional variable our timer thread waits on.
+            mutex              wheelLock;
+            condition_variable wheelVar;
+
+            // Our timer thread, which is only started once the first timer is added.
+            thread * pThread;
+
+            // Returns the tick we're currently within.
+            inline uint64_t tickNow() {
+                return((uint64_t) (chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - this->startTime).count() / QUEUE_TIMER_TICK_US));
+            };
+
+            // Links a timer into the slot it belongs in, given its expiry relative to the current tick.
+            inline void linkNode(uint32_t nodeIndex) {
+                QueueTimerNode * pNode = &(this->allNodes[nodeIndex]);
+                if (pNode->expiryTick < this->currentTick) {
+                    pNode->expiryTick = this->currentTick;
+                }
+
+                // Find the lowest level whose rotation still covers this timer. Anything further out than the whole
+                // wheel sits in the top level, and is re-cascaded (and re-clamped) each time it comes around.
+                uint64_t deltaTicks = (pNode->expiryTick - this->currentTick);
+                uint32_t level      = 0;
+                while ((level < (QUEUE_TIMER_WHEEL_LEVELS - 1)) && (deltaTicks >= (((uint64_t) 1) << (QUEUE_TIMER_WHEEL_BITS * (level + 1))))) {
+                    level += 1;
+                }
+                uint64_t slotTick = pNode->expiryTick;
+                if (deltaTicks >= (((uint64_t) 1) << (QUEUE_TIMER_WHEEL_BITS * QUEUE_TIMER_WHEEL_LEVELS))) {
+                    slotTick = (this->currentTick + (((uint64_t) 1) << (QUEUE_TIMER_WHEEL_BITS * QUEUE_TIMER_WHEEL_LEVELS)) - 1);
+                }
+                uint32_t slotIndex = ((level * QUEUE_TIMER_WHEEL_SLOTS) + ((uint32_t) ((slotTick >> (QUEUE_TIMER_WHEEL_BITS * level)) & (QUEUE_TIMER_WHEEL_SLOTS - 1))));
+
+                // Push it onto the front of the slot's list.
+                pNode->slotIndex = slotIndex;
+                pNode->prevIndex = QUEUE_TIMER_NIL;
+                pNode->nextIndex = this->allSlots[slotIndex];
+                if (pNode->nextIndex != QUEUE_TIMER_NIL) {
+                    this->allNodes[pNode->nextIndex].prevIndex = nodeIndex;
+                }
+                this->allSlots[slotIndex] = nodeIndex;
+            };
+
+            // Unlinks a timer from whichever slot it's in.
+            inline void unlinkNode(uint32_t nodeIndex) {
+                QueueTimerNode * pNode = &(this->allNodes[nodeIndex]);
+                if (pNode->prevIndex != QUEUE_TIMER_NIL) {
+                    this->allNodes[pNode->prevIndex].nextIndex = pNode->nextIndex;
+                } else {
+                    this->allSlots[pNode->slotIndex] = pNode->nextIndex;
+                }
+                if (pNode->nextIndex != QUEUE_TIMER_NIL) {
+                    this->allNodes[pNode->nextIndex].prevIndex = pNode->prevIndex;
+                }
+                pNode->prevIndex = QUEUE_TIMER_NIL;
+                pNode->nextIndex = QUEUE_TIMER_NIL;
+                pNode->slotIndex = QUEUE_TIMER_NIL;
+            };
+
+            // Returns a timer to the pool. Bumping its generation invalidates any outstanding IDs for it.
+            inline void freeNode(uint32_t nodeIndex) {
+                QueueTimerNode * pNode = &(this->allNodes[nodeIndex]);
+                pNode->fireFunc   = nullptr;
+                pNode->pOwner     = nullptr;
+                pNode->generation = ((pNode->generation + 1) & 0x7FFFFFFF);
+                if (pNode->generation == 0) {
+                    pNode->generation = 1;
+                }
+                pNode->nextIndex  = this->freeIndex;
+                this->freeIndex   = nodeIndex;
+                this->numPending -= 1;
+            };
+
+            // Returns a timer's ID.
+            inline QueueTimerID nodeID(uint32_t nodeIndex) {
+                return((((QueueTimerID) this->allNodes[nodeIndex].generation) << 32) | ((QueueTimerID) nodeIndex));
+            };
+
+            // Processes a single tick: cascades any higher levels which have come around, and then queues up everything
+            // due to be called once we let go of our lock.
+            inline void processTick() {
+                // Cascade from the highest level which has come around, down to the first level.
+                for (uint32_t level = (QUEUE_TIMER_WHEEL_LEVELS - 1); level > 0; --level) {
+                    if ((this->currentTick & ((((uint64_t) 1) << (QUEUE_TIMER_WHEEL_BITS * level)) - 1)) == 0) {
+                        uint32_t slotIndex = ((level * QUEUE_TIMER_WHEEL_SLOTS) + ((uint32_t) ((this->currentTick >> (QUEUE_TIMER_WHEEL_BITS * level)) & (QUEUE_TIMER_WHEEL_SLOTS - 1))));
+                        uint32_t nodeIndex = this->allSlots[slotIndex];
+                        this->allSlots[slotIndex] = QUEUE_TIMER_NIL;
+                        while (nodeIndex != QUEUE_TIMER_NIL) {
+                            uint32_t nextIndex = this->allNodes[nodeIndex].nextIndex;
+                            this->linkNode(nodeIndex);
+                            nodeIndex = nextIndex;
+                        }
+                    }
+                }
+
+                // Queue up everything in the first level's slot for this tick.
+                uint32_t slotIndex = ((uint32_t) (this->currentTick & (QUEUE_TIMER_WHEEL_SLOTS - 1)));
+                uint32_t nodeIndex = this->allSlots[slotIndex];
+                this->allSlots[slotIndex] = QUEUE_TIMER_NIL;
+                while (nodeIndex != QUEUE_TIMER_NIL) {
+                    QueueTimerNode * pNode     = &(this->allNodes[nodeIndex]);
+                    uint32_t         nextIndex = pNode->nextIndex;
+                    pNode->prevIndex = QUEUE_TIMER_NIL;
+                    pNode->nextIndex = QUEUE_TIMER_NIL;
+                    pNode->slotIndex = QUEUE_TIMER_NIL;
+
+                    // Queue it up to be called. Periodic timers are re-armed from their last expiry, so they don't drift.
+                    QueueTimerFiring newFiring;
+                    newFiring.timerID     = this->nodeID(nodeIndex);
+                    newFiring.pOwner      = pNode->pOwner;
+                    newFiring.fireFunc    = ((pNode->periodTicks > 0) ? pNode->fireFunc : move(pNode->fireFunc));
+                    newFiring.isCancelled = false;
+                    this->allFiring.push_back(move(newFiring));
+                    if (pNode->periodTicks > 0) {
+                        pNode->expiryTick += pNode->periodTicks;
+                        this->currentTick += 1;
+                        this->linkNode(nodeIndex);
+                        this->currentTick -= 1;
+                    } else {
+                        this->freeNode(nodeIndex);
+                    }
+                    nodeIndex = nextIndex;
+                }
+            };
+
+        public:
+            // Flags we use for interacting with the thread's execution.
+            atomic<bool> keepGoing;
+
+            // Constructor.
+            inline QueueTimerWheel() {
+                // Initialize our class members.
+                this->allNodes     = vector<QueueTimerNode>();
+                this->freeIndex    = QUEUE_TIMER_NIL;
+                this->currentTick  = 0;
+                this->numPending   = 0;
+                this->startTime    = chrono::steady_clock::now();
+                this->pThread      = nullptr;
+                this->allFiring    = vector<QueueTimerFiring>();
+                this->pFiringOwner = nullptr;
+                this->keepGoing    = true;
+                for (uint32_t slotIndex = 0; slotIndex < (QUEUE_TIMER_WHEEL_LEVELS * QUEUE_TIMER_WHEEL_SLOTS); ++slotIndex) {
+                    this->allSlots[slotIndex] = QUEUE_TIMER_NIL;
+                }
+            };
+
+            // Destructor.
+            inline ~QueueTimerWheel() {
+                // Tell our timer thread to stop, and wait for it to join back.
+                this->wheelLock.lock();
+                this->keepGoing = false;
+                this->wheelLock.unlock();
+                this->wheelVar.notify_all();
+                if (this->pThread) {
+                    this->pThread->join();
+                    delete(this->pThread);
+                }
+            };
+
+            // Returns the wheel shared by every Queue.
+            static inline QueueTimerWheel & shared() {
+                static QueueTimerWheel sharedWheel;
+                return(sharedWheel);
+            };
+
+            // Adds a timer which calls fireFunc (on the timer thread, which should only dispatch) once the delay has
+            // passed, and then every period after that if the period is non-zero. Returns an ID for cancelling it.
+            inline QueueTimerID addTimer(const void * pOwner, chrono::microseconds delay, chrono::microseconds period, function<void()> fireFunc) {
+                lock_guard<mutex> tempLock(this->wheelLock);
+
+                // Start our timer thread, if this is the first timer we've ever been given.
+                if (!this->pThread) {
+                    this->pThread = new thread(this->timerThreadFunc, this);
+                }
+
+                // If the wheel's been sitting empty, bring it up to date so it doesn't have to catch up tick by tick.
+                long long int nowUS   = ((long long int) chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - this->startTime).count());
+                uint64_t      nowTick = ((uint64_t) (nowUS / QUEUE_TIMER_TICK_US));
+                if ((this->numPending == 0) && (this->currentTick < nowTick)) {
+                    this->currentTick = nowTick;
+                }
+
+                // Grab a timer from the pool, growing the pool if it's empty.
+                uint32_t nodeIndex = this->freeIndex;
+                if (nodeIndex != QUEUE_TIMER_NIL) {
+                    this->freeIndex = this->allNodes[nodeIndex].nextIndex;
+                } else {
+                    nodeIndex = ((uint32_t) this->allNodes.size());
+                    this->allNodes.push_back(QueueTimerNode());
+                    this->allNodes[nodeIndex].generation = 1;
+                }
+
+                // Fill it in. Round the expiry up to the next tick, so we never fire early.
+                long long int    delayUS  = ((delay.count() > 0) ? ((long long int) delay.count()) : 0);
+                long long int    periodUS = ((period.count() > 0) ? ((long long int) period.count()) : 0);
+                QueueTimerNode * pNode    = &(this->allNodes[nodeIndex]);
+                pNode->expiryTick  = ((uint64_t) ((nowUS + delayUS + QUEUE_TIMER_TICK_US - 1) / QUEUE_TIMER_TICK_US));
+                pNode->periodTicks = ((periodUS > 0) ? max((uint64_t) 1, (uint64_t) ((periodUS + QUEUE_TIMER_TICK_US - 1) / QUEUE_TIMER_TICK_US)) : 0);
+                pNode->pOwner      = pOwner;
+                pNode->fireFunc    = move(fireFunc);
+                this->linkNode(nodeIndex);
+                this->numPending  += 1;
+
+                // Make sure our timer thread's awake to service it.
+                if (this->numPending == 1) {
+                    this->wheelVar.notify_all();
+                }
+                return(this->nodeID(nodeIndex));
+            };
+
+            // Cancels a pending timer, including one which has come due but hasn't been called yet. Returns false if it
+            // already fired (or was already cancelled). A dispatch which has already been handed to its Queue is not
+            // recalled.
+            inline bool cancelTimer(QueueTimerID timerID) {
+                lock_guard<mutex> tempLock(this->wheelLock);
+                bool wasCancelled = false;
+                for (QueueTimerFiring & firing : this->allFiring) {
+                    if ((firing.timerID == timerID) && !firing.isCancelled) {
+                        firing.isCancelled = true;
+                        wasCancelled       = true;
+                    }
+                }
+                uint32_t nodeIndex  = ((uint32_t) (timerID & 0xFFFFFFFF));
+                uint32_t generation = ((uint32_t) (timerID >> 32));
+                if ((nodeIndex >= this->allNodes.size()) || (this->allNodes[nodeIndex].generation != generation) || (this->allNodes[nodeIndex].slotIndex == QUEUE_TIMER_NIL)) {
+                    return(wasCancelled);
+                }
+                this->unlinkNode(nodeIndex);
+                this->freeNode(nodeIndex);
+                return(true);
+            };
+
+            // Cancels every pending timer belonging to an owner, and waits for any of its timers being called right now
+            // to return (unless that's who's calling us). This walks the whole pool, so it's only meant for when an
+            // owner is being destroyed.
+            inline void cancelOwner(const void * pOwner) {
+                unique_lock<mutex> tempLock(this->wheelLock);
+                for (uint32_t nodeIndex = 0; nodeIndex < this->allNodes.size(); ++nodeIndex) {
+                    if ((this->allNodes[nodeIndex].pOwner == pOwner) && (this->allNodes[nodeIndex].slotIndex != QUEUE_TIMER_NIL)) {
+                        this->unlinkNode(nodeIndex);
+                        this->freeNode(nodeIndex);
+                    }
+                }
+                for (QueueTimerFiring & firing : this->allFiring) {
+                    if (firing.pOwner == pOwner) {
+                        firing.isCancelled = true;
+                    }
+                }
+                if ((this->pThread != nullptr) && (this_thread::get_id() != this->pThread->get_id())) {
+                    this->firedVar.wait(tempLock, [this, pOwner] {
+                        return(this->pFiringOwner != pOwner);
+                    });
+                }
+            };
+
+            // Returns the number of timers waiting to fire.
+            inline size_t numTimersPending() {
+                lock_guard<mutex> tempLock(this->wheelLock);
+                return(this->numPending);
+            };
+
+        private:
+            function<void(DispatchCPP::QueueTimerWheel *)> timerThreadFunc = [](DispatchCPP::QueueTimerWheel * pThis) {
+                unique_lock<mutex> tempLock(pThis->wheelLock);
+
+                // Keep going until we're told to stop.
+                while (pThis->keepGoing) {
+                    // Sleep until there's something to wait on.
+                    if (pThis->numPending == 0) {
+                        pThis->wheelVar.wait(tempLock, [pThis] {
+                            return(!pThis->keepGoing || (pThis->numPending > 0));
+                        });
+                        continue;
+                    }
+
+                    // Process every tick up to and including now.
+                    uint64_t nowTick = pThis->tickNow();
+                    while ((pThis->currentTick <= nowTick) && (pThis->numPending > 0)) {
+                        pThis->processTick();
+                        pThis->currentTick += 1;
+                    }
+                    if (pThis->numPending == 0) {
+                        pThis->currentTick = (nowTick + 1);
+                    }
+
+                    // Call everything which came due without holding our lock, so that a slow dispatch never holds up
+                    // the wheel, and timers can be added from within them. Anything cancelled meanwhile is skipped.
+                    for (size_t firingIndex = 0; firingIndex < pThis->allFiring.size(); ++firingIndex) {
+                        if (pThis->allFiring[firingIndex].isCancelled) {
+                            continue;
+                        }
+                        function<void()> fireFunc = move(pThis->allFiring[firingIndex].fireFunc);
+                        pThis->pFiringOwner = pThis->allFiring[firingIndex].pOwner;
+                        tempLock.unlock();
+                        fireFunc();
+                        fireFunc = nullptr;
+                        tempLock.lock();
+                        pThis->pFiringOwner = nullptr;
+                        pThis->firedVar.notify_all();
+                    }
+                    pThis->allFiring.clear();
+                    if (!pThis->keepGoing) {
+                        break;
+                    }
+
+                    // Sleep until the next tick begins.
+                    pThis->wheelVar.wait_until(tempLock, pThis->startTime + chrono::microseconds(pThis->currentTick * QUEUE_TIMER_TICK_US));
+                }
+            };
+    };
+};
+
+#endif // __QUEUE_TIMER_H__
@@ -0,0 +1,153 @@
+#ifndef __QUEUE_WAIT_H__
+#define __QUEUE_WAIT_H__
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+// The number of times an idle thread pauses while spinning, before it yields (or parks).
+#define QUEUE_WAIT_SPIN_COUNT           2000
+
+// The number of times an idle thread yields, before it parks, when it yields at all.
+#define QUEUE_WAIT_YIELD_COUNT          32
+
+// This header file uses the standard namespace.
+using namespace std;
+
+// How idle QueueThreads wait for work, and how they're woken for it. Parking sleeps on the Queue's condition variable
+// (a futex, on Linux). Spinning costs CPU while idle, to pick up work which arrives soon after without sleeping.
+typedef enum {
+    QueueWaitStrategyPark = 0,      // Park straight away, and wake every parked thread for each piece of work.
+    QueueWaitStrategyParkTargeted,  // Park straight away, and wake a single parked thread (if any) for each piece of work.
+    QueueWaitStrategySpin,          // Spin, pausing, for a while before parking. Targeted wakeups.
+    QueueWaitStrategySpinYield      // Spin, pausing, then yield, for a while before parking. Targeted wakeups.
+} QueueWaitStrategy;
+
+// Declare the QueueWaitState within our DispatchCPP namespace.
+namespace DispatchCPP {
+    // The wait strategy shared by a Queue and its threads, along with what they need to follow it: the number of threads
+    // parked (so wakeups can go to just one of them, or be skipped when there's no one to wake) and a sequence number
+    // bumped whenever there's new work (so spinning threads notice it without taking the lock).
+    class QueueWaitState {
+        private:
+            // Our strategy.
+            atomic<int> strategy;
+
+        public:
+            // Bumped whenever work is queued, and the number of threads parked, or woken from parking.
+            atomic<unsigned long long int> signalSequence;
+            atomic<unsigned int>           numParked;
+            atomic<unsigned long long int> numWakeups;
+
+            // Threads which aren't ours, waiting for work they could help with (see QueueTaskGroup::wait()): how many
+            // there are, and what they sleep on. They're woken whenever work is queued, or by wakeHelpers().
+            atomic<unsigned int>           numHelpers;
+            mutex                          helperLock;
+            condition_variable             helperVar;
+
+            // Constructor.
+            inline QueueWaitState() {
+                this->strategy       = (int) QueueWaitStrategyPark;
+                this->signalSequence = 0;
+                this->numParked      = 0;
+                this->numWakeups     = 0;
+                this->numHelpers     = 0;
+            };
+
+            // Sets our strategy. Threads pick it up the next time they wait.
+            inline void setStrategy(QueueWaitStrategy newStrategy) {
+                this->strategy = (int) newStrategy;
+            };
+
+            // Returns our strategy.
+            inline QueueWaitStrategy getStrategy() {
+                return((QueueWaitStrategy) this->strategy.load(memory_order_relaxed));
+            };
+
+            // Returns whether our strategy spins before parking.
+            inline bool isSpinning() {
+                QueueWaitStrategy currentStrategy = this->getStrategy();
+                return((currentStrategy == QueueWaitStrategySpin) || (currentStrategy == QueueWaitStrategySpinYield));
+            };
+
+            // Tells the CPU we're spinning, so it can save power and give the other hyperthread a turn.
+            static inline void pause() {
+#if defined(__x86_64__) || defined(__i386__)
+                __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+                asm volatile("yield");
+#endif
+            };
+
+            // Spins until there's new work since seenSequence, we're told to stop, or we run out of spins (in which case
+            // the caller parks). Does nothing unless our strategy spins.
+            inline void spin(unsigned long long int seenSequence, atomic<bool> & keepGoing) {
+                if (!this->isSpinning()) {
+                    return;
+                }
+                for (unsigned int spinIndex = 0; spinIndex < QUEUE_WAIT_SPIN_COUNT; ++spinIndex) {
+                    if ((this->signalSequence.load(memory_order_acquire) != seenSequence) || !keepGoing.load(memory_order_relaxed)) {
+                        return;
+                    }
+                    QueueWaitState::pause();
+                }
+                if (this->getStrategy() == QueueWaitStrategySpinYield) {
+                    for (unsigned int yieldIndex = 0; yieldIndex < QUEUE_WAIT_YIELD_COUNT; ++yieldIndex) {
+                        if ((this->signalSequence.load(memory_order_acquire) != seenSequence) || !keepGoing.load(memory_order_relaxed)) {
+                            return;
+                        }
+                        this_thread::yield();
+                    }
+                }
+            };
+
+            // Wakes threads for newly queued work, which the caller has already pushed and unlocked. A single piece of
+            // work only wakes a single parked thread (and nobody, if no one's parked), unless we wake everyone for
+            // everything. isSingleWork must be false whenever only some threads could pick the work up.
+            inline void notify(condition_variable * pWorkVar, bool isSingleWork) {
+                this->signalSequence.fetch_add(1);
+                QueueWaitStrategy currentStrategy = this->getStrategy();
+                if ((currentStrategy == QueueWaitStrategyPark) || !isSingleWork) {
+                    pWorkVar->notify_all();
+                } else if (this->numParked.load() > 0) {
+                    pWorkVar->notify_one();
+                }
+                this->wakeHelpers();
+            };
+
+            // Lets helpers know there's new work they could help with, which our threads can't pick up themselves (like
+            // work queued with a parent Queue's scheduler).
+            inline void notifyHelpers() {
+                this->signalSequence.fetch_add(1);
+                this->wakeHelpers();
+            };
+
+            // Wakes every helper, so they check again whether they're done waiting. Costs nothing when there are none.
+            inline void wakeHelpers() {
+                if (this->numHelpers.load() > 0) {
+                    this->helperLock.lock();
+                    this->helperLock.unlock();
+                    this->helperVar.notify_all();
+                }
+            };
+
+            // Sleeps a helper until work has been queued since seenSequence (read before it last looked for work), or
+            // until isDone() returns true. Whatever makes isDone() true has to call wakeHelpers() afterwards.
+            inline void waitToHelp(unsigned long long int seenSequence, function<bool()> isDone) {
+                this->numHelpers.fetch_add(1);
+                unique_lock<mutex> tempLock(this->helperLock);
+                this->helperVar.wait(tempLock, [this, seenSequence, &isDone] {
+                    return((this->signalSequence.load() != seenSequence) || isDone());
+                });
+                tempLock.unlock();
+                this->numHelpers.fetch_sub(1);
+            };
+    };
+};
+
+#endif // __QUEUE_WAIT_H__
@@ -19,10 +19,33 @@ int main(int numArgs, char ** ppArgs) {
 
 	// Determine what kind of test(s) to perform.
 	bool testVectorSort = (argExists("tv"s) || argExists("test-vectors"s));
+	bool testHugeSort   = (argExists("th"s) || argExists("test-huge-vector"s));
 	bool testDownloads  = (argExists("td"s) || argExists("test-downloads"s));
 	bool testFileIO     = (argExists("tf"s) || argExists("test-files"s));
 	bool testMalloc     = (argExists("tm"s) || argExists("test-malloc"s));
 	bool testThreads    = (argExists("tt"s) || argExists("test-threads"s));
+	bool testOverhead   = (argExists("to"s) || argExists("test-overhead"s));
+	bool testReactor    = (argExists("tr"s) || argExists("test-reactor"s));
+	bool testTimers     = (argExists("tw"s) || argExists("test-timers"s));
+	bool testCancel     = (argExists("tc"s) || argExists("test-cancel"s));
+	bool testNumeric    = (argExists("tn"s) || argExists("test-numeric"s));
+	bool testScan       = (argExists("ts"s) || argExists("test-scan"s));
+	bool testState      = (argExists("tx"s) || argExists("test-worker-state"s));
+	bool testKeyed      = (argExists("tk"s) || argExists("test-keyed"s));
+	bool testCoalesce   = (argExists("tq"s) || argExists("test-coalesce"s));
+	bool testLimits     = (argExists("tl"s) || argExists("test-limits"s));
+	bool testForkJoin   = (argExists("tp"s) || argExists("test-fork-join"s));
+	bool testGroups     = (argExists("tg"s) || argExists("test-groups"s));
+	bool testBarrier    = (argExists("tb"s) || argExists("test-barrier"s));
+	bool testTenants    = (argExists("te"s) || argExists("test-tenants"s));
+	bool testOrdered    = (argExists("ti"s) || argExists("test-ordered"s));
+	bool testPipeline   = (argExists("tu"s) || argExists("test-pipeline"s));
+	bool testIngest     = (argExists("ta"s) || argExists("test-ingest"s));
+	bool testSpill      = (argExists("ty"s) || argExists("test-spill"s));
+	bool testWait       = (argExists("tz"s) || argExists("test-wait"s));
+	bool testProducers  = (argExists("tpb"s) || argExists("test-producers"s));
+	bool testMemo       = (argExists("tmc"s) || argExists("test-memo"s));
+	bool testGrain      = (argExists("tgs"s) || argExists("test-grain"s));
 
 	// Did the user specify a custom number of threads to use?
 	auto testNumThreadsArg = pair<bool, size_t>(false, 0);
@@ -37,10 +60,33 @@ int main(int numArgs, char ** ppArgs) {
 
 	// Call into each test we should perform.
 	if (testVectorSort) { testQueueVectorSort(targetNumThreads); }
+	if (testHugeSort)   { testQueueVectorSortHuge(targetNumThreads); }
 	if (testDownloads)  { testQueueDownloads(targetNumThreads);  }
 	if (testFileIO)     { testQueueFileIO(targetNumThreads);     }
 	if (testMalloc)     { testQueueMalloc(targetNumThreads);     }
 	if (testThreads)    { testQueueThreads(targetNumThreads);    }
+	if (testOverhead)   { testQueueOverhead(targetNumThreads);   }
+	if (testReactor)    { testQueueReactor(targetNumThreads);    }
+	if (testTimers)     { testQueueTimers(targetNumThreads);     }
+	if (testCancel)     { testQueueCancel(targetNumThreads);     }
+	if (testNumeric)    { testQueueNumeric(targetNumThreads);    }
+	if (testScan)       { testQueueScan(targetNumThreads);       }
+	if (testState)      { testQueueWorkerState(targetNumThreads); }
+	if (testKeyed)      { testQueueKeyed(targetNumThreads);      }
+	if (testCoalesce)   { testQueueCoalesce(targetNumThreads);   }
+	if (testLimits)     { testQueueLimits(targetNumThreads);     }
+	if (testForkJoin)   { testQueueForkJoin(targetNumThreads);   }
+	if (testGroups)     { testQueueGroups(targetNumThreads);     }
+	if (testBarrier)    { testQueueBarrier(targetNumThreads);    }
+	if (testTenants)    { testQueueTenants(targetNumThreads);    }
+	if (testOrdered)    { testQueueOrdered(targetNumThreads);    }
+	if (testPipeline)   { testQueuePipeline(targetNumThreads);   }
+	if (testIngest)     { testQueueIngest(targetNumThreads);     }
+	if (testSpill)      { testQueueSpill(targetNumThreads);      }
+	if (testWait)       { testQueueWait(targetNumThreads);       }
+	if (testProducers)  { testQueueProducers(targetNumThreads);  }
+	if (testMemo)       { testQueueMemo(targetNumThreads);       }
+	if (testGrain)      { testQueueGrain(targetNumThreads);      }
 
 	return(EXIT_SUCCESS);
 }
@@ -13,6 +13,28 @@
 #include "Tests/TestQueueFileIO.h"
 #include "Tests/TestMalloc.h"
 #include "Tests/TestThreads.h"
+#include "Tests/TestQueueOverhead.h"
+#include "Tests/TestQueueReactor.h"
+#include "Tests/TestQueueTimers.h"
+#include "Tests/TestQueueCancel.h"
+#include "Tests/TestQueueNumeric.h"
+#include "Tests/TestQueueScan.h"
+#include "Tests/TestQueueWorkerState.h"
+#include "Tests/TestQueueKeyed.h"
+#include "Tests/TestQueueCoalesce.h"
+#include "Tests/TestQueueLimits.h"
+#include "Tests/TestQueueForkJoin.h"
+#include "Tests/TestQueueGroups.h"
+#include "Tests/TestQueueBarrier.h"
+#include "Tests/TestQueueTenants.h"
+#include "Tests/TestQueueOrdered.h"
+#include "Tests/TestQueuePipeline.h"
+#include "Tests/TestQueueIngest.h"
+#include "Tests/TestQueueSpill.h"
+#include "Tests/TestQueueWait.h"
+#include "Tests/TestQueueProducers.h"
+#include "Tests/TestQueueMemo.h"
+#include "Tests/TestQueueGrain.h"
 
 // Forward declaration of our application's entry point.
 int main(int numArgs, char ** ppArgs);
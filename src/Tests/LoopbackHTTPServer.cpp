@@ -0,0 +1,257 @@
+#include "LoopbackHTTPServer.h"
+
+// Convenience function for grabbing the current time in nanoseconds.
+static inline long long int nowNS() {
+	return((long long int) chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+LoopbackHTTPServer::LoopbackHTTPServer(unsigned int newLatencyUS, size_t newMaxBodySize) {
+	// Initialize our class members.
+	this->listenFD     = -1;
+	this->epollFD      = -1;
+	this->stopFD       = -1;
+	this->pThread      = nullptr;
+	this->latencyUS    = newLatencyUS;
+	this->maxBodySize  = newMaxBodySize;
+	this->port         = 0;
+	this->numResponses = 0;
+
+	// Fill in the bytes every body is served from.
+	this->bodyData = vector<char>(this->maxBodySize);
+	for (size_t offset = 0; offset < this->maxBodySize; ++offset) {
+		this->bodyData[offset] = LoopbackHTTPServer::bodyByteAt(offset);
+	}
+
+	// Create our listening socket on an ephemeral loopback port.
+	struct sockaddr_in listenAddr;
+	socklen_t          listenAddrLen = sizeof(listenAddr);
+	int                reuseAddr     = 1;
+	memset(&listenAddr, 0, sizeof(listenAddr));
+	listenAddr.sin_family      = AF_INET;
+	listenAddr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	listenAddr.sin_port        = 0;
+	this->listenFD = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	if ((this->listenFD < 0) ||
+	    (setsockopt(this->listenFD, SOL_SOCKET, SO_REUSEADDR, &reuseAddr, sizeof(reuseAddr)) != 0) ||
+	    (bind(this->listenFD, (struct sockaddr *) &listenAddr, sizeof(listenAddr)) != 0) ||
+	    (listen(this->listenFD, SOMAXCONN) != 0) ||
+	    (getsockname(this->listenFD, (struct sockaddr *) &listenAddr, &listenAddrLen) != 0)) {
+		printf("LoopbackHTTPServer: failed to listen on loopback (%s)\n", strerror(errno));
+		return;
+	}
+
+	// Create our epoll instance, registering the listening socket and our stop eventfd with it.
+	struct epoll_event newEvent;
+	this->epollFD = epoll_create1(EPOLL_CLOEXEC);
+	this->stopFD  = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if ((this->epollFD < 0) || (this->stopFD < 0)) {
+		printf("LoopbackHTTPServer: failed to create epoll/eventfd (%s)\n", strerror(errno));
+		return;
+	}
+	newEvent.events  = EPOLLIN;
+	newEvent.data.fd = this->listenFD;
+	epoll_ctl(this->epollFD, EPOLL_CTL_ADD, this->listenFD, &newEvent);
+	newEvent.events  = EPOLLIN;
+	newEvent.data.fd = this->stopFD;
+	epoll_ctl(this->epollFD, EPOLL_CTL_ADD, this->stopFD, &newEvent);
+
+	// Start serving, now.
+	this->port    = ntohs(listenAddr.sin_port);
+	this->pThread = new thread(&LoopbackHTTPServer::serverLoop, this);
+}
+
+LoopbackHTTPServer::~LoopbackHTTPServer() {
+	// Wake the server thread and wait for it to stop.
+	if (this->pThread) {
+		uint64_t stopValue = 1;
+		if (write(this->stopFD, &stopValue, sizeof(stopValue)) == sizeof(stopValue)) {
+			this->pThread->join();
+		} else {
+			this->pThread->detach();
+		}
+		delete(this->pThread);
+	}
+
+	// Close every connection still open, and then ourselves.
+	while (this->allConnections.size() > 0) {
+		this->closeConnection(this->allConnections.begin()->first);
+	}
+	if (this->stopFD >= 0)   { close(this->stopFD);   }
+	if (this->epollFD >= 0)  { close(this->epollFD);  }
+	if (this->listenFD >= 0) { close(this->listenFD); }
+}
+
+void LoopbackHTTPServer::setLatencyUS(unsigned int newLatencyUS) {
+	this->latencyUS = newLatencyUS;
+}
+
+void LoopbackHTTPServer::serverLoop() {
+	struct epoll_event allEvents[LOOPBACK_HTTP_SERVER_MAX_EVENTS];
+	while (true) {
+		// Sleep no longer than it takes for the next pending response to become ready.
+		int timeoutMS = -1;
+		if (this->pendingResponses.size() > 0) {
+			long long int waitNS = (this->pendingResponses.begin()->first - nowNS());
+			timeoutMS = ((waitNS <= 0) ? 0 : ((int) ((waitNS + 999999) / 1000000)));
+		}
+
+		// Wait for something to happen.
+		int numEvents = epoll_wait(this->epollFD, allEvents, LOOPBACK_HTTP_SERVER_MAX_EVENTS, timeoutMS);
+		if ((numEvents < 0) && (errno != EINTR)) {
+			break;
+		}
+
+		// Handle every event we were given.
+		bool shouldStop = false;
+		for (int eventIndex = 0; eventIndex < numEvents; ++eventIndex) {
+			int eventFD = allEvents[eventIndex].data.fd;
+			if (eventFD == this->stopFD) {
+				shouldStop = true;
+			} else if (eventFD == this->listenFD) {
+				this->handleAccept();
+			} else if (this->allConnections.count(eventFD) > 0) {
+				if (allEvents[eventIndex].events & EPOLLOUT) {
+					this->handleWritable(eventFD);
+				}
+				if ((this->allConnections.count(eventFD) > 0) && (allEvents[eventIndex].events & (EPOLLIN | EPOLLHUP | EPOLLERR))) {
+					this->handleReadable(eventFD);
+				}
+			}
+		}
+		if (shouldStop) {
+			break;
+		}
+
+		// Start every response whose artificial latency has elapsed.
+		long long int currentTimeNS = nowNS();
+		while ((this->pendingResponses.size() > 0) && (this->pendingResponses.begin()->first <= currentTimeNS)) {
+			long long int readyTimeNS  = this->pendingResponses.begin()->first;
+			int           connectionFD = this->pendingResponses.begin()->second;
+			this->pendingResponses.erase(this->pendingResponses.begin());
+
+			// Make sure this is still the same connection, and not a new one that reused its descriptor.
+			if ((this->allConnections.count(connectionFD) > 0) && (this->allConnections[connectionFD].readyTimeNS == readyTimeNS)) {
+				this->allConnections[connectionFD].isResponding = true;
+				this->handleWritable(connectionFD);
+			}
+		}
+	}
+}
+
+void LoopbackHTTPServer::handleAccept() {
+	// Accept every connection that's waiting.
+	while (true) {
+		int connectionFD = accept4(this->listenFD, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+		if (connectionFD < 0) {
+			break;
+		}
+		int noDelay = 1;
+		setsockopt(connectionFD, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+
+		// Track this connection, and wait for its request.
+		LoopbackHTTPConnection newConnection;
+		newConnection.requestData      = ""s;
+		newConnection.responseHeader   = ""s;
+		newConnection.responseBodySize = 0;
+		newConnection.numBytesSent     = 0;
+		newConnection.readyTimeNS      = 0;
+		newConnection.isResponding     = false;
+		this->allConnections[connectionFD] = newConnection;
+		struct epoll_event newEvent;
+		newEvent.events  = EPOLLIN;
+		newEvent.data.fd = connectionFD;
+		epoll_ctl(this->epollFD, EPOLL_CTL_ADD, connectionFD, &newEvent);
+	}
+}
+
+void LoopbackHTTPServer::handleReadable(int connectionFD) {
+	LoopbackHTTPConnection * pConnection = &(this->allConnections[connectionFD]);
+	char                     readBuffer[LOOPBACK_HTTP_SERVER_READ_SIZE];
+
+	// Drain everything available on the socket.
+	while (true) {
+		ssize_t numRead = read(connectionFD, readBuffer, sizeof(readBuffer));
+		if (numRead > 0) {
+			// Only hold onto request bytes until we've seen a full request.
+			if (pConnection->readyTimeNS == 0) {
+				pConnection->requestData.append(readBuffer, numRead);
+			}
+			continue;
+		}
+
+		// The client closed (or reset) the connection, so we're done with it.
+		if ((numRead == 0) || ((errno != EAGAIN) && (errno != EWOULDBLOCK))) {
+			this->closeConnection(connectionFD);
+			return;
+		}
+		break;
+	}
+
+	// Have we received the whole request yet?
+	if ((pConnection->readyTimeNS == 0) && (pConnection->requestData.find("\r\n\r\n") != string::npos)) {
+		// Pull the body size out of "GET /<numBytes> HTTP/1.1".
+		unsigned long long int bodySize = 0;
+		if (sscanf(pConnection->requestData.c_str(), "GET /%llu", &bodySize) != 1) {
+			bodySize = 0;
+		}
+		pConnection->responseBodySize = ((bodySize < this->maxBodySize) ? ((size_t) bodySize) : this->maxBodySize);
+		pConnection->responseHeader   = "HTTP/1.1 200 OK\r\n"
+		                                "Content-Type: application/octet-stream\r\n"
+		                                "Content-Length: "s + to_string(pConnection->responseBodySize) + "\r\n"
+		                                "Connection: close\r\n"
+		                                "\r\n";
+		pConnection->requestData.clear();
+
+		// Hold the response back for our artificial latency.
+		pConnection->readyTimeNS = (nowNS() + (((long long int) this->latencyUS.load()) * 1000));
+		this->pendingResponses.insert(pair<long long int, int>(pConnection->readyTimeNS, connectionFD));
+	}
+}
+
+void LoopbackHTTPServer::handleWritable(int connectionFD) {
+	LoopbackHTTPConnection * pConnection = &(this->allConnections[connectionFD]);
+	if (!pConnection->isResponding) {
+		return;
+	}
+
+	// Send as much of the header and body as the socket will take.
+	size_t headerSize = pConnection->responseHeader.size();
+	size_t totalSize  = (headerSize + pConnection->responseBodySize);
+	while (pConnection->numBytesSent < totalSize) {
+		ssize_t numSent = 0;
+		if (pConnection->numBytesSent < headerSize) {
+			numSent = send(connectionFD, pConnection->responseHeader.data() + pConnection->numBytesSent, headerSize - pConnection->numBytesSent, MSG_NOSIGNAL | MSG_MORE);
+		} else {
+			size_t bodyOffset = (pConnection->numBytesSent - headerSize);
+			numSent = send(connectionFD, this->bodyData.data() + bodyOffset, pConnection->responseBodySize - bodyOffset, MSG_NOSIGNAL);
+		}
+		if (numSent > 0) {
+			pConnection->numBytesSent += numSent;
+			continue;
+		}
+		if ((numSent < 0) && ((errno == EAGAIN) || (errno == EWOULDBLOCK))) {
+			// The socket's full, so wait until it drains.
+			struct epoll_event newEvent;
+			newEvent.events  = (EPOLLIN | EPOLLOUT);
+			newEvent.data.fd = connectionFD;
+			epoll_ctl(this->epollFD, EPOLL_CTL_MOD, connectionFD, &newEvent);
+			return;
+		}
+		this->closeConnection(connectionFD);
+		return;
+	}
+
+	// We've sent everything. Leave the connection open until the client closes it, so it never sees a truncated body.
+	pConnection->isResponding = false;
+	this->numResponses       += 1;
+	struct epoll_event newEvent;
+	newEvent.events  = EPOLLIN;
+	newEvent.data.fd = connectionFD;
+	epoll_ctl(this->epollFD, EPOLL_CTL_MOD, connectionFD, &newEvent);
+}
+
+void LoopbackHTTPServer::closeConnection(int connectionFD) {
+	epoll_ctl(this->epollFD, EPOLL_CTL_DEL, connectionFD, NULL);
+	close(connectionFD);
+	this->allConnections.erase(connectionFD);
+}
@@ -0,0 +1,92 @@
+#ifndef __LOOPBACK_HTTP_SERVER_H__
+#define __LOOPBACK_HTTP_SERVER_H__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+// The maximum number of events the server handles per call to epoll_wait.
+#define LOOPBACK_HTTP_SERVER_MAX_EVENTS     256
+
+// The size of the buffer the server reads requests into.
+#define LOOPBACK_HTTP_SERVER_READ_SIZE      4096
+
+// This header file uses the standard namespace.
+using namespace std;
+
+// A minimal HTTP/1.1 server bound to 127.0.0.1 on an ephemeral port, serving "GET /<numBytes>" with a body of that
+// many bytes after an artificial latency. Everything runs on a single epoll thread, so many slow responses can be
+// pending at once without the server itself becoming the bottleneck. Every response closes its connection.
+class LoopbackHTTPServer {
+	private:
+		// The state we keep for each open connection.
+		typedef struct __LOOPBACK_HTTP_CONNECTION__ {
+			string        requestData;
+			string        responseHeader;
+			size_t        responseBodySize;
+			size_t        numBytesSent;
+			long long int readyTimeNS;
+			bool          isResponding;
+		} LoopbackHTTPConnection;
+
+		// Our sockets, the epoll instance driving them, and the eventfd used to wake the server to stop.
+		int listenFD;
+		int epollFD;
+		int stopFD;
+
+		// The server thread, itself.
+		thread * pThread;
+
+		// The artificial latency applied to each response, and the largest body we'll serve.
+		atomic<unsigned int> latencyUS;
+		size_t               maxBodySize;
+
+		// The bytes every body is served from.
+		vector<char> bodyData;
+
+		// All open connections, and the connections waiting on their artificial latency ordered by ready time.
+		map<int, LoopbackHTTPConnection>  allConnections;
+		multimap<long long int, int>      pendingResponses;
+
+		void serverLoop();
+		void handleAccept();
+		void handleReadable(int connectionFD);
+		void handleWritable(int connectionFD);
+		void closeConnection(int connectionFD);
+
+	public:
+		// The port we're listening on, or zero if we failed to start.
+		unsigned short port;
+
+		// The number of responses we've finished sending.
+		atomic<unsigned long long int> numResponses;
+
+		LoopbackHTTPServer(unsigned int newLatencyUS = 0, size_t newMaxBodySize = 16 * 1024 * 1024);
+		~LoopbackHTTPServer();
+
+		// Changes the artificial latency applied to responses requested from now on.
+		void setLatencyUS(unsigned int newLatencyUS);
+
+		// Returns the byte every body has at the given offset, so clients can verify what they receive.
+		static inline char bodyByteAt(size_t offset) {
+			return((char) ('a' + (offset % 26)));
+		};
+};
+
+#endif // __LOOPBACK_HTTP_SERVER_H__
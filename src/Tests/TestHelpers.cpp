@@ -0,0 +1,27 @@
+#include "TestHelpers.h"
+
+vector<unsigned int> TestHelpers::workerCounts(unsigned int maxNumThreads) {
+	vector<unsigned int> allWorkerCounts = vector<unsigned int>();
+	for (unsigned int numWorkers = 1; numWorkers < maxNumThreads; numWorkers *= 2) {
+		allWorkerCounts.push_back(numWorkers);
+	}
+	allWorkerCounts.push_back(maxNumThreads);
+	return(allWorkerCounts);
+}
+
+unsigned long long int TestHelpers::hashWork(unsigned long long int seed, unsigned int numIterations, unsigned long long int hashValue) {
+	for (unsigned int iteration = 0; iteration < numIterations; ++iteration) {
+		hashValue = ((hashValue ^ (seed + iteration)) * 1099511628211ULL);
+	}
+	return(hashValue);
+}
+
+unsigned long long int TestHelpers::hashBytes(const unsigned char * pBytes, size_t numBytes, unsigned int numRounds) {
+	unsigned long long int hashValue = 14695981039346656037ULL;
+	for (unsigned int roundIndex = 0; roundIndex < numRounds; ++roundIndex) {
+		for (size_t byteIndex = 0; byteIndex < numBytes; ++byteIndex) {
+			hashValue = ((hashValue ^ pBytes[byteIndex]) * 1099511628211ULL);
+		}
+	}
+	return(hashValue);
+}
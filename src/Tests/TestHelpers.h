@@ -0,0 +1,24 @@
+#ifndef __TEST_HELPERS_H__
+#define __TEST_HELPERS_H__
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <vector>
+
+// This header file uses the standard namespace.
+using namespace std;
+
+class TestHelpers {
+    public:
+        // Returns the worker counts a test runs with: powers of two below maxNumThreads, plus maxNumThreads itself.
+        static vector<unsigned int> workerCounts(unsigned int maxNumThreads);
+
+        // Stand-in work for tests: FNV-1a hashes seed + iteration, for numIterations iterations, onto hashValue.
+        static unsigned long long int hashWork(unsigned long long int seed, unsigned int numIterations, unsigned long long int hashValue = 14695981039346656037ULL);
+
+        // Same, except it hashes numBytes of pBytes, numRounds times over.
+        static unsigned long long int hashBytes(const unsigned char * pBytes, size_t numBytes, unsigned int numRounds);
+};
+
+#endif // __TEST_HELPERS_H__
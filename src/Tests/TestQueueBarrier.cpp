@@ -0,0 +1,174 @@
+#include "TestQueueBarrier.h"
+
+using namespace DispatchCPP;
+
+// A record in our index. A write sets every field to the same value, so a read which sees them differ saw a torn write.
+typedef struct __BARRIER_RECORD__ {
+	unsigned long long int allFields[BARRIER_NUM_FIELDS];
+} BarrierRecord;
+
+double testQueueBarrierIndex(unsigned int numWorkers, bool useBarriers, unsigned int * pNumTorn) {
+	// Our index, the lock the lock-based version protects it with, and the number of torn reads seen.
+	vector<BarrierRecord>           allRecords = vector<BarrierRecord>(BARRIER_NUM_RECORDS);
+	shared_mutex                    indexLock;
+	atomic<unsigned int>            numTorn(0);
+	atomic<unsigned long long int>  readSink(0);
+	for (unsigned int recordIndex = 0; recordIndex < BARRIER_NUM_RECORDS; ++recordIndex) {
+		for (unsigned int fieldIndex = 0; fieldIndex < BARRIER_NUM_FIELDS; ++fieldIndex) {
+			allRecords[recordIndex].allFields[fieldIndex] = 0;
+		}
+	}
+
+	// Our reads scan a run of records, and our writes rewrite a single record.
+	function<void(unsigned int)> readIndex = [&allRecords, &numTorn, &readSink](unsigned int key) {
+		unsigned long long int total = 0;
+		for (unsigned int recordOffset = 0; recordOffset < BARRIER_RECORDS_PER_READ; ++recordOffset) {
+			BarrierRecord * pRecord = &(allRecords[(key + recordOffset) % BARRIER_NUM_RECORDS]);
+			for (unsigned int fieldIndex = 1; fieldIndex < BARRIER_NUM_FIELDS; ++fieldIndex) {
+				if (((volatile unsigned long long int *) pRecord->allFields)[fieldIndex] != ((volatile unsigned long long int *) pRecord->allFields)[0]) {
+					numTorn.fetch_add(1, memory_order_relaxed);
+				}
+				total += pRecord->allFields[fieldIndex];
+			}
+		}
+		readSink.fetch_add(total, memory_order_relaxed);
+	};
+	function<void(unsigned int, unsigned int)> writeIndex = [&allRecords](unsigned int key, unsigned int value) {
+		BarrierRecord * pRecord = &(allRecords[key % BARRIER_NUM_RECORDS]);
+		for (unsigned int fieldIndex = 0; fieldIndex < BARRIER_NUM_FIELDS; ++fieldIndex) {
+			((volatile unsigned long long int *) pRecord->allFields)[fieldIndex] = value;
+		}
+	};
+
+	// Declare our Queue. Without barriers, reads take the lock shared, and writes take it exclusively.
+	Queue<void, bool, unsigned int, unsigned int> * pIndexQueue = new Queue<void, bool, unsigned int, unsigned int>(
+		new QueueFunction<void, bool, unsigned int, unsigned int>(
+			[&indexLock, &readIndex, &writeIndex, useBarriers](bool isWrite, unsigned int key, unsigned int value) {
+				if (useBarriers) {
+					if (isWrite) {
+						writeIndex(key, value);
+					} else {
+						readIndex(key);
+					}
+				} else if (isWrite) {
+					unique_lock<shared_mutex> tempLock(indexLock);
+					writeIndex(key, value);
+				} else {
+					shared_lock<shared_mutex> tempLock(indexLock);
+					readIndex(key);
+				}
+			}
+		),
+		numWorkers,
+		true
+	);
+
+	// Perform all of our operations, and wait for them to finish.
+	unsigned int randomValue = 12345;
+	auto beforeOperations = chrono::high_resolution_clock::now();
+	for (unsigned int operationIndex = 0; operationIndex < BARRIER_NUM_OPERATIONS; ++operationIndex) {
+		randomValue = ((randomValue * 1103515245) + 12345);
+		bool         isWrite = (((randomValue >> 16) % 100) < BARRIER_WRITE_PERCENT);
+		unsigned int key     = ((randomValue >> 4) % BARRIER_NUM_RECORDS);
+		if (isWrite && useBarriers) {
+			pIndexQueue->dispatchBarrier(true, key, operationIndex);
+		} else {
+			pIndexQueue->dispatchWork(isWrite, key, operationIndex);
+		}
+	}
+	pIndexQueue->hasWorkLeft(true);
+	auto afterOperations = chrono::high_resolution_clock::now();
+
+	// Clean up after ourselves.
+	delete(pIndexQueue);
+
+	*pNumTorn = numTorn;
+	return(((double) chrono::duration_cast<chrono::microseconds>(afterOperations - beforeOperations).count()) / 1000.0);
+}
+
+bool testQueueBarrierSpawnBehind(unsigned int numWorkers, double * pMS) {
+	// Shared with the Queue's work, which outlives us (leaked) if it deadlocks.
+	typedef struct __BARRIER_SPAWN_STATE__ {
+		atomic<bool> didBarrierRun;
+		atomic<bool> didBarrierRunFirst;
+		atomic<bool> isDone;
+	} BarrierSpawnState;
+	shared_ptr<BarrierSpawnState> pState = make_shared<BarrierSpawnState>();
+	pState->didBarrierRun      = false;
+	pState->didBarrierRunFirst = false;
+	pState->isDone             = false;
+
+	// Declare our Queue. Its QueueFunction is never called.
+	Queue<void, unsigned int> * pSpawnQueue = new Queue<void, unsigned int>(
+		new QueueFunction<void, unsigned int>([](unsigned int value) {}),
+		numWorkers,
+		true
+	);
+
+	// One thread runs a slow task, while a task on another dispatches a barrier, spawns a task behind it, and waits on
+	// that. The barrier has to start on the waiting thread (the only thing left running) once the slow task finishes.
+	auto beforeWait = chrono::high_resolution_clock::now();
+	pSpawnQueue->dispatchFunction([]() {
+		this_thread::sleep_for(chrono::milliseconds(BARRIER_SLOW_TASK_MS));
+	});
+	pSpawnQueue->dispatchFunction([pSpawnQueue, pState]() {
+		pSpawnQueue->dispatchBarrierFunction([pState]() {
+			pState->didBarrierRun = true;
+		});
+		QueueTaskGroup group(pSpawnQueue);
+		group.spawn([pState]() {
+			pState->didBarrierRunFirst = pState->didBarrierRun.load();
+		});
+		group.wait();
+		pState->isDone = true;
+	});
+
+	// Wait for it, giving up (and leaking the Queue, which can't be torn down) if it's deadlocked.
+	while (!pState->isDone && (chrono::high_resolution_clock::now() - beforeWait) < chrono::milliseconds(BARRIER_DEADLOCK_TIMEOUT_MS)) {
+		this_thread::sleep_for(chrono::milliseconds(1));
+	}
+	auto afterWait = chrono::high_resolution_clock::now();
+	*pMS = ((double) chrono::duration_cast<chrono::microseconds>(afterWait - beforeWait).count()) / 1000.0;
+	if (!pState->isDone) {
+		return(false);
+	}
+
+	// Clean up after ourselves.
+	pSpawnQueue->hasWorkLeft(true);
+	delete(pSpawnQueue);
+	return(pState->didBarrierRunFirst);
+}
+
+void testQueueBarrier(unsigned int maxNumThreads) {
+	// The worker counts we'll test: powers of two, plus the max itself.
+	vector<unsigned int> allWorkerCounts = TestHelpers::workerCounts(maxNumThreads);
+
+	printf("==========================================================================================\n");
+	printf("=== Index of %u records, %u operations (%u%% writes): reader/writer lock vs barriers\n", BARRIER_NUM_RECORDS, BARRIER_NUM_OPERATIONS, BARRIER_WRITE_PERCENT);
+	printf("==========================================================================================\n");
+	for (unsigned int workerIndex = 0; workerIndex < allWorkerCounts.size(); ++workerIndex) {
+		unsigned int numWorkers     = allWorkerCounts[workerIndex];
+		unsigned int numTornLock    = 0;
+		unsigned int numTornBarrier = 0;
+		double       lockMS         = testQueueBarrierIndex(numWorkers, false, &numTornLock);
+		double       barrierMS      = testQueueBarrierIndex(numWorkers, true,  &numTornBarrier);
+		printf("[%2u Worker%s] Lock: %9.3f ms, barriers: %s%9.3f ms%s (%.2fx) (%s%u torn reads%s)\n",
+			numWorkers, (numWorkers == 1) ? " " : "s", lockMS,
+			(barrierMS < lockMS) ? Colors::pColorGreen : Colors::pColorRed, barrierMS, Colors::pColorReset, lockMS / barrierMS,
+			((numTornLock + numTornBarrier) == 0) ? Colors::pColorGreen : Colors::pColorRed, numTornLock + numTornBarrier, Colors::pColorReset);
+	}
+
+	printf("==========================================================================================\n");
+	printf("=== A task spawning work behind a barrier and waiting on it, while a %u ms task runs\n", BARRIER_SLOW_TASK_MS);
+	printf("==========================================================================================\n");
+	for (unsigned int workerIndex = 0; workerIndex < allWorkerCounts.size(); ++workerIndex) {
+		unsigned int numWorkers = allWorkerCounts[workerIndex];
+		if (numWorkers < 2) {
+			continue;
+		}
+		double spawnMS   = 0.0;
+		bool   isCorrect = testQueueBarrierSpawnBehind(numWorkers, &spawnMS);
+		printf("[%2u Workers] Finished in: %9.3f ms (%s%s%s)\n", numWorkers, spawnMS,
+			isCorrect ? Colors::pColorGreen : Colors::pColorRed, isCorrect ? "correct" : "deadlocked or out of order", Colors::pColorReset);
+	}
+}
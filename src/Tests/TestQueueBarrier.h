@@ -0,0 +1,39 @@
+#ifndef __TEST_QUEUE_BARRIER_H__
+#define __TEST_QUEUE_BARRIER_H__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <vector>
+
+#include "DispatchCPP/DispatchCPP.h"
+#include "Colors.h"
+#include "TestHelpers.h"
+
+// The number of records in our index, the number of fields in each, and how many records each read scans.
+#define BARRIER_NUM_RECORDS             4096
+#define BARRIER_NUM_FIELDS              8
+#define BARRIER_RECORDS_PER_READ        16
+
+// The number of operations performed, and the percentage of them which are writes.
+#define BARRIER_NUM_OPERATIONS          200000
+#define BARRIER_WRITE_PERCENT           5
+
+// How long the slow task holding up a barrier runs, and how long we wait on a task waiting behind it before calling
+// it deadlocked.
+#define BARRIER_SLOW_TASK_MS            200
+#define BARRIER_DEADLOCK_TIMEOUT_MS     5000
+
+double testQueueBarrierIndex(unsigned int numWorkers, bool useBarriers, unsigned int * pNumTorn);
+
+bool testQueueBarrierSpawnBehind(unsigned int numWorkers, double * pMS);
+
+void testQueueBarrier(unsigned int maxNumThreads = 4);
+
+#endif // __TEST_QUEUE_BARRIER_H__
@@ -0,0 +1,204 @@
+#include "TestQueueCancel.h"
+
+using namespace DispatchCPP;
+
+// Convenience function for grabbing the CPU time (user and system) this process has used, in seconds.
+static double processCPUSeconds() {
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) != 0) {
+		return(0.0);
+	}
+	return(((double) (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec)) + (((double) (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec)) / 1000000.0));
+}
+
+// Each task's CPU-bound work: hash a buffer a number of times, and fold the result into a sink.
+static atomic<unsigned long long int> cancelWorkSink(0);
+static void cancelDoWork(unsigned int clientIndex, unsigned int taskIndex) {
+	unsigned char buffer[CANCEL_WORK_BUFFER_SIZE];
+	for (unsigned int index = 0; index < CANCEL_WORK_BUFFER_SIZE; ++index) {
+		buffer[index] = ((unsigned char) (clientIndex + taskIndex + index));
+	}
+	cancelWorkSink.fetch_xor(TestHelpers::hashBytes(buffer, CANCEL_WORK_BUFFER_SIZE, CANCEL_WORK_ITERATIONS), memory_order_relaxed);
+}
+
+double testQueueCancelMassCancel(unsigned int numWorkers, bool useTokens, double * pCPUSeconds, unsigned int * pNumRun) {
+	// Whether each client is still connected, and the number of tasks which actually did their work.
+	vector<atomic<bool>> isConnected   = vector<atomic<bool>>(CANCEL_NUM_CLIENTS);
+	atomic<unsigned int> numRun(0);
+	for (unsigned int clientIndex = 0; clientIndex < CANCEL_NUM_CLIENTS; ++clientIndex) {
+		isConnected[clientIndex] = true;
+	}
+
+	// Declare our Queue. Without tokens, work for a disconnected client still runs, and its result is thrown away.
+	Queue<void, unsigned int, unsigned int> * pClientQueue = new Queue<void, unsigned int, unsigned int>(
+		new QueueFunction<void, unsigned int, unsigned int>(
+			[&numRun](unsigned int clientIndex, unsigned int taskIndex) {
+				cancelDoWork(clientIndex, taskIndex);
+				numRun += 1;
+			}
+		),
+		numWorkers,
+		true
+	);
+
+	// One token per client.
+	vector<QueueCancelToken> allTokens = vector<QueueCancelToken>(CANCEL_NUM_CLIENTS);
+
+	// Start our timers, and have every client dispatch all of its work, interleaved as it would arrive.
+	double cpuBefore      = processCPUSeconds();
+	auto   beforeDispatch = chrono::high_resolution_clock::now();
+	for (unsigned int taskIndex = 0; taskIndex < CANCEL_TASKS_PER_CLIENT; ++taskIndex) {
+		for (unsigned int clientIndex = 0; clientIndex < CANCEL_NUM_CLIENTS; ++clientIndex) {
+			if (useTokens) {
+				pClientQueue->dispatchWork(allTokens[clientIndex], clientIndex, taskIndex);
+			} else {
+				pClientQueue->dispatchWork(clientIndex, taskIndex);
+			}
+		}
+	}
+
+	// Most of our clients disconnect, now.
+	for (unsigned int clientIndex = 0; clientIndex < CANCEL_NUM_DISCONNECTS; ++clientIndex) {
+		isConnected[clientIndex] = false;
+		if (useTokens) {
+			allTokens[clientIndex].cancel();
+		}
+	}
+
+	// Wait for all work to drain, and end our timers.
+	pClientQueue->hasWorkLeft(true);
+	auto afterDispatch = chrono::high_resolution_clock::now();
+	*pCPUSeconds = (processCPUSeconds() - cpuBefore);
+	*pNumRun     = numRun.load();
+
+	// Clean up after ourselves.
+	delete(pClientQueue);
+
+	// Return the number of milliseconds it took for all work to drain.
+	return(((double) chrono::duration_cast<chrono::microseconds>(afterDispatch - beforeDispatch).count()) / 1000.0);
+}
+
+double testQueueCancelCooperative(unsigned int numWorkers, unsigned int * pNumStopped) {
+	// The number of long-running tasks which noticed they were cancelled, and the number which have finished.
+	atomic<unsigned int> numStopped(0);
+	atomic<unsigned int> numFinished(0);
+
+	// Declare our Queue, whose tasks run for a long time, polling their token between chunks of work.
+	Queue<void, unsigned int> * pLongQueue = new Queue<void, unsigned int>(
+		new QueueFunction<void, unsigned int>(
+			[&numStopped, &numFinished](unsigned int taskIndex) {
+				auto startTime = chrono::high_resolution_clock::now();
+				unsigned int chunkIndex = 0;
+				while ((chrono::high_resolution_clock::now() - startTime) < chrono::milliseconds(CANCEL_LONG_TASK_MS)) {
+					if (QueueCancelToken::isCurrentCancelled()) {
+						numStopped += 1;
+						break;
+					}
+					cancelDoWork(taskIndex, chunkIndex++);
+				}
+				numFinished += 1;
+			}
+		),
+		numWorkers,
+		true
+	);
+
+	// Start one long-running task per worker, and let them get going.
+	QueueCancelToken longToken;
+	for (unsigned int taskIndex = 0; taskIndex < numWorkers; ++taskIndex) {
+		pLongQueue->dispatchWork(longToken, taskIndex);
+	}
+	usleep(CANCEL_LONG_TASK_CANCEL_MS * 1000);
+
+	// Cancel them, and time how long it takes for all of them to stop.
+	auto beforeCancel = chrono::high_resolution_clock::now();
+	longToken.cancel();
+	while (numFinished.load() < numWorkers) {
+		this_thread::yield();
+	}
+	auto afterCancel = chrono::high_resolution_clock::now();
+	*pNumStopped = numStopped.load();
+
+	// Clean up after ourselves.
+	pLongQueue->hasWorkLeft(true);
+	delete(pLongQueue);
+
+	// Return the number of microseconds it took for every task to stop.
+	return((double) chrono::duration_cast<chrono::microseconds>(afterCancel - beforeCancel).count());
+}
+
+double testQueueCancelOverhead(unsigned int numWorkers, bool useTokens) {
+	// Declare our Queue, whose function does nothing at all.
+	Queue<void> * pEmptyQueue = new Queue<void>(
+		new QueueFunction<void>(
+			[]() {}
+		),
+		numWorkers,
+		true
+	);
+
+	// Dispatch all of our empty tasks, and wait for them to drain.
+	QueueCancelToken emptyToken;
+	auto beforeDispatch = chrono::high_resolution_clock::now();
+	for (unsigned int taskIndex = 0; taskIndex < CANCEL_OVERHEAD_NUM_TASKS; ++taskIndex) {
+		if (useTokens) {
+			pEmptyQueue->dispatchWork(emptyToken);
+		} else {
+			pEmptyQueue->dispatchWork();
+		}
+	}
+	pEmptyQueue->hasWorkLeft(true);
+	auto afterDispatch = chrono::high_resolution_clock::now();
+
+	// Clean up after ourselves.
+	delete(pEmptyQueue);
+
+	// Return the number of nanoseconds each task took, end to end.
+	return(((double) chrono::duration_cast<chrono::nanoseconds>(afterDispatch - beforeDispatch).count()) / ((double) CANCEL_OVERHEAD_NUM_TASKS));
+}
+
+void testQueueCancel(unsigned int maxNumThreads) {
+	// The worker counts we'll test: powers of two, plus the max itself.
+	vector<unsigned int> allWorkerCounts = TestHelpers::workerCounts(maxNumThreads);
+
+	printf("==========================================================================================\n");
+	printf("=== Mass cancel (%u clients x %u tasks, %u clients disconnect right after dispatching)\n", CANCEL_NUM_CLIENTS, CANCEL_TASKS_PER_CLIENT, CANCEL_NUM_DISCONNECTS);
+	printf("==========================================================================================\n");
+	for (unsigned int workerIndex = 0; workerIndex < allWorkerCounts.size(); ++workerIndex) {
+		unsigned int numWorkers   = allWorkerCounts[workerIndex];
+		double       noTokenCPU   = 0.0, tokenCPU   = 0.0;
+		unsigned int noTokenNumRun = 0,  tokenNumRun = 0;
+		double       noTokenMS    = testQueueCancelMassCancel(numWorkers, false, &noTokenCPU, &noTokenNumRun);
+		double       tokenMS      = testQueueCancelMassCancel(numWorkers, true,  &tokenCPU,   &tokenNumRun);
+		printf("[%2u Worker%s] No tokens: %6u tasks run, %8.1f mS, %7.3f CPU s\n",
+			numWorkers, (numWorkers == 1) ? " " : "s", noTokenNumRun, noTokenMS, noTokenCPU);
+		printf("[%2u Worker%s] Tokens:    %6u tasks run, %8.1f mS, %7.3f CPU s %s(%.1f%% CPU saved)%s\n",
+			numWorkers, (numWorkers == 1) ? " " : "s", tokenNumRun, tokenMS, tokenCPU,
+			Colors::pColorGreen, ((noTokenCPU > 0.0) ? (100.0 * (1.0 - (tokenCPU / noTokenCPU))) : 0.0), Colors::pColorReset);
+		if ((workerIndex + 1) < allWorkerCounts.size()) {
+			printf("------------------------------------------------------------------------------------------\n");
+		}
+	}
+
+	printf("==========================================================================================\n");
+	printf("=== Cooperative cancel of running tasks (each runs %u mS unless cancelled)\n", CANCEL_LONG_TASK_MS);
+	printf("==========================================================================================\n");
+	for (unsigned int workerIndex = 0; workerIndex < allWorkerCounts.size(); ++workerIndex) {
+		unsigned int numWorkers  = allWorkerCounts[workerIndex];
+		unsigned int numStopped  = 0;
+		double       stopUS      = testQueueCancelCooperative(numWorkers, &numStopped);
+		printf("[%2u Worker%s] %u/%u tasks stopped early, all stopped within %s%9.1f uS%s of cancel()\n",
+			numWorkers, (numWorkers == 1) ? " " : "s", numStopped, numWorkers, Colors::pColorGreen, stopUS, Colors::pColorReset);
+	}
+
+	printf("==========================================================================================\n");
+	printf("=== Cost of checking a token (%u empty tasks)\n", CANCEL_OVERHEAD_NUM_TASKS);
+	printf("==========================================================================================\n");
+	for (unsigned int workerIndex = 0; workerIndex < allWorkerCounts.size(); ++workerIndex) {
+		unsigned int numWorkers = allWorkerCounts[workerIndex];
+		double       noTokenNS  = testQueueCancelOverhead(numWorkers, false);
+		double       tokenNS    = testQueueCancelOverhead(numWorkers, true);
+		printf("[%2u Worker%s] No tokens: %8.1f nS/task, tokens: %s%8.1f nS/task%s\n",
+			numWorkers, (numWorkers == 1) ? " " : "s", noTokenNS, Colors::pColorGreen, tokenNS, Colors::pColorReset);
+	}
+}
@@ -0,0 +1,39 @@
+#ifndef __TEST_QUEUE_CANCEL_H__
+#define __TEST_QUEUE_CANCEL_H__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/resource.h>
+
+#include <atomic>
+#include <chrono>
+#include <vector>
+
+#include "DispatchCPP/DispatchCPP.h"
+#include "Colors.h"
+#include "TestHelpers.h"
+
+// The number of clients dispatching work, how many tasks each dispatches, and how many of them disconnect.
+#define CANCEL_NUM_CLIENTS              16
+#define CANCEL_TASKS_PER_CLIENT         1000
+#define CANCEL_NUM_DISCONNECTS          12
+
+// The number of hashing passes each task makes (its CPU-bound work), and the size of the buffer hashed.
+#define CANCEL_WORK_ITERATIONS          16
+#define CANCEL_WORK_BUFFER_SIZE         1024
+
+// How long each long-running task runs for if it's never cancelled, and how long we wait before cancelling it.
+#define CANCEL_LONG_TASK_MS             2000
+#define CANCEL_LONG_TASK_CANCEL_MS      50
+
+// The number of empty tasks used to measure what checking a token costs.
+#define CANCEL_OVERHEAD_NUM_TASKS       200000
+
+double testQueueCancelMassCancel(unsigned int numWorkers, bool useTokens, double * pCPUSeconds, unsigned int * pNumRun);
+double testQueueCancelCooperative(unsigned int numWorkers, unsigned int * pNumStopped);
+double testQueueCancelOverhead(unsigned int numWorkers, bool useTokens);
+
+void testQueueCancel(unsigned int maxNumThreads = 4);
+
+#endif // __TEST_QUEUE_CANCEL_H__
@@ -0,0 +1,102 @@
+#include "TestQueueCoalesce.h"
+
+using namespace DispatchCPP;
+
+// Each refresh's work: hash its key a number of times, and fold the result into a sink.
+static atomic<unsigned long long int> coalesceWorkSink(0);
+static void coalesceDoWork(unsigned int key) {
+	coalesceWorkSink.fetch_xor(TestHelpers::hashWork(key, COALESCE_WORK_ITERATIONS), memory_order_relaxed);
+}
+
+double testQueueCoalesceRun(unsigned int numWorkers, CoalesceMode mode, unsigned long long int * pNumRun, unsigned long long int * pNumCounted, double * pAverageDepth, size_t * pMaxDepth) {
+	// The number of refreshes which actually ran, and the number of requests they accounted for.
+	atomic<unsigned long long int> numRun(0);
+	atomic<unsigned long long int> numCounted(0);
+
+	// Declare our Queue. Each refresh is handed its key, and the number of requests it's standing in for.
+	Queue<void, unsigned int, unsigned int> * pRefreshQueue = new Queue<void, unsigned int, unsigned int>(
+		new QueueFunction<void, unsigned int, unsigned int>(
+			[&numRun, &numCounted](unsigned int key, unsigned int numRequests) {
+				coalesceDoWork(key);
+				numRun.fetch_add(1, memory_order_relaxed);
+				numCounted.fetch_add(numRequests, memory_order_relaxed);
+			}
+		),
+		numWorkers,
+		true
+	);
+
+	// When merging, a refresh stands in for every request merged into it.
+	function<tuple<unsigned int, unsigned int>(const tuple<unsigned int, unsigned int> &, const tuple<unsigned int, unsigned int> &)> mergeFunc =
+		[](const tuple<unsigned int, unsigned int> & waitingArgs, const tuple<unsigned int, unsigned int> & newArgs) {
+			return(make_tuple(get<0>(newArgs), get<1>(waitingArgs) + get<1>(newArgs)));
+		};
+
+	// Request all of our refreshes, sampling the queue's depth as we go.
+	unsigned int randomValue = 12345;
+	double       totalDepth  = 0.0;
+	unsigned int numSamples  = 0;
+	size_t       maxDepth    = 0;
+	auto beforeDispatch = chrono::high_resolution_clock::now();
+	for (unsigned int dispatchIndex = 0; dispatchIndex < COALESCE_NUM_DISPATCHES; ++dispatchIndex) {
+		randomValue = ((randomValue * 1103515245) + 12345);
+		unsigned int key = ((randomValue >> 8) % COALESCE_NUM_KEYS);
+		switch (mode) {
+			case CoalesceModeNone:    pRefreshQueue->dispatchWork(key, 1);                     break;
+			case CoalesceModeReplace: pRefreshQueue->dispatchWorkCoalesced(key, key, 1);       break;
+			case CoalesceModeMerge:   pRefreshQueue->dispatchWorkCoalesced(key, mergeFunc, key, 1); break;
+		}
+		if ((dispatchIndex % COALESCE_DEPTH_SAMPLE_INTERVAL) == 0) {
+			size_t currentDepth = pRefreshQueue->getQueueDepth();
+			totalDepth += (double) currentDepth;
+			maxDepth    = max(maxDepth, currentDepth);
+			numSamples++;
+		}
+	}
+	pRefreshQueue->hasWorkLeft(true);
+	auto afterDispatch = chrono::high_resolution_clock::now();
+
+	// Clean up after ourselves.
+	delete(pRefreshQueue);
+
+	*pNumRun       = numRun;
+	*pNumCounted   = numCounted;
+	*pAverageDepth = (totalDepth / ((double) numSamples));
+	*pMaxDepth     = maxDepth;
+	return(((double) chrono::duration_cast<chrono::microseconds>(afterDispatch - beforeDispatch).count()) / 1000.0);
+}
+
+void testQueueCoalesce(unsigned int maxNumThreads) {
+	// The worker counts we'll test: powers of two, plus the max itself.
+	vector<unsigned int> allWorkerCounts = TestHelpers::workerCounts(maxNumThreads);
+
+	const char * allModeNames[] = { "Plain   ", "Coalesce", "Merge   " };
+	printf("==========================================================================================\n");
+	printf("=== Cache refreshes, %u keys, %u requests\n", COALESCE_NUM_KEYS, COALESCE_NUM_DISPATCHES);
+	printf("==========================================================================================\n");
+	for (unsigned int workerIndex = 0; workerIndex < allWorkerCounts.size(); ++workerIndex) {
+		unsigned int numWorkers = allWorkerCounts[workerIndex];
+		double       plainMS    = 0.0;
+		for (unsigned int modeIndex = CoalesceModeNone; modeIndex <= CoalesceModeMerge; ++modeIndex) {
+			unsigned long long int numRun      = 0;
+			unsigned long long int numCounted  = 0;
+			double                 averageDepth = 0.0;
+			size_t                 maxDepth     = 0;
+			double                 totalMS      = testQueueCoalesceRun(numWorkers, (CoalesceMode) modeIndex, &numRun, &numCounted, &averageDepth, &maxDepth);
+			if (modeIndex == CoalesceModeNone) {
+				plainMS = totalMS;
+			}
+
+			// Every request must be accounted for, unless we're deliberately keeping only the latest one.
+			bool isCorrect = ((modeIndex == CoalesceModeReplace) || (numCounted == COALESCE_NUM_DISPATCHES));
+			printf("[%2u Worker%s] %s: %s%9.3f ms%s, %7llu refreshes run (%5.1f%% saved), depth avg %8.1f max %6zu%s\n",
+				numWorkers, (numWorkers == 1) ? " " : "s", allModeNames[modeIndex],
+				(totalMS <= plainMS) ? Colors::pColorGreen : Colors::pColorRed, totalMS, Colors::pColorReset,
+				numRun, 100.0 * (1.0 - (((double) numRun) / ((double) COALESCE_NUM_DISPATCHES))), averageDepth, maxDepth,
+				isCorrect ? "" : " (requests lost!)");
+		}
+		if ((workerIndex + 1) < allWorkerCounts.size()) {
+			printf("------------------------------------------------------------------------------------------\n");
+		}
+	}
+}
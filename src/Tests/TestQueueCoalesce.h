@@ -0,0 +1,38 @@
+#ifndef __TEST_QUEUE_COALESCE_H__
+#define __TEST_QUEUE_COALESCE_H__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <tuple>
+#include <vector>
+
+#include "DispatchCPP/DispatchCPP.h"
+#include "Colors.h"
+#include "TestHelpers.h"
+
+// The number of cache keys being refreshed, and the total number of refreshes requested across all of them.
+#define COALESCE_NUM_KEYS               256
+#define COALESCE_NUM_DISPATCHES         200000
+
+// The number of hashing passes each refresh makes (its CPU-bound work).
+#define COALESCE_WORK_ITERATIONS        2048
+
+// How often (in dispatches) we sample the queue's depth.
+#define COALESCE_DEPTH_SAMPLE_INTERVAL  64
+
+// How work is dispatched: as-is, coalesced keeping the latest arguments, or coalesced merging them.
+typedef enum {
+	CoalesceModeNone = 0,
+	CoalesceModeReplace,
+	CoalesceModeMerge
+} CoalesceMode;
+
+double testQueueCoalesceRun(unsigned int numWorkers, CoalesceMode mode, unsigned long long int * pNumRun, unsigned long long int * pNumCounted, double * pAverageDepth, size_t * pMaxDepth);
+
+void testQueueCoalesce(unsigned int maxNumThreads = 4);
+
+#endif // __TEST_QUEUE_COALESCE_H__
@@ -1,5 +1,371 @@
 #include "TestQueueDownloads.h"
 
+using namespace DispatchCPP;
+
+// The state of a single download, shared by both the blocking and the epoll-driven clients.
+typedef struct __DOWNLOAD_STATE__ {
+	int    socketFD;
+	string requestData;
+	size_t numRequestSent;
+	string headerData;
+	bool   hasHeader;
+	size_t contentLength;
+	size_t numBodyReceived;
+	bool   bodyIntact;
+} DownloadState, * pDownloadState;
+
+// Prepares a download of a body of the given size, without connecting it yet.
+static void downloadInit(DownloadState * pState, size_t bodySize) {
+	pState->socketFD        = -1;
+	pState->requestData     = "GET /"s + to_string(bodySize) + " HTTP/1.1\r\nHost: 127.0.0.1\r\nConnection: close\r\n\r\n";
+	pState->numRequestSent  = 0;
+	pState->headerData      = ""s;
+	pState->hasHeader       = false;
+	pState->contentLength   = 0;
+	pState->numBodyReceived = 0;
+	pState->bodyIntact      = true;
+}
+
+// Feeds received bytes into a download. Returns true once the whole body has arrived.
+static bool downloadConsume(DownloadState * pState, const char * pData, size_t numBytes) {
+	// Still waiting on the end of the header?
+	if (!pState->hasHeader) {
+		pState->headerData.append(pData, numBytes);
+		size_t headerEnd = pState->headerData.find("\r\n\r\n");
+		if (headerEnd == string::npos) {
+			return(false);
+		}
+
+		// Pull out the content length, and treat whatever followed the header as body.
+		size_t lengthIndex = pState->headerData.find("Content-Length: ");
+		unsigned long long int contentLength = 0;
+		if ((lengthIndex == string::npos) || (lengthIndex > headerEnd) ||
+		    (sscanf(pState->headerData.c_str() + lengthIndex, "Content-Length: %llu", &contentLength) != 1)) {
+			pState->bodyIntact = false;
+		}
+		pState->hasHeader     = true;
+		pState->contentLength = ((size_t) contentLength);
+		pData                 = (pState->headerData.data() + headerEnd + 4);
+		numBytes              = (pState->headerData.size() - (headerEnd + 4));
+	}
+
+	// Verify each body byte against what the server serves, as a real client would have to look at it anyway.
+	for (size_t index = 0; index < numBytes; ++index) {
+		if (pData[index] != LoopbackHTTPServer::bodyByteAt(pState->numBodyReceived + index)) {
+			pState->bodyIntact = false;
+		}
+	}
+	pState->numBodyReceived += numBytes;
+	return(pState->numBodyReceived >= pState->contentLength);
+}
+
+// Closes a download's socket with a reset, so neither side is left holding a TIME_WAIT entry per download.
+static void downloadClose(DownloadState * pState) {
+	if (pState->socketFD >= 0) {
+		struct linger abortiveLinger;
+		abortiveLinger.l_onoff  = 1;
+		abortiveLinger.l_linger = 0;
+		setsockopt(pState->socketFD, SOL_SOCKET, SO_LINGER, &abortiveLinger, sizeof(abortiveLinger));
+		close(pState->socketFD);
+		pState->socketFD = -1;
+	}
+}
+
+// Returns the loopback address of our server.
+static struct sockaddr_in downloadServerAddr(unsigned short port) {
+	struct sockaddr_in serverAddr;
+	memset(&serverAddr, 0, sizeof(serverAddr));
+	serverAddr.sin_family      = AF_INET;
+	serverAddr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	serverAddr.sin_port        = htons(port);
+	return(serverAddr);
+}
+
+// Downloads a single body with a blocking socket. Returns whether the whole body arrived intact.
+static bool downloadBlocking(unsigned short port, size_t bodySize) {
+	DownloadState      state;
+	struct sockaddr_in serverAddr = downloadServerAddr(port);
+	downloadInit(&state, bodySize);
+
+	// Connect and send our request.
+	state.socketFD = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if ((state.socketFD < 0) || (connect(state.socketFD, (struct sockaddr *) &serverAddr, sizeof(serverAddr)) != 0)) {
+		downloadClose(&state);
+		return(false);
+	}
+	int noDelay = 1;
+	setsockopt(state.socketFD, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+	while (state.numRequestSent < state.requestData.size()) {
+		ssize_t numSent = send(state.socketFD, state.requestData.data() + state.numRequestSent, state.requestData.size() - state.numRequestSent, MSG_NOSIGNAL);
+		if (numSent <= 0) {
+			downloadClose(&state);
+			return(false);
+		}
+		state.numRequestSent += numSent;
+	}
+
+	// Read until we've got the whole body, blocking this thread for as long as the server takes.
+	vector<char> readBuffer = vector<char>(DOWNLOADS_READ_SIZE);
+	bool         isDone     = false;
+	while (!isDone) {
+		ssize_t numRead = recv(state.socketFD, readBuffer.data(), readBuffer.size(), 0);
+		if (numRead <= 0) {
+			break;
+		}
+		isDone = downloadConsume(&state, readBuffer.data(), (size_t) numRead);
+	}
+	downloadClose(&state);
+	return(isDone && state.bodyIntact && (state.numBodyReceived == bodySize));
+}
+
+// Downloads numDownloads bodies from a single thread, keeping up to maxInFlight of them going at once with
+// non-blocking sockets driven by epoll. Returns the number which arrived intact.
+static unsigned int downloadEpoll(unsigned short port, size_t bodySize, unsigned int numDownloads, unsigned int maxInFlight) {
+	struct sockaddr_in    serverAddr   = downloadServerAddr(port);
+	vector<DownloadState> allStates    = vector<DownloadState>(numDownloads);
+	vector<char>          readBuffer   = vector<char>(DOWNLOADS_READ_SIZE);
+	unsigned int          numStarted   = 0;
+	unsigned int          numFinished  = 0;
+	unsigned int          numSucceeded = 0;
+	int                   epollFD      = epoll_create1(EPOLL_CLOEXEC);
+	if (epollFD < 0) {
+		return(0);
+	}
+
+	while (numFinished < numDownloads) {
+		// Start as many downloads as we're allowed to have in flight.
+		while ((numStarted < numDownloads) && ((numStarted - numFinished) < maxInFlight)) {
+			DownloadState * pState = &(allStates[numStarted]);
+			downloadInit(pState, bodySize);
+			pState->socketFD = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+			int noDelay = 1;
+			setsockopt(pState->socketFD, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+			int connectResult = connect(pState->socketFD, (struct sockaddr *) &serverAddr, sizeof(serverAddr));
+			if ((pState->socketFD < 0) || ((connectResult != 0) && (errno != EINPROGRESS))) {
+				downloadClose(pState);
+				numFinished += 1;
+			} else {
+				// Wait for the connection to become writable, so we can send our request.
+				struct epoll_event newEvent;
+				newEvent.events   = EPOLLOUT;
+				newEvent.data.u32 = numStarted;
+				epoll_ctl(epollFD, EPOLL_CTL_ADD, pState->socketFD, &newEvent);
+			}
+			numStarted += 1;
+		}
+
+		// Wait for any of our downloads to make progress.
+		struct epoll_event allEvents[DOWNLOADS_EPOLL_MAX_IN_FLIGHT];
+		int numEvents = epoll_wait(epollFD, allEvents, DOWNLOADS_EPOLL_MAX_IN_FLIGHT, 1000);
+		if ((numEvents < 0) && (errno != EINTR)) {
+			break;
+		}
+		for (int eventIndex = 0; eventIndex < numEvents; ++eventIndex) {
+			DownloadState * pState = &(allStates[allEvents[eventIndex].data.u32]);
+			if (pState->socketFD < 0) {
+				continue;
+			}
+			bool hasFailed = false;
+			bool isDone    = false;
+
+			// Still sending our request?
+			if (pState->numRequestSent < pState->requestData.size()) {
+				ssize_t numSent = send(pState->socketFD, pState->requestData.data() + pState->numRequestSent, pState->requestData.size() - pState->numRequestSent, MSG_NOSIGNAL);
+				if (numSent > 0) {
+					pState->numRequestSent += numSent;
+				} else if ((numSent < 0) && (errno != EAGAIN) && (errno != EWOULDBLOCK)) {
+					hasFailed = true;
+				}
+
+				// Once the request's out, switch over to waiting for the response.
+				if (!hasFailed && (pState->numRequestSent == pState->requestData.size())) {
+					struct epoll_event newEvent;
+					newEvent.events   = EPOLLIN;
+					newEvent.data.u32 = allEvents[eventIndex].data.u32;
+					epoll_ctl(epollFD, EPOLL_CTL_MOD, pState->socketFD, &newEvent);
+				}
+
+			// Otherwise, drain everything that's arrived.
+			} else {
+				while (!isDone && !hasFailed) {
+					ssize_t numRead = recv(pState->socketFD, readBuffer.data(), readBuffer.size(), 0);
+					if (numRead > 0) {
+						isDone = downloadConsume(pState, readBuffer.data(), (size_t) numRead);
+					} else if ((numRead < 0) && ((errno == EAGAIN) || (errno == EWOULDBLOCK))) {
+						break;
+					} else {
+						hasFailed = true;
+					}
+				}
+			}
+
+			// Did this download wrap up, one way or another?
+			if (isDone || hasFailed) {
+				if (isDone && pState->bodyIntact && (pState->numBodyReceived == bodySize)) {
+					numSucceeded += 1;
+				}
+				epoll_ctl(epollFD, EPOLL_CTL_DEL, pState->socketFD, NULL);
+				downloadClose(pState);
+				numFinished += 1;
+			}
+		}
+
+		// If nothing happened for a whole second, the rest aren't coming.
+		if (numEvents == 0) {
+			break;
+		}
+	}
+
+	// Clean up after ourselves.
+	for (unsigned int index = 0; index < numStarted; ++index) {
+		downloadClose(&(allStates[index]));
+	}
+	close(epollFD);
+	return(numSucceeded);
+}
+
+// Makes numDownloads blocking downloads, one per dispatch, across numThreads workers. Returns the number of microseconds it took.
+static double testQueueDownloadsBlocking(unsigned short port, size_t bodySize, unsigned int numDownloads, unsigned int numThreads, unsigned int * pNumSucceeded) {
+	atomic<unsigned int> numSucceeded(0);
+
+	// Start our timer.
+	auto beforeParallel = chrono::high_resolution_clock::now();
+
+	// Declare our Queue, each of whose workers is parked in recv() for most of each download.
+	Queue<void> * pDownloadQueue = new Queue<void>(
+		new QueueFunction<void>(
+			[port, bodySize, &numSucceeded]() {
+				if (downloadBlocking(port, bodySize)) {
+					numSucceeded += 1;
+				}
+			}
+		),
+		numThreads,
+		true
+	);
+
+	// Dispatch all our downloads, and wait for them to finish.
+	for (unsigned int index = 0; index < numDownloads; ++index) {
+		pDownloadQueue->dispatchWork();
+	}
+	pDownloadQueue->hasWorkLeft(true);
+
+	// End our timer.
+	auto afterParallel = chrono::high_resolution_clock::now();
+
+	// Clean up after ourselves.
+	delete(pDownloadQueue);
+
+	*pNumSucceeded = numSucceeded.load();
+	return((double) chrono::duration_cast<chrono::microseconds>(afterParallel - beforeParallel).count());
+}
+
+// Makes numDownloads downloads split across numThreads workers, each of which drives its share with epoll. Returns the number of microseconds it took.
+static double testQueueDownloadsEpoll(unsigned short port, size_t bodySize, unsigned int numDownloads, unsigned int numThreads, unsigned int * pNumSucceeded) {
+	atomic<unsigned int> numSucceeded(0);
+
+	// Start our timer.
+	auto beforeParallel = chrono::high_resolution_clock::now();
+
+	// Declare our Queue, each dispatch of which runs an event loop over its share of the downloads.
+	Queue<void, unsigned int> * pDownloadQueue = new Queue<void, unsigned int>(
+		new QueueFunction<void, unsigned int>(
+			[port, bodySize, &numSucceeded](unsigned int numShareDownloads) {
+				numSucceeded += downloadEpoll(port, bodySize, numShareDownloads, DOWNLOADS_EPOLL_MAX_IN_FLIGHT);
+			}
+		),
+		numThreads,
+		true
+	);
+
+	// Dispatch one share per worker, and wait for them to finish.
+	for (unsigned int threadIndex = 0; threadIndex < numThreads; ++threadIndex) {
+		unsigned int numShareDownloads = ((numDownloads / numThreads) + ((threadIndex < (numDownloads % numThreads)) ? 1 : 0));
+		if (numShareDownloads > 0) {
+			pDownloadQueue->dispatchWork(numShareDownloads);
+		}
+	}
+	pDownloadQueue->hasWorkLeft(true);
+
+	// End our timer.
+	auto afterParallel = chrono::high_resolution_clock::now();
+
+	// Clean up after ourselves.
+	delete(pDownloadQueue);
+
+	*pNumSucceeded = numSucceeded.load();
+	return((double) chrono::duration_cast<chrono::microseconds>(afterParallel - beforeParallel).count());
+}
+
+// Prints a single result line, comparing its throughput against the single blocking worker.
+static void printDownloadsResult(const char * pLabel, unsigned int numThreads, unsigned int numDownloads, unsigned int numSucceeded, size_t bodySize, double numMicroseconds, double baseMicroseconds) {
+	double numSeconds = (numMicroseconds / 1000000.0);
+	printf("[%-8s] %3u Thread%s => %9.1f downloads/s, %8.1f MB/s ",
+		pLabel,
+		numThreads,
+		(numThreads == 1) ? " " : "s",
+		((double) numSucceeded) / numSeconds,
+		((((double) numSucceeded) * ((double) bodySize)) / (1024.0 * 1024.0)) / numSeconds);
+	if (baseMicroseconds > 0.0) {
+		printf("(%s%6.2fx speedup%s)", ((numMicroseconds < baseMicroseconds) ? Colors::pColorGreen : Colors::pColorRed), baseMicroseconds / numMicroseconds, Colors::pColorReset);
+	}
+	if (numSucceeded != numDownloads) {
+		printf(" %s%u/%u FAILED%s", Colors::pColorRed, numDownloads - numSucceeded, numDownloads, Colors::pColorReset);
+	}
+	printf("\n");
+}
+
 void testQueueDownloads(unsigned int maxNumThreads) {
-    printf("Hello, world!\n");
-}
\ No newline at end of file
+	// The body sizes and artificial latencies we'll test with.
+	size_t       allBodySizes[]  = { 4 * 1024, 256 * 1024, 4 * 1024 * 1024 };
+	unsigned int allLatenciesUS[] = { 0, 5000 };
+
+	// Start our stand-in server.
+	LoopbackHTTPServer server(0, allBodySizes[(sizeof(allBodySizes) / sizeof(allBodySizes[0])) - 1]);
+	if (server.port == 0) {
+		printf("%sFAILED TO START THE LOOPBACK SERVER%s\n", Colors::pColorRed, Colors::pColorReset);
+		return;
+	}
+
+	// Build the thread counts for the blocking workers, which oversubscribe, and for the epoll workers, which don't need to.
+	vector<unsigned int> allBlockingThreadCounts = vector<unsigned int>();
+	vector<unsigned int> allEpollThreadCounts    = vector<unsigned int>();
+	for (unsigned int numThreads = 1; numThreads < (maxNumThreads * DOWNLOADS_OVERSUBSCRIBE_FACTOR); numThreads *= 2) {
+		allBlockingThreadCounts.push_back(numThreads);
+		if (numThreads < maxNumThreads) {
+			allEpollThreadCounts.push_back(numThreads);
+		}
+	}
+	allBlockingThreadCounts.push_back(maxNumThreads * DOWNLOADS_OVERSUBSCRIBE_FACTOR);
+	allEpollThreadCounts.push_back(maxNumThreads);
+
+	for (unsigned int latencyIndex = 0; latencyIndex < (sizeof(allLatenciesUS) / sizeof(allLatenciesUS[0])); ++latencyIndex) {
+		server.setLatencyUS(allLatenciesUS[latencyIndex]);
+		for (unsigned int sizeIndex = 0; sizeIndex < (sizeof(allBodySizes) / sizeof(allBodySizes[0])); ++sizeIndex) {
+			size_t       bodySize     = allBodySizes[sizeIndex];
+			unsigned int numDownloads = ((unsigned int) min((size_t) DOWNLOADS_MAX_PER_RUN, (size_t) (DOWNLOADS_MAX_BYTES_PER_RUN / bodySize)));
+			printf("==========================================================================================\n");
+			printf("=== %u downloads of %zu KB each, with %.1f mS of server latency\n", numDownloads, bodySize / 1024, ((double) allLatenciesUS[latencyIndex]) / 1000.0);
+			printf("==========================================================================================\n");
+
+			// Blocking sockets, one download per dispatch.
+			double baseMicroseconds = 0.0;
+			for (unsigned int threadIndex = 0; threadIndex < allBlockingThreadCounts.size(); ++threadIndex) {
+				unsigned int numSucceeded    = 0;
+				double       numMicroseconds = testQueueDownloadsBlocking(server.port, bodySize, numDownloads, allBlockingThreadCounts[threadIndex], &numSucceeded);
+				if (threadIndex == 0) {
+					baseMicroseconds = numMicroseconds;
+				}
+				printDownloadsResult("Blocking", allBlockingThreadCounts[threadIndex], numDownloads, numSucceeded, bodySize, numMicroseconds, ((threadIndex == 0) ? 0.0 : baseMicroseconds));
+			}
+			printf("------------------------------------------------------------------------------------------\n");
+
+			// Non-blocking sockets, one event loop per worker.
+			for (unsigned int threadIndex = 0; threadIndex < allEpollThreadCounts.size(); ++threadIndex) {
+				unsigned int numSucceeded    = 0;
+				double       numMicroseconds = testQueueDownloadsEpoll(server.port, bodySize, numDownloads, allEpollThreadCounts[threadIndex], &numSucceeded);
+				printDownloadsResult("Epoll", allEpollThreadCounts[threadIndex], numDownloads, numSucceeded, bodySize, numMicroseconds, baseMicroseconds);
+			}
+		}
+	}
+}
@@ -4,11 +4,40 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
 
+#include <atomic>
 #include <chrono>
+#include <string>
+#include <vector>
 
 #include "../DispatchCPP/DispatchCPP.h"
 
+#include "Colors.h"
+#include "LoopbackHTTPServer.h"
+
+// The most bytes we'll download across all the downloads in a single run. Fewer downloads are made of larger bodies.
+#define DOWNLOADS_MAX_BYTES_PER_RUN     (256 * 1024 * 1024)
+
+// The most downloads we'll make in a single run.
+#define DOWNLOADS_MAX_PER_RUN           256
+
+// How far past the max number of threads we oversubscribe the blocking workers.
+#define DOWNLOADS_OVERSUBSCRIBE_FACTOR  8
+
+// The most downloads each epoll-driven worker keeps in flight at once.
+#define DOWNLOADS_EPOLL_MAX_IN_FLIGHT   64
+
+// The size of the buffer each download reads into.
+#define DOWNLOADS_READ_SIZE             (64 * 1024)
+
 void testQueueDownloads(unsigned int maxNumThreads = 4);
 
-#endif // __TEST_QUEUE_DOWNLOADS_H__
\ No newline at end of file
+#endif // __TEST_QUEUE_DOWNLOADS_H__
@@ -1,5 +1,462 @@
 #include "TestQueueFileIO.h"
 
+using namespace DispatchCPP;
+
+// Printable names for each of our engines.
+static const char * pFileIOEngineNames[FileIOEngineCount] = {
+	"read/write",
+	"pread/pwrite",
+	"mmap",
+	"copy_file_range",
+};
+
+// Copies a range of a file using read/write through a heap buffer.
+static bool copyFileRangeBuffered(int srcFD, int dstFD, off_t offset, size_t length) {
+	// Position both files at the start of our range.
+	if ((lseek(srcFD, offset, SEEK_SET) != offset) || (lseek(dstFD, offset, SEEK_SET) != offset)) {
+		return(false);
+	}
+
+	// Allocate our buffer.
+	char * pBuffer = ((char *) malloc(FILE_IO_BUFFER_SIZE));
+	if (!pBuffer) {
+		return(false);
+	}
+
+	// Keep reading and writing until we've copied the whole range.
+	bool hitError = false;
+	while ((length > 0) && !hitError) {
+		ssize_t numRead = read(srcFD, pBuffer, ((length < FILE_IO_BUFFER_SIZE) ? length : FILE_IO_BUFFER_SIZE));
+		if (numRead <= 0) {
+			hitError = true;
+			break;
+		}
+		for (ssize_t numWritten = 0; numWritten < numRead;) {
+			ssize_t writeResult = write(dstFD, pBuffer + numWritten, numRead - numWritten);
+			if (writeResult <= 0) {
+				hitError = true;
+				break;
+			}
+			numWritten += writeResult;
+		}
+		length -= numRead;
+	}
+
+	// Clean up after ourselves.
+	free(pBuffer);
+	return(!hitError);
+}
+
+// Copies a range of a file using pread/pwrite through a page-aligned buffer.
+static bool copyFileRangePReadPWrite(int srcFD, int dstFD, off_t offset, size_t length) {
+	// Allocate our aligned buffer.
+	void * pBuffer = nullptr;
+	if (posix_memalign(&pBuffer, FILE_IO_BUFFER_ALIGNMENT, FILE_IO_BUFFER_SIZE) != 0) {
+		return(false);
+	}
+
+	// Keep reading and writing at explicit offsets until we've copied the whole range.
+	bool hitError = false;
+	while ((length > 0) && !hitError) {
+		ssize_t numRead = pread(srcFD, pBuffer, ((length < FILE_IO_BUFFER_SIZE) ? length : FILE_IO_BUFFER_SIZE), offset);
+		if (numRead <= 0) {
+			hitError = true;
+			break;
+		}
+		for (ssize_t numWritten = 0; numWritten < numRead;) {
+			ssize_t writeResult = pwrite(dstFD, ((char *) pBuffer) + numWritten, numRead - numWritten, offset + numWritten);
+			if (writeResult <= 0) {
+				hitError = true;
+				break;
+			}
+			numWritten += writeResult;
+		}
+		offset += numRead;
+		length -= numRead;
+	}
+
+	// Clean up after ourselves.
+	free(pBuffer);
+	return(!hitError);
+}
+
+// Copies a range of a file by mapping both files and copying between the mappings. The destination must already be sized.
+static bool copyFileRangeMMap(int srcFD, int dstFD, off_t offset, size_t length) {
+	// Nothing to map? Nothing to copy.
+	if (length == 0) {
+		return(true);
+	}
+
+	// Mappings must start on a page boundary, so map from the page our range starts in.
+	off_t  pageSize      = ((off_t) sysconf(_SC_PAGESIZE));
+	off_t  mapOffset     = (offset - (offset % pageSize));
+	size_t mapSlack      = ((size_t) (offset - mapOffset));
+	size_t mapLength     = (length + mapSlack);
+
+	// Map both files, now.
+	void * pSrcMap = mmap(NULL, mapLength, PROT_READ, MAP_SHARED, srcFD, mapOffset);
+	if (pSrcMap == MAP_FAILED) {
+		return(false);
+	}
+	void * pDstMap = mmap(NULL, mapLength, PROT_READ | PROT_WRITE, MAP_SHARED, dstFD, mapOffset);
+	if (pDstMap == MAP_FAILED) {
+		munmap(pSrcMap, mapLength);
+		return(false);
+	}
+
+	// We're only ever going to walk these front to back.
+	madvise(pSrcMap, mapLength, MADV_SEQUENTIAL);
+	madvise(pDstMap, mapLength, MADV_SEQUENTIAL);
+
+	// Copy the range over, and clean up after ourselves.
+	memcpy(((char *) pDstMap) + mapSlack, ((char *) pSrcMap) + mapSlack, length);
+	munmap(pDstMap, mapLength);
+	munmap(pSrcMap, mapLength);
+	return(true);
+}
+
+// Copies a range of a file within the kernel, via copy_file_range, falling back to sendfile where it's unsupported.
+static bool copyFileRangeKernel(int srcFD, int dstFD, off_t offset, size_t length) {
+	off_t srcOffset = offset;
+	off_t dstOffset = offset;
+	while (length > 0) {
+		ssize_t numCopied = copy_file_range(srcFD, &srcOffset, dstFD, &dstOffset, length, 0);
+		if (numCopied > 0) {
+			length -= numCopied;
+			continue;
+		}
+
+		// Did we hit something other than the filesystem (or kernel) not supporting it?
+		if ((numCopied == 0) || ((errno != EXDEV) && (errno != ENOSYS) && (errno != EINVAL) && (errno != EOPNOTSUPP))) {
+			return(false);
+		}
+
+		// Fall back to sendfile for whatever's left.
+		if (lseek(dstFD, dstOffset, SEEK_SET) != dstOffset) {
+			return(false);
+		}
+		while (length > 0) {
+			ssize_t numSent = sendfile(dstFD, srcFD, &srcOffset, length);
+			if (numSent <= 0) {
+				return(false);
+			}
+			length -= numSent;
+		}
+	}
+	return(true);
+}
+
+// Copies a range of one file into the same range of another file, using the given engine.
+bool copyFileRange(FileIOEngine engine, int srcFD, int dstFD, off_t offset, size_t length) {
+	switch (engine) {
+		case FileIOEngineBuffered:      return(copyFileRangeBuffered(srcFD, dstFD, offset, length));
+		case FileIOEnginePReadPWrite:   return(copyFileRangePReadPWrite(srcFD, dstFD, offset, length));
+		case FileIOEngineMMap:          return(copyFileRangeMMap(srcFD, dstFD, offset, length));
+		case FileIOEngineCopyFileRange: return(copyFileRangeKernel(srcFD, dstFD, offset, length));
+		default:                        return(false);
+	}
+}
+
+// Copies a whole file to a destination path, sizing the destination up front.
+static bool copyFileWhole(FileIOEngine engine, const string & srcFile, const string & dstFile) {
+	int srcFD = open(srcFile.c_str(), O_RDONLY);
+	if (srcFD < 0) {
+		return(false);
+	}
+	int dstFD = open(dstFile.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if (dstFD < 0) {
+		close(srcFD);
+		return(false);
+	}
+
+	// Size the destination to match the source, and copy it all across.
+	struct stat srcStat;
+	bool        returnValue = ((fstat(srcFD, &srcStat) == 0) && (ftruncate(dstFD, srcStat.st_size) == 0));
+	if (returnValue) {
+		returnValue = copyFileRange(engine, srcFD, dstFD, 0, (size_t) srcStat.st_size);
+	}
+
+	// Clean up after ourselves.
+	close(dstFD);
+	close(srcFD);
+	return(returnValue);
+}
+
+// Copies a single chunk of a file into an already-sized destination file.
+static bool copyFileChunk(FileIOEngine engine, const string & srcFile, const string & dstFile, off_t offset, size_t length) {
+	int srcFD = open(srcFile.c_str(), O_RDONLY);
+	if (srcFD < 0) {
+		return(false);
+	}
+	int dstFD = open(dstFile.c_str(), O_RDWR);
+	if (dstFD < 0) {
+		close(srcFD);
+		return(false);
+	}
+	bool returnValue = copyFileRange(engine, srcFD, dstFD, offset, length);
+	close(dstFD);
+	close(srcFD);
+	return(returnValue);
+}
+
+// Copies the source file numCopies times, single threaded. With more than one copy, each destination is suffixed with its index.
+void copyFileManually(string srcFile, string dstFile, unsigned int numCopies) {
+	for (unsigned int index = 0; index < numCopies; ++index) {
+		string targetFile = ((numCopies == 1) ? dstFile : (dstFile + "." + to_string(index)));
+		if (!copyFileWhole(FileIOEngineBuffered, srcFile, targetFile)) {
+			printf("%sFAILED TO COPY %s TO %s%s\n", Colors::pColorRed, srcFile.c_str(), targetFile.c_str(), Colors::pColorReset);
+		}
+	}
+}
+
+// Creates a file of the given size filled with pseudo-random bytes.
+static bool createSourceFile(const string & targetFile, size_t fileSize) {
+	int targetFD = open(targetFile.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (targetFD < 0) {
+		return(false);
+	}
+
+	// Fill a buffer with random words, and write it out until we hit our size.
+	vector<unsigned int> randBuffer = vector<unsigned int>(FILE_IO_BUFFER_SIZE / sizeof(unsigned int));
+	bool                 hitError   = false;
+	while ((fileSize > 0) && !hitError) {
+		for (unsigned int index = 0; index < randBuffer.size(); ++index) {
+			randBuffer[index] = ((unsigned int) rand());
+		}
+		size_t  numToWrite  = ((fileSize < FILE_IO_BUFFER_SIZE) ? fileSize : FILE_IO_BUFFER_SIZE);
+		ssize_t writeResult = write(targetFD, randBuffer.data(), numToWrite);
+		hitError  = (writeResult != ((ssize_t) numToWrite));
+		fileSize -= numToWrite;
+	}
+	close(targetFD);
+	return(!hitError);
+}
+
+// Returns whether two files have identical contents.
+static bool filesMatch(const string & fileA, const string & fileB) {
+	bool returnValue = false;
+	int  fdA         = open(fileA.c_str(), O_RDONLY);
+	int  fdB         = open(fileB.c_str(), O_RDONLY);
+	if ((fdA >= 0) && (fdB >= 0)) {
+		struct stat statA, statB;
+		if ((fstat(fdA, &statA) == 0) && (fstat(fdB, &statB) == 0) && (statA.st_size == statB.st_size)) {
+			if (statA.st_size == 0) {
+				returnValue = true;
+			} else {
+				void * pMapA = mmap(NULL, statA.st_size, PROT_READ, MAP_SHARED, fdA, 0);
+				void * pMapB = mmap(NULL, statB.st_size, PROT_READ, MAP_SHARED, fdB, 0);
+				if ((pMapA != MAP_FAILED) && (pMapB != MAP_FAILED)) {
+					returnValue = (memcmp(pMapA, pMapB, statA.st_size) == 0);
+				}
+				if (pMapA != MAP_FAILED) { munmap(pMapA, statA.st_size); }
+				if (pMapB != MAP_FAILED) { munmap(pMapB, statB.st_size); }
+			}
+		}
+	}
+	if (fdA >= 0) { close(fdA); }
+	if (fdB >= 0) { close(fdB); }
+	return(returnValue);
+}
+
+// Copies each of the source files to its destination, one file per dispatch. Returns the number of microseconds it took.
+static double testQueueFileIOFiles(FileIOEngine engine, unsigned int numThreads, vector<string> * pSrcFiles, vector<string> * pDstFiles, bool * pSucceeded) {
+	atomic<unsigned int> numFailures(0);
+
+	// Start our timer.
+	auto beforeParallel = chrono::high_resolution_clock::now();
+
+	// Declare our Queue, which copies a whole file per dispatch.
+	Queue<void, unsigned int> * pCopyQueue = new Queue<void, unsigned int>(
+		new QueueFunction<void, unsigned int>(
+			[engine, pSrcFiles, pDstFiles, &numFailures](unsigned int fileIndex) {
+				if (!copyFileWhole(engine, (*pSrcFiles)[fileIndex], (*pDstFiles)[fileIndex])) {
+					numFailures += 1;
+				}
+			}
+		),
+		numThreads,
+		true
+	);
+
+	// Dispatch all our copies, and wait for them to finish.
+	for (unsigned int fileIndex = 0; fileIndex < pSrcFiles->size(); ++fileIndex) {
+		pCopyQueue->dispatchWork(fileIndex);
+	}
+	pCopyQueue->hasWorkLeft(true);
+
+	// End our timer.
+	auto afterParallel = chrono::high_resolution_clock::now();
+
+	// Clean up after ourselves.
+	delete(pCopyQueue);
+
+	*pSucceeded = (numFailures.load() == 0);
+	return((double) chrono::duration_cast<chrono::microseconds>(afterParallel - beforeParallel).count());
+}
+
+// Copies a single large file in chunks, one chunk per dispatch. Returns the number of microseconds it took.
+static double testQueueFileIOChunks(FileIOEngine engine, unsigned int numThreads, const string & srcFile, const string & dstFile, size_t fileSize, bool * pSucceeded) {
+	atomic<unsigned int> numFailures(0);
+
+	// Start our timer.
+	auto beforeParallel = chrono::high_resolution_clock::now();
+
+	// Create and size the destination up front, so chunks can land in any order.
+	int dstFD = open(dstFile.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if ((dstFD < 0) || (ftruncate(dstFD, fileSize) != 0)) {
+		if (dstFD >= 0) {
+			close(dstFD);
+		}
+		*pSucceeded = false;
+		return(0.0);
+	}
+	close(dstFD);
+
+	// Declare our Queue, which copies a single chunk per dispatch.
+	Queue<void, off_t, size_t> * pCopyQueue = new Queue<void, off_t, size_t>(
+		new QueueFunction<void, off_t, size_t>(
+			[engine, &srcFile, &dstFile, &numFailures](off_t offset, size_t length) {
+				if (!copyFileChunk(engine, srcFile, dstFile, offset, length)) {
+					numFailures += 1;
+				}
+			}
+		),
+		numThreads,
+		true
+	);
+
+	// Dispatch all our chunks, and wait for them to finish.
+	for (size_t offset = 0; offset < fileSize; offset += FILE_IO_CHUNK_SIZE) {
+		size_t length = (((fileSize - offset) < FILE_IO_CHUNK_SIZE) ? (fileSize - offset) : FILE_IO_CHUNK_SIZE);
+		pCopyQueue->dispatchWork((off_t) offset, length);
+	}
+	pCopyQueue->hasWorkLeft(true);
+
+	// End our timer.
+	auto afterParallel = chrono::high_resolution_clock::now();
+
+	// Clean up after ourselves.
+	delete(pCopyQueue);
+
+	*pSucceeded = (numFailures.load() == 0);
+	return((double) chrono::duration_cast<chrono::microseconds>(afterParallel - beforeParallel).count());
+}
+
+// Prints a single result line, comparing its throughput against our manual baseline.
+static void printFileIOResult(const char * pEngineName, unsigned int numThreads, double numBytes, double numMicroseconds, double manualMBPS, bool succeeded) {
+	double mbPerSecond = ((numBytes / (1024.0 * 1024.0)) / (numMicroseconds / 1000000.0));
+	printf("[%-15s] %2u Thread%s => %9.1f MB/s (%s%5.2fx vs manual%s)%s\n",
+		pEngineName,
+		numThreads,
+		(numThreads == 1) ? " " : "s",
+		mbPerSecond,
+		((mbPerSecond > manualMBPS) ? Colors::pColorGreen : Colors::pColorRed),
+		mbPerSecond / manualMBPS,
+		Colors::pColorReset,
+		(succeeded ? "" : " COPY MISMATCH!"));
+}
+
 void testQueueFileIO(unsigned int maxNumThreads) {
-    printf("Hello, worldddddd!\n");
-}
\ No newline at end of file
+	// Create our scratch directory.
+	char scratchDir[] = FILE_IO_TEMP_DIR "/DispatchCPP-FileIO-XXXXXX";
+	if (!mkdtemp(scratchDir)) {
+		printf("%sFAILED TO CREATE A SCRATCH DIRECTORY IN %s%s\n", Colors::pColorRed, FILE_IO_TEMP_DIR, Colors::pColorReset);
+		return;
+	}
+	string scratchPath = string(scratchDir);
+
+	// The thread counts we'll test: powers of two, plus the max itself.
+	vector<unsigned int> allThreadCounts = TestHelpers::workerCounts(maxNumThreads);
+
+	// Create all of our source files.
+	printf("Creating %u files of %u MB, and one file of %u MB in %s...", FILE_IO_NUM_FILES, FILE_IO_FILE_SIZE / (1024 * 1024), FILE_IO_LARGE_FILE_SIZE / (1024 * 1024), scratchDir);
+	srand(123456);
+	vector<string> allSrcFiles = vector<string>();
+	vector<string> allDstFiles = vector<string>();
+	bool           hitError    = false;
+	for (unsigned int fileIndex = 0; fileIndex < FILE_IO_NUM_FILES; ++fileIndex) {
+		allSrcFiles.push_back(scratchPath + "/src." + to_string(fileIndex));
+		allDstFiles.push_back(scratchPath + "/dst." + to_string(fileIndex));
+		hitError = (hitError || !createSourceFile(allSrcFiles.back(), FILE_IO_FILE_SIZE));
+	}
+	string largeSrcFile = scratchPath + "/src.large";
+	string largeDstFile = scratchPath + "/dst.large";
+	hitError = (hitError || !createSourceFile(largeSrcFile, FILE_IO_LARGE_FILE_SIZE));
+	printf("%s\n", (hitError ? "FAILED!" : "done!"));
+
+	// Only bother running if we've got our source files.
+	if (!hitError) {
+		// N files, one file per dispatch --------------------------------------------------------------
+		printf("==========================================================================================\n");
+		printf("=== Copying %u files of %u MB each, one file per dispatch\n", FILE_IO_NUM_FILES, FILE_IO_FILE_SIZE / (1024 * 1024));
+		printf("==========================================================================================\n");
+		double numBytesFiles = ((double) FILE_IO_NUM_FILES) * ((double) FILE_IO_FILE_SIZE);
+
+		double manualMBPS    = 0.0;
+		for (unsigned int runIndex = 0; runIndex < FILE_IO_NUM_MANUAL_RUNS; ++runIndex) {
+			for (unsigned int fileIndex = 0; fileIndex < FILE_IO_NUM_FILES; ++fileIndex) {
+				unlink(allDstFiles[fileIndex].c_str());
+			}
+			auto beforeManual = chrono::high_resolution_clock::now();
+			for (unsigned int fileIndex = 0; fileIndex < FILE_IO_NUM_FILES; ++fileIndex) {
+				copyFileManually(allSrcFiles[fileIndex], allDstFiles[fileIndex], 1);
+			}
+			auto afterManual  = chrono::high_resolution_clock::now();
+			manualMBPS = max(manualMBPS, ((numBytesFiles / (1024.0 * 1024.0)) / (((double) chrono::duration_cast<chrono::microseconds>(afterManual - beforeManual).count()) / 1000000.0)));
+		}
+		printf("%s[%-15s]  Manually  => %9.1f MB/s (best of %u runs)%s\n", Colors::pColorGreen, pFileIOEngineNames[FileIOEngineBuffered], manualMBPS, FILE_IO_NUM_MANUAL_RUNS, Colors::pColorReset);
+
+		for (unsigned int engineIndex = 0; engineIndex < FileIOEngineCount; ++engineIndex) {
+			printf("------------------------------------------------------------------------------------------\n");
+			for (unsigned int threadIndex = 0; threadIndex < allThreadCounts.size(); ++threadIndex) {
+				// Remove the previous run's copies, so every run writes fresh files.
+				for (unsigned int fileIndex = 0; fileIndex < FILE_IO_NUM_FILES; ++fileIndex) {
+					unlink(allDstFiles[fileIndex].c_str());
+				}
+
+				bool   succeeded       = false;
+				double numMicroseconds = testQueueFileIOFiles((FileIOEngine) engineIndex, allThreadCounts[threadIndex], &allSrcFiles, &allDstFiles, &succeeded);
+				for (unsigned int fileIndex = 0; succeeded && (fileIndex < FILE_IO_NUM_FILES); ++fileIndex) {
+					succeeded = filesMatch(allSrcFiles[fileIndex], allDstFiles[fileIndex]);
+				}
+				printFileIOResult(pFileIOEngineNames[engineIndex], allThreadCounts[threadIndex], numBytesFiles, numMicroseconds, manualMBPS, succeeded);
+			}
+		}
+
+		// One large file, one chunk per dispatch ------------------------------------------------------
+		printf("==========================================================================================\n");
+		printf("=== Copying one %u MB file in %u MB chunks, one chunk per dispatch\n", FILE_IO_LARGE_FILE_SIZE / (1024 * 1024), FILE_IO_CHUNK_SIZE / (1024 * 1024));
+		printf("==========================================================================================\n");
+		double numBytesLarge = ((double) FILE_IO_LARGE_FILE_SIZE);
+		manualMBPS           = 0.0;
+		for (unsigned int runIndex = 0; runIndex < FILE_IO_NUM_MANUAL_RUNS; ++runIndex) {
+			unlink(largeDstFile.c_str());
+			auto beforeManual = chrono::high_resolution_clock::now();
+			copyFileManually(largeSrcFile, largeDstFile, 1);
+			auto afterManual  = chrono::high_resolution_clock::now();
+			manualMBPS = max(manualMBPS, ((numBytesLarge / (1024.0 * 1024.0)) / (((double) chrono::duration_cast<chrono::microseconds>(afterManual - beforeManual).count()) / 1000000.0)));
+		}
+		printf("%s[%-15s]  Manually  => %9.1f MB/s (best of %u runs)%s\n", Colors::pColorGreen, pFileIOEngineNames[FileIOEngineBuffered], manualMBPS, FILE_IO_NUM_MANUAL_RUNS, Colors::pColorReset);
+
+		for (unsigned int engineIndex = 0; engineIndex < FileIOEngineCount; ++engineIndex) {
+			printf("------------------------------------------------------------------------------------------\n");
+			for (unsigned int threadIndex = 0; threadIndex < allThreadCounts.size(); ++threadIndex) {
+				unlink(largeDstFile.c_str());
+
+				bool   succeeded       = false;
+				double numMicroseconds = testQueueFileIOChunks((FileIOEngine) engineIndex, allThreadCounts[threadIndex], largeSrcFile, largeDstFile, FILE_IO_LARGE_FILE_SIZE, &succeeded);
+				succeeded = (succeeded && filesMatch(largeSrcFile, largeDstFile));
+				printFileIOResult(pFileIOEngineNames[engineIndex], allThreadCounts[threadIndex], numBytesLarge, numMicroseconds, manualMBPS, succeeded);
+			}
+		}
+	}
+
+	// Clean up after ourselves.
+	for (unsigned int fileIndex = 0; fileIndex < allSrcFiles.size(); ++fileIndex) {
+		unlink(allSrcFiles[fileIndex].c_str());
+		unlink(allDstFiles[fileIndex].c_str());
+	}
+	unlink(largeSrcFile.c_str());
+	unlink(largeDstFile.c_str());
+	rmdir(scratchDir);
+}
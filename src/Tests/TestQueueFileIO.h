@@ -4,13 +4,55 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/sendfile.h>
+#include <sys/stat.h>
+#include <sys/types.h>
 
+#include <atomic>
 #include <chrono>
+#include <string>
+#include <vector>
 
 #include "../DispatchCPP/DispatchCPP.h"
 
+#include "Colors.h"
+#include "TestHelpers.h"
+
+// The directory our scratch files are created within.
+#define FILE_IO_TEMP_DIR            "/tmp"
+
+// The number and size of the files copied whole, one file per dispatch.
+#define FILE_IO_NUM_FILES           32
+#define FILE_IO_FILE_SIZE           (8 * 1024 * 1024)
+
+// The size of the large file copied in chunks, and the size of each chunk dispatched.
+#define FILE_IO_LARGE_FILE_SIZE     (256 * 1024 * 1024)
+#define FILE_IO_CHUNK_SIZE          (4 * 1024 * 1024)
+
+// The number of manual (single-threaded) runs made, the fastest of which is our baseline. Early runs pay for warming the page cache.
+#define FILE_IO_NUM_MANUAL_RUNS     3
+
+// The size of the buffers used by the buffered and pread/pwrite engines, and the alignment of the latter.
+#define FILE_IO_BUFFER_SIZE         (1024 * 1024)
+#define FILE_IO_BUFFER_ALIGNMENT    4096
+
+// The engines we're able to copy files with.
+typedef enum __FILE_IO_ENGINE__ {
+	FileIOEngineBuffered = 0,
+	FileIOEnginePReadPWrite,
+	FileIOEngineMMap,
+	FileIOEngineCopyFileRange,
+	FileIOEngineCount
+} FileIOEngine;
+
 void testQueueFileIO(unsigned int maxNumThreads = 4);
 
 void copyFileManually(string srcFile, string dstFile, unsigned int numCopies);
 
-#endif // __TEST_QUEUE_FILE_IO_H__
\ No newline at end of file
+bool copyFileRange(FileIOEngine engine, int srcFD, int dstFD, off_t offset, size_t length);
+
+#endif // __TEST_QUEUE_FILE_IO_H__
@@ -0,0 +1,176 @@
+#include "TestQueueForkJoin.h"
+
+using namespace DispatchCPP;
+
+// Recursively quicksorts [pBegin, pEnd): the left half is spawned, the right half is sorted by the calling task, and
+// then the calling task waits on (and helps with) the left half.
+static void forkJoinQuicksort(Queue<void> * pQueue, unsigned int * pBegin, unsigned int * pEnd) {
+	size_t numElements = (size_t) (pEnd - pBegin);
+	if (numElements <= FORK_JOIN_SORT_CUTOFF) {
+		sort(pBegin, pEnd);
+		return;
+	}
+
+	// Partition around the median of the first, middle and last elements.
+	unsigned int   allCandidates[3] = { pBegin[0], pBegin[numElements / 2], pEnd[-1] };
+	sort(allCandidates, allCandidates + 3);
+	unsigned int   pivot      = allCandidates[1];
+	unsigned int * pMiddle    = partition(pBegin, pEnd, [pivot](unsigned int value) { return(value < pivot); });
+	unsigned int * pMiddleEnd = partition(pMiddle, pEnd, [pivot](unsigned int value) { return(value == pivot); });
+
+	// Sort both sides, in parallel.
+	QueueTaskGroup taskGroup(pQueue);
+	taskGroup.spawn([pQueue, pBegin, pMiddle]() {
+		forkJoinQuicksort(pQueue, pBegin, pMiddle);
+	});
+	forkJoinQuicksort(pQueue, pMiddleEnd, pEnd);
+	taskGroup.wait();
+}
+
+// Computes the nth Fibonacci number the slow, recursive way.
+static unsigned long long int serialFib(unsigned int n) {
+	return((n < 2) ? n : (serialFib(n - 1) + serialFib(n - 2)));
+}
+
+// Recursively computes the nth Fibonacci number, spawning fib(n - 1) and computing fib(n - 2) itself.
+static unsigned long long int forkJoinFib(Queue<void> * pQueue, unsigned int n) {
+	if (n < FORK_JOIN_FIB_CUTOFF) {
+		return(serialFib(n));
+	}
+
+	unsigned long long int leftResult = 0;
+	QueueTaskGroup taskGroup(pQueue);
+	taskGroup.spawn([pQueue, n, &leftResult]() {
+		leftResult = forkJoinFib(pQueue, n - 1);
+	});
+	unsigned long long int rightResult = forkJoinFib(pQueue, n - 2);
+	taskGroup.wait();
+	return(leftResult + rightResult);
+}
+
+double testQueueForkJoinSort(unsigned int numWorkers, bool * pIsSorted) {
+	// Fill our vector with random values.
+	srand(1);
+	vector<unsigned int> allValues = vector<unsigned int>(FORK_JOIN_SORT_SIZE);
+	for (unsigned int index = 0; index < FORK_JOIN_SORT_SIZE; ++index) {
+		allValues[index] = (unsigned int) rand();
+	}
+
+	// Declare our Queue, which only ever runs the functions our task groups spawn onto it (0 workers means serial).
+	Queue<void> * pSortQueue = new Queue<void>(new QueueFunction<void>([]() {}), max(numWorkers, 1u), true);
+
+	// Sort it. The root of the recursion runs on the queue as well, just as nested divide-and-conquer work would.
+	auto beforeSort = chrono::high_resolution_clock::now();
+	if (numWorkers == 0) {
+		sort(allValues.begin(), allValues.end());
+	} else {
+		QueueTaskGroup rootGroup(pSortQueue);
+		rootGroup.spawn([pSortQueue, &allValues]() {
+			forkJoinQuicksort(pSortQueue, allValues.data(), allValues.data() + allValues.size());
+		});
+		rootGroup.wait();
+	}
+	auto afterSort = chrono::high_resolution_clock::now();
+
+	// Clean up after ourselves.
+	delete(pSortQueue);
+
+	*pIsSorted = is_sorted(allValues.begin(), allValues.end());
+	return(((double) chrono::duration_cast<chrono::microseconds>(afterSort - beforeSort).count()) / 1000.0);
+}
+
+double testQueueForkJoinFib(unsigned int numWorkers, unsigned long long int * pResult) {
+	// Declare our Queue, which only ever runs the functions our task groups spawn onto it (0 workers means serial).
+	Queue<void> * pFibQueue = new Queue<void>(new QueueFunction<void>([]() {}), max(numWorkers, 1u), true);
+
+	// Compute our Fibonacci number, with the root of the recursion running on the queue.
+	auto beforeFib = chrono::high_resolution_clock::now();
+	if (numWorkers == 0) {
+		*pResult = serialFib(FORK_JOIN_FIB_N);
+	} else {
+		QueueTaskGroup rootGroup(pFibQueue);
+		rootGroup.spawn([pFibQueue, pResult]() {
+			*pResult = forkJoinFib(pFibQueue, FORK_JOIN_FIB_N);
+		});
+		rootGroup.wait();
+	}
+	auto afterFib = chrono::high_resolution_clock::now();
+
+	// Clean up after ourselves.
+	delete(pFibQueue);
+
+	return(((double) chrono::duration_cast<chrono::microseconds>(afterFib - beforeFib).count()) / 1000.0);
+}
+
+bool testQueueForkJoinDiscarded(bool useTargetQueue) {
+	atomic<unsigned int> numRun(0);
+
+	// Our tasks sit behind work keeping their only thread busy: either on their own Queue, or on the parent Queue it
+	// targets.
+	Queue<void> * pParentQueue = (useTargetQueue ? new Queue<void>(new QueueFunction<void>([]() {}), 1, true) : nullptr);
+	Queue<void> * pTaskQueue   = new Queue<void>(new QueueFunction<void>([]() {}), 1, true);
+	if (useTargetQueue) {
+		pTaskQueue->setTargetQueue(pParentQueue);
+		pParentQueue->dispatchFunction([]() { usleep(FORK_JOIN_DISCARD_BLOCK_US); });
+	} else {
+		pTaskQueue->dispatchFunction([]() { usleep(FORK_JOIN_DISCARD_BLOCK_US); });
+	}
+	QueueTaskGroup * pGroup = new QueueTaskGroup(pTaskQueue);
+	for (unsigned int taskIndex = 0; taskIndex < FORK_JOIN_NUM_DISCARDED; ++taskIndex) {
+		pGroup->spawn([&numRun]() {
+			numRun.fetch_add(1, memory_order_relaxed);
+		});
+	}
+
+	// Destroying the Queue (which removes it from its parent's scheduler) throws the tasks away, which must still
+	// finish them, or the group would wait forever (in which case it's leaked, rather than destroyed).
+	delete(pTaskQueue);
+	bool isFinished = (pGroup->numPending() == 0);
+	if (isFinished) {
+		delete(pGroup);
+	}
+	if (pParentQueue != nullptr) {
+		delete(pParentQueue);
+	}
+	return(isFinished && (numRun.load() < FORK_JOIN_NUM_DISCARDED));
+}
+
+void testQueueForkJoin(unsigned int maxNumThreads) {
+	// The worker counts we'll test: powers of two, plus the max itself.
+	vector<unsigned int> allWorkerCounts = TestHelpers::workerCounts(maxNumThreads);
+
+	printf("==========================================================================================\n");
+	printf("=== Fork-join quicksort of %u values (serial below %u)\n", FORK_JOIN_SORT_SIZE, FORK_JOIN_SORT_CUTOFF);
+	printf("==========================================================================================\n");
+	bool   isSorted = false;
+	double serialMS = testQueueForkJoinSort(0, &isSorted);
+	printf("[  Serial  ] %9.3f ms (std::sort)\n", serialMS);
+	for (unsigned int workerIndex = 0; workerIndex < allWorkerCounts.size(); ++workerIndex) {
+		unsigned int numWorkers = allWorkerCounts[workerIndex];
+		double       sortMS     = testQueueForkJoinSort(numWorkers, &isSorted);
+		printf("[%2u Worker%s] %s%9.3f ms%s (%.2fx) %s%s%s\n", numWorkers, (numWorkers == 1) ? " " : "s",
+			(sortMS < serialMS) ? Colors::pColorGreen : Colors::pColorRed, sortMS, Colors::pColorReset, serialMS / sortMS,
+			isSorted ? Colors::pColorGreen : Colors::pColorRed, isSorted ? "sorted" : "NOT SORTED", Colors::pColorReset);
+	}
+
+	printf("==========================================================================================\n");
+	printf("=== Fork-join fib(%u) (serial below %u)\n", FORK_JOIN_FIB_N, FORK_JOIN_FIB_CUTOFF);
+	printf("==========================================================================================\n");
+	unsigned long long int serialResult = 0;
+	unsigned long long int fibResult    = 0;
+	serialMS = testQueueForkJoinFib(0, &serialResult);
+	printf("[  Serial  ] %9.3f ms = %llu\n", serialMS, serialResult);
+	for (unsigned int workerIndex = 0; workerIndex < allWorkerCounts.size(); ++workerIndex) {
+		unsigned int numWorkers = allWorkerCounts[workerIndex];
+		double       fibMS      = testQueueForkJoinFib(numWorkers, &fibResult);
+		printf("[%2u Worker%s] %s%9.3f ms%s (%.2fx) = %s%llu%s\n", numWorkers, (numWorkers == 1) ? " " : "s",
+			(fibMS < serialMS) ? Colors::pColorGreen : Colors::pColorRed, fibMS, Colors::pColorReset, serialMS / fibMS,
+			(fibResult == serialResult) ? Colors::pColorGreen : Colors::pColorRed, fibResult, Colors::pColorReset);
+	}
+
+	printf("------------------------------------------------------------------------------------------\n");
+	bool queueDiscardWorks  = testQueueForkJoinDiscarded(false);
+	bool targetDiscardWorks = testQueueForkJoinDiscarded(true);
+	printf("Tasks thrown away by a destroyed Queue finish: %s%s%s\n", queueDiscardWorks ? Colors::pColorGreen : Colors::pColorRed, queueDiscardWorks ? "yes" : "NO", Colors::pColorReset);
+	printf("Tasks thrown away by a removed target finish:  %s%s%s\n", targetDiscardWorks ? Colors::pColorGreen : Colors::pColorRed, targetDiscardWorks ? "yes" : "NO", Colors::pColorReset);
+}
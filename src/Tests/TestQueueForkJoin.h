@@ -0,0 +1,34 @@
+#ifndef __TEST_QUEUE_FORK_JOIN_H__
+#define __TEST_QUEUE_FORK_JOIN_H__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+#include "DispatchCPP/DispatchCPP.h"
+#include "Colors.h"
+#include "TestHelpers.h"
+
+// The size of the vector quicksorted, and the size below which a partition is sorted serially rather than split.
+#define FORK_JOIN_SORT_SIZE             4000000
+#define FORK_JOIN_SORT_CUTOFF           16384
+
+// The Fibonacci number computed, and the number below which it's computed serially rather than split.
+#define FORK_JOIN_FIB_N                 36
+#define FORK_JOIN_FIB_CUTOFF            20
+
+// The number of spawned tasks thrown away unrun, and how long the work ahead of them keeps their thread busy.
+#define FORK_JOIN_NUM_DISCARDED         100
+#define FORK_JOIN_DISCARD_BLOCK_US      20000
+
+double testQueueForkJoinSort(unsigned int numWorkers, bool * pIsSorted);
+double testQueueForkJoinFib(unsigned int numWorkers, unsigned long long int * pResult);
+bool testQueueForkJoinDiscarded(bool useTargetQueue);
+
+void testQueueForkJoin(unsigned int maxNumThreads = 4);
+
+#endif // __TEST_QUEUE_FORK_JOIN_H__
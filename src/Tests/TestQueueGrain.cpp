@@ -0,0 +1,105 @@
+#include "TestQueueGrain.h"
+
+using namespace DispatchCPP;
+
+// Sorts every vector in allEntries (reset from allOriginal first), returning how many milliseconds it took.
+static double testQueueGrainRun(Queue<void> * pQueue, QueueGrainTuner * pTuner, vector<unsigned int> & allEntries, const vector<unsigned int> & allOriginal, unsigned int vectorSize, bool * pIsCorrect) {
+	// Start from the same unsorted entries every time.
+	allEntries = allOriginal;
+	unsigned int numVectors = (unsigned int) (allEntries.size() / vectorSize);
+	unsigned int * pEntries = allEntries.data();
+
+	// Sort every vector: on the calling thread without a Queue, one dispatch per vector without a tuner, or in
+	// autotuned chunks of vectors with one.
+	auto beforeRun = chrono::high_resolution_clock::now();
+	if (pQueue == nullptr) {
+		for (unsigned int vectorIndex = 0; vectorIndex < numVectors; ++vectorIndex) {
+			sort(pEntries + ((size_t) vectorIndex * vectorSize), pEntries + ((size_t) (vectorIndex + 1) * vectorSize));
+		}
+	} else if (pTuner == nullptr) {
+		parallelRun(pQueue, numVectors, [pEntries, vectorSize](unsigned int vectorIndex) {
+			sort(pEntries + ((size_t) vectorIndex * vectorSize), pEntries + ((size_t) (vectorIndex + 1) * vectorSize));
+		});
+	} else {
+		parallelForAdaptive(pQueue, pTuner, numVectors, [pEntries, vectorSize](size_t firstVector, size_t lastVector) {
+			for (size_t vectorIndex = firstVector; vectorIndex < lastVector; ++vectorIndex) {
+				sort(pEntries + (vectorIndex * vectorSize), pEntries + ((vectorIndex + 1) * vectorSize));
+			}
+		});
+	}
+	auto afterRun = chrono::high_resolution_clock::now();
+
+	// Make sure every vector came out sorted.
+	*pIsCorrect = true;
+	for (unsigned int vectorIndex = 0; vectorIndex < numVectors; ++vectorIndex) {
+		if (!is_sorted(pEntries + ((size_t) vectorIndex * vectorSize), pEntries + ((size_t) (vectorIndex + 1) * vectorSize))) {
+			*pIsCorrect = false;
+			break;
+		}
+	}
+
+	return(((double) chrono::duration_cast<chrono::microseconds>(afterRun - beforeRun).count()) / 1000.0);
+}
+
+void testQueueGrain(unsigned int maxNumThreads) {
+	// The worker counts we'll test: powers of two, plus the max itself.
+	vector<unsigned int> allWorkerCounts = TestHelpers::workerCounts(maxNumThreads);
+
+	// Our random entries, and a Queue (and tuner) for each worker count. Each tuner is kept from one vector size to
+	// the next, so every row starts out tuned for the one before it and has to adapt.
+	vector<unsigned int> allOriginal = vector<unsigned int>(GRAIN_TOTAL_ENTRIES);
+	vector<unsigned int> allEntries  = vector<unsigned int>(GRAIN_TOTAL_ENTRIES);
+	unsigned long long int randomState = 88172645463325252ULL;
+	for (unsigned int & entry : allOriginal) {
+		randomState ^= (randomState << 13);
+		randomState ^= (randomState >> 7);
+		randomState ^= (randomState << 17);
+		entry = (unsigned int) randomState;
+	}
+	vector<Queue<void> *>     allQueues = vector<Queue<void> *>();
+	vector<QueueGrainTuner *> allTuners = vector<QueueGrainTuner *>();
+	for (unsigned int numWorkers : allWorkerCounts) {
+		allQueues.push_back(new Queue<void>(new QueueFunction<void>([]() {}), numWorkers, true));
+		allTuners.push_back(new QueueGrainTuner(GRAIN_TARGET_US));
+	}
+
+	for (unsigned int vectorSize = GRAIN_MIN_VECTOR_SIZE; vectorSize <= GRAIN_MAX_VECTOR_SIZE; vectorSize *= 4) {
+		unsigned int numVectors = (GRAIN_TOTAL_ENTRIES / vectorSize);
+		bool         isCorrect  = false;
+		double       serialMS   = testQueueGrainRun(nullptr, nullptr, allEntries, allOriginal, vectorSize, &isCorrect);
+		printf("==========================================================================================\n");
+		printf("=== %6u vectors x %6u entries: serial %9.3f ms, one dispatch per vector vs autotuned chunks (%uus target)\n", numVectors, vectorSize, serialMS, GRAIN_TARGET_US);
+		printf("==========================================================================================\n");
+		for (unsigned int workerIndex = 0; workerIndex < allWorkerCounts.size(); ++workerIndex) {
+			unsigned int      numWorkers = allWorkerCounts[workerIndex];
+			Queue<void>     * pQueue     = allQueues[workerIndex];
+			QueueGrainTuner * pTuner     = allTuners[workerIndex];
+			bool              allCorrect = isCorrect;
+
+			// One dispatch per vector.
+			double perVectorMS = testQueueGrainRun(pQueue, nullptr, allEntries, allOriginal, vectorSize, &isCorrect);
+			allCorrect = (allCorrect && isCorrect);
+
+			// Autotuned, a few rounds over, noting the chunk size the tuner settles on after each.
+			string allChunkSizes = string();
+			double tunedMS       = 0.0;
+			for (unsigned int roundIndex = 0; roundIndex < GRAIN_NUM_ROUNDS; ++roundIndex) {
+				tunedMS    = testQueueGrainRun(pQueue, pTuner, allEntries, allOriginal, vectorSize, &isCorrect);
+				allCorrect = (allCorrect && isCorrect);
+				allChunkSizes += ((roundIndex == 0) ? "" : " -> ") + to_string(pTuner->getChunkSize());
+			}
+
+			printf("[%2u Worker%s] Per vector: %9.3f ms, autotuned: %s%9.3f ms%s (%.2fx), %8.1f ns/vector, chunk %s (%s%s%s)\n",
+				numWorkers, (numWorkers == 1) ? " " : "s", perVectorMS,
+				(tunedMS < perVectorMS) ? Colors::pColorGreen : Colors::pColorRed, tunedMS, Colors::pColorReset, perVectorMS / tunedMS,
+				pTuner->getCostPerItemNS(), allChunkSizes.c_str(),
+				allCorrect ? Colors::pColorGreen : Colors::pColorRed, allCorrect ? "correct" : "INCORRECT", Colors::pColorReset);
+		}
+	}
+
+	// Clean up after ourselves.
+	for (unsigned int workerIndex = 0; workerIndex < allWorkerCounts.size(); ++workerIndex) {
+		delete(allQueues[workerIndex]);
+		delete(allTuners[workerIndex]);
+	}
+}
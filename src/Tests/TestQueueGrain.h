@@ -0,0 +1,30 @@
+#ifndef __TEST_QUEUE_GRAIN_H__
+#define __TEST_QUEUE_GRAIN_H__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "DispatchCPP/DispatchCPP.h"
+#include "Colors.h"
+#include "TestHelpers.h"
+
+// The number of entries sorted in each row, split evenly into vectors of each size from the smallest to the largest.
+#define GRAIN_TOTAL_ENTRIES             (1 << 21)
+#define GRAIN_MIN_VECTOR_SIZE           32
+#define GRAIN_MAX_VECTOR_SIZE           131072
+
+// The number of times each row is sorted with the autotuned chunk size, to show it settling.
+#define GRAIN_NUM_ROUNDS                5
+
+// How long each autotuned chunk should take.
+#define GRAIN_TARGET_US                 100
+
+void testQueueGrain(unsigned int maxNumThreads = 4);
+
+#endif // __TEST_QUEUE_GRAIN_H__
@@ -0,0 +1,166 @@
+#include "TestQueueGroups.h"
+
+using namespace DispatchCPP;
+
+double testQueueGroupsFanOut(unsigned int numHandlerThreads, bool useNotify, unsigned int * pNumResponses) {
+	// The number of responses sent, and the number of backend calls each request has had answered.
+	atomic<unsigned int>         numResponses(0);
+	vector<atomic<unsigned int>> allNumAnswered = vector<atomic<unsigned int>>(GROUPS_NUM_REQUESTS);
+	for (unsigned int requestIndex = 0; requestIndex < GROUPS_NUM_REQUESTS; ++requestIndex) {
+		allNumAnswered[requestIndex] = 0;
+	}
+
+	// Our backend calls, which just take a while.
+	Queue<void, unsigned int> * pBackendQueue = new Queue<void, unsigned int>(
+		new QueueFunction<void, unsigned int>(
+			[&allNumAnswered](unsigned int requestIndex) {
+				usleep(GROUPS_BACKEND_CALL_US);
+				allNumAnswered[requestIndex] += 1;
+			}
+		),
+		GROUPS_NUM_BACKEND_THREADS,
+		true
+	);
+
+	// Our request handlers, which fan out to the backend, and respond once every call has been answered.
+	Queue<void, unsigned int> * pHandlerQueue = nullptr;
+	pHandlerQueue = new Queue<void, unsigned int>(
+		new QueueFunction<void, unsigned int>(
+			[&pHandlerQueue, pBackendQueue, &allNumAnswered, &numResponses, useNotify](unsigned int requestIndex) {
+				// The response, which is only correct once every backend call's been answered.
+				function<void()> respond = [&allNumAnswered, &numResponses, requestIndex]() {
+					if (allNumAnswered[requestIndex] == GROUPS_FAN_OUT) {
+						numResponses += 1;
+					}
+				};
+
+				QueueGroup requestGroup;
+				for (unsigned int callIndex = 0; callIndex < GROUPS_FAN_OUT; ++callIndex) {
+					pBackendQueue->dispatchWork(requestGroup, requestIndex);
+				}
+
+				// Either respond from a callback once the group drains, or hold on to our thread until it does.
+				if (useNotify) {
+					requestGroup.notify(pHandlerQueue, respond);
+				} else {
+					requestGroup.wait();
+					respond();
+				}
+			}
+		),
+		numHandlerThreads,
+		true
+	);
+
+	// Handle all of our requests, and wait until every one has been responded to.
+	auto beforeRequests = chrono::high_resolution_clock::now();
+	for (unsigned int requestIndex = 0; requestIndex < GROUPS_NUM_REQUESTS; ++requestIndex) {
+		pHandlerQueue->dispatchWork(requestIndex);
+	}
+	while (true) {
+		pHandlerQueue->hasWorkLeft(true);
+		pBackendQueue->hasWorkLeft(true);
+		if (!pHandlerQueue->hasWorkLeft(false)) {
+			break;
+		}
+	}
+	auto afterRequests = chrono::high_resolution_clock::now();
+
+	// Clean up after ourselves.
+	delete(pHandlerQueue);
+	delete(pBackendQueue);
+
+	*pNumResponses = numResponses;
+	return(((double) chrono::duration_cast<chrono::microseconds>(afterRequests - beforeRequests).count()) / 1000.0);
+}
+
+bool testQueueGroupsWaitFor() {
+	Queue<void> * pSlowQueue = new Queue<void>(
+		new QueueFunction<void>(
+			[]() { usleep(20000); }
+		),
+		1,
+		true
+	);
+
+	// A group which takes 20ms to drain must time out after 1ms, and must drain within a second.
+	QueueGroup slowGroup;
+	pSlowQueue->dispatchWork(slowGroup);
+	bool timedOut = !slowGroup.waitFor(chrono::milliseconds(1));
+	bool drained  = slowGroup.waitFor(chrono::seconds(1));
+
+	delete(pSlowQueue);
+	return(timedOut && drained && (slowGroup.numPending() == 0));
+}
+
+bool testQueueGroupsDiscarded(bool useTargetQueue) {
+	atomic<unsigned int> numRun(0);
+	atomic<bool>         wasNotified(false);
+	Queue<void> * pNotifyQueue = new Queue<void>(new QueueFunction<void>([]() {}), 1, true);
+
+	// Our group's work sits behind work keeping its only thread busy: either on its own Queue, or on the parent Queue
+	// it targets.
+	Queue<void> * pParentQueue = (useTargetQueue ? new Queue<void>(new QueueFunction<void>([]() {}), 1, true) : nullptr);
+	Queue<void> * pGroupQueue  = new Queue<void>(
+		new QueueFunction<void>(
+			[&numRun]() { numRun.fetch_add(1, memory_order_relaxed); }
+		),
+		1,
+		true
+	);
+	if (useTargetQueue) {
+		pGroupQueue->setTargetQueue(pParentQueue);
+		pParentQueue->dispatchFunction([]() { usleep(GROUPS_DISCARD_BLOCK_US); });
+	} else {
+		pGroupQueue->dispatchFunction([]() { usleep(GROUPS_DISCARD_BLOCK_US); });
+	}
+	QueueGroup discardedGroup;
+	for (unsigned int workIndex = 0; workIndex < GROUPS_NUM_DISCARDED; ++workIndex) {
+		pGroupQueue->dispatchWork(discardedGroup);
+	}
+	discardedGroup.notify(pNotifyQueue, [&wasNotified]() {
+		wasNotified = true;
+	});
+
+	// Destroying the Queue (which removes it from its parent's scheduler) throws the group's work away, which must
+	// still drain the group.
+	delete(pGroupQueue);
+	bool drained = discardedGroup.waitFor(chrono::seconds(1));
+	for (unsigned int pollIndex = 0; drained && !wasNotified && (pollIndex < 1000); ++pollIndex) {
+		usleep(1000);
+	}
+	pNotifyQueue->hasWorkLeft(true);
+	if (pParentQueue != nullptr) {
+		delete(pParentQueue);
+	}
+	delete(pNotifyQueue);
+	return(drained && wasNotified && (numRun.load() < GROUPS_NUM_DISCARDED));
+}
+
+void testQueueGroups(unsigned int maxNumThreads) {
+	// The worker counts we'll test: powers of two, plus the max itself.
+	vector<unsigned int> allWorkerCounts = TestHelpers::workerCounts(maxNumThreads);
+
+	printf("==========================================================================================\n");
+	printf("=== Fan-out/join: %u requests x %u backend calls of %uus (%u backend threads)\n", GROUPS_NUM_REQUESTS, GROUPS_FAN_OUT, GROUPS_BACKEND_CALL_US, GROUPS_NUM_BACKEND_THREADS);
+	printf("==========================================================================================\n");
+	for (unsigned int workerIndex = 0; workerIndex < allWorkerCounts.size(); ++workerIndex) {
+		unsigned int numHandlers  = allWorkerCounts[workerIndex];
+		unsigned int numWaited    = 0;
+		unsigned int numNotified  = 0;
+		double       waitMS       = testQueueGroupsFanOut(numHandlers, false, &numWaited);
+		double       notifyMS     = testQueueGroupsFanOut(numHandlers, true,  &numNotified);
+		printf("[%2u Handler%s] wait(): %9.3f ms, notify(): %s%9.3f ms%s (%.2fx) (%s%u/%u responses%s)\n",
+			numHandlers, (numHandlers == 1) ? " " : "s", waitMS,
+			(notifyMS < waitMS) ? Colors::pColorGreen : Colors::pColorRed, notifyMS, Colors::pColorReset, waitMS / notifyMS,
+			((numWaited == GROUPS_NUM_REQUESTS) && (numNotified == GROUPS_NUM_REQUESTS)) ? Colors::pColorGreen : Colors::pColorRed,
+			min(numWaited, numNotified), GROUPS_NUM_REQUESTS, Colors::pColorReset);
+	}
+	printf("------------------------------------------------------------------------------------------\n");
+	bool waitForWorks = testQueueGroupsWaitFor();
+	printf("waitFor() times out and drains: %s%s%s\n", waitForWorks ? Colors::pColorGreen : Colors::pColorRed, waitForWorks ? "yes" : "NO", Colors::pColorReset);
+	bool queueDiscardWorks  = testQueueGroupsDiscarded(false);
+	bool targetDiscardWorks = testQueueGroupsDiscarded(true);
+	printf("Work thrown away by a destroyed Queue drains the group: %s%s%s\n", queueDiscardWorks ? Colors::pColorGreen : Colors::pColorRed, queueDiscardWorks ? "yes" : "NO", Colors::pColorReset);
+	printf("Work thrown away by a removed target drains the group:  %s%s%s\n", targetDiscardWorks ? Colors::pColorGreen : Colors::pColorRed, targetDiscardWorks ? "yes" : "NO", Colors::pColorReset);
+}
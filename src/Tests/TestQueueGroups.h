@@ -0,0 +1,34 @@
+#ifndef __TEST_QUEUE_GROUPS_H__
+#define __TEST_QUEUE_GROUPS_H__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <vector>
+
+#include "DispatchCPP/DispatchCPP.h"
+#include "Colors.h"
+#include "TestHelpers.h"
+
+// The number of requests handled, how many backend calls each fans out to, and how long each backend call takes.
+#define GROUPS_NUM_REQUESTS             200
+#define GROUPS_FAN_OUT                  8
+#define GROUPS_BACKEND_CALL_US          1000
+
+// The number of threads making backend calls.
+#define GROUPS_NUM_BACKEND_THREADS      64
+
+// The number of pieces of group work thrown away unrun, and how long the work ahead of them keeps their thread busy.
+#define GROUPS_NUM_DISCARDED            100
+#define GROUPS_DISCARD_BLOCK_US         20000
+
+double testQueueGroupsFanOut(unsigned int numHandlerThreads, bool useNotify, unsigned int * pNumResponses);
+bool testQueueGroupsWaitFor();
+bool testQueueGroupsDiscarded(bool useTargetQueue);
+
+void testQueueGroups(unsigned int maxNumThreads = 4);
+
+#endif // __TEST_QUEUE_GROUPS_H__
@@ -0,0 +1,121 @@
+#include "TestQueueIngest.h"
+
+using namespace DispatchCPP;
+
+// Each record's work: pull the value out of its second field.
+static unsigned long long int ingestParseRecord(string_view record) {
+	size_t                 firstComma  = record.find(',');
+	size_t                 secondComma = record.find(',', firstComma + 1);
+	unsigned long long int value       = 0;
+	from_chars(record.data() + firstComma + 1, record.data() + secondComma, value);
+	return(value);
+}
+
+double testQueueIngestGetLine(unsigned int numWorkers, unsigned long long int * pNumRecords, unsigned long long int * pChecksum) {
+	// Our queue, which parses each record it's handed.
+	atomic<unsigned long long int> numRecords = 0;
+	atomic<unsigned long long int> checksum   = 0;
+	Queue<void, string> * pQueue = new Queue<void, string>(
+		new QueueFunction<void, string>(
+			[&numRecords, &checksum](string record) {
+				checksum.fetch_add(ingestParseRecord(record), memory_order_relaxed);
+				numRecords.fetch_add(1, memory_order_relaxed);
+			}
+		),
+		numWorkers,
+		true
+	);
+
+	// Read each line on this thread, and dispatch it.
+	auto beforeRun = chrono::high_resolution_clock::now();
+	ifstream inputFile(INGEST_FILE_PATH);
+	string   line;
+	while (getline(inputFile, line)) {
+		pQueue->dispatchWork(line);
+	}
+	pQueue->hasWorkLeft(true);
+	auto afterRun = chrono::high_resolution_clock::now();
+
+	// Clean up after ourselves.
+	delete(pQueue);
+
+	*pNumRecords = numRecords.load();
+	*pChecksum   = checksum.load();
+	return(((double) chrono::duration_cast<chrono::microseconds>(afterRun - beforeRun).count()) / 1000.0);
+}
+
+double testQueueIngestMMap(unsigned int numWorkers, unsigned long long int * pNumRecords, unsigned long long int * pChecksum) {
+	// Our queue, which parses every record in each chunk it's handed.
+	atomic<unsigned long long int> numRecords = 0;
+	atomic<unsigned long long int> checksum   = 0;
+	Queue<void, string_view> * pQueue = new Queue<void, string_view>(
+		new QueueFunction<void, string_view>(
+			[&numRecords, &checksum](string_view chunk) {
+				unsigned long long int chunkRecords  = 0;
+				unsigned long long int chunkChecksum = 0;
+				QueueIngest::forEachRecord(chunk, [&chunkRecords, &chunkChecksum](string_view record) {
+					chunkChecksum += ingestParseRecord(record);
+					chunkRecords++;
+				});
+				checksum.fetch_add(chunkChecksum, memory_order_relaxed);
+				numRecords.fetch_add(chunkRecords, memory_order_relaxed);
+			}
+		),
+		numWorkers,
+		true
+	);
+
+	// Map the file in, and dispatch each of its chunks.
+	auto beforeRun = chrono::high_resolution_clock::now();
+	QueueIngest ingest(INGEST_FILE_PATH, INGEST_CHUNK_SIZE);
+	pQueue->dispatchIngest(ingest);
+	pQueue->hasWorkLeft(true);
+	auto afterRun = chrono::high_resolution_clock::now();
+
+	// Clean up after ourselves.
+	delete(pQueue);
+
+	*pNumRecords = numRecords.load();
+	*pChecksum   = checksum.load();
+	return(((double) chrono::duration_cast<chrono::microseconds>(afterRun - beforeRun).count()) / 1000.0);
+}
+
+void testQueueIngest(unsigned int maxNumThreads) {
+	// The worker counts we'll test: powers of two, plus the max itself.
+	vector<unsigned int> allWorkerCounts = TestHelpers::workerCounts(maxNumThreads);
+
+	// Generate our input file, and the checksum we expect.
+	unsigned long long int expectedChecksum = 0;
+	FILE *                 pFile            = fopen(INGEST_FILE_PATH, "w");
+	if (pFile == nullptr) {
+		printf("%sUnable to create %s%s\n", Colors::pColorRed, INGEST_FILE_PATH, Colors::pColorReset);
+		return;
+	}
+	for (unsigned int recordIndex = 0; recordIndex < INGEST_NUM_RECORDS; ++recordIndex) {
+		unsigned long long int value = ((recordIndex * 2654435761ULL) % 1000000007ULL);
+		fprintf(pFile, "%u,%llu,record-%08u\n", recordIndex, value, recordIndex);
+		expectedChecksum += value;
+	}
+	fclose(pFile);
+
+	printf("==========================================================================================\n");
+	printf("=== Ingest of %u records: getline + per-record dispatch vs QueueIngest (%u KB chunks)\n", INGEST_NUM_RECORDS, INGEST_CHUNK_SIZE / 1024);
+	printf("==========================================================================================\n");
+	for (unsigned int workerIndex = 0; workerIndex < allWorkerCounts.size(); ++workerIndex) {
+		unsigned int           numWorkers      = allWorkerCounts[workerIndex];
+		unsigned long long int getLineRecords  = 0;
+		unsigned long long int getLineChecksum = 0;
+		unsigned long long int mmapRecords     = 0;
+		unsigned long long int mmapChecksum    = 0;
+		double                 getLineMS       = testQueueIngestGetLine(numWorkers, &getLineRecords, &getLineChecksum);
+		double                 mmapMS          = testQueueIngestMMap(numWorkers, &mmapRecords, &mmapChecksum);
+		bool                   isCorrect       = ((getLineRecords == INGEST_NUM_RECORDS) && (mmapRecords == INGEST_NUM_RECORDS) && (getLineChecksum == expectedChecksum) && (mmapChecksum == expectedChecksum));
+		printf("[%2u Worker%s] getline: %9.3f ms (%6.2f M records/s), ingest: %s%9.3f ms (%6.2f M records/s)%s (%.2fx) (%s%s%s)\n",
+			numWorkers, (numWorkers == 1) ? " " : "s", getLineMS, (INGEST_NUM_RECORDS / 1000.0) / getLineMS,
+			(mmapMS < getLineMS) ? Colors::pColorGreen : Colors::pColorRed, mmapMS, (INGEST_NUM_RECORDS / 1000.0) / mmapMS, Colors::pColorReset, getLineMS / mmapMS,
+			isCorrect ? Colors::pColorGreen : Colors::pColorRed, isCorrect ? "correct" : "INCORRECT", Colors::pColorReset);
+	}
+
+	// Clean up after ourselves.
+	unlink(INGEST_FILE_PATH);
+}
@@ -0,0 +1,32 @@
+#ifndef __TEST_QUEUE_INGEST_H__
+#define __TEST_QUEUE_INGEST_H__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "DispatchCPP/DispatchCPP.h"
+#include "Colors.h"
+#include "TestHelpers.h"
+
+// Where our generated input file lives, and the number of records in it.
+#define INGEST_FILE_PATH                "/tmp/dispatchcpp-ingest.csv"
+#define INGEST_NUM_RECORDS              2000000
+
+// The size of each chunk dispatched.
+#define INGEST_CHUNK_SIZE               (1024 * 1024)
+
+double testQueueIngestGetLine(unsigned int numWorkers, unsigned long long int * pNumRecords, unsigned long long int * pChecksum);
+double testQueueIngestMMap(unsigned int numWorkers, unsigned long long int * pNumRecords, unsigned long long int * pChecksum);
+
+void testQueueIngest(unsigned int maxNumThreads = 4);
+
+#endif // __TEST_QUEUE_INGEST_H__
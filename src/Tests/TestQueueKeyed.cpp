@@ -0,0 +1,146 @@
+#include "TestQueueKeyed.h"
+
+using namespace DispatchCPP;
+
+// Each key's state: the sequence number of the next task we expect for it, and a hash its tasks keep folding into.
+typedef struct alignas(64) __KEYED_STATE__ {
+	unsigned int           nextSequence;
+	unsigned long long int hashValue;
+} KeyedState;
+
+// Builds the order tasks are dispatched in: which key each task is for, and its sequence number within that key.
+static void keyedBuildTasks(bool isSkewed, vector<unsigned int> & allKeys, vector<unsigned int> & allSequences) {
+	vector<unsigned int> nextSequence = vector<unsigned int>(KEYED_NUM_KEYS, 0);
+	unsigned int         randomValue  = 12345;
+	allKeys      = vector<unsigned int>(KEYED_NUM_TASKS);
+	allSequences = vector<unsigned int>(KEYED_NUM_TASKS);
+	for (unsigned int taskIndex = 0; taskIndex < KEYED_NUM_TASKS; ++taskIndex) {
+		randomValue = ((randomValue * 1103515245) + 12345);
+		unsigned int key = ((randomValue >> 8) % KEYED_NUM_KEYS);
+		if (isSkewed && (((randomValue >> 20) % 100) < KEYED_HOT_KEY_PERCENT)) {
+			key = 0;
+		}
+		allKeys[taskIndex]      = key;
+		allSequences[taskIndex] = nextSequence[key]++;
+	}
+}
+
+// Each task's work: make sure it's the task we expected next for its key, then hash into the key's state.
+static void keyedDoWork(KeyedState * pState, unsigned int sequence, atomic<unsigned int> * pNumOutOfOrder) {
+	if (pState->nextSequence != sequence) {
+		pNumOutOfOrder->fetch_add(1, memory_order_relaxed);
+	}
+	pState->nextSequence = (sequence + 1);
+	pState->hashValue = TestHelpers::hashWork(sequence, KEYED_WORK_ITERATIONS, pState->hashValue);
+}
+
+double testQueueKeyedSerialBank(bool isSkewed, unsigned int * pNumOutOfOrder) {
+	vector<unsigned int> allKeys, allSequences;
+	keyedBuildTasks(isSkewed, allKeys, allSequences);
+	vector<KeyedState>   allStates    = vector<KeyedState>(KEYED_NUM_KEYS);
+	atomic<unsigned int> numOutOfOrder(0);
+	for (unsigned int key = 0; key < KEYED_NUM_KEYS; ++key) {
+		allStates[key].nextSequence = 0;
+		allStates[key].hashValue    = 14695981039346656037ULL;
+	}
+
+	// One serial Queue (and so one thread) per key: the way per-key ordering has to be done without keyed dispatch.
+	QueueFunction<void, unsigned int, unsigned int> * pKeyedFunc = new QueueFunction<void, unsigned int, unsigned int>(
+		[&allStates, &numOutOfOrder](unsigned int key, unsigned int sequence) {
+			keyedDoWork(&(allStates[key]), sequence, &numOutOfOrder);
+		}
+	);
+	vector<Queue<void, unsigned int, unsigned int> *> allQueues = vector<Queue<void, unsigned int, unsigned int> *>();
+	for (unsigned int key = 0; key < KEYED_NUM_KEYS; ++key) {
+		allQueues.push_back(new Queue<void, unsigned int, unsigned int>(pKeyedFunc, 1));
+	}
+
+	// Dispatch all of our work, and wait for every queue to finish.
+	auto beforeDispatch = chrono::high_resolution_clock::now();
+	for (unsigned int taskIndex = 0; taskIndex < KEYED_NUM_TASKS; ++taskIndex) {
+		allQueues[allKeys[taskIndex]]->dispatchWork(allKeys[taskIndex], allSequences[taskIndex]);
+	}
+	for (unsigned int key = 0; key < KEYED_NUM_KEYS; ++key) {
+		allQueues[key]->hasWorkLeft(true);
+	}
+	auto afterDispatch = chrono::high_resolution_clock::now();
+
+	// Clean up after ourselves.
+	for (unsigned int key = 0; key < KEYED_NUM_KEYS; ++key) {
+		delete(allQueues[key]);
+	}
+	delete(pKeyedFunc);
+
+	*pNumOutOfOrder = numOutOfOrder;
+	return(((double) chrono::duration_cast<chrono::microseconds>(afterDispatch - beforeDispatch).count()) / 1000.0);
+}
+
+double testQueueKeyedLanes(unsigned int numWorkers, bool isSkewed, bool rebalance, unsigned int * pNumOutOfOrder) {
+	vector<unsigned int> allKeys, allSequences;
+	keyedBuildTasks(isSkewed, allKeys, allSequences);
+	vector<KeyedState>   allStates    = vector<KeyedState>(KEYED_NUM_KEYS);
+	atomic<unsigned int> numOutOfOrder(0);
+	for (unsigned int key = 0; key < KEYED_NUM_KEYS; ++key) {
+		allStates[key].nextSequence = 0;
+		allStates[key].hashValue    = 14695981039346656037ULL;
+	}
+
+	// A single Queue, with its keys spread over its threads' lanes.
+	Queue<void, unsigned int, unsigned int> * pKeyedQueue = new Queue<void, unsigned int, unsigned int>(
+		new QueueFunction<void, unsigned int, unsigned int>(
+			[&allStates, &numOutOfOrder](unsigned int key, unsigned int sequence) {
+				keyedDoWork(&(allStates[key]), sequence, &numOutOfOrder);
+			}
+		),
+		numWorkers,
+		true
+	);
+	pKeyedQueue->setKeyedRebalancing(rebalance);
+
+	// Dispatch all of our work, and wait for it to finish.
+	auto beforeDispatch = chrono::high_resolution_clock::now();
+	for (unsigned int taskIndex = 0; taskIndex < KEYED_NUM_TASKS; ++taskIndex) {
+		pKeyedQueue->dispatchWorkKeyed(allKeys[taskIndex], allKeys[taskIndex], allSequences[taskIndex]);
+	}
+	pKeyedQueue->hasWorkLeft(true);
+	auto afterDispatch = chrono::high_resolution_clock::now();
+
+	// Clean up after ourselves.
+	delete(pKeyedQueue);
+
+	*pNumOutOfOrder = numOutOfOrder;
+	return(((double) chrono::duration_cast<chrono::microseconds>(afterDispatch - beforeDispatch).count()) / 1000.0);
+}
+
+void testQueueKeyed(unsigned int maxNumThreads) {
+	// The worker counts we'll test: powers of two, plus the max itself.
+	vector<unsigned int> allWorkerCounts = TestHelpers::workerCounts(maxNumThreads);
+
+	for (unsigned int skewIndex = 0; skewIndex < 2; ++skewIndex) {
+		bool isSkewed = (skewIndex == 1);
+		printf("==========================================================================================\n");
+		printf("=== Keyed work, %u keys, %u tasks (%s)\n", KEYED_NUM_KEYS, KEYED_NUM_TASKS, isSkewed ? "one hot key" : "uniform keys");
+		printf("==========================================================================================\n");
+
+		// The bank of serial queues we're comparing against.
+		unsigned int numOutOfOrder = 0;
+		double       bankMS        = testQueueKeyedSerialBank(isSkewed, &numOutOfOrder);
+		printf("[%2u Serial Queues] %9.3f ms (%s%u out of order%s)\n", KEYED_NUM_KEYS, bankMS,
+			(numOutOfOrder == 0) ? Colors::pColorGreen : Colors::pColorRed, numOutOfOrder, Colors::pColorReset);
+		printf("------------------------------------------------------------------------------------------\n");
+
+		// Keyed dispatch, with and without rebalancing.
+		for (unsigned int workerIndex = 0; workerIndex < allWorkerCounts.size(); ++workerIndex) {
+			unsigned int numWorkers       = allWorkerCounts[workerIndex];
+			unsigned int numOutOfOrderFix = 0;
+			unsigned int numOutOfOrderRe  = 0;
+			double       fixedMS          = testQueueKeyedLanes(numWorkers, isSkewed, false, &numOutOfOrderFix);
+			double       rebalancedMS     = testQueueKeyedLanes(numWorkers, isSkewed, true,  &numOutOfOrderRe);
+			printf("[%2u Worker%s] Keyed: %s%9.3f ms%s, rebalanced: %s%9.3f ms%s (%s%u out of order%s)\n",
+				numWorkers, (numWorkers == 1) ? " " : "s",
+				(fixedMS < bankMS) ? Colors::pColorGreen : Colors::pColorRed, fixedMS, Colors::pColorReset,
+				(rebalancedMS < bankMS) ? Colors::pColorGreen : Colors::pColorRed, rebalancedMS, Colors::pColorReset,
+				((numOutOfOrderFix + numOutOfOrderRe) == 0) ? Colors::pColorGreen : Colors::pColorRed, numOutOfOrderFix + numOutOfOrderRe, Colors::pColorReset);
+		}
+	}
+}
@@ -0,0 +1,31 @@
+#ifndef __TEST_QUEUE_KEYED_H__
+#define __TEST_QUEUE_KEYED_H__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <vector>
+
+#include "DispatchCPP/DispatchCPP.h"
+#include "Colors.h"
+#include "TestHelpers.h"
+
+// The number of keys (entities) work is dispatched for, and the total number of tasks dispatched across all of them.
+#define KEYED_NUM_KEYS                  64
+#define KEYED_NUM_TASKS                 200000
+
+// When skewed, this percentage of all tasks goes to a single hot key.
+#define KEYED_HOT_KEY_PERCENT           50
+
+// The number of hashing passes each task makes over its key's state (its CPU-bound work).
+#define KEYED_WORK_ITERATIONS           256
+
+double testQueueKeyedSerialBank(bool isSkewed, unsigned int * pNumOutOfOrder);
+double testQueueKeyedLanes(unsigned int numWorkers, bool isSkewed, bool rebalance, unsigned int * pNumOutOfOrder);
+
+void testQueueKeyed(unsigned int maxNumThreads = 4);
+
+#endif // __TEST_QUEUE_KEYED_H__
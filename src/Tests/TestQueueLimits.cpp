@@ -0,0 +1,132 @@
+#include "TestQueueLimits.h"
+
+using namespace DispatchCPP;
+
+// Convenience function for grabbing the CPU time (user and system) this process has used, in seconds.
+static double limitsCPUSeconds() {
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) != 0) {
+		return(0.0);
+	}
+	return(((double) (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec)) + (((double) (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec)) / 1000000.0));
+}
+
+// Waits for a Queue's work to finish, sampling how many of its threads are busy running work as we go.
+template <class RType, typename ...Args>
+static double limitsWaitAndSample(Queue<RType, Args...> * pQueue) {
+	unsigned long long int numSamples = 0;
+	unsigned long long int numBusy    = 0;
+	while (pQueue->hasWorkLeft(false)) {
+		vector<QueueThreadStatus> allStatus = pQueue->getThreadStatus();
+		for (unsigned int threadIndex = 0; threadIndex < allStatus.size(); ++threadIndex) {
+			numBusy += ((allStatus[threadIndex].state == QueueThreadStateRunning) ? 1 : 0);
+			numSamples++;
+		}
+		usleep(LIMITS_SAMPLE_INTERVAL_US);
+	}
+	return((numSamples > 0) ? ((100.0 * ((double) numBusy)) / ((double) numSamples)) : 0.0);
+}
+
+double testQueueLimitsRate(unsigned int numWorkers, bool useLimiter, double * pBusyPercent, double * pCPUSeconds) {
+	// Without a limiter, each worker throttles itself by sleeping after every task, which is what the limiter replaces.
+	unsigned int throttleUS = (unsigned int) ((((double) numWorkers) * 1000000.0) / LIMITS_RATE);
+	Queue<void> * pRateQueue = new Queue<void>(
+		new QueueFunction<void>(
+			[useLimiter, throttleUS]() {
+				if (!useLimiter) {
+					usleep(throttleUS);
+				}
+			}
+		),
+		numWorkers,
+		true
+	);
+	if (useLimiter) {
+		pRateQueue->setRateLimit(LIMITS_RATE);
+	}
+
+	// Dispatch all of our work, and wait for it to finish.
+	double cpuBefore      = limitsCPUSeconds();
+	auto   beforeDispatch = chrono::high_resolution_clock::now();
+	for (unsigned int taskIndex = 0; taskIndex < LIMITS_RATE_NUM_TASKS; ++taskIndex) {
+		pRateQueue->dispatchWork();
+	}
+	*pBusyPercent = limitsWaitAndSample(pRateQueue);
+	pRateQueue->hasWorkLeft(true);
+	auto   afterDispatch  = chrono::high_resolution_clock::now();
+	*pCPUSeconds = (limitsCPUSeconds() - cpuBefore);
+
+	// Clean up after ourselves.
+	delete(pRateQueue);
+
+	// Return the rate we actually achieved.
+	double numSeconds = (((double) chrono::duration_cast<chrono::microseconds>(afterDispatch - beforeDispatch).count()) / 1000000.0);
+	return(((double) LIMITS_RATE_NUM_TASKS) / numSeconds);
+}
+
+double testQueueLimitsCap(unsigned int numWorkers, unsigned int * pMaxSeenInFlight) {
+	// Each task keeps track of how many tasks are running alongside it.
+	atomic<unsigned int> numInFlight(0);
+	atomic<unsigned int> maxSeenInFlight(0);
+	Queue<void> * pCappedQueue = new Queue<void>(
+		new QueueFunction<void>(
+			[&numInFlight, &maxSeenInFlight]() {
+				unsigned int currentInFlight = (numInFlight.fetch_add(1) + 1);
+				unsigned int previousMax     = maxSeenInFlight.load();
+				while ((currentInFlight > previousMax) && !maxSeenInFlight.compare_exchange_weak(previousMax, currentInFlight)) {}
+				usleep(LIMITS_CAP_TASK_US);
+				numInFlight.fetch_sub(1);
+			}
+		),
+		numWorkers,
+		true
+	);
+	pCappedQueue->setMaxInFlight(LIMITS_MAX_IN_FLIGHT);
+
+	// Dispatch all of our work, and wait for it to finish.
+	auto beforeDispatch = chrono::high_resolution_clock::now();
+	for (unsigned int taskIndex = 0; taskIndex < LIMITS_CAP_NUM_TASKS; ++taskIndex) {
+		pCappedQueue->dispatchWork();
+	}
+	pCappedQueue->hasWorkLeft(true);
+	auto afterDispatch = chrono::high_resolution_clock::now();
+
+	// Clean up after ourselves.
+	delete(pCappedQueue);
+
+	*pMaxSeenInFlight = maxSeenInFlight;
+	return(((double) chrono::duration_cast<chrono::microseconds>(afterDispatch - beforeDispatch).count()) / 1000.0);
+}
+
+void testQueueLimits(unsigned int maxNumThreads) {
+	// The worker counts we'll test: powers of two, plus the max itself.
+	vector<unsigned int> allWorkerCounts = TestHelpers::workerCounts(maxNumThreads);
+
+	printf("==========================================================================================\n");
+	printf("=== Rate limiting to %.0f tasks/s (%u tasks): sleeping in the function vs setRateLimit()\n", LIMITS_RATE, LIMITS_RATE_NUM_TASKS);
+	printf("==========================================================================================\n");
+	for (unsigned int workerIndex = 0; workerIndex < allWorkerCounts.size(); ++workerIndex) {
+		unsigned int numWorkers = allWorkerCounts[workerIndex];
+		double       sleepBusy  = 0.0, sleepCPU   = 0.0;
+		double       limitBusy  = 0.0, limitCPU   = 0.0;
+		double       sleepRate  = testQueueLimitsRate(numWorkers, false, &sleepBusy, &sleepCPU);
+		double       limitRate  = testQueueLimitsRate(numWorkers, true,  &limitBusy, &limitCPU);
+		bool         isOnRate   = ((limitRate > (LIMITS_RATE * 0.9)) && (limitRate < (LIMITS_RATE * 1.1)));
+		printf("[%2u Worker%s] Sleeping: %7.1f tasks/s, workers busy %5.1f%%  |  Limiter: %s%7.1f tasks/s%s, workers busy %s%5.1f%%%s, %.3fs CPU\n",
+			numWorkers, (numWorkers == 1) ? " " : "s", sleepRate, sleepBusy,
+			isOnRate ? Colors::pColorGreen : Colors::pColorRed, limitRate, Colors::pColorReset,
+			(limitBusy < sleepBusy) ? Colors::pColorGreen : Colors::pColorRed, limitBusy, Colors::pColorReset, limitCPU);
+	}
+
+	printf("==========================================================================================\n");
+	printf("=== Capping to %u in flight (%u tasks of %uus each)\n", LIMITS_MAX_IN_FLIGHT, LIMITS_CAP_NUM_TASKS, LIMITS_CAP_TASK_US);
+	printf("==========================================================================================\n");
+	for (unsigned int workerIndex = 0; workerIndex < allWorkerCounts.size(); ++workerIndex) {
+		unsigned int numWorkers      = allWorkerCounts[workerIndex];
+		unsigned int maxSeenInFlight = 0;
+		double       totalMS         = testQueueLimitsCap(numWorkers, &maxSeenInFlight);
+		printf("[%2u Worker%s] %9.3f ms, at most %s%u in flight%s\n",
+			numWorkers, (numWorkers == 1) ? " " : "s", totalMS,
+			(maxSeenInFlight <= LIMITS_MAX_IN_FLIGHT) ? Colors::pColorGreen : Colors::pColorRed, maxSeenInFlight, Colors::pColorReset);
+	}
+}
@@ -0,0 +1,34 @@
+#ifndef __TEST_QUEUE_LIMITS_H__
+#define __TEST_QUEUE_LIMITS_H__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/resource.h>
+
+#include <atomic>
+#include <chrono>
+#include <vector>
+
+#include "DispatchCPP/DispatchCPP.h"
+#include "Colors.h"
+#include "TestHelpers.h"
+
+// The rate (tasks per second) we limit to, and the number of tasks dispatched when measuring it.
+#define LIMITS_RATE                     2000.0
+#define LIMITS_RATE_NUM_TASKS           1000
+
+// The most tasks allowed to run at once, the number of tasks dispatched when testing it, and how long each one takes.
+#define LIMITS_MAX_IN_FLIGHT            2
+#define LIMITS_CAP_NUM_TASKS            200
+#define LIMITS_CAP_TASK_US              2000
+
+// How often we sample our workers' states, to see how many of them are busy.
+#define LIMITS_SAMPLE_INTERVAL_US       500
+
+double testQueueLimitsRate(unsigned int numWorkers, bool useLimiter, double * pBusyPercent, double * pCPUSeconds);
+double testQueueLimitsCap(unsigned int numWorkers, unsigned int * pMaxSeenInFlight);
+
+void testQueueLimits(unsigned int maxNumThreads = 4);
+
+#endif // __TEST_QUEUE_LIMITS_H__
@@ -0,0 +1,84 @@
+#include "TestQueueMemo.h"
+
+using namespace DispatchCPP;
+
+// Each result: hash its key a number of times.
+static unsigned long long int memoDoWork(unsigned int key) {
+	return(TestHelpers::hashWork(key, MEMO_WORK_ITERATIONS));
+}
+
+double testQueueMemoRun(unsigned int numWorkers, vector<unsigned int> & allKeys, bool isMemoized, unsigned long long int * pChecksum, QueueMemoStats * pStats) {
+	// Our queue, whose post function sums up every result.
+	atomic<unsigned long long int> checksum = 0;
+	function<void(unsigned long long int)> postFunc = [&checksum](unsigned long long int result) {
+		checksum.fetch_add(result, memory_order_relaxed);
+	};
+	QueueFunction<unsigned long long int, unsigned int> * pFunction = new QueueFunction<unsigned long long int, unsigned int>(
+		[](unsigned int key) {
+			return(memoDoWork(key));
+		},
+		nullptr,
+		&postFunc
+	);
+	if (isMemoized) {
+		pFunction->setMemoized(MEMO_MAX_ENTRIES);
+	}
+	Queue<unsigned long long int, unsigned int> * pQueue = new Queue<unsigned long long int, unsigned int>(pFunction, numWorkers, false);
+
+	// Dispatch every key, and wait for them all.
+	auto beforeRun = chrono::high_resolution_clock::now();
+	for (unsigned int key : allKeys) {
+		pQueue->dispatchWork(key);
+	}
+	pQueue->hasWorkLeft(true);
+	auto afterRun = chrono::high_resolution_clock::now();
+
+	// Clean up after ourselves.
+	delete(pQueue);
+	*pStats = pFunction->getMemoStats();
+	delete(pFunction);
+
+	*pChecksum = checksum.load();
+	return(((double) chrono::duration_cast<chrono::microseconds>(afterRun - beforeRun).count()) / 1000.0);
+}
+
+void testQueueMemo(unsigned int maxNumThreads) {
+	// The worker counts we'll test: powers of two, plus the max itself.
+	vector<unsigned int> allWorkerCounts = TestHelpers::workerCounts(maxNumThreads);
+
+	// Draw our keys, skewed toward the smallest (the product of two uniform draws), and the checksum we expect.
+	vector<unsigned int>   allKeys          = vector<unsigned int>();
+	unsigned long long int randomState      = 88172645463325252ULL;
+	unsigned long long int expectedChecksum = 0;
+	for (unsigned int taskIndex = 0; taskIndex < MEMO_NUM_TASKS; ++taskIndex) {
+		randomState ^= (randomState << 13);
+		randomState ^= (randomState >> 7);
+		randomState ^= (randomState << 17);
+		unsigned long long int firstDraw  = ((randomState >> 32) % MEMO_NUM_KEYS);
+		unsigned long long int secondDraw = ((randomState & 0xFFFFFFFFULL) % MEMO_NUM_KEYS);
+		allKeys.push_back((unsigned int) ((firstDraw * secondDraw) / MEMO_NUM_KEYS));
+		expectedChecksum += memoDoWork(allKeys.back());
+	}
+
+	printf("==========================================================================================\n");
+	printf("=== %u pure tasks over %u skewed keys: recomputing vs memoized (%u entries)\n", MEMO_NUM_TASKS, MEMO_NUM_KEYS, MEMO_MAX_ENTRIES);
+	printf("==========================================================================================\n");
+	for (unsigned int workerIndex = 0; workerIndex < allWorkerCounts.size(); ++workerIndex) {
+		unsigned int           numWorkers     = allWorkerCounts[workerIndex];
+		unsigned long long int plainChecksum  = 0;
+		unsigned long long int memoChecksum   = 0;
+		QueueMemoStats         plainStats;
+		QueueMemoStats         memoStats;
+		double                 plainMS        = testQueueMemoRun(numWorkers, allKeys, false, &plainChecksum, &plainStats);
+		double                 memoMS         = testQueueMemoRun(numWorkers, allKeys, true, &memoChecksum, &memoStats);
+		bool                   isCorrect      = ((plainChecksum == expectedChecksum) && (memoChecksum == expectedChecksum));
+		double                 hitRate        = ((100.0 * (double) (memoStats.numHits + memoStats.numAttached)) / (double) MEMO_NUM_TASKS);
+		double                 computeMS      = (((double) memoStats.computeNS) / 1000000.0);
+		double                 savedMS        = ((memoStats.numMisses > 0) ? ((computeMS / (double) memoStats.numMisses) * (double) (memoStats.numHits + memoStats.numAttached)) : 0.0);
+		printf("[%2u Worker%s] Recomputing: %9.3f ms, memoized: %s%9.3f ms%s (%.2fx), %5.1f%% hit (%llu hits, %llu single-flighted, %llu evictions), ~%.1f ms CPU saved (%s%s%s)\n",
+			numWorkers, (numWorkers == 1) ? " " : "s", plainMS,
+			(memoMS < plainMS) ? Colors::pColorGreen : Colors::pColorRed, memoMS, Colors::pColorReset, plainMS / memoMS,
+			hitRate, memoStats.numHits, memoStats.numAttached, memoStats.numEvictions, savedMS,
+			isCorrect ? Colors::pColorGreen : Colors::pColorRed, isCorrect ? "correct" : "INCORRECT", Colors::pColorReset);
+	}
+}
@@ -0,0 +1,29 @@
+#ifndef __TEST_QUEUE_MEMO_H__
+#define __TEST_QUEUE_MEMO_H__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <vector>
+
+#include "DispatchCPP/DispatchCPP.h"
+#include "Colors.h"
+#include "TestHelpers.h"
+
+// The number of pieces of work dispatched, the number of distinct arguments they're drawn from (skewed toward the
+// smallest), and the number of hashing passes each result takes to compute.
+#define MEMO_NUM_TASKS                  40000
+#define MEMO_NUM_KEYS                   4000
+#define MEMO_WORK_ITERATIONS            20000
+
+// The most results our memo cache holds.
+#define MEMO_MAX_ENTRIES                1024
+
+double testQueueMemoRun(unsigned int numWorkers, vector<unsigned int> & allKeys, bool isMemoized, unsigned long long int * pChecksum, QueueMemoStats * pStats);
+
+void testQueueMemo(unsigned int maxNumThreads = 4);
+
+#endif // __TEST_QUEUE_MEMO_H__
@@ -0,0 +1,236 @@
+#include "TestQueueNumeric.h"
+
+using namespace DispatchCPP;
+
+// The kernels we benchmark, by name.
+static const char * allKernelNames[] = { "sum", "dot", "minmax", "altsum", "xform-reduce", "histogram" };
+static const unsigned int numKernels = (sizeof(allKernelNames) / sizeof(allKernelNames[0]));
+
+// Convenience function for filling an array with the same values the math test uses.
+static void fillData(vector<double> * pData, size_t numEntries) {
+	pData->resize(numEntries);
+	for (size_t index = 0; index < numEntries; ++index) {
+		(*pData)[index] = (((double) rand()) / ((double) (rand() + 1)));
+	}
+}
+
+// Convenience function for whether two results agree closely enough (SIMD sums in a different order).
+static bool resultsMatch(double resultA, double resultB) {
+	return(fabs(resultA - resultB) <= (1e-9 * max(1.0, max(fabs(resultA), fabs(resultB)))));
+}
+
+// Runs a single kernel over a range, serially, on whichever instruction set is current.
+static double runKernelSerially(const char * pKernelName, const double * pDataA, const double * pDataB, size_t numEntries) {
+	if (strcmp(pKernelName, "sum") == 0) {
+		return(numericSum(pDataA, numEntries));
+	} else if (strcmp(pKernelName, "dot") == 0) {
+		return(numericDot(pDataA, pDataB, numEntries));
+	} else if (strcmp(pKernelName, "minmax") == 0) {
+		double minValue = 0.0, maxValue = 0.0;
+		numericMinMax(pDataA, numEntries, &minValue, &maxValue);
+		return(minValue + maxValue);
+	} else if (strcmp(pKernelName, "altsum") == 0) {
+		return(numericAlternatingSum(pDataA, numEntries));
+	} else if (strcmp(pKernelName, "xform-reduce") == 0) {
+		// There's no serial flavour of transform-reduce, so run it on the calling thread alone.
+		return(parallelTransformReduce((Queue<void> *) nullptr, pDataA, numEntries, 0.0, plus<double>(), [](double value) { return(value * value); }));
+	} else {
+		size_t allBins[NUMERIC_NUM_BINS + 1] = { 0 };
+		numericHistogram(pDataA, numEntries, 0.0, 8.0, NUMERIC_NUM_BINS, allBins);
+		double weightedSum = 0.0;
+		for (unsigned int binIndex = 0; binIndex < NUMERIC_NUM_BINS; ++binIndex) {
+			weightedSum += (((double) allBins[binIndex]) * ((double) (binIndex + 1)));
+		}
+		return(weightedSum);
+	}
+}
+
+double testQueueNumericSingleCore(const char * pKernelName, NumericISA isa, vector<double> * pDataA, vector<double> * pDataB, double * pResult) {
+	// Switch over to the instruction set we're testing.
+	NumericISA previousISA = numericGetISA();
+	numericSetISA(isa);
+
+	// Run the kernel over the (cached) array, over and over.
+	double sinkValue  = 0.0;
+	auto   beforeRuns = chrono::high_resolution_clock::now();
+	for (unsigned int runIndex = 0; runIndex < NUMERIC_CACHED_REPEATS; ++runIndex) {
+		sinkValue += runKernelSerially(pKernelName, pDataA->data(), pDataB->data(), pDataA->size());
+	}
+	auto afterRuns = chrono::high_resolution_clock::now();
+	*pResult = (sinkValue / ((double) NUMERIC_CACHED_REPEATS));
+
+	// Put things back the way they were.
+	numericSetISA(previousISA);
+
+	// Return the number of nanoseconds per entry.
+	double numNanoseconds = ((double) chrono::duration_cast<chrono::nanoseconds>(afterRuns - beforeRuns).count());
+	return(numNanoseconds / (((double) NUMERIC_CACHED_REPEATS) * ((double) pDataA->size())));
+}
+
+double testQueueNumericParallel(const char * pKernelName, unsigned int numThreads, vector<double> * pDataA, vector<double> * pDataB, double * pResult) {
+	// Declare the Queue whose threads our kernels run on. Its own function is never used.
+	Queue<void> * pNumericQueue = new Queue<void>(
+		new QueueFunction<void>(
+			[]() {}
+		),
+		numThreads,
+		true
+	);
+
+	// Run the kernel once over the whole (large) array.
+	const double * pData      = pDataA->data();
+	size_t         numEntries = pDataA->size();
+	auto           beforeRun  = chrono::high_resolution_clock::now();
+	if (strcmp(pKernelName, "sum") == 0) {
+		*pResult = parallelSum(pNumericQueue, pData, numEntries);
+	} else if (strcmp(pKernelName, "dot") == 0) {
+		*pResult = parallelDot(pNumericQueue, pData, pDataB->data(), numEntries);
+	} else if (strcmp(pKernelName, "minmax") == 0) {
+		double minValue = 0.0, maxValue = 0.0;
+		parallelMinMax(pNumericQueue, pData, numEntries, &minValue, &maxValue);
+		*pResult = (minValue + maxValue);
+	} else if (strcmp(pKernelName, "altsum") == 0) {
+		*pResult = parallelAlternatingSum(pNumericQueue, pData, numEntries);
+	} else if (strcmp(pKernelName, "xform-reduce") == 0) {
+		*pResult = parallelTransformReduce(pNumericQueue, pData, numEntries, 0.0, plus<double>(), [](double value) { return(value * value); });
+	} else {
+		vector<size_t> allBins     = parallelHistogram(pNumericQueue, pData, numEntries, 0.0, 8.0, NUMERIC_NUM_BINS);
+		double         weightedSum = 0.0;
+		for (unsigned int binIndex = 0; binIndex < NUMERIC_NUM_BINS; ++binIndex) {
+			weightedSum += (((double) allBins[binIndex]) * ((double) (binIndex + 1)));
+		}
+		*pResult = weightedSum;
+	}
+	auto afterRun = chrono::high_resolution_clock::now();
+
+	// Clean up after ourselves.
+	delete(pNumericQueue);
+
+	// Return the number of milliseconds the kernel took.
+	return(((double) chrono::duration_cast<chrono::microseconds>(afterRun - beforeRun).count()) / 1000.0);
+}
+
+double testQueueNumericMath(unsigned int numThreads, unsigned int numArrays, unsigned int numEntries, double * pResult) {
+	// Allocate the same arrays the math test does.
+	srand(SRAND_INIT_VALUE);
+	double ** ppData = ((double **) malloc(sizeof(double *) * numArrays));
+	for (unsigned int index = 0; index < numArrays; ++index) {
+		ppData[index] = ((double *) malloc(sizeof(double) * numEntries));
+		for (unsigned int subIndex = 0; subIndex < numEntries; ++subIndex) {
+			ppData[index][subIndex] = (((double) rand()) / ((double) rand()));
+		}
+	}
+
+	// Each array sums the alternating sums of every one of its prefixes, just as the math test does.
+	vector<double> allSums = vector<double>(numArrays, 0.0);
+	Queue<void, unsigned int> * pMathQueue = new Queue<void, unsigned int>(
+		new QueueFunction<void, unsigned int>(
+			[ppData, numEntries, &allSums](unsigned int arrayIndex) {
+				double sumTotal = 0.0;
+				for (unsigned int index = 0; index < numEntries; ++index) {
+					sumTotal += numericAlternatingSum(ppData[arrayIndex], index);
+				}
+				allSums[arrayIndex] = sumTotal;
+			}
+		),
+		numThreads,
+		true
+	);
+
+	// Dispatch every array, and wait for them all to finish.
+	auto beforeParallel = chrono::high_resolution_clock::now();
+	for (unsigned int index = 0; index < numArrays; ++index) {
+		pMathQueue->dispatchWork(index);
+	}
+	pMathQueue->hasWorkLeft(true);
+	auto afterParallel = chrono::high_resolution_clock::now();
+
+	// Clean up after ourselves.
+	delete(pMathQueue);
+	for (unsigned int index = 0; index < numArrays; ++index) {
+		free(ppData[index]);
+	}
+	free(ppData);
+
+	// Return how long it took, in microseconds.
+	*pResult = numericSumScalar(allSums.data(), allSums.size());
+	return((double) chrono::duration_cast<chrono::microseconds>(afterParallel - beforeParallel).count());
+}
+
+void testQueueNumeric(unsigned int maxNumThreads) {
+	// The worker counts we'll test: powers of two, plus the max itself.
+	vector<unsigned int> allWorkerCounts = TestHelpers::workerCounts(maxNumThreads);
+	NumericISA bestISA = numericDetectISA();
+
+	// Single-core SIMD gains -----------------------------------------------------------------------
+	printf("==========================================================================================\n");
+	printf("=== Single-core kernels (%u cached entries x %u runs, best ISA: %s)\n", NUMERIC_CACHED_ENTRIES, NUMERIC_CACHED_REPEATS, numericISAName(bestISA));
+	printf("==========================================================================================\n");
+	srand(SRAND_INIT_VALUE);
+	vector<double> cachedDataA = vector<double>();
+	vector<double> cachedDataB = vector<double>();
+	fillData(&cachedDataA, NUMERIC_CACHED_ENTRIES);
+	fillData(&cachedDataB, NUMERIC_CACHED_ENTRIES);
+	for (unsigned int kernelIndex = 0; kernelIndex < numKernels; ++kernelIndex) {
+		double scalarResult = 0.0;
+		double scalarNS     = testQueueNumericSingleCore(allKernelNames[kernelIndex], NumericISAScalar, &cachedDataA, &cachedDataB, &scalarResult);
+		printf("[%-12s] %-6s %7.3f nS/entry", allKernelNames[kernelIndex], numericISAName(NumericISAScalar), scalarNS);
+		for (int isa = (NumericISAScalar + 1); isa <= bestISA; ++isa) {
+			double simdResult = 0.0;
+			double simdNS     = testQueueNumericSingleCore(allKernelNames[kernelIndex], (NumericISA) isa, &cachedDataA, &cachedDataB, &simdResult);
+			printf(", %-4s %7.3f nS/entry (%s%5.2fx%s)", numericISAName((NumericISA) isa), simdNS,
+				(resultsMatch(scalarResult, simdResult) ? Colors::pColorGreen : Colors::pColorRed), (scalarNS / simdNS), Colors::pColorReset);
+		}
+		printf("\n");
+	}
+
+	// Multi-core gains -----------------------------------------------------------------------------
+	printf("==========================================================================================\n");
+	printf("=== Parallel kernels (%u entries, %s)\n", NUMERIC_LARGE_ENTRIES, numericISAName(bestISA));
+	printf("==========================================================================================\n");
+	vector<double> largeDataA = vector<double>();
+	vector<double> largeDataB = vector<double>();
+	fillData(&largeDataA, NUMERIC_LARGE_ENTRIES);
+	fillData(&largeDataB, NUMERIC_LARGE_ENTRIES);
+	for (unsigned int kernelIndex = 0; kernelIndex < numKernels; ++kernelIndex) {
+		double baseResult = 0.0;
+		double baseMS     = 0.0;
+		for (unsigned int workerIndex = 0; workerIndex < allWorkerCounts.size(); ++workerIndex) {
+			unsigned int numWorkers = allWorkerCounts[workerIndex];
+			double       result     = 0.0;
+			double       numMS      = testQueueNumericParallel(allKernelNames[kernelIndex], numWorkers, &largeDataA, &largeDataB, &result);
+			if (workerIndex == 0) {
+				baseResult = result;
+				baseMS     = numMS;
+			}
+			printf("[%-12s] [%2u Worker%s] %9.3f mS %s(%5.2fx)%s\n", allKernelNames[kernelIndex], numWorkers, (numWorkers == 1) ? " " : "s", numMS,
+				(resultsMatch(baseResult, result) ? Colors::pColorGreen : Colors::pColorRed), (baseMS / numMS), Colors::pColorReset);
+		}
+		if ((kernelIndex + 1) < numKernels) {
+			printf("------------------------------------------------------------------------------------------\n");
+		}
+	}
+	largeDataA = vector<double>();
+	largeDataB = vector<double>();
+
+	// The math test, rewritten on top of the kernels -----------------------------------------------
+	printf("==========================================================================================\n");
+	printf("=== Math test equivalent (alternating sums of every prefix)\n");
+	printf("==========================================================================================\n");
+	for (unsigned int numArrays = NUMERIC_MATH_MIN_ARRAYS; numArrays <= NUMERIC_MATH_MAX_ARRAYS; numArrays *= 4) {
+		for (unsigned int numEntries = NUMERIC_MATH_MIN_ENTRIES; numEntries <= NUMERIC_MATH_MAX_ENTRIES; numEntries *= 10) {
+			double originalUS   = testQueueMathThreads(1, numArrays, numEntries);
+			double scalarResult = 0.0, simdResult = 0.0, parallelResult = 0.0;
+			numericSetISA(NumericISAScalar);
+			double scalarUS     = testQueueNumericMath(1, numArrays, numEntries, &scalarResult);
+			numericSetISA(bestISA);
+			double simdUS       = testQueueNumericMath(1, numArrays, numEntries, &simdResult);
+			double parallelUS   = testQueueNumericMath(maxNumThreads, numArrays, numEntries, &parallelResult);
+			bool   allMatch     = (resultsMatch(scalarResult, simdResult) && resultsMatch(scalarResult, parallelResult));
+			printf("[%4u Arrays, %6u Entries] Original: %9.3f mS, Scalar: %9.3f mS, %s: %s%9.3f mS%s, %s x %2u: %s%9.3f mS (%.2fx)%s\n",
+				numArrays, numEntries, originalUS / 1000.0, scalarUS / 1000.0,
+				numericISAName(bestISA), (allMatch ? Colors::pColorGreen : Colors::pColorRed), simdUS / 1000.0, Colors::pColorReset,
+				numericISAName(bestISA), maxNumThreads, (allMatch ? Colors::pColorGreen : Colors::pColorRed), parallelUS / 1000.0, (originalUS / parallelUS), Colors::pColorReset);
+		}
+	}
+}
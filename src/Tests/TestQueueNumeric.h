@@ -0,0 +1,40 @@
+#ifndef __TEST_QUEUE_NUMERIC_H__
+#define __TEST_QUEUE_NUMERIC_H__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <math.h>
+
+#include <chrono>
+#include <vector>
+
+#include "DispatchCPP/DispatchCPP.h"
+#include "Colors.h"
+#include "TestHelpers.h"
+#include "TestThreads.h"
+
+// The number of entries in the array each single-core kernel runs over (small enough to stay in cache), and how many
+// times each kernel is run over it.
+#define NUMERIC_CACHED_ENTRIES          16384
+#define NUMERIC_CACHED_REPEATS          2000
+
+// The number of entries in the array the parallel kernels run over (256MB of doubles).
+#define NUMERIC_LARGE_ENTRIES           (32 * 1024 * 1024)
+
+// The number of bins used by the histogram kernels.
+#define NUMERIC_NUM_BINS                64
+
+// The shapes of the math test equivalent: numbers of arrays, and numbers of entries per array.
+#define NUMERIC_MATH_MIN_ARRAYS         32
+#define NUMERIC_MATH_MAX_ARRAYS         128
+#define NUMERIC_MATH_MIN_ENTRIES        1000
+#define NUMERIC_MATH_MAX_ENTRIES        10000
+
+double testQueueNumericSingleCore(const char * pKernelName, NumericISA isa, vector<double> * pDataA, vector<double> * pDataB, double * pResult);
+double testQueueNumericParallel(const char * pKernelName, unsigned int numThreads, vector<double> * pDataA, vector<double> * pDataB, double * pResult);
+double testQueueNumericMath(unsigned int numThreads, unsigned int numArrays, unsigned int numEntries, double * pResult);
+
+void testQueueNumeric(unsigned int maxNumThreads = 4);
+
+#endif // __TEST_QUEUE_NUMERIC_H__
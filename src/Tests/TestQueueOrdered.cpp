@@ -0,0 +1,129 @@
+#include "TestQueueOrdered.h"
+
+using namespace DispatchCPP;
+
+// Each item's work: hash its index a number of times.
+static unsigned long long int orderedDoWork(unsigned int itemIndex) {
+	return(TestHelpers::hashWork(itemIndex, ORDERED_WORK_ITERATIONS));
+}
+
+// Folds a result into a checksum which depends on the order results arrive in.
+static unsigned long long int orderedFold(unsigned long long int checksum, unsigned long long int result) {
+	return((checksum * 31) + result);
+}
+
+double testQueueOrderedSerialQueue(unsigned int numWorkers, unsigned long long int * pChecksum, size_t * pMaxBuffered) {
+	// The serial queue we hand results to, which buffers them until the next one in order arrives.
+	unsigned long long int                   checksum     = 0;
+	unsigned int                             nextIndex    = 0;
+	size_t                                   maxBuffered  = 0;
+	map<unsigned int, unsigned long long int> allBuffered = map<unsigned int, unsigned long long int>();
+	Queue<void, unsigned int, unsigned long long int> * pSerialQueue = new Queue<void, unsigned int, unsigned long long int>(
+		new QueueFunction<void, unsigned int, unsigned long long int>(
+			[&](unsigned int itemIndex, unsigned long long int result) {
+				allBuffered[itemIndex] = result;
+				maxBuffered = max(maxBuffered, allBuffered.size());
+				auto nextResult = allBuffered.begin();
+				while ((nextResult != allBuffered.end()) && (nextResult->first == nextIndex)) {
+					checksum = orderedFold(checksum, nextResult->second);
+					nextIndex++;
+					nextResult = allBuffered.erase(nextResult);
+				}
+			}
+		),
+		1,
+		true
+	);
+
+	// Our parallel queue, which does the work and passes each result on.
+	Queue<void, unsigned int> * pMapQueue = new Queue<void, unsigned int>(
+		new QueueFunction<void, unsigned int>(
+			[pSerialQueue](unsigned int itemIndex) {
+				pSerialQueue->dispatchWork(itemIndex, orderedDoWork(itemIndex));
+			}
+		),
+		numWorkers,
+		true
+	);
+
+	// Map every item, and wait for every result to be folded in.
+	auto beforeMap = chrono::high_resolution_clock::now();
+	for (unsigned int itemIndex = 0; itemIndex < ORDERED_NUM_ITEMS; ++itemIndex) {
+		pMapQueue->dispatchWork(itemIndex);
+	}
+	pMapQueue->hasWorkLeft(true);
+	pSerialQueue->hasWorkLeft(true);
+	auto afterMap = chrono::high_resolution_clock::now();
+
+	// Clean up after ourselves.
+	delete(pMapQueue);
+	delete(pSerialQueue);
+
+	*pChecksum    = checksum;
+	*pMaxBuffered = maxBuffered;
+	return(((double) chrono::duration_cast<chrono::microseconds>(afterMap - beforeMap).count()) / 1000.0);
+}
+
+double testQueueOrderedStream(unsigned int numWorkers, unsigned long long int * pChecksum) {
+	// Our parallel queue, whose results are handed back through a stream.
+	Queue<unsigned long long int, unsigned int> * pMapQueue = new Queue<unsigned long long int, unsigned int>(
+		new QueueFunction<unsigned long long int, unsigned int>(
+			[](unsigned int itemIndex) {
+				return(orderedDoWork(itemIndex));
+			}
+		),
+		numWorkers,
+		true
+	);
+	QueueResultStream<unsigned long long int> resultStream(ORDERED_STREAM_CAPACITY);
+
+	// Consume results on their own thread, since dispatching blocks whenever the stream is full.
+	unsigned long long int checksum = 0;
+	auto beforeMap = chrono::high_resolution_clock::now();
+	thread consumerThread = thread([&resultStream, &checksum]() {
+		unsigned long long int result = 0;
+		while (resultStream.next(result)) {
+			checksum = orderedFold(checksum, result);
+		}
+	});
+	for (unsigned int itemIndex = 0; itemIndex < ORDERED_NUM_ITEMS; ++itemIndex) {
+		pMapQueue->dispatchWorkOrdered(resultStream, itemIndex);
+	}
+	resultStream.close();
+	consumerThread.join();
+	auto afterMap = chrono::high_resolution_clock::now();
+
+	// Clean up after ourselves.
+	delete(pMapQueue);
+
+	*pChecksum = checksum;
+	return(((double) chrono::duration_cast<chrono::microseconds>(afterMap - beforeMap).count()) / 1000.0);
+}
+
+void testQueueOrdered(unsigned int maxNumThreads) {
+	// The worker counts we'll test: powers of two, plus the max itself.
+	vector<unsigned int> allWorkerCounts = TestHelpers::workerCounts(maxNumThreads);
+
+	// The checksum we expect, computed serially.
+	unsigned long long int expectedChecksum = 0;
+	for (unsigned int itemIndex = 0; itemIndex < ORDERED_NUM_ITEMS; ++itemIndex) {
+		expectedChecksum = orderedFold(expectedChecksum, orderedDoWork(itemIndex));
+	}
+
+	printf("==========================================================================================\n");
+	printf("=== Ordered parallel map of %u items: serial queue + buffering vs QueueResultStream (%u slots)\n", ORDERED_NUM_ITEMS, ORDERED_STREAM_CAPACITY);
+	printf("==========================================================================================\n");
+	for (unsigned int workerIndex = 0; workerIndex < allWorkerCounts.size(); ++workerIndex) {
+		unsigned int           numWorkers     = allWorkerCounts[workerIndex];
+		unsigned long long int serialChecksum = 0;
+		unsigned long long int streamChecksum = 0;
+		size_t                 maxBuffered    = 0;
+		double                 serialMS       = testQueueOrderedSerialQueue(numWorkers, &serialChecksum, &maxBuffered);
+		double                 streamMS       = testQueueOrderedStream(numWorkers, &streamChecksum);
+		bool                   isInOrder      = ((serialChecksum == expectedChecksum) && (streamChecksum == expectedChecksum));
+		printf("[%2u Worker%s] Serial queue: %9.3f ms (up to %6zu buffered), stream: %s%9.3f ms%s (%.2fx) (%s%s%s)\n",
+			numWorkers, (numWorkers == 1) ? " " : "s", serialMS, maxBuffered,
+			(streamMS < serialMS) ? Colors::pColorGreen : Colors::pColorRed, streamMS, Colors::pColorReset, serialMS / streamMS,
+			isInOrder ? Colors::pColorGreen : Colors::pColorRed, isInOrder ? "in order" : "OUT OF ORDER", Colors::pColorReset);
+	}
+}
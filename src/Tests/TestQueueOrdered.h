@@ -0,0 +1,29 @@
+#ifndef __TEST_QUEUE_ORDERED_H__
+#define __TEST_QUEUE_ORDERED_H__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <map>
+#include <thread>
+#include <vector>
+
+#include "DispatchCPP/DispatchCPP.h"
+#include "Colors.h"
+#include "TestHelpers.h"
+
+// The number of items mapped, and the number of hashing passes each one takes (its CPU-bound work).
+#define ORDERED_NUM_ITEMS               200000
+#define ORDERED_WORK_ITERATIONS         256
+
+// The number of results our stream holds.
+#define ORDERED_STREAM_CAPACITY         1024
+
+double testQueueOrderedSerialQueue(unsigned int numWorkers, unsigned long long int * pChecksum, size_t * pMaxBuffered);
+double testQueueOrderedStream(unsigned int numWorkers, unsigned long long int * pChecksum);
+
+void testQueueOrdered(unsigned int maxNumThreads = 4);
+
+#endif // __TEST_QUEUE_ORDERED_H__
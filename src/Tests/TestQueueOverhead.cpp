@@ -0,0 +1,259 @@
+#include "TestQueueOverhead.h"
+
+using namespace DispatchCPP;
+
+// Convenience function for grabbing the current time in nanoseconds.
+static inline long long int nowNS() {
+	return((long long int) chrono::duration_cast<chrono::nanoseconds>(chrono::high_resolution_clock::now().time_since_epoch()).count());
+}
+
+// Convenience function for printing the distribution of a set of latencies (in microseconds).
+static void printLatencies(const char * pLabel, vector<double> * pLatenciesUS) {
+	// Sort our latencies so we can pull percentiles out of them.
+	sort(pLatenciesUS->begin(), pLatenciesUS->end());
+
+	// Make sure we actually have samples to report.
+	size_t numSamples = pLatenciesUS->size();
+	if (numSamples == 0) {
+		printf("%s no samples!\n", pLabel);
+		return;
+	}
+
+	printf("%-41s min %9.3f uS, p50 %9.3f uS, p90 %9.3f uS, p99 %9.3f uS, max %9.3f uS\n",
+		pLabel,
+		(*pLatenciesUS)[0],
+		(*pLatenciesUS)[(numSamples * 50) / 100],
+		(*pLatenciesUS)[(numSamples * 90) / 100],
+		(*pLatenciesUS)[(numSamples * 99) / 100],
+		(*pLatenciesUS)[numSamples - 1]);
+}
+
+double testQueueOverheadThroughput(unsigned int numProducers, unsigned int numWorkers, unsigned int numTasks) {
+	// Declare our Queue, whose function does nothing at all.
+	Queue<void> * pEmptyQueue = new Queue<void>(
+		new QueueFunction<void>(
+			[]() {}
+		),
+		numWorkers,
+		true
+	);
+
+	// Create our producers, holding each of them until we've created all of them.
+	atomic<bool>   startProducing(false);
+	vector<thread> allProducers = vector<thread>();
+	for (unsigned int producerIndex = 0; producerIndex < numProducers; ++producerIndex) {
+		// Split the tasks evenly across producers, with the first producer taking any remainder.
+		unsigned int numProducerTasks = ((numTasks / numProducers) + ((producerIndex == 0) ? (numTasks % numProducers) : 0));
+		allProducers.push_back(thread([pEmptyQueue, numProducerTasks, &startProducing]() {
+			while (!startProducing.load()) {
+				this_thread::yield();
+			}
+			for (unsigned int index = 0; index < numProducerTasks; ++index) {
+				pEmptyQueue->dispatchWork();
+			}
+		}));
+	}
+
+	// Start our timer, and let all the producers take off.
+	auto beforeDispatch = chrono::high_resolution_clock::now();
+	startProducing.store(true);
+
+	// Wait for all producers to finish, and then for all work to drain.
+	for (unsigned int producerIndex = 0; producerIndex < numProducers; ++producerIndex) {
+		allProducers[producerIndex].join();
+	}
+	pEmptyQueue->hasWorkLeft(true);
+
+	// End our timer.
+	auto afterDispatch = chrono::high_resolution_clock::now();
+
+	// Clean up after ourselves.
+	delete(pEmptyQueue);
+
+	// Return the number of tasks per second we managed (a fast enough run can take under a microsecond to time).
+	double numMicroseconds = max(((double) chrono::duration_cast<chrono::nanoseconds>(afterDispatch - beforeDispatch).count()) / 1000.0, 0.001);
+	return(((double) numTasks) / (numMicroseconds / 1000000.0));
+}
+
+void testQueueOverheadLatency(unsigned int numWorkers, unsigned int numSamples, unsigned int idleTimeUS, bool isSpinning, vector<double> * pLatenciesUS) {
+	// The time each sample was enqueued, and whether the most recent one has started yet.
+	vector<long long int> enqueueTimesNS = vector<long long int>(numSamples, 0);
+	atomic<bool>          hasStarted(false);
+
+	// Declare our Queue, which records how long each sample took to start executing.
+	Queue<void, unsigned int> * pLatencyQueue = new Queue<void, unsigned int>(
+		new QueueFunction<void, unsigned int>(
+			[&enqueueTimesNS, &hasStarted, pLatenciesUS](unsigned int sampleIndex) {
+				long long int startTimeNS = nowNS();
+				(*pLatenciesUS)[sampleIndex] = (((double) (startTimeNS - enqueueTimesNS[sampleIndex])) / 1000.0);
+				hasStarted.store(true);
+			}
+		),
+		numWorkers,
+		true
+	);
+
+	// Keep our workers spinning between samples, if asked, so we measure handing work over rather than waking a
+	// parked thread.
+	if (isSpinning) {
+		pLatencyQueue->setWaitStrategy(QueueWaitStrategySpin);
+	}
+
+	// Dispatch each sample one at a time, waiting for each to start before dispatching the next.
+	pLatenciesUS->assign(numSamples, 0.0);
+	for (unsigned int sampleIndex = 0; sampleIndex < numSamples; ++sampleIndex) {
+		// Should we let the queue go idle before dispatching?
+		if (idleTimeUS > 0) {
+			usleep(idleTimeUS);
+		}
+
+		hasStarted.store(false);
+		enqueueTimesNS[sampleIndex] = nowNS();
+		pLatencyQueue->dispatchWork(sampleIndex);
+		while (!hasStarted.load()) {
+			this_thread::yield();
+		}
+	}
+
+	// Clean up after ourselves.
+	pLatencyQueue->hasWorkLeft(true);
+	delete(pLatencyQueue);
+}
+
+double testQueueOverheadPingPong(unsigned int numTrips) {
+	// Declare our two serial queues, each of which bounces the ball back to the other.
+	Queue<void, unsigned int> * pPingQueue = nullptr;
+	Queue<void, unsigned int> * pPongQueue = nullptr;
+	atomic<bool>                isDone(false);
+
+	pPingQueue = new Queue<void, unsigned int>(
+		new QueueFunction<void, unsigned int>(
+			[&pPongQueue, &isDone](unsigned int tripsLeft) {
+				if (tripsLeft == 0) {
+					isDone.store(true);
+				} else {
+					pPongQueue->dispatchWork(tripsLeft);
+				}
+			}
+		),
+		1,
+		true
+	);
+	pPongQueue = new Queue<void, unsigned int>(
+		new QueueFunction<void, unsigned int>(
+			[&pPingQueue](unsigned int tripsLeft) {
+				pPingQueue->dispatchWork(tripsLeft - 1);
+			}
+		),
+		1,
+		true
+	);
+
+	// Serve the ball, and wait for the last return.
+	auto beforePingPong = chrono::high_resolution_clock::now();
+	pPingQueue->dispatchWork(numTrips);
+	while (!isDone.load()) {
+		usleep(10);
+	}
+	auto afterPingPong = chrono::high_resolution_clock::now();
+
+	// Clean up after ourselves.
+	pPingQueue->hasWorkLeft(true);
+	pPongQueue->hasWorkLeft(true);
+	delete(pPingQueue);
+	delete(pPongQueue);
+
+	// Return the average round trip time in microseconds.
+	double numMicroseconds = ((double) chrono::duration_cast<chrono::nanoseconds>(afterPingPong - beforePingPong).count()) / 1000.0;
+	return(numMicroseconds / ((double) numTrips));
+}
+
+void testQueueOverheadHasWorkLeft(unsigned int numWorkers, unsigned int numSamples, vector<double> * pLatenciesUS) {
+	// The time the most recent task finished.
+	atomic<long long int> finishTimeNS(0);
+
+	// Declare our Queue, whose function does a small amount of waiting so the caller is already blocked.
+	Queue<void> * pWaitQueue = new Queue<void>(
+		new QueueFunction<void>(
+			[&finishTimeNS]() {
+				usleep(100);
+				finishTimeNS.store(nowNS());
+			}
+		),
+		numWorkers,
+		true
+	);
+
+	// Dispatch a single task and measure how long after it finishes the blocking call returns.
+	pLatenciesUS->assign(numSamples, 0.0);
+	for (unsigned int sampleIndex = 0; sampleIndex < numSamples; ++sampleIndex) {
+		pWaitQueue->dispatchWork();
+		pWaitQueue->hasWorkLeft(true);
+		long long int returnTimeNS = nowNS();
+		(*pLatenciesUS)[sampleIndex] = (((double) (returnTimeNS - finishTimeNS.load())) / 1000.0);
+	}
+
+	// Clean up after ourselves.
+	delete(pWaitQueue);
+}
+
+void testQueueOverhead(unsigned int maxNumThreads) {
+	// The worker counts we'll test: powers of two, plus the max itself.
+	vector<unsigned int> allWorkerCounts = TestHelpers::workerCounts(maxNumThreads);
+
+	// Empty-task throughput ------------------------------------------------------------------------
+	printf("==========================================================================================\n");
+	printf("=== Empty-task throughput (%u tasks per run)\n", OVERHEAD_THROUGHPUT_NUM_TASKS);
+	printf("==========================================================================================\n");
+	for (unsigned int workerIndex = 0; workerIndex < allWorkerCounts.size(); ++workerIndex) {
+		unsigned int numWorkers = allWorkerCounts[workerIndex];
+		for (unsigned int numProducers = 1; numProducers <= 8; numProducers *= 2) {
+			double tasksPerSecond = testQueueOverheadThroughput(numProducers, numWorkers, OVERHEAD_THROUGHPUT_NUM_TASKS);
+			printf("[%2u Worker%s, %u Producer%s] %s%12.0f tasks/s (%7.3f uS/task)%s\n",
+				numWorkers,
+				(numWorkers == 1) ? " " : "s",
+				numProducers,
+				(numProducers == 1) ? " " : "s",
+				Colors::pColorGreen,
+				tasksPerSecond,
+				1000000.0 / tasksPerSecond,
+				Colors::pColorReset);
+		}
+		if ((workerIndex + 1) < allWorkerCounts.size()) {
+			printf("------------------------------------------------------------------------------------------\n");
+		}
+	}
+
+	// Enqueue-to-start and wakeup latencies --------------------------------------------------------
+	printf("==========================================================================================\n");
+	printf("=== Single-task latency (%u samples per run)\n", OVERHEAD_LATENCY_NUM_SAMPLES);
+	printf("==========================================================================================\n");
+	vector<double> allLatenciesUS = vector<double>();
+	for (unsigned int workerIndex = 0; workerIndex < allWorkerCounts.size(); ++workerIndex) {
+		unsigned int numWorkers = allWorkerCounts[workerIndex];
+		char         label[64];
+
+		testQueueOverheadLatency(numWorkers, OVERHEAD_LATENCY_NUM_SAMPLES, 0, true, &allLatenciesUS);
+		snprintf(label, sizeof(label), "[%2u Worker%s] Enqueue-to-start (spinning):", numWorkers, (numWorkers == 1) ? " " : "s");
+		printLatencies(label, &allLatenciesUS);
+
+		testQueueOverheadLatency(numWorkers, OVERHEAD_LATENCY_NUM_SAMPLES, 0, false, &allLatenciesUS);
+		snprintf(label, sizeof(label), "[%2u Worker%s] Enqueue-to-start (parked):", numWorkers, (numWorkers == 1) ? " " : "s");
+		printLatencies(label, &allLatenciesUS);
+
+		testQueueOverheadLatency(numWorkers, OVERHEAD_LATENCY_NUM_SAMPLES / 4, OVERHEAD_WAKEUP_IDLE_TIME_US, false, &allLatenciesUS);
+		snprintf(label, sizeof(label), "[%2u Worker%s] Wakeup from idle:", numWorkers, (numWorkers == 1) ? " " : "s");
+		printLatencies(label, &allLatenciesUS);
+
+		testQueueOverheadHasWorkLeft(numWorkers, OVERHEAD_LATENCY_NUM_SAMPLES / 4, &allLatenciesUS);
+		snprintf(label, sizeof(label), "[%2u Worker%s] hasWorkLeft(true):", numWorkers, (numWorkers == 1) ? " " : "s");
+		printLatencies(label, &allLatenciesUS);
+	}
+
+	// Ping-pong between two serial queues ----------------------------------------------------------
+	printf("==========================================================================================\n");
+	printf("=== Ping-pong between two serial queues (%u round trips)\n", OVERHEAD_PING_PONG_NUM_TRIPS);
+	printf("==========================================================================================\n");
+	double roundTripUS = testQueueOverheadPingPong(OVERHEAD_PING_PONG_NUM_TRIPS);
+	printf("[Ping-Pong] %s%9.3f uS/round trip%s\n", Colors::pColorGreen, roundTripUS, Colors::pColorReset);
+}
@@ -0,0 +1,37 @@
+#ifndef __TEST_QUEUE_OVERHEAD_H__
+#define __TEST_QUEUE_OVERHEAD_H__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "DispatchCPP/DispatchCPP.h"
+#include "Colors.h"
+#include "TestHelpers.h"
+
+// The number of empty tasks dispatched for each throughput run.
+#define OVERHEAD_THROUGHPUT_NUM_TASKS   200000
+
+// The number of samples gathered for each latency measurement.
+#define OVERHEAD_LATENCY_NUM_SAMPLES    2000
+
+// The number of round trips performed by the ping-pong measurement.
+#define OVERHEAD_PING_PONG_NUM_TRIPS    20000
+
+// How long we let a queue sit idle before dispatching to it when measuring wakeup latency.
+#define OVERHEAD_WAKEUP_IDLE_TIME_US    2000
+
+double testQueueOverheadThroughput(unsigned int numProducers, unsigned int numWorkers, unsigned int numTasks);
+void   testQueueOverheadLatency(unsigned int numWorkers, unsigned int numSamples, unsigned int idleTimeUS, bool isSpinning, std::vector<double> * pLatenciesUS);
+double testQueueOverheadPingPong(unsigned int numTrips);
+void   testQueueOverheadHasWorkLeft(unsigned int numWorkers, unsigned int numSamples, std::vector<double> * pLatenciesUS);
+
+void testQueueOverhead(unsigned int maxNumThreads = 4);
+
+#endif // __TEST_QUEUE_OVERHEAD_H__
@@ -0,0 +1,168 @@
+#include "TestQueuePipeline.h"
+
+using namespace DispatchCPP;
+
+// A parsed line.
+typedef struct __PIPELINE_RECORD__ {
+	unsigned int           bucket;
+	unsigned long long int value;
+} PipelineRecord;
+
+// Parse: split a line of the form "bucket,value".
+static PipelineRecord pipelineParse(const string & line) {
+	size_t         commaIndex = line.find(',');
+	PipelineRecord record;
+	record.bucket = ((unsigned int) strtoul(line.c_str(), nullptr, 10));
+	record.value  = strtoull(line.c_str() + commaIndex + 1, nullptr, 10);
+	return(record);
+}
+
+// Transform: hash the record's value a number of times.
+static PipelineRecord pipelineTransform(PipelineRecord record) {
+	record.value = TestHelpers::hashWork(record.value, PIPELINE_WORK_ITERATIONS);
+	return(record);
+}
+
+// Folds our buckets into a single checksum.
+static unsigned long long int pipelineChecksum(unsigned long long int * pBuckets) {
+	unsigned long long int checksum = 0;
+	for (unsigned int bucketIndex = 0; bucketIndex < PIPELINE_NUM_BUCKETS; ++bucketIndex) {
+		checksum = ((checksum * 31) + pBuckets[bucketIndex]);
+	}
+	return(checksum);
+}
+
+double testQueuePipelineNested(unsigned int numWorkers, vector<string> & allLines, unsigned long long int * pChecksum) {
+	// Aggregate: a serial queue summing each record into its bucket.
+	unsigned long long int allBuckets[PIPELINE_NUM_BUCKETS] = {};
+	Queue<void, unsigned int, unsigned long long int> * pAggregateQueue = new Queue<void, unsigned int, unsigned long long int>(
+		new QueueFunction<void, unsigned int, unsigned long long int>(
+			[&allBuckets](unsigned int bucket, unsigned long long int value) {
+				allBuckets[bucket] += value;
+			}
+		),
+		1,
+		true
+	);
+
+	// Transform: a serial queue passing each record on to be aggregated.
+	Queue<void, unsigned int, unsigned long long int> * pTransformQueue = new Queue<void, unsigned int, unsigned long long int>(
+		new QueueFunction<void, unsigned int, unsigned long long int>(
+			[pAggregateQueue](unsigned int bucket, unsigned long long int value) {
+				PipelineRecord record;
+				record.bucket = bucket;
+				record.value  = value;
+				record = pipelineTransform(record);
+				pAggregateQueue->dispatchWork(record.bucket, record.value);
+			}
+		),
+		1,
+		true
+	);
+
+	// Parse: a parallel queue passing each record on to be transformed.
+	Queue<void, string> * pParseQueue = new Queue<void, string>(
+		new QueueFunction<void, string>(
+			[pTransformQueue](string line) {
+				PipelineRecord record = pipelineParse(line);
+				pTransformQueue->dispatchWork(record.bucket, record.value);
+			}
+		),
+		numWorkers,
+		true
+	);
+
+	// Parse every line, and wait for each stage to drain in turn.
+	auto beforeRun = chrono::high_resolution_clock::now();
+	for (string & line : allLines) {
+		pParseQueue->dispatchWork(line);
+	}
+	pParseQueue->hasWorkLeft(true);
+	pTransformQueue->hasWorkLeft(true);
+	pAggregateQueue->hasWorkLeft(true);
+	auto afterRun = chrono::high_resolution_clock::now();
+
+	// Clean up after ourselves.
+	delete(pParseQueue);
+	delete(pTransformQueue);
+	delete(pAggregateQueue);
+
+	*pChecksum = pipelineChecksum(allBuckets);
+	return(((double) chrono::duration_cast<chrono::microseconds>(afterRun - beforeRun).count()) / 1000.0);
+}
+
+double testQueuePipelineChannels(unsigned int numWorkers, vector<string> & allLines, unsigned long long int * pChecksum, size_t * pNumStages, Queue<void> * pQueue) {
+	// Parse in parallel, then transform and aggregate serially (which fuses them onto a single thread). Given a Queue,
+	// parsing and transforming run on its threads instead of ones of their own, with aggregating fused onto the latter.
+	unsigned long long int allBuckets[PIPELINE_NUM_BUCKETS] = {};
+	QueuePipeline<string> pipeline(PIPELINE_CHANNEL_CAPACITY);
+	auto parseFunc = [](string && line) {
+		return(pipelineParse(line));
+	};
+	auto transformFunc = [](PipelineRecord && record) {
+		return(pipelineTransform(record));
+	};
+	auto sinkFunc = [&allBuckets](PipelineRecord && record) {
+		allBuckets[record.bucket] += record.value;
+	};
+	if (pQueue != nullptr) {
+		pipeline.then<PipelineRecord>(pQueue, numWorkers, parseFunc).then<PipelineRecord>(pQueue, 1, transformFunc).sink(1, sinkFunc);
+	} else {
+		pipeline.then<PipelineRecord>(numWorkers, parseFunc).then<PipelineRecord>(1, transformFunc).sink(1, sinkFunc);
+	}
+
+	// Push every line (moving it, rather than copying it), and wait for them all to come out the other end.
+	auto beforeRun = chrono::high_resolution_clock::now();
+	for (string & line : allLines) {
+		pipeline.push(move(line));
+	}
+	pipeline.finish();
+	auto afterRun = chrono::high_resolution_clock::now();
+
+	*pChecksum  = pipelineChecksum(allBuckets);
+	*pNumStages = pipeline.getNumStages();
+	return(((double) chrono::duration_cast<chrono::microseconds>(afterRun - beforeRun).count()) / 1000.0);
+}
+
+void testQueuePipeline(unsigned int maxNumThreads) {
+	// The worker counts we'll test: powers of two, plus the max itself.
+	vector<unsigned int> allWorkerCounts = TestHelpers::workerCounts(maxNumThreads);
+
+	// Build our lines, and the checksum we expect, computed serially.
+	vector<string>         allLines = vector<string>();
+	unsigned long long int allBuckets[PIPELINE_NUM_BUCKETS] = {};
+	for (unsigned int lineIndex = 0; lineIndex < PIPELINE_NUM_LINES; ++lineIndex) {
+		allLines.push_back(to_string(lineIndex % PIPELINE_NUM_BUCKETS) + "," + to_string(((unsigned long long int) lineIndex) * 2654435761ULL));
+		PipelineRecord record = pipelineTransform(pipelineParse(allLines.back()));
+		allBuckets[record.bucket] += record.value;
+	}
+	unsigned long long int expectedChecksum = pipelineChecksum(allBuckets);
+
+	printf("==========================================================================================\n");
+	printf("=== Parse -> transform -> aggregate of %u lines: nested dispatch vs QueuePipeline (%u slots)\n", PIPELINE_NUM_LINES, PIPELINE_CHANNEL_CAPACITY);
+	printf("==========================================================================================\n");
+	for (unsigned int workerIndex = 0; workerIndex < allWorkerCounts.size(); ++workerIndex) {
+		unsigned int           numWorkers       = allWorkerCounts[workerIndex];
+		unsigned long long int nestedChecksum   = 0;
+		unsigned long long int channelChecksum  = 0;
+		unsigned long long int sharedChecksum   = 0;
+		size_t                 numStages        = 0;
+		size_t                 numSharedStages  = 0;
+		vector<string>         nestedLines      = allLines;
+		vector<string>         pipelineLines    = allLines;
+		vector<string>         sharedLines      = allLines;
+		double                 nestedMS         = testQueuePipelineNested(numWorkers, nestedLines, &nestedChecksum);
+		double                 pipelineMS       = testQueuePipelineChannels(numWorkers, pipelineLines, &channelChecksum, &numStages);
+
+		// The same pipeline, with its parallel and serial stages sharing one Queue.
+		Queue<void> * pSharedQueue = new Queue<void>(new QueueFunction<void>([]() {}), numWorkers + 1, true);
+		double        sharedMS     = testQueuePipelineChannels(numWorkers, sharedLines, &sharedChecksum, &numSharedStages, pSharedQueue);
+		delete pSharedQueue;
+
+		bool isCorrect = ((nestedChecksum == expectedChecksum) && (channelChecksum == expectedChecksum) && (sharedChecksum == expectedChecksum));
+		printf("[%2u Worker%s] Nested dispatch: %9.3f ms, pipeline (%zu stage%s after fusing): %s%9.3f ms%s (%.2fx), on one Queue: %9.3f ms (%s%s%s)\n",
+			numWorkers, (numWorkers == 1) ? " " : "s", nestedMS, numStages, (numStages == 1) ? "" : "s",
+			(pipelineMS < nestedMS) ? Colors::pColorGreen : Colors::pColorRed, pipelineMS, Colors::pColorReset, nestedMS / pipelineMS, sharedMS,
+			isCorrect ? Colors::pColorGreen : Colors::pColorRed, isCorrect ? "correct" : "INCORRECT", Colors::pColorReset);
+	}
+}
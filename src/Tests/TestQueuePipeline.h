@@ -0,0 +1,30 @@
+#ifndef __TEST_QUEUE_PIPELINE_H__
+#define __TEST_QUEUE_PIPELINE_H__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "DispatchCPP/DispatchCPP.h"
+#include "Colors.h"
+#include "TestHelpers.h"
+
+// The number of lines parsed, and the number of hashing passes each record's transform takes.
+#define PIPELINE_NUM_LINES              200000
+#define PIPELINE_WORK_ITERATIONS        64
+
+// The number of buckets records are aggregated into, and the number of values each channel holds.
+#define PIPELINE_NUM_BUCKETS            64
+#define PIPELINE_CHANNEL_CAPACITY       1024
+
+double testQueuePipelineNested(unsigned int numWorkers, vector<string> & allLines, unsigned long long int * pChecksum);
+double testQueuePipelineChannels(unsigned int numWorkers, vector<string> & allLines, unsigned long long int * pChecksum, size_t * pNumStages, DispatchCPP::Queue<void> * pQueue = nullptr);
+
+void testQueuePipeline(unsigned int maxNumThreads = 4);
+
+#endif // __TEST_QUEUE_PIPELINE_H__
@@ -0,0 +1,65 @@
+#include "TestQueueProducers.h"
+
+using namespace DispatchCPP;
+
+double testQueueProducersRun(unsigned int numWorkers, unsigned int numProducers, bool isBuffered, bool * pIsCorrect) {
+	// Our queue, which sums up every producer's work.
+	atomic<unsigned long long int> indexSum = 0;
+	atomic<unsigned int>           numDone  = 0;
+	Queue<void, unsigned int> * pQueue = new Queue<void, unsigned int>(
+		new QueueFunction<void, unsigned int>(
+			[&indexSum, &numDone](unsigned int taskIndex) {
+				indexSum.fetch_add(taskIndex, memory_order_relaxed);
+				numDone.fetch_add(1, memory_order_relaxed);
+			}
+		),
+		numWorkers,
+		true
+	);
+
+	// Have every producer dispatch its share at once, either straight onto the queue or through its own buffer.
+	unsigned int   numPerProducer = (PRODUCERS_NUM_TASKS / numProducers);
+	vector<thread> allProducers   = vector<thread>();
+	auto beforeRun = chrono::high_resolution_clock::now();
+	for (unsigned int producerIndex = 0; producerIndex < numProducers; ++producerIndex) {
+		allProducers.push_back(thread([pQueue, producerIndex, numPerProducer, isBuffered]() {
+			unsigned int firstIndex = (producerIndex * numPerProducer);
+			for (unsigned int taskIndex = firstIndex; taskIndex < (firstIndex + numPerProducer); ++taskIndex) {
+				if (isBuffered) {
+					pQueue->dispatchWorkBuffered(taskIndex);
+				} else {
+					pQueue->dispatchWork(taskIndex);
+				}
+			}
+		}));
+	}
+	for (thread & producer : allProducers) {
+		producer.join();
+	}
+	pQueue->hasWorkLeft(true);
+	auto afterRun = chrono::high_resolution_clock::now();
+
+	// Clean up after ourselves.
+	delete(pQueue);
+
+	unsigned long long int numTasks = ((unsigned long long int) numPerProducer * numProducers);
+	*pIsCorrect = ((numDone.load() == numTasks) && (indexSum.load() == ((numTasks * (numTasks - 1)) / 2)));
+	return(((double) chrono::duration_cast<chrono::microseconds>(afterRun - beforeRun).count()) / 1000.0);
+}
+
+void testQueueProducers(unsigned int maxNumThreads) {
+	printf("==========================================================================================\n");
+	printf("=== %u tasks from many producers on %u worker%s: shared lock vs per-producer buffers (%u per batch)\n", PRODUCERS_NUM_TASKS, maxNumThreads, (maxNumThreads == 1) ? "" : "s", QUEUE_PRODUCER_FLUSH_SIZE);
+	printf("==========================================================================================\n");
+	for (unsigned int numProducers = 1; numProducers <= PRODUCERS_MAX_PRODUCERS; numProducers *= 2) {
+		bool   isLockCorrect     = false;
+		bool   isBufferedCorrect = false;
+		double lockMS            = testQueueProducersRun(maxNumThreads, numProducers, false, &isLockCorrect);
+		double bufferedMS        = testQueueProducersRun(maxNumThreads, numProducers, true, &isBufferedCorrect);
+		bool   isCorrect         = (isLockCorrect && isBufferedCorrect);
+		printf("[%2u Producer%s] Shared lock: %9.3f ms (%6.2f M tasks/s), buffered: %s%9.3f ms (%6.2f M tasks/s)%s (%.2fx) (%s%s%s)\n",
+			numProducers, (numProducers == 1) ? " " : "s", lockMS, (PRODUCERS_NUM_TASKS / 1000.0) / lockMS,
+			(bufferedMS < lockMS) ? Colors::pColorGreen : Colors::pColorRed, bufferedMS, (PRODUCERS_NUM_TASKS / 1000.0) / bufferedMS, Colors::pColorReset, lockMS / bufferedMS,
+			isCorrect ? Colors::pColorGreen : Colors::pColorRed, isCorrect ? "correct" : "INCORRECT", Colors::pColorReset);
+	}
+}
@@ -0,0 +1,26 @@
+#ifndef __TEST_QUEUE_PRODUCERS_H__
+#define __TEST_QUEUE_PRODUCERS_H__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "DispatchCPP/DispatchCPP.h"
+#include "Colors.h"
+
+// The number of pieces of work dispatched in total, split between however many producers there are.
+#define PRODUCERS_NUM_TASKS             640000
+
+// The most producer threads we test with.
+#define PRODUCERS_MAX_PRODUCERS         32
+
+double testQueueProducersRun(unsigned int numWorkers, unsigned int numProducers, bool isBuffered, bool * pIsCorrect);
+
+void testQueueProducers(unsigned int maxNumThreads = 4);
+
+#endif // __TEST_QUEUE_PRODUCERS_H__
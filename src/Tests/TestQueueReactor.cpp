@@ -0,0 +1,294 @@
+#include "TestQueueReactor.h"
+
+using namespace DispatchCPP;
+
+// The server's CPU-bound segment for each message: hash it a number of times, and fold the result into a sink.
+static atomic<unsigned long long int> echoWorkSink(0);
+static void echoDoWork(const char * pMessage) {
+	echoWorkSink.fetch_xor(TestHelpers::hashBytes((const unsigned char *) pMessage, REACTOR_MESSAGE_SIZE, REACTOR_WORK_ITERATIONS), memory_order_relaxed);
+}
+
+// Creates a listening socket on an ephemeral loopback port, returning it and filling in the port.
+static int echoListen(unsigned short * pPort) {
+	struct sockaddr_in listenAddr;
+	socklen_t          listenAddrLen = sizeof(listenAddr);
+	memset(&listenAddr, 0, sizeof(listenAddr));
+	listenAddr.sin_family      = AF_INET;
+	listenAddr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	listenAddr.sin_port        = 0;
+	int listenFD = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if ((listenFD < 0) ||
+	    (bind(listenFD, (struct sockaddr *) &listenAddr, sizeof(listenAddr)) != 0) ||
+	    (listen(listenFD, SOMAXCONN) != 0) ||
+	    (getsockname(listenFD, (struct sockaddr *) &listenAddr, &listenAddrLen) != 0)) {
+		if (listenFD >= 0) {
+			close(listenFD);
+		}
+		return(-1);
+	}
+	*pPort = ntohs(listenAddr.sin_port);
+	return(listenFD);
+}
+
+// Starts all our clients. Each connects, then repeatedly thinks, sends a message, and waits on its echo.
+static vector<thread> echoStartClients(unsigned short port, atomic<unsigned int> * pNumFailures) {
+	vector<thread> allClients = vector<thread>();
+	for (unsigned int clientIndex = 0; clientIndex < REACTOR_NUM_CLIENTS; ++clientIndex) {
+		allClients.push_back(thread([port, clientIndex, pNumFailures]() {
+			struct sockaddr_in serverAddr;
+			memset(&serverAddr, 0, sizeof(serverAddr));
+			serverAddr.sin_family      = AF_INET;
+			serverAddr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+			serverAddr.sin_port        = htons(port);
+			int clientFD = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+			if ((clientFD < 0) || (connect(clientFD, (struct sockaddr *) &serverAddr, sizeof(serverAddr)) != 0)) {
+				*pNumFailures += REACTOR_NUM_MESSAGES;
+				if (clientFD >= 0) {
+					close(clientFD);
+				}
+				return;
+			}
+			int noDelay = 1;
+			setsockopt(clientFD, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+
+			char sendBuffer[REACTOR_MESSAGE_SIZE];
+			char recvBuffer[REACTOR_MESSAGE_SIZE];
+			for (unsigned int messageIndex = 0; messageIndex < REACTOR_NUM_MESSAGES; ++messageIndex) {
+				usleep(REACTOR_CLIENT_THINK_US);
+				for (unsigned int index = 0; index < REACTOR_MESSAGE_SIZE; ++index) {
+					sendBuffer[index] = ((char) (clientIndex + messageIndex + index));
+				}
+				bool hitError = (send(clientFD, sendBuffer, REACTOR_MESSAGE_SIZE, MSG_NOSIGNAL) != REACTOR_MESSAGE_SIZE);
+				if (!hitError) {
+					hitError = (recv(clientFD, recvBuffer, REACTOR_MESSAGE_SIZE, MSG_WAITALL) != REACTOR_MESSAGE_SIZE);
+				}
+				if (hitError || (memcmp(sendBuffer, recvBuffer, REACTOR_MESSAGE_SIZE) != 0)) {
+					*pNumFailures += 1;
+				}
+			}
+			close(clientFD);
+		}));
+	}
+	return(allClients);
+}
+
+double testQueueReactorEchoBlocking(unsigned int numThreads, unsigned int * pNumFailures) {
+	atomic<unsigned int> numFailures(0);
+	unsigned short       port     = 0;
+	int                  listenFD = echoListen(&port);
+	if (listenFD < 0) {
+		*pNumFailures = (REACTOR_NUM_CLIENTS * REACTOR_NUM_MESSAGES);
+		return(0.0);
+	}
+
+	// Declare our Queue, each dispatch of which serves one connection until it closes, blocking in recv() between messages.
+	Queue<void, int> * pServerQueue = new Queue<void, int>(
+		new QueueFunction<void, int>(
+			[](int connectionFD) {
+				char messageBuffer[REACTOR_MESSAGE_SIZE];
+				while (recv(connectionFD, messageBuffer, REACTOR_MESSAGE_SIZE, MSG_WAITALL) == REACTOR_MESSAGE_SIZE) {
+					echoDoWork(messageBuffer);
+					if (send(connectionFD, messageBuffer, REACTOR_MESSAGE_SIZE, MSG_NOSIGNAL) != REACTOR_MESSAGE_SIZE) {
+						break;
+					}
+				}
+				close(connectionFD);
+			}
+		),
+		numThreads,
+		true
+	);
+
+	// Start our timer, and our clients.
+	auto           beforeEcho = chrono::high_resolution_clock::now();
+	vector<thread> allClients = echoStartClients(port, &numFailures);
+
+	// Accept each connection, and dispatch it to be served.
+	for (unsigned int clientIndex = 0; clientIndex < REACTOR_NUM_CLIENTS; ++clientIndex) {
+		int connectionFD = accept4(listenFD, NULL, NULL, SOCK_CLOEXEC);
+		if (connectionFD >= 0) {
+			int noDelay = 1;
+			setsockopt(connectionFD, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+			pServerQueue->dispatchWork(connectionFD);
+		}
+	}
+
+	// Wait for every client to finish, and for the server to drain.
+	for (unsigned int clientIndex = 0; clientIndex < allClients.size(); ++clientIndex) {
+		allClients[clientIndex].join();
+	}
+	pServerQueue->hasWorkLeft(true);
+
+	// End our timer.
+	auto afterEcho = chrono::high_resolution_clock::now();
+
+	// Clean up after ourselves.
+	delete(pServerQueue);
+	close(listenFD);
+
+	*pNumFailures = numFailures.load();
+	return((double) chrono::duration_cast<chrono::microseconds>(afterEcho - beforeEcho).count());
+}
+
+// The server's state for each connection when it's driven by the reactor.
+typedef struct __REACTOR_ECHO_CONNECTION__ {
+	int          connectionFD;
+	char         messageBuffer[REACTOR_MESSAGE_SIZE];
+	unsigned int numBuffered;
+} ReactorEchoConnection;
+
+double testQueueReactorEchoReactor(unsigned int numThreads, unsigned int * pNumFailures) {
+	atomic<unsigned int> numFailures(0);
+	atomic<unsigned int> numClosed(0);
+	unsigned short       port     = 0;
+	int                  listenFD = echoListen(&port);
+	if (listenFD < 0) {
+		*pNumFailures = (REACTOR_NUM_CLIENTS * REACTOR_NUM_MESSAGES);
+		return(0.0);
+	}
+
+	// Declare our reactor and our Queue. The Queue does nothing of its own; it only runs continuations.
+	QueueReactor                  reactor;
+	vector<ReactorEchoConnection> allConnections = vector<ReactorEchoConnection>(REACTOR_NUM_CLIENTS);
+	Queue<void>                 * pServerQueue   = new Queue<void>(
+		new QueueFunction<void>(
+			[]() {}
+		),
+		numThreads,
+		true
+	);
+
+	// Our continuation: drain whatever's arrived, echo every whole message, and either re-arm or close.
+	function<void(unsigned int)> onReadable = nullptr;
+	onReadable = [&allConnections, &reactor, &pServerQueue, &numClosed, &onReadable](unsigned int connectionIndex) {
+		ReactorEchoConnection * pConnection  = &(allConnections[connectionIndex]);
+		int                     connectionFD = pConnection->connectionFD;
+		bool                    isClosed     = false;
+		while (true) {
+			ssize_t numRead = recv(connectionFD, pConnection->messageBuffer + pConnection->numBuffered, REACTOR_MESSAGE_SIZE - pConnection->numBuffered, 0);
+			if (numRead > 0) {
+				pConnection->numBuffered += numRead;
+				if (pConnection->numBuffered == REACTOR_MESSAGE_SIZE) {
+					echoDoWork(pConnection->messageBuffer);
+					if (send(connectionFD, pConnection->messageBuffer, REACTOR_MESSAGE_SIZE, MSG_NOSIGNAL) != REACTOR_MESSAGE_SIZE) {
+						isClosed = true;
+						break;
+					}
+					pConnection->numBuffered = 0;
+				}
+				continue;
+			}
+			isClosed = ((numRead == 0) || ((errno != EAGAIN) && (errno != EWOULDBLOCK)));
+			break;
+		}
+
+		// Either give this worker back until the next message arrives, or we're done with this connection.
+		if (!isClosed) {
+			reactor.watchFD(connectionFD, EPOLLIN, pServerQueue, [&onReadable, connectionIndex](int readyFD, uint32_t readyEvents) {
+				onReadable(connectionIndex);
+			});
+		} else {
+			reactor.unwatchFD(connectionFD);
+			close(connectionFD);
+			numClosed += 1;
+		}
+	};
+
+	// Start our timer, and our clients.
+	auto           beforeEcho = chrono::high_resolution_clock::now();
+	vector<thread> allClients = echoStartClients(port, &numFailures);
+
+	// Accept each connection, and hand it to the reactor.
+	unsigned int numAccepted = 0;
+	for (unsigned int clientIndex = 0; clientIndex < REACTOR_NUM_CLIENTS; ++clientIndex) {
+		int connectionFD = accept4(listenFD, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+		if (connectionFD >= 0) {
+			int noDelay = 1;
+			setsockopt(connectionFD, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+			allConnections[numAccepted].connectionFD = connectionFD;
+			allConnections[numAccepted].numBuffered  = 0;
+			numAccepted += 1;
+		}
+	}
+	for (unsigned int index = 0; index < numAccepted; ++index) {
+		reactor.watchFD(allConnections[index].connectionFD, EPOLLIN, pServerQueue, [&onReadable, index](int readyFD, uint32_t readyEvents) {
+			onReadable(index);
+		});
+	}
+
+	// Wait for every client to finish, and for every connection to close out.
+	for (unsigned int clientIndex = 0; clientIndex < allClients.size(); ++clientIndex) {
+		allClients[clientIndex].join();
+	}
+	while (numClosed.load() < numAccepted) {
+		usleep(50);
+	}
+	pServerQueue->hasWorkLeft(true);
+
+	// End our timer.
+	auto afterEcho = chrono::high_resolution_clock::now();
+
+	// Clean up after ourselves.
+	delete(pServerQueue);
+	close(listenFD);
+
+	*pNumFailures = numFailures.load();
+	return((double) chrono::duration_cast<chrono::microseconds>(afterEcho - beforeEcho).count());
+}
+
+void testQueueReactor(unsigned int maxNumThreads) {
+	double numMessages = ((double) (REACTOR_NUM_CLIENTS * REACTOR_NUM_MESSAGES));
+
+	printf("==========================================================================================\n");
+	printf("=== Echo: %u clients, %u messages each, %u uS think time, %u byte messages\n", REACTOR_NUM_CLIENTS, REACTOR_NUM_MESSAGES, REACTOR_CLIENT_THINK_US, REACTOR_MESSAGE_SIZE);
+	printf("==========================================================================================\n");
+
+	// Blocking workers, one connection per dispatch. These need a thread per connection to keep every client busy.
+	vector<unsigned int> allBlockingThreadCounts = vector<unsigned int>();
+	vector<double>       allBlockingThroughputs  = vector<double>();
+	for (unsigned int numThreads = 1; numThreads <= REACTOR_NUM_CLIENTS; numThreads *= 2) {
+		unsigned int numFailures     = 0;
+		double       numMicroseconds = testQueueReactorEchoBlocking(numThreads, &numFailures);
+		double       throughput      = (numMessages / (numMicroseconds / 1000000.0));
+		allBlockingThreadCounts.push_back(numThreads);
+		allBlockingThroughputs.push_back(throughput);
+		printf("[Blocking] %3u Thread%s => %10.1f echoes/s", numThreads, (numThreads == 1) ? " " : "s", throughput);
+		if (numFailures > 0) {
+			printf(" %s%u FAILED%s", Colors::pColorRed, numFailures, Colors::pColorReset);
+		}
+		printf("\n");
+	}
+	printf("------------------------------------------------------------------------------------------\n");
+
+	// Reactor-driven workers, which are only held while there's a message to process: powers of two, plus the max itself.
+	vector<unsigned int> allReactorThreadCounts = TestHelpers::workerCounts(maxNumThreads);
+	for (unsigned int numThreads : allReactorThreadCounts) {
+		unsigned int numFailures     = 0;
+		double       numMicroseconds = testQueueReactorEchoReactor(numThreads, &numFailures);
+		double       throughput      = (numMessages / (numMicroseconds / 1000000.0));
+
+		// Find the fewest blocking threads which kept up with this.
+		unsigned int numBlockingToMatch = 0;
+		for (unsigned int index = 0; index < allBlockingThroughputs.size(); ++index) {
+			if (allBlockingThroughputs[index] >= throughput) {
+				numBlockingToMatch = allBlockingThreadCounts[index];
+				break;
+			}
+		}
+		printf("[Reactor]  %3u Thread%s => %10.1f echoes/s (%s",
+			numThreads,
+			(numThreads == 1) ? " " : "s",
+			throughput,
+			Colors::pColorGreen);
+		if (numBlockingToMatch > 0) {
+			printf("blocking needed %u threads to match", numBlockingToMatch);
+		} else {
+			printf("blocking never matched this");
+		}
+		printf("%s)", Colors::pColorReset);
+		if (numFailures > 0) {
+			printf(" %s%u FAILED%s", Colors::pColorRed, numFailures, Colors::pColorReset);
+		}
+		printf("\n");
+	}
+}
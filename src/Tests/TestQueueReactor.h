@@ -0,0 +1,41 @@
+#ifndef __TEST_QUEUE_REACTOR_H__
+#define __TEST_QUEUE_REACTOR_H__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "DispatchCPP/DispatchCPP.h"
+#include "Colors.h"
+#include "TestHelpers.h"
+
+// The number of concurrent client connections, and the number of echoes each client waits on.
+#define REACTOR_NUM_CLIENTS         64
+#define REACTOR_NUM_MESSAGES        50
+
+// How long each client thinks between receiving an echo and sending its next message.
+#define REACTOR_CLIENT_THINK_US     500
+
+// The size of every message echoed, and the number of hashing passes the server makes over each (its CPU-bound segment).
+#define REACTOR_MESSAGE_SIZE        64
+#define REACTOR_WORK_ITERATIONS     64
+
+double testQueueReactorEchoBlocking(unsigned int numThreads, unsigned int * pNumFailures);
+double testQueueReactorEchoReactor(unsigned int numThreads, unsigned int * pNumFailures);
+
+void testQueueReactor(unsigned int maxNumThreads = 4);
+
+#endif // __TEST_QUEUE_REACTOR_H__
@@ -0,0 +1,128 @@
+#include "TestQueueScan.h"
+
+using namespace DispatchCPP;
+
+// Our predicate for compaction and partitioning: keep roughly half of the entries.
+static inline bool scanKeep(unsigned int value) {
+	return((value & 0x10) != 0);
+}
+
+double testQueueScanRun(vector<unsigned int> * pInput, vector<unsigned int> * pOutput, function<void(void)> scanFunc) {
+	// Run it, now.
+	auto beforeRun = chrono::high_resolution_clock::now();
+	scanFunc();
+	auto afterRun = chrono::high_resolution_clock::now();
+
+	// Return the number of milliseconds it took.
+	return(((double) chrono::duration_cast<chrono::microseconds>(afterRun - beforeRun).count()) / 1000.0);
+}
+
+// Convenience function for printing a timing against its baseline, and whether it matched.
+static void printResult(const char * pLabel, double numMS, double baseMS, bool isCorrect) {
+	printf("%s %9.2f mS (%s%5.2fx%s)%s\n",
+		pLabel, numMS,
+		((numMS < baseMS) ? Colors::pColorGreen : Colors::pColorRed), (baseMS / numMS), Colors::pColorReset,
+		(isCorrect ? "" : " MISMATCH"));
+}
+
+void testQueueScan(unsigned int maxNumThreads) {
+	// The worker counts we'll test: powers of two, plus the max itself.
+	vector<unsigned int> allWorkerCounts = TestHelpers::workerCounts(maxNumThreads);
+
+	// Work out how much memory we're willing to use.
+	double maxBytes = (((double) sysconf(_SC_PHYS_PAGES)) * ((double) sysconf(_SC_PAGESIZE)) * SCAN_MAX_MEMORY_FRACTION);
+
+	for (unsigned long long int numEntries = SCAN_MIN_ENTRIES; numEntries <= SCAN_MAX_ENTRIES; numEntries *= 10) {
+		printf("==========================================================================================\n");
+		printf("=== %llu entries\n", numEntries);
+		printf("==========================================================================================\n");
+
+		// Make sure our input, output and each of the four references all fit.
+		double neededBytes = (6.0 * ((double) numEntries) * sizeof(unsigned int));
+		if (neededBytes > maxBytes) {
+			printf("%sSkipped: needs %.1f GB, only %.1f GB allowed%s\n", Colors::pColorMagenta, neededBytes / 1e9, maxBytes / 1e9, Colors::pColorReset);
+			continue;
+		}
+
+		// Fill our input with randomness we can expect.
+		vector<unsigned int> input     = vector<unsigned int>(numEntries);
+		vector<unsigned int> output    = vector<unsigned int>(numEntries);
+		vector<unsigned int> reference = vector<unsigned int>();
+		srand(123456);
+		for (unsigned long long int index = 0; index < numEntries; ++index) {
+			input[index] = ((unsigned int) rand());
+		}
+
+		// Our baselines, each of which also gives us the reference to check against.
+		double inclusiveBaseMS = testQueueScanRun(&input, &output, [&input, &output]() {
+			inclusive_scan(input.begin(), input.end(), output.begin());
+		});
+		vector<unsigned int> inclusiveReference = output;
+		printf("[std::inclusive_scan   ] %9.2f mS\n", inclusiveBaseMS);
+
+		double exclusiveBaseMS = testQueueScanRun(&input, &output, [&input, &output]() {
+			exclusive_scan(input.begin(), input.end(), output.begin(), 0U);
+		});
+		vector<unsigned int> exclusiveReference = output;
+		printf("[std::exclusive_scan   ] %9.2f mS\n", exclusiveBaseMS);
+
+		size_t numKept        = 0;
+		double copyIfBaseMS   = testQueueScanRun(&input, &output, [&input, &output, &numKept]() {
+			numKept = (size_t) (copy_if(input.begin(), input.end(), output.begin(), scanKeep) - output.begin());
+		});
+		vector<unsigned int> copyIfReference = vector<unsigned int>(output.begin(), output.begin() + numKept);
+		printf("[std::copy_if          ] %9.2f mS\n", copyIfBaseMS);
+
+		output = input;
+		double partitionBaseMS = testQueueScanRun(&input, &output, [&output]() {
+			stable_partition(output.begin(), output.end(), scanKeep);
+		});
+		vector<unsigned int> partitionReference = output;
+		printf("[std::stable_partition ] %9.2f mS\n", partitionBaseMS);
+
+		// Now our own, across each worker count.
+		for (unsigned int workerIndex = 0; workerIndex < allWorkerCounts.size(); ++workerIndex) {
+			unsigned int numWorkers = allWorkerCounts[workerIndex];
+			printf("------------------------------------------------------------------------------------------\n");
+
+			// Declare the Queue whose threads our scans run on. Its own function is never used.
+			Queue<void> * pScanQueue = new Queue<void>(
+				new QueueFunction<void>(
+					[]() {}
+				),
+				numWorkers,
+				true
+			);
+
+			char label[64];
+			snprintf(label, sizeof(label), "[%2u Worker%s] InclusiveScan", numWorkers, (numWorkers == 1) ? " " : "s");
+			double numMS = testQueueScanRun(&input, &output, [pScanQueue, &input, &output]() {
+				parallelInclusiveScan(pScanQueue, input.begin(), input.end(), output.begin());
+			});
+			printResult(label, numMS, inclusiveBaseMS, (output == inclusiveReference));
+
+			snprintf(label, sizeof(label), "[%2u Worker%s] ExclusiveScan", numWorkers, (numWorkers == 1) ? " " : "s");
+			numMS = testQueueScanRun(&input, &output, [pScanQueue, &input, &output]() {
+				parallelExclusiveScan(pScanQueue, input.begin(), input.end(), output.begin(), 0U);
+			});
+			printResult(label, numMS, exclusiveBaseMS, (output == exclusiveReference));
+
+			snprintf(label, sizeof(label), "[%2u Worker%s] CopyIf       ", numWorkers, (numWorkers == 1) ? " " : "s");
+			size_t numCopied = 0;
+			numMS = testQueueScanRun(&input, &output, [pScanQueue, &input, &output, &numCopied]() {
+				numCopied = (size_t) (parallelCopyIf(pScanQueue, input.begin(), input.end(), output.begin(), scanKeep) - output.begin());
+			});
+			printResult(label, numMS, copyIfBaseMS, ((numCopied == numKept) && equal(copyIfReference.begin(), copyIfReference.end(), output.begin())));
+
+			snprintf(label, sizeof(label), "[%2u Worker%s] Partition    ", numWorkers, (numWorkers == 1) ? " " : "s");
+			output = input;
+			numMS = testQueueScanRun(&input, &output, [pScanQueue, &output]() {
+				parallelPartition(pScanQueue, output.begin(), output.end(), scanKeep);
+			});
+			printResult(label, numMS, partitionBaseMS, (output == partitionReference));
+
+			// Delete our scan queue, now.
+			delete(pScanQueue);
+		}
+	}
+}
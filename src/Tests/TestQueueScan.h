@@ -0,0 +1,30 @@
+#ifndef __TEST_QUEUE_SCAN_H__
+#define __TEST_QUEUE_SCAN_H__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <numeric>
+#include <vector>
+
+#include "DispatchCPP/DispatchCPP.h"
+#include "Colors.h"
+#include "TestHelpers.h"
+
+// The range of sizes we scan, each 10x the last. Sizes which wouldn't fit in memory (alongside the references every
+// result is checked against) are skipped.
+#define SCAN_MIN_ENTRIES            1000000ULL
+#define SCAN_MAX_ENTRIES            1000000000ULL
+
+// The fraction of physical memory a single run is allowed to use.
+#define SCAN_MAX_MEMORY_FRACTION    0.5
+
+double testQueueScanRun(vector<unsigned int> * pInput, vector<unsigned int> * pOutput, function<void(void)> scanFunc);
+
+void testQueueScan(unsigned int maxNumThreads = 4);
+
+#endif // __TEST_QUEUE_SCAN_H__
@@ -0,0 +1,118 @@
+#include "TestQueueSpill.h"
+
+using namespace DispatchCPP;
+
+// Returns our resident memory, in MB.
+static double spillResidentMB() {
+	FILE * pStatFile = fopen("/proc/self/statm", "r");
+	if (pStatFile == nullptr) {
+		return(0.0);
+	}
+	unsigned long long int numPages    = 0;
+	unsigned long long int numResident = 0;
+	if (fscanf(pStatFile, "%llu %llu", &numPages, &numResident) != 2) {
+		numResident = 0;
+	}
+	fclose(pStatFile);
+	return(((double) numResident * (double) sysconf(_SC_PAGESIZE)) / (1024.0 * 1024.0));
+}
+
+// Each piece of work: hash its payload, a few times over.
+static unsigned long long int spillDoWork(const SpillPayload & payload) {
+	return(TestHelpers::hashBytes(payload.data, SPILL_PAYLOAD_SIZE, SPILL_WORK_ROUNDS));
+}
+
+double testQueueSpillRun(unsigned int numWorkers, bool enableSpill, double * pDispatchMS, double * pPeakMB, size_t * pMaxSpilled, bool * pIsCorrect) {
+	// Our queue, which checks every piece of work arrives (and, with a single worker, arrives in order).
+	atomic<unsigned long long int> numDone   = 0;
+	atomic<unsigned long long int> indexSum  = 0;
+	atomic<bool>                   isInOrder = true;
+	unsigned int                   nextIndex = 0;
+	Queue<void, SpillPayload> * pQueue = new Queue<void, SpillPayload>(
+		new QueueFunction<void, SpillPayload>(
+			[&, numWorkers](SpillPayload payload) {
+				if ((numWorkers == 1) && ((payload.index != (nextIndex++)) || (payload.data[0] != ((unsigned char) payload.index)))) {
+					isInOrder = false;
+				}
+				if (spillDoWork(payload) != 0) {
+					indexSum.fetch_add(payload.index, memory_order_relaxed);
+				}
+				numDone.fetch_add(1, memory_order_relaxed);
+			}
+		),
+		numWorkers,
+		true
+	);
+	if (enableSpill) {
+		pQueue->setSpill(SPILL_MAX_IN_MEMORY);
+	}
+
+	// Sample our resident memory while we run.
+	atomic<bool> keepSampling = true;
+	double       baselineMB   = spillResidentMB();
+	double       peakMB       = baselineMB;
+	size_t       maxSpilled   = 0;
+	thread samplerThread = thread([&]() {
+		while (keepSampling) {
+			peakMB     = max(peakMB, spillResidentMB());
+			maxSpilled = max(maxSpilled, pQueue->getNumSpilled());
+			usleep(SPILL_SAMPLE_INTERVAL_US);
+		}
+	});
+
+	// Dispatch at a steady rate, faster than it can be worked through, then wait for the backlog to drain.
+	auto         beforeRun = chrono::high_resolution_clock::now();
+	SpillPayload payload;
+	for (unsigned int itemIndex = 0; itemIndex < SPILL_NUM_ITEMS; ++itemIndex) {
+		if ((itemIndex % SPILL_PACE_BATCH) == 0) {
+			this_thread::sleep_until(beforeRun + chrono::microseconds((((unsigned long long int) itemIndex) * 1000000ULL) / SPILL_ARRIVAL_RATE));
+		}
+		payload.index = itemIndex;
+		memset(payload.data, (int) (itemIndex & 0xFF), SPILL_PAYLOAD_SIZE);
+		pQueue->dispatchWork(payload);
+	}
+	auto afterDispatch = chrono::high_resolution_clock::now();
+	pQueue->hasWorkLeft(true);
+	auto afterRun = chrono::high_resolution_clock::now();
+	keepSampling = false;
+	samplerThread.join();
+
+	// Clean up after ourselves, handing freed memory back so it doesn't hide the next run's growth.
+	delete(pQueue);
+	malloc_trim(0);
+
+	unsigned long long int expectedSum = ((((unsigned long long int) SPILL_NUM_ITEMS) * (SPILL_NUM_ITEMS - 1)) / 2);
+	*pDispatchMS = (((double) chrono::duration_cast<chrono::microseconds>(afterDispatch - beforeRun).count()) / 1000.0);
+	*pPeakMB     = (peakMB - baselineMB);
+	*pMaxSpilled = maxSpilled;
+	*pIsCorrect  = ((numDone.load() == SPILL_NUM_ITEMS) && (indexSum.load() == expectedSum) && isInOrder.load());
+	return(((double) chrono::duration_cast<chrono::microseconds>(afterRun - beforeRun).count()) / 1000.0);
+}
+
+void testQueueSpill(unsigned int maxNumThreads) {
+	// The worker counts we'll test: powers of two, plus the max itself.
+	vector<unsigned int> allWorkerCounts = TestHelpers::workerCounts(maxNumThreads);
+
+	printf("==========================================================================================\n");
+	printf("=== %u x %zu byte work items, dispatched steadily at %.2f M/s: in memory vs spilling past %u items\n", SPILL_NUM_ITEMS, sizeof(SpillPayload), SPILL_ARRIVAL_RATE / 1000000.0, SPILL_MAX_IN_MEMORY);
+	printf("==========================================================================================\n");
+	for (unsigned int workerIndex = 0; workerIndex < allWorkerCounts.size(); ++workerIndex) {
+		unsigned int numWorkers = allWorkerCounts[workerIndex];
+		double       offPeakMB  = 0.0;
+		for (unsigned int spillIndex = 0; spillIndex < 2; ++spillIndex) {
+			bool   enableSpill = (spillIndex == 1);
+			double dispatchMS  = 0.0;
+			double peakMB      = 0.0;
+			size_t maxSpilled  = 0;
+			bool   isCorrect   = false;
+			double totalMS     = testQueueSpillRun(numWorkers, enableSpill, &dispatchMS, &peakMB, &maxSpilled, &isCorrect);
+			if (!enableSpill) {
+				offPeakMB = peakMB;
+			}
+			printf("[%2u Worker%s] Spill %-3s: %9.3f ms total (%6.2f M items/s, dispatched in %9.3f ms), peak RSS +%s%8.1f MB%s, up to %7zu spilled (%s%s%s)\n",
+				numWorkers, (numWorkers == 1) ? " " : "s", enableSpill ? "on" : "off", totalMS, (SPILL_NUM_ITEMS / 1000.0) / totalMS, dispatchMS,
+				!enableSpill ? Colors::pColorReset : ((peakMB < offPeakMB) ? Colors::pColorGreen : Colors::pColorRed), peakMB, Colors::pColorReset, maxSpilled,
+				isCorrect ? Colors::pColorGreen : Colors::pColorRed, isCorrect ? "correct" : "INCORRECT", Colors::pColorReset);
+		}
+	}
+}
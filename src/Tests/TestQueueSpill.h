@@ -0,0 +1,42 @@
+#ifndef __TEST_QUEUE_SPILL_H__
+#define __TEST_QUEUE_SPILL_H__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <malloc.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "DispatchCPP/DispatchCPP.h"
+#include "Colors.h"
+#include "TestHelpers.h"
+
+// The number of pieces of work dispatched, the size of each one's payload, and how many times each piece hashes it.
+#define SPILL_NUM_ITEMS                 500000
+#define SPILL_PAYLOAD_SIZE              240
+#define SPILL_WORK_ROUNDS               8
+
+// How fast work is dispatched, steadily, in pieces per second: well past what the workers get through, so the backlog
+// keeps growing (and spilling, and being read back) for as long as we dispatch. We check the clock every so many pieces.
+#define SPILL_ARRIVAL_RATE              1000000
+#define SPILL_PACE_BATCH                1000
+
+// The most work held in memory once spilling, and how often we sample our resident memory.
+#define SPILL_MAX_IN_MEMORY             10000
+#define SPILL_SAMPLE_INTERVAL_US        5000
+
+// A piece of work's arguments.
+typedef struct __SPILL_PAYLOAD__ {
+	unsigned int  index;
+	unsigned char data[SPILL_PAYLOAD_SIZE];
+} SpillPayload;
+
+double testQueueSpillRun(unsigned int numWorkers, bool enableSpill, double * pDispatchMS, double * pPeakMB, size_t * pMaxSpilled, bool * pIsCorrect);
+
+void testQueueSpill(unsigned int maxNumThreads = 4);
+
+#endif // __TEST_QUEUE_SPILL_H__
@@ -0,0 +1,100 @@
+#include "TestQueueTenants.h"
+
+using namespace DispatchCPP;
+
+// Returns the current time, in steady_clock nanoseconds.
+static long long int tenantsNowNS() {
+	return((long long int) chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+// Each task's work: hash a value a number of times, and fold the result into a sink.
+static atomic<unsigned long long int> tenantsWorkSink(0);
+static void tenantsDoWork(unsigned int seed) {
+	tenantsWorkSink.fetch_xor(TestHelpers::hashWork(seed, TENANTS_WORK_ITERATIONS), memory_order_relaxed);
+}
+
+double testQueueTenantsRun(unsigned int numWorkers, bool useHierarchy, vector<double> & allLightLatenciesUS) {
+	// How long each light task waited to start.
+	allLightLatenciesUS = vector<double>(TENANTS_NUM_LIGHT * TENANTS_LIGHT_NUM_TASKS, 0.0);
+
+	// Every tenant's work: a tenant index (flooding is TENANTS_NUM_LIGHT), a task index, and when it was dispatched.
+	QueueFunction<void, unsigned int, unsigned int, long long int> * pTenantFunc = new QueueFunction<void, unsigned int, unsigned int, long long int>(
+		[&](unsigned int tenantIndex, unsigned int taskIndex, long long int dispatchNS) {
+			if (tenantIndex < TENANTS_NUM_LIGHT) {
+				allLightLatenciesUS[(tenantIndex * TENANTS_LIGHT_NUM_TASKS) + taskIndex] = (((double) (tenantsNowNS() - dispatchNS)) / 1000.0);
+			}
+			tenantsDoWork(taskIndex);
+		}
+	);
+
+	// Our shared Queue, and (when using a hierarchy) a Queue per tenant targeting it. Otherwise every tenant dispatches
+	// straight onto the shared Queue.
+	Queue<void, unsigned int, unsigned int, long long int> * pSharedQueue = new Queue<void, unsigned int, unsigned int, long long int>(pTenantFunc, numWorkers);
+	vector<Queue<void, unsigned int, unsigned int, long long int> *> allTenantQueues = vector<Queue<void, unsigned int, unsigned int, long long int> *>();
+	for (unsigned int tenantIndex = 0; tenantIndex <= TENANTS_NUM_LIGHT; ++tenantIndex) {
+		if (useHierarchy) {
+			allTenantQueues.push_back(new Queue<void, unsigned int, unsigned int, long long int>(pTenantFunc, 1));
+			allTenantQueues.back()->setTargetQueue(pSharedQueue);
+		} else {
+			allTenantQueues.push_back(pSharedQueue);
+		}
+	}
+
+	// Flood the queue, then have each light tenant dispatch its work at its own pace.
+	auto beforeRun = chrono::high_resolution_clock::now();
+	for (unsigned int taskIndex = 0; taskIndex < TENANTS_FLOOD_NUM_TASKS; ++taskIndex) {
+		allTenantQueues[TENANTS_NUM_LIGHT]->dispatchWork(TENANTS_NUM_LIGHT, taskIndex, tenantsNowNS());
+	}
+	vector<thread> allLightThreads = vector<thread>();
+	for (unsigned int tenantIndex = 0; tenantIndex < TENANTS_NUM_LIGHT; ++tenantIndex) {
+		allLightThreads.push_back(thread([&allTenantQueues, tenantIndex]() {
+			for (unsigned int taskIndex = 0; taskIndex < TENANTS_LIGHT_NUM_TASKS; ++taskIndex) {
+				allTenantQueues[tenantIndex]->dispatchWork(tenantIndex, taskIndex, tenantsNowNS());
+				usleep(TENANTS_LIGHT_INTERVAL_US);
+			}
+		}));
+	}
+	for (unsigned int tenantIndex = 0; tenantIndex < TENANTS_NUM_LIGHT; ++tenantIndex) {
+		allLightThreads[tenantIndex].join();
+	}
+	for (unsigned int tenantIndex = 0; tenantIndex <= TENANTS_NUM_LIGHT; ++tenantIndex) {
+		allTenantQueues[tenantIndex]->hasWorkLeft(true);
+	}
+	pSharedQueue->hasWorkLeft(true);
+	auto afterRun = chrono::high_resolution_clock::now();
+
+	// Clean up after ourselves, children first.
+	if (useHierarchy) {
+		for (unsigned int tenantIndex = 0; tenantIndex <= TENANTS_NUM_LIGHT; ++tenantIndex) {
+			delete(allTenantQueues[tenantIndex]);
+		}
+	}
+	delete(pSharedQueue);
+	delete(pTenantFunc);
+
+	sort(allLightLatenciesUS.begin(), allLightLatenciesUS.end());
+	return(((double) chrono::duration_cast<chrono::microseconds>(afterRun - beforeRun).count()) / 1000.0);
+}
+
+void testQueueTenants(unsigned int maxNumThreads) {
+	// The worker counts we'll test: powers of two, plus the max itself.
+	vector<unsigned int> allWorkerCounts = TestHelpers::workerCounts(maxNumThreads);
+
+	printf("==========================================================================================\n");
+	printf("=== 1 tenant flooding %u tasks, %u light tenants dispatching %u tasks every %uus\n", TENANTS_FLOOD_NUM_TASKS, TENANTS_NUM_LIGHT, TENANTS_LIGHT_NUM_TASKS, TENANTS_LIGHT_INTERVAL_US);
+	printf("==========================================================================================\n");
+	for (unsigned int workerIndex = 0; workerIndex < allWorkerCounts.size(); ++workerIndex) {
+		unsigned int numWorkers = allWorkerCounts[workerIndex];
+		for (unsigned int modeIndex = 0; modeIndex < 2; ++modeIndex) {
+			bool           useHierarchy  = (modeIndex == 1);
+			vector<double> allLatenciesUS;
+			double         totalMS       = testQueueTenantsRun(numWorkers, useHierarchy, allLatenciesUS);
+			size_t         numLatencies  = allLatenciesUS.size();
+			printf("[%2u Worker%s] %s: %9.3f ms, light latency p50 %s%9.1f uS%s p99 %s%9.1f uS%s max %9.1f uS\n",
+				numWorkers, (numWorkers == 1) ? " " : "s", useHierarchy ? "Fair (DRR)" : "Shared    ", totalMS,
+				useHierarchy ? Colors::pColorGreen : "", allLatenciesUS[numLatencies / 2], useHierarchy ? Colors::pColorReset : "",
+				useHierarchy ? Colors::pColorGreen : "", allLatenciesUS[(numLatencies * 99) / 100], useHierarchy ? Colors::pColorReset : "",
+				allLatenciesUS[numLatencies - 1]);
+		}
+	}
+}
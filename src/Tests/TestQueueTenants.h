@@ -0,0 +1,33 @@
+#ifndef __TEST_QUEUE_TENANTS_H__
+#define __TEST_QUEUE_TENANTS_H__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "DispatchCPP/DispatchCPP.h"
+#include "Colors.h"
+#include "TestHelpers.h"
+
+// The number of tasks our flooding tenant dispatches all at once.
+#define TENANTS_FLOOD_NUM_TASKS         10000
+
+// The number of light tenants, how many tasks each dispatches, and how far apart it dispatches them.
+#define TENANTS_NUM_LIGHT               4
+#define TENANTS_LIGHT_NUM_TASKS         50
+#define TENANTS_LIGHT_INTERVAL_US       2000
+
+// The number of hashing passes each task makes (its CPU-bound work).
+#define TENANTS_WORK_ITERATIONS         4096
+
+double testQueueTenantsRun(unsigned int numWorkers, bool useHierarchy, vector<double> & allLightLatenciesUS);
+
+void testQueueTenants(unsigned int maxNumThreads = 4);
+
+#endif // __TEST_QUEUE_TENANTS_H__
@@ -0,0 +1,240 @@
+#include "TestQueueTimers.h"
+
+using namespace DispatchCPP;
+
+// Convenience function for grabbing the current time in nanoseconds, on the same clock the timer wheel uses.
+static inline long long int nowNS() {
+	return((long long int) chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+// Convenience function for grabbing our resident set size, in bytes.
+static size_t residentBytes() {
+	size_t numPages = 0, numResident = 0;
+	FILE * pStatm = fopen("/proc/self/statm", "r");
+	if (pStatm) {
+		if (fscanf(pStatm, "%zu %zu", &numPages, &numResident) != 2) {
+			numResident = 0;
+		}
+		fclose(pStatm);
+	}
+	return(numResident * ((size_t) sysconf(_SC_PAGESIZE)));
+}
+
+// Convenience function for printing the distribution of a set of latencies (in microseconds).
+static void printLatencies(const char * pLabel, vector<double> * pLatenciesUS) {
+	// Sort our latencies so we can pull percentiles out of them.
+	sort(pLatenciesUS->begin(), pLatenciesUS->end());
+
+	// Make sure we actually have samples to report.
+	size_t numSamples = pLatenciesUS->size();
+	if (numSamples == 0) {
+		printf("%s no samples!\n", pLabel);
+		return;
+	}
+
+	printf("%s min %9.1f uS, p50 %9.1f uS, p90 %9.1f uS, p99 %9.1f uS, max %9.1f uS\n",
+		pLabel,
+		(*pLatenciesUS)[0],
+		(*pLatenciesUS)[(numSamples * 50) / 100],
+		(*pLatenciesUS)[(numSamples * 90) / 100],
+		(*pLatenciesUS)[(numSamples * 99) / 100],
+		(*pLatenciesUS)[numSamples - 1]);
+}
+
+void testQueueTimersPending(unsigned int numWorkers, unsigned int numTimers, vector<double> * pLatenessUS) {
+	// When each timer should fire, how late each actually ran, and how many have run.
+	vector<long long int> targetTimesNS = vector<long long int>(numTimers, 0);
+	vector<double>        allLatenessUS = vector<double>(numTimers, -1.0);
+	vector<QueueTimerID>  allTimerIDs   = vector<QueueTimerID>(numTimers, 0);
+	atomic<unsigned int>  numFired(0);
+
+	// Declare our Queue, which records how late each timer ran.
+	Queue<void, unsigned int> * pTimerQueue = new Queue<void, unsigned int>(
+		new QueueFunction<void, unsigned int>(
+			[&targetTimesNS, &allLatenessUS, &numFired](unsigned int timerIndex) {
+				allLatenessUS[timerIndex] = (((double) (nowNS() - targetTimesNS[timerIndex])) / 1000.0);
+				numFired += 1;
+			}
+		),
+		numWorkers,
+		true
+	);
+
+	// Add every timer, spreading their delays evenly over our range, and measuring what they cost us.
+	size_t residentBefore = residentBytes();
+	auto   beforeAdd      = chrono::high_resolution_clock::now();
+	for (unsigned int timerIndex = 0; timerIndex < numTimers; ++timerIndex) {
+		long long int delayUS = ((TIMERS_MIN_DELAY_MS * 1000LL) + ((((long long int) timerIndex) * 7919LL) % ((TIMERS_MAX_DELAY_MS - TIMERS_MIN_DELAY_MS) * 1000LL)));
+		targetTimesNS[timerIndex] = (nowNS() + (delayUS * 1000LL));
+		allTimerIDs[timerIndex]   = pTimerQueue->dispatchAfter(chrono::microseconds(delayUS), timerIndex);
+	}
+	auto   afterAdd      = chrono::high_resolution_clock::now();
+	size_t residentAfter = residentBytes();
+
+	// Cancel every other timer.
+	unsigned int numCancelled = 0;
+	auto beforeCancel = chrono::high_resolution_clock::now();
+	for (unsigned int timerIndex = 1; timerIndex < numTimers; timerIndex += 2) {
+		numCancelled += (pTimerQueue->cancelTimer(allTimerIDs[timerIndex]) ? 1 : 0);
+	}
+	auto afterCancel = chrono::high_resolution_clock::now();
+
+	double addNS    = ((double) chrono::duration_cast<chrono::nanoseconds>(afterAdd - beforeAdd).count());
+	double cancelNS = ((double) chrono::duration_cast<chrono::nanoseconds>(afterCancel - beforeCancel).count());
+	printf("[%2u Worker%s] Added %u timers:      %s%9.1f nS/timer%s, %s%6.1f bytes/timer%s resident\n",
+		numWorkers, (numWorkers == 1) ? " " : "s", numTimers,
+		Colors::pColorGreen, (addNS / ((double) numTimers)), Colors::pColorReset,
+		Colors::pColorGreen, (((double) (residentAfter - min(residentAfter, residentBefore))) / ((double) numTimers)), Colors::pColorReset);
+	printf("[%2u Worker%s] Cancelled %u timers:  %s%9.1f nS/timer%s\n",
+		numWorkers, (numWorkers == 1) ? " " : "s", numCancelled,
+		Colors::pColorGreen, (cancelNS / ((double) max(numCancelled, 1u))), Colors::pColorReset);
+
+	// Wait for every remaining timer to fire, giving up well after the last should have.
+	unsigned int numExpected = (numTimers - numCancelled);
+	long long int giveUpNS   = (nowNS() + ((TIMERS_MAX_DELAY_MS + 5000LL) * 1000000LL));
+	while ((numFired.load() < numExpected) && (nowNS() < giveUpNS)) {
+		usleep(10000);
+	}
+	pTimerQueue->hasWorkLeft(true);
+
+	// Collect how late each timer ran. Cancelled timers should never have run, and none should have run early.
+	unsigned int numWrong = 0;
+	pLatenessUS->clear();
+	for (unsigned int timerIndex = 0; timerIndex < numTimers; ++timerIndex) {
+		bool wasCancelled = ((timerIndex % 2) == 1);
+		bool hasFired     = (allLatenessUS[timerIndex] != -1.0);
+		if ((wasCancelled == hasFired) || (hasFired && (allLatenessUS[timerIndex] < 0.0))) {
+			numWrong += 1;
+		}
+		if (hasFired) {
+			pLatenessUS->push_back(allLatenessUS[timerIndex]);
+		}
+	}
+	if (numWrong > 0) {
+		printf("%s%u timers fired early, fired after being cancelled, or never fired!%s\n", Colors::pColorRed, numWrong, Colors::pColorReset);
+	}
+
+	// Clean up after ourselves.
+	delete(pTimerQueue);
+}
+
+double testQueueTimersEmulated(unsigned int numWorkers, bool useTimers) {
+	// Every task just counts itself. When emulating timers, each task first sleeps through its delay.
+	atomic<unsigned int> numRun(0);
+	Queue<void, bool> * pDelayQueue = new Queue<void, bool>(
+		new QueueFunction<void, bool>(
+			[&numRun](bool shouldSleep) {
+				if (shouldSleep) {
+					usleep(TIMERS_EMULATED_DELAY_MS * 1000);
+				}
+				numRun += 1;
+			}
+		),
+		numWorkers,
+		true
+	);
+
+	// Start our timer, and dispatch every delayed task.
+	auto beforeDispatch = chrono::high_resolution_clock::now();
+	for (unsigned int taskIndex = 0; taskIndex < TIMERS_NUM_EMULATED; ++taskIndex) {
+		if (useTimers) {
+			pDelayQueue->dispatchAfter(chrono::milliseconds(TIMERS_EMULATED_DELAY_MS), false);
+		} else {
+			pDelayQueue->dispatchWork(true);
+		}
+	}
+
+	// Wait for all of them to have run.
+	while (numRun.load() < TIMERS_NUM_EMULATED) {
+		usleep(100);
+	}
+	auto afterDispatch = chrono::high_resolution_clock::now();
+
+	// Clean up after ourselves.
+	pDelayQueue->hasWorkLeft(true);
+	delete(pDelayQueue);
+
+	// Return the number of milliseconds it took for every delayed task to run.
+	return(((double) chrono::duration_cast<chrono::microseconds>(afterDispatch - beforeDispatch).count()) / 1000.0);
+}
+
+unsigned int testQueueTimersPeriodic(unsigned int numWorkers, vector<double> * pIntervalsUS) {
+	// The time of every tick our periodic task sees.
+	mutex                 tickLock;
+	vector<long long int> allTickTimesNS = vector<long long int>();
+
+	Queue<void> * pPeriodicQueue = new Queue<void>(
+		new QueueFunction<void>(
+			[&tickLock, &allTickTimesNS]() {
+				lock_guard<mutex> tempLock(tickLock);
+				allTickTimesNS.push_back(nowNS());
+			}
+		),
+		numWorkers,
+		true
+	);
+
+	// Let our periodic task run for a while, then cancel it.
+	long long int startTimeNS = nowNS();
+	QueueTimerID  timerID     = pPeriodicQueue->dispatchEvery(chrono::milliseconds(TIMERS_PERIOD_MS));
+	usleep(TIMERS_PERIODIC_RUN_MS * 1000);
+	pPeriodicQueue->cancelTimer(timerID);
+	pPeriodicQueue->hasWorkLeft(true);
+
+	// Make sure nothing fires once it's been cancelled.
+	tickLock.lock();
+	size_t numTicks = allTickTimesNS.size();
+	tickLock.unlock();
+	usleep(TIMERS_PERIOD_MS * 5 * 1000);
+	pPeriodicQueue->hasWorkLeft(true);
+	tickLock.lock();
+	if (allTickTimesNS.size() != numTicks) {
+		printf("%sPeriodic timer fired %zu times after being cancelled!%s\n", Colors::pColorRed, (allTickTimesNS.size() - numTicks), Colors::pColorReset);
+	}
+
+	// Figure out how far each tick landed from where it should have. Periodic timers don't drift, so each tick is
+	// measured against its ideal time rather than against the tick before it.
+	pIntervalsUS->clear();
+	for (size_t tickIndex = 0; tickIndex < numTicks; ++tickIndex) {
+		long long int idealTimeNS = (startTimeNS + (((long long int) (tickIndex + 1)) * TIMERS_PERIOD_MS * 1000000LL));
+		pIntervalsUS->push_back(((double) (allTickTimesNS[tickIndex] - idealTimeNS)) / 1000.0);
+	}
+	tickLock.unlock();
+
+	// Clean up after ourselves.
+	delete(pPeriodicQueue);
+	return((unsigned int) numTicks);
+}
+
+void testQueueTimers(unsigned int maxNumThreads) {
+	// The worker counts we'll test: powers of two, plus the max itself.
+	vector<unsigned int> allWorkerCounts = TestHelpers::workerCounts(maxNumThreads);
+
+	printf("==========================================================================================\n");
+	printf("=== %u pending timers (delays spread over %u-%u mS, every other one cancelled)\n", TIMERS_NUM_PENDING, TIMERS_MIN_DELAY_MS, TIMERS_MAX_DELAY_MS);
+	printf("==========================================================================================\n");
+	vector<double> allLatenessUS = vector<double>();
+	testQueueTimersPending(maxNumThreads, TIMERS_NUM_PENDING, &allLatenessUS);
+	char label[128];
+	snprintf(label, sizeof(label), "[%2u Worker%s] Firing lateness:     ", maxNumThreads, (maxNumThreads == 1) ? " " : "s");
+	printLatencies(label, &allLatenessUS);
+
+	printf("==========================================================================================\n");
+	printf("=== %u tasks delayed by %u mS (sleeping within each task vs dispatchAfter)\n", TIMERS_NUM_EMULATED, TIMERS_EMULATED_DELAY_MS);
+	printf("==========================================================================================\n");
+	for (unsigned int workerIndex = 0; workerIndex < allWorkerCounts.size(); ++workerIndex) {
+		unsigned int numWorkers = allWorkerCounts[workerIndex];
+		double sleepingMS = testQueueTimersEmulated(numWorkers, false);
+		double timersMS   = testQueueTimersEmulated(numWorkers, true);
+		printf("[%2u Worker%s] Sleeping: %9.1f mS, dispatchAfter: %s%7.1f mS%s\n",
+			numWorkers, (numWorkers == 1) ? " " : "s", sleepingMS, Colors::pColorGreen, timersMS, Colors::pColorReset);
+	}
+
+	printf("==========================================================================================\n");
+	printf("=== Periodic timer (every %u mS for %u mS)\n", TIMERS_PERIOD_MS, TIMERS_PERIODIC_RUN_MS);
+	printf("==========================================================================================\n");
+	vector<double> allIntervalsUS = vector<double>();
+	unsigned int   numTicks       = testQueueTimersPeriodic(maxNumThreads, &allIntervalsUS);
+	snprintf(label, sizeof(label), "[%2u Worker%s] %3u ticks, lateness: ", maxNumThreads, (maxNumThreads == 1) ? " " : "s", numTicks);
+	printLatencies(label, &allIntervalsUS);
+}
@@ -0,0 +1,36 @@
+#ifndef __TEST_QUEUE_TIMERS_H__
+#define __TEST_QUEUE_TIMERS_H__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <vector>
+
+#include "DispatchCPP/DispatchCPP.h"
+#include "Colors.h"
+#include "TestHelpers.h"
+
+// The number of timers we hold pending at once, and the range their delays are spread over.
+#define TIMERS_NUM_PENDING              1000000
+#define TIMERS_MIN_DELAY_MS             1000
+#define TIMERS_MAX_DELAY_MS             3000
+
+// The number of delayed tasks we compare against sleeping inside a task, and how long each is delayed.
+#define TIMERS_NUM_EMULATED             256
+#define TIMERS_EMULATED_DELAY_MS        20
+
+// The period of our periodic timer, and how long we let it run.
+#define TIMERS_PERIOD_MS                10
+#define TIMERS_PERIODIC_RUN_MS          1000
+
+void testQueueTimersPending(unsigned int numWorkers, unsigned int numTimers, vector<double> * pLatenessUS);
+double testQueueTimersEmulated(unsigned int numWorkers, bool useTimers);
+unsigned int testQueueTimersPeriodic(unsigned int numWorkers, vector<double> * pIntervalsUS);
+
+void testQueueTimers(unsigned int maxNumThreads = 4);
+
+#endif // __TEST_QUEUE_TIMERS_H__
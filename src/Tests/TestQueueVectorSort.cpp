@@ -343,3 +343,121 @@ void testVectorSortingDispatchCPP(unsigned int numVectors, unsigned int vectorSi
     // Deallocate our array of vectors.
     testVectorSortingDispatchCPP_Deallocate(ppAllVectors, numVectors, numThreads);
 }
+
+// Convenience function for timing a sort of a copy of the original vector, and checking it against the reference.
+static double testVectorSortHugeRun(vector<unsigned int> * pOriginal, vector<unsigned int> * pReference, vector<unsigned int> * pWorking, function<void(vector<unsigned int> *)> sortFunc) {
+    // Start from the same unsorted data each time.
+    *pWorking = *pOriginal;
+
+    // Sort it, now.
+    auto beforeSort = chrono::high_resolution_clock::now();
+    sortFunc(pWorking);
+    auto afterSort = chrono::high_resolution_clock::now();
+
+    // Make sure it actually came out sorted.
+    if ((pReference->size() > 0) && (*pWorking != *pReference)) {
+        printf("%sSORTED VECTOR DOES NOT MATCH THE REFERENCE%s ", Colors::pColorRed, Colors::pColorReset);
+    }
+
+    // Return the number of milliseconds the sort took.
+    return(((double) chrono::duration_cast<chrono::microseconds>(afterSort - beforeSort).count()) / 1000.0);
+}
+
+void testQueueVectorSortHuge(unsigned int maxNumThreads) {
+    // The thread counts we'll test: powers of two, plus the max itself.
+    vector<unsigned int> allThreadCounts = TestHelpers::workerCounts(maxNumThreads);
+
+    // Fill our one huge vector with randomness we can expect.
+    vector<unsigned int> originalVector  = vector<unsigned int>();
+    vector<unsigned int> referenceVector = vector<unsigned int>();
+    vector<unsigned int> workingVector   = vector<unsigned int>();
+    originalVector.reserve(VECTOR_SORT_HUGE_SIZE);
+    srand(123456);
+    for (unsigned int index = 0; index < VECTOR_SORT_HUGE_SIZE; ++index) {
+        originalVector.push_back(rand());
+    }
+
+    printf("===================================================================================================\n");
+    printf("=== Sorting one vector of %u entries\n", VECTOR_SORT_HUGE_SIZE);
+    printf("===================================================================================================\n");
+
+    // Our baseline is a plain std::sort, which also gives us the reference every other sort is checked against.
+    printf("%s                      std::sort => ", Colors::pColorGreen);
+    double numMillisecondsBase = testVectorSortHugeRun(&originalVector, &referenceVector, &workingVector, [](vector<unsigned int> * pVector) {
+        sort(pVector->begin(), pVector->end());
+    });
+    referenceVector = workingVector;
+    printf("%9.2fms%s\n", numMillisecondsBase, Colors::pColorReset);
+
+#ifdef ENABLE_STD_EXECUTION_PAR
+    printf("      std::sort(execution::par) => ");
+    double numMillisecondsPar = testVectorSortHugeRun(&originalVector, &referenceVector, &workingVector, [](vector<unsigned int> * pVector) {
+        sort(execution::par, pVector->begin(), pVector->end());
+    });
+    printf("%9.2fms (%4.2fx speedup)\n", numMillisecondsPar, (numMillisecondsBase / numMillisecondsPar));
+#else // ENABLE_STD_EXECUTION_PAR
+    printf("      std::sort(execution::par) => not built (requires TBB)\n");
+#endif // ENABLE_STD_EXECUTION_PAR
+
+    // Now try both of our own parallel sorts, across each thread count.
+    for (unsigned int threadIndex = 0; threadIndex < allThreadCounts.size(); ++threadIndex) {
+        unsigned int numThreads = allThreadCounts[threadIndex];
+        printf("---------------------------------------------------------------------------------------------------\n");
+
+        // Declare the Queue whose threads our sorts run on. Its own function is never used.
+        Queue<void> * pSortQueue = new Queue<void>(
+            new QueueFunction<void>(
+                []() {}
+            ),
+            numThreads,
+            true
+        );
+
+        printf("  %2u Thread%s: parallelSort      => ", numThreads, (numThreads == 1) ? " " : "s");
+        double numMillisecondsSample = testVectorSortHugeRun(&originalVector, &referenceVector, &workingVector, [pSortQueue](vector<unsigned int> * pVector) {
+            parallelSort(pSortQueue, pVector->begin(), pVector->end());
+        });
+        printf("%9.2fms (%s%4.2fx speedup%s)\n", numMillisecondsSample, ((numMillisecondsBase > numMillisecondsSample) ? Colors::pColorGreen : Colors::pColorRed), (numMillisecondsBase / numMillisecondsSample), Colors::pColorReset);
+
+        printf("  %2u Thread%s: parallelRadixSort => ", numThreads, (numThreads == 1) ? " " : "s");
+        double numMillisecondsRadix = testVectorSortHugeRun(&originalVector, &referenceVector, &workingVector, [pSortQueue](vector<unsigned int> * pVector) {
+            parallelRadixSort(pSortQueue, pVector->begin(), pVector->end());
+        });
+        printf("%9.2fms (%s%4.2fx speedup%s)\n", numMillisecondsRadix, ((numMillisecondsBase > numMillisecondsRadix) ? Colors::pColorGreen : Colors::pColorRed), (numMillisecondsBase / numMillisecondsRadix), Colors::pColorReset);
+
+        // Delete our sort queue, now.
+        delete(pSortQueue);
+    }
+
+    // Now the same again, with only a handful of distinct keys, so sample sort's buckets come out badly skewed.
+    for (unsigned int index = 0; index < VECTOR_SORT_HUGE_SIZE; ++index) {
+        originalVector[index] = (originalVector[index] % VECTOR_SORT_HUGE_DISTINCT_KEYS);
+    }
+    referenceVector.clear();
+    printf("===================================================================================================\n");
+    printf("=== Sorting one vector of %u entries, with only %u distinct keys\n", VECTOR_SORT_HUGE_SIZE, VECTOR_SORT_HUGE_DISTINCT_KEYS);
+    printf("===================================================================================================\n");
+    printf("%s                      std::sort => ", Colors::pColorGreen);
+    numMillisecondsBase = testVectorSortHugeRun(&originalVector, &referenceVector, &workingVector, [](vector<unsigned int> * pVector) {
+        sort(pVector->begin(), pVector->end());
+    });
+    referenceVector = workingVector;
+    printf("%9.2fms%s\n", numMillisecondsBase, Colors::pColorReset);
+    for (unsigned int threadIndex = 0; threadIndex < allThreadCounts.size(); ++threadIndex) {
+        unsigned int  numThreads = allThreadCounts[threadIndex];
+        Queue<void> * pSortQueue = new Queue<void>(
+            new QueueFunction<void>(
+                []() {}
+            ),
+            numThreads,
+            true
+        );
+        printf("  %2u Thread%s: parallelSort      => ", numThreads, (numThreads == 1) ? " " : "s");
+        double numMillisecondsSample = testVectorSortHugeRun(&originalVector, &referenceVector, &workingVector, [pSortQueue](vector<unsigned int> * pVector) {
+            parallelSort(pSortQueue, pVector->begin(), pVector->end());
+        });
+        printf("%9.2fms (%s%4.2fx speedup%s)\n", numMillisecondsSample, ((numMillisecondsBase > numMillisecondsSample) ? Colors::pColorGreen : Colors::pColorRed), (numMillisecondsBase / numMillisecondsSample), Colors::pColorReset);
+        delete(pSortQueue);
+    }
+    printf("===================================================================================================\n");
+}
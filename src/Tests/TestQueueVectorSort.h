@@ -7,10 +7,16 @@
 
 #include <algorithm>
 #include <chrono>
+#include <vector>
+
+#ifdef ENABLE_STD_EXECUTION_PAR
+#include <execution>
+#endif // ENABLE_STD_EXECUTION_PAR
 
 #include "../DispatchCPP/DispatchCPP.h"
 
 #include "Colors.h"
+#include "TestHelpers.h"
 
 // This define enables allocating the vectors in parallel.
 #define ENABLE_PARALLEL_ALLOCATIONS
@@ -18,6 +24,13 @@
 // This define enables deallocating the vectors in parallel.
 #define ENABLE_PARALLEL_DEALLOCATIONS
 
+// The number of entries in the single vector sorted by testQueueVectorSortHuge().
+#define VECTOR_SORT_HUGE_SIZE 100000000
+
+// The number of distinct keys in the duplicate-heavy vector sorted by testQueueVectorSortHuge().
+#define VECTOR_SORT_HUGE_DISTINCT_KEYS 8
+
 void testQueueVectorSort(unsigned int maxNumThreads = 4);
+void testQueueVectorSortHuge(unsigned int maxNumThreads = 4);
 
 #endif // __TEST_QUEUE_VECTOR_SORT_H__
\ No newline at end of file
@@ -0,0 +1,95 @@
+#include "TestQueueWait.h"
+
+using namespace DispatchCPP;
+
+// The names of each strategy we test.
+static const char * pWaitStrategyNames[] = {
+	"park",
+	"park, targeted",
+	"spin",
+	"spin, yield"
+};
+
+// Returns steady_clock's time, in nanoseconds.
+static long long int waitNowNS() {
+	return((long long int) chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+// Returns the CPU time our whole process has used, in milliseconds.
+static double waitCPUMS() {
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+	return((((double) (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec)) * 1000.0) + (((double) (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec)) / 1000.0));
+}
+
+WaitResult testQueueWaitRun(unsigned int numWorkers, QueueWaitStrategy strategy, bool isHighLoad) {
+	// Our queue, which records how long each piece of work waited between being dispatched and starting.
+	unsigned int          numTasks     = (isHighLoad ? WAIT_HIGH_LOAD_NUM_TASKS : WAIT_LOW_LOAD_NUM_TASKS);
+	vector<long long int> allLatencyNS = vector<long long int>(numTasks, 0);
+	atomic<unsigned int>  numDone      = 0;
+	Queue<void, long long int> * pQueue = new Queue<void, long long int>(
+		new QueueFunction<void, long long int>(
+			[&allLatencyNS, &numDone](long long int dispatchNS) {
+				long long int latencyNS = (waitNowNS() - dispatchNS);
+				allLatencyNS[numDone.fetch_add(1)] = latencyNS;
+			}
+		),
+		numWorkers,
+		true
+	);
+	pQueue->setWaitStrategy(strategy);
+	usleep(1000);
+
+	// Dispatch our work, either trickling it in, or all at once.
+	unsigned long long int wakeupsBefore = pQueue->getNumWakeups();
+	double                 cpuBefore     = waitCPUMS();
+	auto                   beforeRun     = chrono::high_resolution_clock::now();
+	for (unsigned int taskIndex = 0; taskIndex < numTasks; ++taskIndex) {
+		if (!isHighLoad) {
+			usleep(WAIT_LOW_LOAD_GAP_US);
+		}
+		pQueue->dispatchWork(waitNowNS());
+	}
+	pQueue->hasWorkLeft(true);
+	auto afterRun = chrono::high_resolution_clock::now();
+
+	WaitResult result;
+	result.wallMS     = (((double) chrono::duration_cast<chrono::microseconds>(afterRun - beforeRun).count()) / 1000.0);
+	result.cpuMS      = (waitCPUMS() - cpuBefore);
+	result.numWakeups = (pQueue->getNumWakeups() - wakeupsBefore);
+
+	// Clean up after ourselves.
+	delete(pQueue);
+
+	sort(allLatencyNS.begin(), allLatencyNS.end());
+	result.medianLatencyUS = (((double) allLatencyNS[numTasks / 2]) / 1000.0);
+	result.p99LatencyUS    = (((double) allLatencyNS[(numTasks * 99) / 100]) / 1000.0);
+	return(result);
+}
+
+void testQueueWait(unsigned int maxNumThreads) {
+	// The worker counts we'll test: powers of two, plus the max itself.
+	vector<unsigned int> allWorkerCounts = TestHelpers::workerCounts(maxNumThreads);
+
+	for (unsigned int loadIndex = 0; loadIndex < 2; ++loadIndex) {
+		bool isHighLoad = (loadIndex == 1);
+		printf("==========================================================================================\n");
+		if (isHighLoad) {
+			printf("=== High load: %u tasks in a single burst\n", WAIT_HIGH_LOAD_NUM_TASKS);
+		} else {
+			printf("=== Low load: %u tasks, %u us apart\n", WAIT_LOW_LOAD_NUM_TASKS, WAIT_LOW_LOAD_GAP_US);
+		}
+		printf("==========================================================================================\n");
+		for (unsigned int workerIndex = 0; workerIndex < allWorkerCounts.size(); ++workerIndex) {
+			unsigned int numWorkers = allWorkerCounts[workerIndex];
+			WaitResult   parkResult = testQueueWaitRun(numWorkers, QueueWaitStrategyPark, isHighLoad);
+			for (int strategyIndex = QueueWaitStrategyPark; strategyIndex <= QueueWaitStrategySpinYield; ++strategyIndex) {
+				WaitResult result = ((strategyIndex == QueueWaitStrategyPark) ? parkResult : testQueueWaitRun(numWorkers, (QueueWaitStrategy) strategyIndex, isHighLoad));
+				printf("[%2u Worker%s] %-14s: %9.3f ms wall, %9.3f ms CPU, latency p50 %s%9.2f us%s p99 %9.2f us, %8llu wakeups\n",
+					numWorkers, (numWorkers == 1) ? " " : "s", pWaitStrategyNames[strategyIndex], result.wallMS, result.cpuMS,
+					(strategyIndex == QueueWaitStrategyPark) ? Colors::pColorReset : ((result.medianLatencyUS < parkResult.medianLatencyUS) ? Colors::pColorGreen : Colors::pColorRed),
+					result.medianLatencyUS, Colors::pColorReset, result.p99LatencyUS, result.numWakeups);
+			}
+		}
+	}
+}
@@ -0,0 +1,38 @@
+#ifndef __TEST_QUEUE_WAIT_H__
+#define __TEST_QUEUE_WAIT_H__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <vector>
+
+#include "DispatchCPP/DispatchCPP.h"
+#include "Colors.h"
+#include "TestHelpers.h"
+
+// Low load: work trickles in, one piece at a time, with a gap between each.
+#define WAIT_LOW_LOAD_NUM_TASKS         2000
+#define WAIT_LOW_LOAD_GAP_US            200
+
+// High load: work is dispatched in a single burst.
+#define WAIT_HIGH_LOAD_NUM_TASKS        200000
+
+// The results of a single run.
+typedef struct __WAIT_RESULT__ {
+	double                 wallMS;
+	double                 cpuMS;
+	double                 medianLatencyUS;
+	double                 p99LatencyUS;
+	unsigned long long int numWakeups;
+} WaitResult;
+
+WaitResult testQueueWaitRun(unsigned int numWorkers, QueueWaitStrategy strategy, bool isHighLoad);
+
+void testQueueWait(unsigned int maxNumThreads = 4);
+
+#endif // __TEST_QUEUE_WAIT_H__
@@ -0,0 +1,218 @@
+#include "TestQueueWorkerState.h"
+
+using namespace DispatchCPP;
+
+// The way QueueThread used to lay out its state: volatile flags side by side, with nothing keeping one worker's flags
+// off of the cache line holding another's.
+typedef struct __PACKED_WORKER_STATE__ {
+	volatile bool keepGoing;
+	volatile bool isRunning;
+	volatile bool isIdle;
+} PackedWorkerState;
+
+// The way QueueThread lays out its state now: atomics on their own cache line, updated under a sequence number.
+typedef struct alignas(QUEUE_THREAD_CACHE_LINE_SIZE) __PADDED_WORKER_STATE__ {
+	atomic<unsigned int>           sequence;
+	atomic<int>                    state;
+	atomic<long long int>          taskStartNS;
+	atomic<unsigned long long int> numTasksDone;
+} PaddedWorkerState;
+
+double testQueueWorkerStateEmulated(unsigned int numWorkers, bool usePaddedAtomics, bool withMonitor) {
+	vector<PackedWorkerState> allPacked = vector<PackedWorkerState>(numWorkers);
+	vector<PaddedWorkerState> allPadded = vector<PaddedWorkerState>(numWorkers);
+	for (unsigned int workerIndex = 0; workerIndex < numWorkers; ++workerIndex) {
+		allPacked[workerIndex].keepGoing = true;
+		allPacked[workerIndex].isRunning = true;
+		allPacked[workerIndex].isIdle    = true;
+		allPadded[workerIndex].sequence     = 0;
+		allPadded[workerIndex].state        = (int) QueueThreadStateIdle;
+		allPadded[workerIndex].taskStartNS  = 0;
+		allPadded[workerIndex].numTasksDone = 0;
+	}
+
+	// Our monitor spins over every worker's state, the way hasWorkLeft() polls it.
+	atomic<bool>           keepMonitoring(true);
+	atomic<unsigned int>   numIdleSeen(0);
+	thread               * pMonitor = nullptr;
+	if (withMonitor) {
+		pMonitor = new thread([&]() {
+			unsigned int numIdle = 0;
+			while (keepMonitoring.load(memory_order_relaxed)) {
+				for (unsigned int workerIndex = 0; workerIndex < numWorkers; ++workerIndex) {
+					if (usePaddedAtomics) {
+						numIdle += ((allPadded[workerIndex].state.load(memory_order_acquire) != QueueThreadStateRunning) ? 1 : 0);
+					} else {
+						numIdle += (allPacked[workerIndex].isIdle ? 1 : 0);
+					}
+				}
+			}
+			numIdleSeen = numIdle;
+		});
+	}
+
+	// Each worker flips its own state back and forth, as it would around each task.
+	auto beforeUpdates = chrono::high_resolution_clock::now();
+	vector<thread> allWorkers = vector<thread>();
+	for (unsigned int workerIndex = 0; workerIndex < numWorkers; ++workerIndex) {
+		allWorkers.push_back(thread([&, workerIndex]() {
+			PackedWorkerState * pPacked = &(allPacked[workerIndex]);
+			PaddedWorkerState * pPadded = &(allPadded[workerIndex]);
+			for (unsigned int updateIndex = 0; updateIndex < WORKER_STATE_NUM_UPDATES; ++updateIndex) {
+				if (usePaddedAtomics) {
+					unsigned int sequence = pPadded->sequence.load(memory_order_relaxed);
+					pPadded->sequence.store(sequence + 1, memory_order_relaxed);
+					atomic_thread_fence(memory_order_release);
+					pPadded->taskStartNS.store((updateIndex & 1) ? 0 : updateIndex, memory_order_relaxed);
+					pPadded->numTasksDone.store(pPadded->numTasksDone.load(memory_order_relaxed) + (updateIndex & 1), memory_order_relaxed);
+					pPadded->state.store((updateIndex & 1) ? QueueThreadStateIdle : QueueThreadStateRunning, memory_order_relaxed);
+					pPadded->sequence.store(sequence + 2, memory_order_release);
+				} else {
+					pPacked->isIdle = ((updateIndex & 1) != 0);
+				}
+			}
+		}));
+	}
+	for (unsigned int workerIndex = 0; workerIndex < numWorkers; ++workerIndex) {
+		allWorkers[workerIndex].join();
+	}
+	auto afterUpdates = chrono::high_resolution_clock::now();
+
+	// Stop our monitor.
+	keepMonitoring = false;
+	if (pMonitor) {
+		pMonitor->join();
+		delete(pMonitor);
+	}
+
+	// Return the number of nanoseconds each update took, per worker.
+	double numNanoseconds = ((double) chrono::duration_cast<chrono::nanoseconds>(afterUpdates - beforeUpdates).count());
+	return(numNanoseconds / ((double) WORKER_STATE_NUM_UPDATES));
+}
+
+double testQueueWorkerStateQueue(unsigned int numWorkers, unsigned int monitorMode) {
+	// Declare our Queue, whose function does nothing at all.
+	Queue<void> * pEmptyQueue = new Queue<void>(
+		new QueueFunction<void>(
+			[]() {}
+		),
+		numWorkers,
+		true
+	);
+
+	// Our monitor either polls hasWorkLeft() (mode 1) or takes status snapshots (mode 2) the whole time.
+	atomic<bool>   keepMonitoring(true);
+	thread       * pMonitor = nullptr;
+	if (monitorMode != 0) {
+		pMonitor = new thread([&]() {
+			unsigned long long int numDone = 0;
+			while (keepMonitoring.load(memory_order_relaxed)) {
+				if (monitorMode == 1) {
+					numDone += (pEmptyQueue->hasWorkLeft(false) ? 1 : 0);
+				} else {
+					vector<QueueThreadStatus> allStatus = pEmptyQueue->getThreadStatus();
+					numDone += allStatus[0].numTasksDone;
+				}
+				this_thread::yield();
+			}
+		});
+	}
+
+	// Dispatch all of our empty tasks, and wait for them to drain.
+	auto beforeDispatch = chrono::high_resolution_clock::now();
+	for (unsigned int taskIndex = 0; taskIndex < WORKER_STATE_NUM_TASKS; ++taskIndex) {
+		pEmptyQueue->dispatchWork();
+	}
+	pEmptyQueue->hasWorkLeft(true);
+	auto afterDispatch = chrono::high_resolution_clock::now();
+
+	// Stop our monitor, and make sure every task was counted.
+	keepMonitoring = false;
+	if (pMonitor) {
+		pMonitor->join();
+		delete(pMonitor);
+	}
+	unsigned long long int numTasksDone = 0;
+	vector<QueueThreadStatus> allStatus = pEmptyQueue->getThreadStatus();
+	for (unsigned int workerIndex = 0; workerIndex < allStatus.size(); ++workerIndex) {
+		numTasksDone += allStatus[workerIndex].numTasksDone;
+	}
+	if (numTasksDone != WORKER_STATE_NUM_TASKS) {
+		printf("%sWorkers counted %llu tasks done, expected %u!%s\n", Colors::pColorRed, numTasksDone, WORKER_STATE_NUM_TASKS, Colors::pColorReset);
+	}
+
+	// Clean up after ourselves.
+	delete(pEmptyQueue);
+
+	// Return the number of nanoseconds each task took, end to end.
+	return(((double) chrono::duration_cast<chrono::nanoseconds>(afterDispatch - beforeDispatch).count()) / ((double) WORKER_STATE_NUM_TASKS));
+}
+
+double testQueueWorkerStateSnapshot(unsigned int numWorkers) {
+	// Declare our Queue, whose function sleeps briefly so its workers move between states.
+	Queue<void> * pSleepyQueue = new Queue<void>(
+		new QueueFunction<void>(
+			[]() { usleep(10); }
+		),
+		numWorkers,
+		true
+	);
+	for (unsigned int taskIndex = 0; taskIndex < (numWorkers * 1000); ++taskIndex) {
+		pSleepyQueue->dispatchWork();
+	}
+
+	// Time taking snapshots while they work.
+	unsigned long long int numRunning = 0;
+	auto beforeSnapshots = chrono::high_resolution_clock::now();
+	for (unsigned int snapshotIndex = 0; snapshotIndex < WORKER_STATE_NUM_SNAPSHOTS; ++snapshotIndex) {
+		vector<QueueThreadStatus> allStatus = pSleepyQueue->getThreadStatus();
+		for (unsigned int workerIndex = 0; workerIndex < allStatus.size(); ++workerIndex) {
+			numRunning += ((allStatus[workerIndex].state == QueueThreadStateRunning) ? 1 : 0);
+		}
+	}
+	auto afterSnapshots = chrono::high_resolution_clock::now();
+
+	// Clean up after ourselves.
+	pSleepyQueue->hasWorkLeft(true);
+	delete(pSleepyQueue);
+
+	// Return the number of nanoseconds each snapshot took.
+	return(((double) chrono::duration_cast<chrono::nanoseconds>(afterSnapshots - beforeSnapshots).count()) / ((double) WORKER_STATE_NUM_SNAPSHOTS));
+}
+
+void testQueueWorkerState(unsigned int maxNumThreads) {
+	// The worker counts we'll test: powers of two, plus the max itself.
+	vector<unsigned int> allWorkerCounts = TestHelpers::workerCounts(maxNumThreads);
+
+	printf("==========================================================================================\n");
+	printf("=== Worker state updates, old vs new layout (%u updates per worker, with a polling monitor)\n", WORKER_STATE_NUM_UPDATES);
+	printf("==========================================================================================\n");
+	for (unsigned int workerIndex = 0; workerIndex < allWorkerCounts.size(); ++workerIndex) {
+		unsigned int numWorkers = allWorkerCounts[workerIndex];
+		double       packedNS   = testQueueWorkerStateEmulated(numWorkers, false, true);
+		double       paddedNS   = testQueueWorkerStateEmulated(numWorkers, true,  true);
+		printf("[%2u Worker%s] Packed volatile: %7.3f nS/update, padded atomic: %s%7.3f nS/update%s\n",
+			numWorkers, (numWorkers == 1) ? " " : "s", packedNS, ((paddedNS < packedNS) ? Colors::pColorGreen : Colors::pColorRed), paddedNS, Colors::pColorReset);
+	}
+
+	printf("==========================================================================================\n");
+	printf("=== Empty-task throughput while being monitored (%u tasks)\n", WORKER_STATE_NUM_TASKS);
+	printf("==========================================================================================\n");
+	for (unsigned int workerIndex = 0; workerIndex < allWorkerCounts.size(); ++workerIndex) {
+		unsigned int numWorkers   = allWorkerCounts[workerIndex];
+		double       unmonitoredNS = testQueueWorkerStateQueue(numWorkers, 0);
+		double       pollingNS     = testQueueWorkerStateQueue(numWorkers, 1);
+		double       snapshotNS    = testQueueWorkerStateQueue(numWorkers, 2);
+		printf("[%2u Worker%s] Unmonitored: %8.1f nS/task, hasWorkLeft(): %8.1f nS/task, getThreadStatus(): %8.1f nS/task\n",
+			numWorkers, (numWorkers == 1) ? " " : "s", unmonitoredNS, pollingNS, snapshotNS);
+	}
+
+	printf("==========================================================================================\n");
+	printf("=== Status snapshot cost (%u snapshots of busy workers)\n", WORKER_STATE_NUM_SNAPSHOTS);
+	printf("==========================================================================================\n");
+	for (unsigned int workerIndex = 0; workerIndex < allWorkerCounts.size(); ++workerIndex) {
+		unsigned int numWorkers = allWorkerCounts[workerIndex];
+		printf("[%2u Worker%s] getThreadStatus(): %s%8.1f nS%s\n",
+			numWorkers, (numWorkers == 1) ? " " : "s", Colors::pColorGreen, testQueueWorkerStateSnapshot(numWorkers), Colors::pColorReset);
+	}
+}
@@ -0,0 +1,30 @@
+#ifndef __TEST_QUEUE_WORKER_STATE_H__
+#define __TEST_QUEUE_WORKER_STATE_H__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "DispatchCPP/DispatchCPP.h"
+#include "Colors.h"
+#include "TestHelpers.h"
+
+// The number of state updates each emulated worker makes.
+#define WORKER_STATE_NUM_UPDATES        5000000
+
+// The number of empty tasks dispatched when measuring a real Queue, and the number of status snapshots timed.
+#define WORKER_STATE_NUM_TASKS          500000
+#define WORKER_STATE_NUM_SNAPSHOTS      100000
+
+double testQueueWorkerStateEmulated(unsigned int numWorkers, bool usePaddedAtomics, bool withMonitor);
+double testQueueWorkerStateQueue(unsigned int numWorkers, unsigned int monitorMode);
+double testQueueWorkerStateSnapshot(unsigned int numWorkers);
+
+void testQueueWorkerState(unsigned int maxNumThreads = 4);
+
+#endif // __TEST_QUEUE_WORKER_STATE_H__